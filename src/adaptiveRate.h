@@ -0,0 +1,154 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+// Acquisition interval controller. A transient (|dΔT/dt| over the threshold, or a
+// heater power step) drops the interval straight to the minimum; every quiet sample
+// then stretches it by the backoff factor up to the maximum. The slope is smoothed
+// with a first-order filter so RTD noise alone does not hold the fast rate.
+class AdaptiveRate
+{
+public:
+    void begin(uint32_t minMs, uint32_t maxMs, float slopeThreshold, float powerStep, float backoff, uint32_t smoothingMs)
+    {
+        minInterval = minMs;
+        maxInterval = maxMs;
+        slopeLimit = slopeThreshold;
+        powerLimit = powerStep;
+        growth = backoff;
+        tau = smoothingMs;
+        current = minMs;
+        primed = false;
+        slopeKs = 0;
+        transientCount = 0;
+    }
+
+    // Feeds one sample, returns the interval until the next one
+    uint32_t update(uint32_t nowMs, float dT, float power)
+    {
+        if (!primed)
+        {
+            primed = true;
+            lastMs = nowMs;
+            lastDT = dT;
+            lastPower = power;
+            return current;
+        }
+
+        uint32_t dtMs = nowMs - lastMs;
+        if (dtMs == 0)
+        {
+            return current;
+        }
+        float raw = (dT - lastDT) * 1000.0f / dtMs; // K/s
+        slopeKs += (raw - slopeKs) * dtMs / (float)(tau + dtMs);
+        bool step = fabsf(power - lastPower) > powerLimit;
+        lastMs = nowMs;
+        lastDT = dT;
+        lastPower = power;
+
+        fast = step || fabsf(slopeKs) > slopeLimit;
+        if (fast)
+        {
+            if (current != minInterval)
+            {
+                transientCount++;
+            }
+            current = minInterval;
+        }
+        else
+        {
+            float next = current * growth;
+            current = next > maxInterval ? maxInterval : (uint32_t)next;
+        }
+        return current;
+    }
+
+    uint32_t interval() const { return current; }
+    float slope() const { return slopeKs; } // Smoothed dΔT/dt, K/s
+    bool transient() const { return fast; }
+    uint32_t transients() const { return transientCount; }
+
+private:
+    uint32_t minInterval = 1000;
+    uint32_t maxInterval = 1000;
+    float slopeLimit = 0;
+    float powerLimit = 0;
+    float growth = 1;
+    uint32_t tau = 1;
+    uint32_t current = 1000;
+    bool primed = false;
+    bool fast = false;
+    uint32_t lastMs = 0;
+    float lastDT = 0;
+    float lastPower = 0;
+    float slopeKs = 0;
+    uint32_t transientCount = 0;
+};
+
+// Change-only logging: a sample is logged when ΔT, power or k has left the deadband
+// around the last logged row, no sooner than minMs after it, and at least every maxMs
+// so a steady run still shows up as alive.
+class DeadbandLogger
+{
+public:
+    void begin(float dTBand, float powerBand, float kRelativeBand, uint32_t minMs, uint32_t maxMs)
+    {
+        bandDT = dTBand;
+        bandPower = powerBand;
+        bandK = kRelativeBand;
+        minInterval = minMs;
+        maxInterval = maxMs;
+        hasLogged = false;
+        loggedCount = 0;
+        suppressedCount = 0;
+    }
+
+    bool shouldLog(uint32_t nowMs, float dT, float power, float k)
+    {
+        bool log;
+        if (!hasLogged)
+        {
+            log = true;
+        }
+        else
+        {
+            uint32_t age = nowMs - lastMs;
+            bool moved = fabsf(dT - lastDT) > bandDT ||
+                         fabsf(power - lastPower) > bandPower ||
+                         fabsf(k - lastK) > bandK * fabsf(lastK);
+            log = age >= maxInterval || (moved && age >= minInterval);
+        }
+
+        if (!log)
+        {
+            suppressedCount++;
+            return false;
+        }
+        hasLogged = true;
+        lastMs = nowMs;
+        lastDT = dT;
+        lastPower = power;
+        lastK = k;
+        loggedCount++;
+        return true;
+    }
+
+    uint32_t logged() const { return loggedCount; }
+    uint32_t suppressed() const { return suppressedCount; }
+
+private:
+    float bandDT = 0;
+    float bandPower = 0;
+    float bandK = 0;
+    uint32_t minInterval = 0;
+    uint32_t maxInterval = 0;
+    bool hasLogged = false;
+    uint32_t lastMs = 0;
+    float lastDT = 0;
+    float lastPower = 0;
+    float lastK = 0;
+    uint32_t loggedCount = 0;
+    uint32_t suppressedCount = 0;
+};
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+// Incremental overlapping Allan variance at octave-spaced τ = 2^k·τ0, k < Octaves.
+//   σ²(τ) = ⟨(S[n] − 2·S[n−M] + S[n−2M])² / M²⟩ / 2,   S = running sum of the stream
+// Octaves up to 2^ALLAN_OVERLAP_LOG2 are fully overlapping on the input. Above that a
+// cascade of pairwise averages halves the rate per level, and each level evaluates its
+// one octave over 2^ALLAN_OVERLAP_LOG2 of its own samples, i.e. overlapping with a
+// stride of τ / 2^ALLAN_OVERLAP_LOG2. Memory is bounded by Octaves, not by τ, and a
+// sample costs one push per level it reaches: amortised O(1), worst case O(log τ).
+#define ALLAN_OVERLAP_LOG2 2
+#define ALLAN_MIN_TERMS 4 // Below this an octave is not reported as the optimum
+
+template <int Channels, int Octaves>
+class AllanVariance
+{
+    static const int M_MAX = 1 << ALLAN_OVERLAP_LOG2;
+    static const int RING = 2 * M_MAX + 1;
+    static const int LEVELS = Octaves > ALLAN_OVERLAP_LOG2 ? Octaves - ALLAN_OVERLAP_LOG2 : 1;
+
+public:
+    void reset()
+    {
+        samples = 0;
+        for (int l = 0; l < LEVELS; l++)
+        {
+            Level &level = levels[l];
+            level.count = 0;
+            level.head = 0;
+            level.pending = false;
+            for (int c = 0; c < Channels; c++)
+            {
+                level.sum[c] = 0;
+                level.ring[0][c] = 0;
+            }
+        }
+        for (int k = 0; k < Octaves; k++)
+        {
+            terms[k] = 0;
+            for (int c = 0; c < Channels; c++)
+            {
+                acc[k][c] = 0;
+            }
+        }
+    }
+
+    void push(const float y[Channels])
+    {
+        double v[Channels];
+        for (int c = 0; c < Channels; c++)
+        {
+            if (samples == 0)
+            {
+                reference[c] = y[c]; // Keeps the running sums small
+            }
+            v[c] = (double)y[c] - reference[c];
+        }
+        samples++;
+        pushLevel(0, v);
+    }
+
+    uint32_t count() const { return samples; }
+    int octaves() const { return Octaves; }
+    uint32_t termCount(int k) const { return terms[k]; }
+
+    // τ of octave k in units of τ0
+    uint32_t tauFactor(int k) const { return 1UL << k; }
+
+    double avar(int c, int k) const { return terms[k] ? acc[k][c] / (2.0 * terms[k]) : 0; }
+    double adev(int c, int k) const { return sqrt(avar(c, k)); }
+
+    // Octave with the lowest deviation: averaging longer than this lets drift in. -1 = no data
+    int bestOctave(int c) const
+    {
+        int best = -1;
+        for (int k = 0; k < Octaves; k++)
+        {
+            if (terms[k] >= ALLAN_MIN_TERMS && (best < 0 || avar(c, k) < avar(c, best)))
+            {
+                best = k;
+            }
+        }
+        return best;
+    }
+
+private:
+    struct Level
+    {
+        double sum[Channels];        // Running sum of this level's stream
+        double ring[RING][Channels]; // Last RING running sums, ring[head] is the newest
+        double carry[Channels];      // First half of the next pair average
+        uint32_t count;              // Values pushed into this level
+        int head;
+        bool pending;
+    };
+
+    void pushLevel(int l, const double v[Channels])
+    {
+        Level &level = levels[l];
+        level.head = (level.head + 1) % RING;
+        for (int c = 0; c < Channels; c++)
+        {
+            level.sum[c] += v[c];
+            level.ring[level.head][c] = level.sum[c];
+        }
+        level.count++;
+
+        // Level 0 serves octaves 0..ALLAN_OVERLAP_LOG2, every other level one octave
+        int first = l == 0 ? 0 : l + ALLAN_OVERLAP_LOG2;
+        int last = l + ALLAN_OVERLAP_LOG2 < Octaves - 1 ? l + ALLAN_OVERLAP_LOG2 : Octaves - 1;
+        for (int k = first; k <= last; k++)
+        {
+            int m = 1 << (k - l);
+            if (level.count < (uint32_t)(2 * m))
+            {
+                continue;
+            }
+            const double *s0 = level.ring[level.head];
+            const double *s1 = level.ring[(level.head + RING - m) % RING];
+            const double *s2 = level.ring[(level.head + RING - 2 * m) % RING];
+            for (int c = 0; c < Channels; c++)
+            {
+                double d = (s0[c] - 2 * s1[c] + s2[c]) / m;
+                acc[k][c] += d * d;
+            }
+            terms[k]++;
+        }
+
+        if (l + 1 >= LEVELS)
+        {
+            return;
+        }
+        if (!level.pending)
+        {
+            for (int c = 0; c < Channels; c++)
+            {
+                level.carry[c] = v[c];
+            }
+            level.pending = true;
+            return;
+        }
+        double pair[Channels];
+        for (int c = 0; c < Channels; c++)
+        {
+            pair[c] = 0.5 * (level.carry[c] + v[c]);
+        }
+        level.pending = false;
+        pushLevel(l + 1, pair);
+    }
+
+    Level levels[LEVELS];
+    double acc[Octaves][Channels];
+    uint32_t terms[Octaves];
+    double reference[Channels];
+    uint32_t samples = 0;
+};
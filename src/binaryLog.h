@@ -0,0 +1,246 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+
+// Deferred-format logging. A log call stores the format string pointer and up to
+// LOG_MAX_ARGS raw pointer-sized (32-bit on the ESP32) arguments in a fixed-size record; the text is produced
+// later by whoever drains the ring. Format strings must be literals and %s arguments
+// must outlive the record (literals, globals), nothing is copied.
+#define LOG_LEVEL_ERROR 0
+#define LOG_LEVEL_WARN 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_DEBUG 3
+
+#define LOG_MAX_ARGS 4
+
+#define LOG_ARG_INT 0
+#define LOG_ARG_UINT 1
+#define LOG_ARG_FLOAT 2
+#define LOG_ARG_STR 3
+
+typedef struct
+{
+    uint32_t t_ms;
+    const char *format;
+    uint8_t level;
+    uint8_t core;
+    uint8_t argc;
+    uint8_t types; // Two bits per argument, LOG_ARG_*
+    uintptr_t args[LOG_MAX_ARGS];
+} LogRecord_t;
+
+inline void logStore(LogRecord_t &r, uint8_t type, uintptr_t bits)
+{
+    r.types |= type << (2 * r.argc);
+    r.args[r.argc++] = bits;
+}
+
+inline void logArg(LogRecord_t &r, int v) { logStore(r, LOG_ARG_INT, (uint32_t)v); }
+inline void logArg(LogRecord_t &r, long v) { logStore(r, LOG_ARG_INT, (uint32_t)v); }
+inline void logArg(LogRecord_t &r, unsigned int v) { logStore(r, LOG_ARG_UINT, v); }
+inline void logArg(LogRecord_t &r, unsigned long v) { logStore(r, LOG_ARG_UINT, (uint32_t)v); }
+inline void logArg(LogRecord_t &r, const char *v) { logStore(r, LOG_ARG_STR, (uintptr_t)v); }
+inline void logArg(LogRecord_t &r, double v)
+{
+    float f = (float)v;
+    uint32_t bits;
+    memcpy(&bits, &f, sizeof(bits));
+    logStore(r, LOG_ARG_FLOAT, bits);
+}
+
+inline void logPack(LogRecord_t &) {}
+
+template <typename T, typename... Rest>
+inline void logPack(LogRecord_t &r, T value, Rest... rest)
+{
+    logArg(r, value);
+    logPack(r, rest...);
+}
+
+// Bounded multi-producer / single-consumer ring. Producers reserve a slot with a CAS
+// on head and publish it through the slot's sequence number, so a task preempted
+// mid-write on the same core never corrupts another record. Full ring = record dropped.
+template <uint16_t N>
+class LogRing
+{
+    static_assert((N & (N - 1)) == 0, "Ring size must be a power of two");
+
+public:
+    LogRing()
+    {
+        for (uint16_t i = 0; i < N; i++)
+        {
+            seq[i].store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(const LogRecord_t &record)
+    {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        do
+        {
+            if (h - tail.load(std::memory_order_acquire) >= N)
+            {
+                dropCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        } while (!head.compare_exchange_weak(h, h + 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+        slots[h & (N - 1)] = record;
+        seq[h & (N - 1)].store(h + 1, std::memory_order_release);
+        writeCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Next published record, nullptr when empty or the oldest reservation is still being written
+    const LogRecord_t *peek() const
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        return seq[t & (N - 1)].load(std::memory_order_acquire) == t + 1 ? &slots[t & (N - 1)] : nullptr;
+    }
+
+    void pop()
+    {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        seq[t & (N - 1)].store(t + N, std::memory_order_relaxed);
+        tail.store(t + 1, std::memory_order_release);
+    }
+
+    uint32_t written() const { return writeCount.load(std::memory_order_relaxed); }
+    uint32_t drops() const { return dropCount.load(std::memory_order_relaxed); }
+
+private:
+    LogRecord_t slots[N];
+    std::atomic<uint32_t> seq[N];
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+    std::atomic<uint32_t> writeCount{0};
+    std::atomic<uint32_t> dropCount{0};
+};
+
+// Expands a record into text, one conversion at a time with the argument's stored type.
+// Length modifiers are dropped (every argument is 32-bit); returns the length.
+inline size_t logFormat(const LogRecord_t &r, char *out, size_t size)
+{
+    size_t n = 0;
+    int arg = 0;
+    const char *p = r.format;
+    while (*p && n + 1 < size)
+    {
+        if (*p != '%')
+        {
+            out[n++] = *p++;
+            continue;
+        }
+        if (p[1] == '%')
+        {
+            out[n++] = '%';
+            p += 2;
+            continue;
+        }
+
+        char spec[16];
+        size_t s = 0;
+        spec[s++] = *p++;
+        while (*p && !strchr("diuxXcsfFeEgGp", *p))
+        {
+            if (!strchr("hlzjtL", *p) && s < sizeof(spec) - 2)
+            {
+                spec[s++] = *p;
+            }
+            p++;
+        }
+        if (!*p)
+        {
+            break;
+        }
+        char conversion = *p++;
+        spec[s++] = conversion;
+        spec[s] = '\0';
+
+        int written;
+        if (arg >= r.argc)
+        {
+            written = snprintf(out + n, size - n, "?");
+        }
+        else
+        {
+            uint8_t type = (r.types >> (2 * arg)) & 3;
+            uintptr_t word = r.args[arg++];
+            uint32_t bits = (uint32_t)word;
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            if (strchr("fFeEgG", conversion))
+            {
+                double v = type == LOG_ARG_FLOAT ? f : type == LOG_ARG_INT ? (double)(int32_t)bits : (double)bits;
+                written = snprintf(out + n, size - n, spec, v);
+            }
+            else if (conversion == 's')
+            {
+                written = snprintf(out + n, size - n, spec, type == LOG_ARG_STR && word ? (const char *)word : "?");
+            }
+            else if (type == LOG_ARG_FLOAT)
+            {
+                written = snprintf(out + n, size - n, spec, (int)f);
+            }
+            else
+            {
+                written = snprintf(out + n, size - n, spec, bits);
+            }
+        }
+        if (written > 0)
+        {
+            n += (size_t)written < size - n ? (size_t)written : size - n - 1;
+        }
+    }
+    out[n] = '\0';
+    return n;
+}
+
+// One ring per core: producers only contend with tasks and ISRs of their own core
+template <uint16_t N, int Cores>
+class BinaryLog
+{
+public:
+    template <typename... Args>
+    bool write(uint8_t level, uint8_t core, uint32_t tMs, const char *format, Args... args)
+    {
+        static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "Too many log arguments");
+        LogRecord_t record;
+        record.t_ms = tMs;
+        record.format = format;
+        record.level = level;
+        record.core = core;
+        record.argc = 0;
+        record.types = 0;
+        logPack(record, args...);
+        return rings[core].push(record);
+    }
+
+    // Oldest published record over all cores (merged by timestamp), nullptr when none
+    const LogRecord_t *peek(int &core) const
+    {
+        const LogRecord_t *oldest = nullptr;
+        for (int c = 0; c < Cores; c++)
+        {
+            const LogRecord_t *r = rings[c].peek();
+            if (r && (!oldest || (int32_t)(r->t_ms - oldest->t_ms) < 0))
+            {
+                oldest = r;
+                core = c;
+            }
+        }
+        return oldest;
+    }
+
+    void pop(int core) { rings[core].pop(); }
+
+    uint32_t written(int core) const { return rings[core].written(); }
+    uint32_t drops(int core) const { return rings[core].drops(); }
+
+private:
+    LogRing<N> rings[Cores];
+};
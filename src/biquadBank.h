@@ -0,0 +1,167 @@
+#pragma once
+
+#include <stdint.h>
+
+// Biquad cascades designed at compile time and run over several channels at once.
+// Coefficients come from the RBJ cookbook formulas evaluated by constexpr functions, so
+// a topology table costs no flash for trig and no time at boot. Every topology has the
+// same number of sections (unused ones are pass-through), which keeps the per-sample
+// loop free of branches: sections outside, channels inside, each coefficient and state
+// variable in its own array (structure of arrays), transposed direct form II.
+namespace biquad
+{
+constexpr double PI = 3.14159265358979323846;
+
+// sin/cos by Taylor series after reduction to [-π, π], good to ~1e-15 there
+constexpr double reduce(double x)
+{
+    while (x > PI)
+    {
+        x -= 2 * PI;
+    }
+    while (x < -PI)
+    {
+        x += 2 * PI;
+    }
+    return x;
+}
+
+constexpr double sin(double x)
+{
+    x = reduce(x);
+    double term = x, sum = x;
+    for (int n = 1; n < 20; n++)
+    {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double cos(double x)
+{
+    return sin(x + PI / 2);
+}
+} // namespace biquad
+
+typedef struct
+{
+    float b0, b1, b2; // Normalized by a0
+    float a1, a2;
+} BiquadCoefficients_t;
+
+constexpr BiquadCoefficients_t biquadNormalize(double b0, double b1, double b2, double a0, double a1, double a2)
+{
+    return {(float)(b0 / a0), (float)(b1 / a0), (float)(b2 / a0), (float)(a1 / a0), (float)(a2 / a0)};
+}
+
+constexpr BiquadCoefficients_t biquadIdentity()
+{
+    return {1, 0, 0, 0, 0};
+}
+
+// Second-order low-pass, Q = 0.7071 is Butterworth
+constexpr BiquadCoefficients_t biquadLowPass(double f0, double fs, double q)
+{
+    double w0 = 2 * biquad::PI * f0 / fs;
+    double alpha = biquad::sin(w0) / (2 * q);
+    double c = biquad::cos(w0);
+    return biquadNormalize((1 - c) / 2, 1 - c, (1 - c) / 2, 1 + alpha, -2 * c, 1 - alpha);
+}
+
+// Notch at f0, −3 dB bandwidth f0 / q
+constexpr BiquadCoefficients_t biquadNotch(double f0, double fs, double q)
+{
+    double w0 = 2 * biquad::PI * f0 / fs;
+    double alpha = biquad::sin(w0) / (2 * q);
+    double c = biquad::cos(w0);
+    return biquadNormalize(1, -2 * c, 1, 1 + alpha, -2 * c, 1 - alpha);
+}
+
+// Gain at DC, for compile-time checks of a design
+constexpr double biquadDcGain(const BiquadCoefficients_t &s)
+{
+    return ((double)s.b0 + s.b1 + s.b2) / (1.0 + s.a1 + s.a2);
+}
+
+template <int Sections>
+struct BiquadCascade
+{
+    BiquadCoefficients_t sections[Sections];
+};
+
+template <int Sections>
+constexpr double biquadDcGain(const BiquadCascade<Sections> &cascade)
+{
+    double gain = 1;
+    for (int i = 0; i < Sections; i++)
+    {
+        gain *= biquadDcGain(cascade.sections[i]);
+    }
+    return gain;
+}
+
+template <int Channels, int Sections>
+class BiquadBank
+{
+public:
+    // Per channel, from the precompiled topologies. Starts settled at value (no step response).
+    void select(int channel, const BiquadCascade<Sections> &cascade, float value = 0)
+    {
+        for (int s = 0; s < Sections; s++)
+        {
+            const BiquadCoefficients_t &k = cascade.sections[s];
+            b0[s][channel] = k.b0;
+            b1[s][channel] = k.b1;
+            b2[s][channel] = k.b2;
+            a1[s][channel] = k.a1;
+            a2[s][channel] = k.a2;
+        }
+        prime(channel, value);
+    }
+
+    // State of a channel that has been at value forever
+    void prime(int channel, float value)
+    {
+        float x = value;
+        for (int s = 0; s < Sections; s++)
+        {
+            float y = x * (b0[s][channel] + b1[s][channel] + b2[s][channel]) / (1 + a1[s][channel] + a2[s][channel]);
+            z2[s][channel] = b2[s][channel] * x - a2[s][channel] * y;
+            z1[s][channel] = y - b0[s][channel] * x;
+            x = y;
+        }
+    }
+
+    void process(const float in[Channels], float out[Channels])
+    {
+        float x[Channels];
+        for (int c = 0; c < Channels; c++)
+        {
+            x[c] = in[c];
+        }
+        for (int s = 0; s < Sections; s++)
+        {
+            for (int c = 0; c < Channels; c++)
+            {
+                float y = b0[s][c] * x[c] + z1[s][c];
+                z1[s][c] = b1[s][c] * x[c] - a1[s][c] * y + z2[s][c];
+                z2[s][c] = b2[s][c] * x[c] - a2[s][c] * y;
+                x[c] = y;
+            }
+        }
+        for (int c = 0; c < Channels; c++)
+        {
+            out[c] = x[c];
+        }
+    }
+
+private:
+    float b0[Sections][Channels];
+    float b1[Sections][Channels];
+    float b2[Sections][Channels];
+    float a1[Sections][Channels];
+    float a2[Sections][Channels];
+    float z1[Sections][Channels] = {};
+    float z2[Sections][Channels] = {};
+};
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <stdint.h>
+
+// Push button and status LED state machines, free of the RTOS: the firmware's ISR and
+// software timers call in, times are passed by the caller (the tick count in ms on
+// target, the time base of the timers) and pins go through the functions given to
+// begin(). Callers serialise access (the timer task, ledMux for the LEDs).
+
+enum ButtonEvent
+{
+    BUTTON_NONE,
+    BUTTON_DOWN,        // Settled press, start the long-press timer
+    BUTTON_SHORT_PRESS, // Released before the long-press time
+    BUTTON_RELEASED     // Released after a long press
+};
+
+// Any edge restarts the debounce time; the level is read once it has been stable for
+// debounceMs. A press held for longPressMs is reported once by longPressDue().
+class ButtonDebouncer
+{
+public:
+    void begin(bool (*readPin)(), uint32_t debounceMs, uint32_t longPressMs)
+    {
+        read = readPin;
+        debounce = debounceMs;
+        longPress = longPressMs;
+        pressed = false;
+        longHandled = false;
+        edgeCount = 0;
+    }
+
+    // From the edge ISR, so forced inline to stay in IRAM
+    inline __attribute__((always_inline)) void edge(uint32_t nowMs)
+    {
+        lastEdgeMs = nowMs;
+        edgeCount++;
+    }
+
+    // When the debounce time may have passed; an edge since then defers to its own timer
+    ButtonEvent settle(uint32_t nowMs)
+    {
+        if (nowMs - lastEdgeMs < debounce)
+        {
+            return BUTTON_NONE;
+        }
+        bool down = read();
+        if (down && !pressed)
+        {
+            pressed = true;
+            longHandled = false;
+            pressStartMs = nowMs;
+            return BUTTON_DOWN;
+        }
+        if (!down && pressed)
+        {
+            pressed = false;
+            return !longHandled && nowMs - pressStartMs < longPress ? BUTTON_SHORT_PRESS : BUTTON_RELEASED;
+        }
+        return BUTTON_NONE;
+    }
+
+    // True once per press, when it has been held for longPressMs
+    bool longPressDue(uint32_t nowMs)
+    {
+        if (!pressed || longHandled || nowMs - pressStartMs < longPress)
+        {
+            return false;
+        }
+        longHandled = true;
+        return true;
+    }
+
+    bool isPressed() const { return pressed; }
+    uint32_t edges() const { return edgeCount; }
+
+private:
+    bool (*read)() = nullptr;
+    uint32_t debounce = 0;
+    uint32_t longPress = 0;
+    volatile uint32_t lastEdgeMs = 0; // Written by the ISR
+    volatile uint32_t edgeCount = 0;
+    uint32_t pressStartMs = 0;
+    bool pressed = false;
+    bool longHandled = false;
+};
+
+// Each LED has an idle level and an optional blink pattern: on for onMs, off for offMs,
+// count times (-1 = forever), then back to the idle level. tick() runs the transitions
+// that are due and returns the wait until the next one, so a one-shot timer only wakes
+// up for actual transitions.
+#define LED_NO_CHANGE 0xFFFFFFFFu // All LEDs idle, nothing to schedule
+
+typedef struct
+{
+    uint8_t pin;
+    bool level;        // Current output
+    bool idleLevel;    // Output when no pattern is running
+    uint16_t onMs;
+    uint16_t offMs;
+    int16_t remaining; // Blinks left, -1 = forever, 0 = idle
+    uint32_t nextChangeMs;
+} LedChannel_t;
+
+template <int Count>
+class LedPatterns
+{
+public:
+    // Drives every LED to its idle level
+    void begin(void (*writePin)(uint8_t pin, bool level), const uint8_t pins[], const bool idleLevels[])
+    {
+        write = writePin;
+        for (int i = 0; i < Count; i++)
+        {
+            leds[i] = {pins[i], idleLevels[i], idleLevels[i], 0, 0, 0, 0};
+            write(pins[i], idleLevels[i]);
+        }
+    }
+
+    // Solid level, shown once a running pattern ends
+    void setIdle(int id, bool level)
+    {
+        leds[id].idleLevel = level;
+        if (leds[id].remaining == 0)
+        {
+            leds[id].level = level;
+            write(leds[id].pin, level);
+        }
+    }
+
+    // Starts on; count 0 just turns the LED on and leaves it there
+    void blink(int id, uint16_t onMs, uint16_t offMs, int16_t count, uint32_t nowMs)
+    {
+        LedChannel_t &led = leds[id];
+        led.onMs = onMs;
+        led.offMs = offMs;
+        led.remaining = count;
+        led.level = true;
+        led.nextChangeMs = nowMs + onMs;
+        write(led.pin, true);
+    }
+
+    uint32_t tick(uint32_t nowMs)
+    {
+        for (int i = 0; i < Count; i++)
+        {
+            LedChannel_t &led = leds[i];
+            if (led.remaining == 0 || (int32_t)(nowMs - led.nextChangeMs) < 0)
+            {
+                continue;
+            }
+
+            if (led.level)
+            {
+                led.level = false;
+                led.nextChangeMs = nowMs + led.offMs;
+                if (led.remaining > 0 && --led.remaining == 0)
+                {
+                    led.level = led.idleLevel; // Pattern finished
+                }
+            }
+            else
+            {
+                led.level = true;
+                led.nextChangeMs = nowMs + led.onMs;
+            }
+            write(led.pin, led.level);
+        }
+        return nextWait(nowMs);
+    }
+
+    // Until the earliest pending transition, at least 1 ms; LED_NO_CHANGE when all are idle
+    uint32_t nextWait(uint32_t nowMs) const
+    {
+        uint32_t wait = LED_NO_CHANGE;
+        for (int i = 0; i < Count; i++)
+        {
+            if (leds[i].remaining != 0)
+            {
+                uint32_t left = (int32_t)(leds[i].nextChangeMs - nowMs) > 0 ? leds[i].nextChangeMs - nowMs : 1;
+                wait = left < wait ? left : wait;
+            }
+        }
+        return wait;
+    }
+
+    bool level(int id) const { return leds[id].level; }
+    bool running(int id) const { return leds[id].remaining != 0; }
+
+private:
+    void (*write)(uint8_t pin, bool level) = nullptr;
+    LedChannel_t leds[Count] = {};
+};
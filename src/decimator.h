@@ -0,0 +1,161 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+// Two-stage decimator for the raw capture stream:
+//   stage 1: CIC (order CIC_ORDER) decimating by cicRate, cheap integer rejection of high-rate noise
+//   stage 2: windowed-sinc FIR decimating by firRate, flattens the passband and removes CIC aliases
+// Inputs are integers (RTD codes, mV, uA); CIC registers are uint64_t so wrap-around is well defined.
+#define CIC_ORDER 3
+#define FIR_MAX_TAPS 129
+
+template <int Channels>
+class CicFirDecimator
+{
+public:
+    void begin(uint16_t cicRate, uint16_t firRate)
+    {
+        cicR = cicRate < 1 ? 1 : cicRate;
+        firR = firRate < 1 ? 1 : firRate;
+        cicGain = powf((float)cicR, CIC_ORDER);
+
+        // Blackman windowed sinc, cutoff a little under the output Nyquist
+        numTaps = 4 * firR + 1;
+        if (numTaps > FIR_MAX_TAPS)
+        {
+            numTaps = FIR_MAX_TAPS;
+        }
+        float fc = 0.4f / firR; // cycles per input sample
+        float sum = 0;
+        int mid = numTaps / 2;
+        for (int i = 0; i < numTaps; i++)
+        {
+            int n = i - mid;
+            float sinc = (n == 0) ? 2 * fc : sinf(2 * (float)M_PI * fc * n) / ((float)M_PI * n);
+            float w = 0.42f - 0.5f * cosf(2 * (float)M_PI * i / (numTaps - 1)) + 0.08f * cosf(4 * (float)M_PI * i / (numTaps - 1));
+            taps[i] = sinc * w;
+            sum += taps[i];
+        }
+        for (int i = 0; i < numTaps; i++)
+        {
+            taps[i] /= sum; // Unity DC gain
+        }
+
+        reset();
+    }
+
+    void reset()
+    {
+        for (int c = 0; c < Channels; c++)
+        {
+            for (int s = 0; s < CIC_ORDER; s++)
+            {
+                integrator[c][s] = 0;
+                combDelay[c][s] = 0;
+            }
+            for (int i = 0; i < FIR_MAX_TAPS; i++)
+            {
+                history[c][i] = 0;
+            }
+        }
+        cicCount = 0;
+        firCount = 0;
+        firPos = 0;
+        settled = 0;
+    }
+
+    // Feed one input sample per channel; returns true and fills out[] when a decimated sample is ready
+    bool push(const int32_t in[Channels], float out[Channels])
+    {
+        for (int c = 0; c < Channels; c++)
+        {
+            uint64_t acc = (uint64_t)(int64_t)in[c];
+            for (int s = 0; s < CIC_ORDER; s++)
+            {
+                integrator[c][s] += acc;
+                acc = integrator[c][s];
+            }
+        }
+
+        if (++cicCount < cicR)
+        {
+            return false;
+        }
+        cicCount = 0;
+
+        // Comb section at the CIC output rate, then into the FIR history
+        for (int c = 0; c < Channels; c++)
+        {
+            uint64_t acc = integrator[c][CIC_ORDER - 1];
+            for (int s = 0; s < CIC_ORDER; s++)
+            {
+                uint64_t prev = combDelay[c][s];
+                combDelay[c][s] = acc;
+                acc -= prev;
+            }
+            cicOut[c] = (float)(int64_t)acc / cicGain;
+        }
+
+        // The first CIC_ORDER outputs are start-up transients of the comb section
+        if (settled < CIC_ORDER)
+        {
+            settled++;
+            return false;
+        }
+
+        for (int c = 0; c < Channels; c++)
+        {
+            if (settled == CIC_ORDER)
+            {
+                // Prime the FIR window with the first valid value so output starts without a long ramp
+                for (int i = 0; i < numTaps; i++)
+                {
+                    history[c][i] = cicOut[c];
+                }
+            }
+            history[c][firPos] = cicOut[c];
+        }
+        settled = CIC_ORDER + 1;
+        firPos = (firPos + 1) % numTaps;
+
+        if (++firCount < firR)
+        {
+            return false;
+        }
+        firCount = 0;
+
+        for (int c = 0; c < Channels; c++)
+        {
+            float acc = 0;
+            int idx = firPos;
+            for (int i = 0; i < numTaps; i++)
+            {
+                acc += taps[i] * history[c][idx];
+                idx = (idx + 1 == numTaps) ? 0 : idx + 1;
+            }
+            out[c] = acc;
+        }
+        return true;
+    }
+
+    // Number of input samples before the first output is produced
+    uint32_t latency() const { return (uint32_t)cicR * (CIC_ORDER + firR); }
+
+private:
+    uint16_t cicR = 1;
+    uint16_t firR = 1;
+    float cicGain = 1;
+    int numTaps = 1;
+    float taps[FIR_MAX_TAPS];
+
+    uint64_t integrator[Channels][CIC_ORDER];
+    uint64_t combDelay[Channels][CIC_ORDER];
+    float history[Channels][FIR_MAX_TAPS];
+
+    uint16_t cicCount = 0;
+    uint16_t firCount = 0;
+    int firPos = 0;
+    int settled = 0;
+    float cicOut[Channels];
+};
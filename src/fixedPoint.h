@@ -0,0 +1,166 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Signed fixed-point value with FracBits fractional bits stored in 32 bits.
+// The scaling is part of the type, so mixing formats needs an explicit rescale<>().
+template <int FracBits>
+struct Fixed
+{
+    static_assert(FracBits >= 0 && FracBits < 31, "FracBits out of range");
+    static const int32_t ONE = (int32_t)1 << FracBits;
+
+    int32_t raw;
+
+    static Fixed fromRaw(int32_t r)
+    {
+        Fixed f;
+        f.raw = r;
+        return f;
+    }
+
+    // Boundary conversions only (sensor libraries return float)
+    static Fixed fromFloat(float v) { return fromRaw((int32_t)(v * ONE + (v >= 0 ? 0.5f : -0.5f))); }
+    float toFloat() const { return (float)raw / ONE; }
+
+    Fixed operator+(Fixed o) const { return fromRaw(raw + o.raw); }
+    Fixed operator-(Fixed o) const { return fromRaw(raw - o.raw); }
+    bool operator<(Fixed o) const { return raw < o.raw; }
+    bool operator>(Fixed o) const { return raw > o.raw; }
+
+    Fixed operator*(Fixed o) const { return fromRaw((int32_t)(((int64_t)raw * o.raw) >> FracBits)); }
+    Fixed operator/(Fixed o) const { return fromRaw(o.raw ? (int32_t)(((int64_t)raw << FracBits) / o.raw) : 0); }
+
+    Fixed abs() const { return fromRaw(raw < 0 ? -raw : raw); }
+
+    template <int ToBits>
+    Fixed<ToBits> rescale() const
+    {
+        return Fixed<ToBits>::fromRaw(ToBits >= FracBits ? raw << (ToBits - FracBits) : raw >> (FracBits - ToBits));
+    }
+};
+
+typedef Fixed<16> Q16; // Q16.16: K, V, mA, mW, mm and W/m·K all fit in ±32767
+
+// Median of a small window of fixed-point values (insertion sort, window copied by the caller)
+template <int FracBits>
+Fixed<FracBits> fixedMedian(Fixed<FracBits> samples[], int size)
+{
+    for (int i = 1; i < size; i++)
+    {
+        Fixed<FracBits> v = samples[i];
+        int j = i - 1;
+        while (j >= 0 && samples[j].raw > v.raw)
+        {
+            samples[j + 1] = samples[j];
+            j--;
+        }
+        samples[j + 1] = v;
+    }
+    return samples[size / 2];
+}
+
+// k = (P[mW] · L[mm]) / (A[mm²] · |ΔT|[K] · 1000), integer only.
+// Numerator is kept in Q32 and the denominator in Q16 so the quotient lands in Q16.
+inline Q16 fixedConductivity(Q16 power, Q16 thickness, Q16 area, Q16 dT)
+{
+    int64_t num = (int64_t)power.raw * thickness.raw;           // Q32
+    int64_t den = (((int64_t)area.raw * dT.abs().raw) >> 16) * 1000; // Q16
+    if (den <= 0 || num <= 0)
+    {
+        return Q16::fromRaw(0);
+    }
+    int64_t k = num / den;
+    return Q16::fromRaw(k > INT32_MAX ? INT32_MAX : (int32_t)k);
+}
+
+// Integer-only decimal formatting with round-half-up, returns the string length as
+// written (truncated to size - 1, nothing written when size is 0)
+template <int FracBits>
+size_t formatFixed(char *buf, size_t size, Fixed<FracBits> v, int decimals)
+{
+    if (size == 0)
+    {
+        return 0;
+    }
+    static const uint32_t pow10[] = {1, 10, 100, 1000, 10000, 100000};
+    if (decimals < 0)
+    {
+        decimals = 0;
+    }
+    if (decimals > 5)
+    {
+        decimals = 5;
+    }
+
+    bool negative = v.raw < 0;
+    uint64_t mag = negative ? (uint64_t)(-(int64_t)v.raw) : (uint64_t)v.raw;
+    // Scale to an integer count of 10^-decimals units
+    uint64_t scaled = (mag * pow10[decimals] + ((uint64_t)1 << FracBits >> 1)) >> FracBits;
+    uint32_t whole = (uint32_t)(scaled / pow10[decimals]);
+    uint32_t frac = (uint32_t)(scaled % pow10[decimals]);
+
+    char tmp[24];
+    size_t n = 0;
+    for (int i = 0; i < decimals; i++)
+    {
+        tmp[n++] = '0' + frac % 10;
+        frac /= 10;
+    }
+    if (decimals > 0)
+    {
+        tmp[n++] = '.';
+    }
+    do
+    {
+        tmp[n++] = '0' + whole % 10;
+        whole /= 10;
+    } while (whole);
+    if (negative && scaled != 0)
+    {
+        tmp[n++] = '-';
+    }
+
+    size_t len = 0;
+    while (n > 0 && len + 1 < size)
+    {
+        buf[len++] = tmp[--n];
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+// RTD code -> kelvin by linear interpolation in a table built once at boot,
+// so the per-sample conversion needs no sqrt or float math
+#define RTD_TABLE_SHIFT 7 // 128 codes per segment
+#define RTD_TABLE_SIZE ((32768 >> RTD_TABLE_SHIFT) + 1)
+
+class RtdTable
+{
+public:
+    template <typename Convert>
+    void build(Convert codeToKelvin)
+    {
+        for (int i = 0; i < RTD_TABLE_SIZE; i++)
+        {
+            table[i] = Q16::fromFloat(codeToKelvin((float)(i << RTD_TABLE_SHIFT)));
+        }
+    }
+
+    Q16 kelvin(uint16_t code) const
+    {
+        uint32_t idx = code >> RTD_TABLE_SHIFT;
+        if (idx >= RTD_TABLE_SIZE - 1)
+        {
+            return table[RTD_TABLE_SIZE - 1];
+        }
+        int32_t frac = code & ((1 << RTD_TABLE_SHIFT) - 1);
+        int32_t lo = table[idx].raw;
+        int32_t hi = table[idx + 1].raw;
+        return Q16::fromRaw(lo + (int32_t)(((int64_t)(hi - lo) * frac) >> RTD_TABLE_SHIFT));
+    }
+
+private:
+    Q16 table[RTD_TABLE_SIZE];
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <math.h>
+
+// Online fit of a first-order approach to equilibrium, dΔT/dt = (ΔT∞ − ΔT)/τ.
+// Integrated from the first sample it is linear in the parameters:
+//   ΔT(t) = d + c0·t + c1·∫ΔT dt,   c0 = ΔT∞/τ,  c1 = −1/τ
+// which recursive least squares with exponential forgetting solves in O(1) per
+// sample, also for the uneven intervals of adaptive sampling. The integral form
+// keeps the RTD noise white (a difference form would amplify it), and the
+// forgetting lets the fit follow a higher-order response as its slow mode takes over.
+#define FORECAST_MIN_SAMPLES 20
+#define FORECAST_PARAMS 3
+
+class SteadyStateForecast
+{
+public:
+    void begin(double forgetting)
+    {
+        lambda = forgetting;
+        reset();
+    }
+
+    // Call on a step in heater power, the old asymptote no longer applies
+    void reset()
+    {
+        for (int i = 0; i < FORECAST_PARAMS; i++)
+        {
+            theta[i] = 0;
+            for (int j = 0; j < FORECAST_PARAMS; j++)
+            {
+                P[i][j] = i == j ? 1e6 : 0;
+            }
+        }
+        residualVar = 0;
+        integral = 0;
+        n = 0;
+        primed = false;
+    }
+
+    void update(double tSeconds, double y)
+    {
+        if (!primed)
+        {
+            primed = true;
+            t0 = tSeconds;
+        }
+        else
+        {
+            double dt = tSeconds - lastT;
+            if (dt <= 0)
+            {
+                return;
+            }
+            integral += 0.5 * (y + lastY) * dt;
+        }
+        lastT = tSeconds;
+        lastY = y;
+
+        double phi[FORECAST_PARAMS] = {1, tSeconds - t0, integral};
+        double Pphi[FORECAST_PARAMS];
+        double error = y;
+        double denom = lambda;
+        for (int i = 0; i < FORECAST_PARAMS; i++)
+        {
+            error -= phi[i] * theta[i];
+            Pphi[i] = 0;
+            for (int j = 0; j < FORECAST_PARAMS; j++)
+            {
+                Pphi[i] += P[i][j] * phi[j];
+            }
+            denom += phi[i] * Pphi[i];
+        }
+        for (int i = 0; i < FORECAST_PARAMS; i++)
+        {
+            theta[i] += Pphi[i] / denom * error;
+            for (int j = 0; j < FORECAST_PARAMS; j++)
+            {
+                P[i][j] = (P[i][j] - Pphi[i] * Pphi[j] / denom) / lambda;
+            }
+        }
+        if (n >= FORECAST_PARAMS)
+        {
+            // A priori residuals, skipping the ones before the fit is determined
+            residualVar = n == FORECAST_PARAMS ? error * error : lambda * residualVar + (1 - lambda) * error * error;
+        }
+        n++;
+    }
+
+    int count() const { return n; }
+
+    // The fit describes an approach to equilibrium (finite, positive τ)
+    bool valid() const { return n >= FORECAST_MIN_SAMPLES && theta[2] < 0 && -1 / theta[2] < 1e6; }
+
+    double asymptote() const { return theta[2] < 0 ? -theta[1] / theta[2] : lastY; }
+    double tau() const { return theta[2] < 0 ? -1 / theta[2] : INFINITY; }
+
+    // Standard uncertainty of the asymptote (delta method on the parameter covariance)
+    double asymptoteUnc() const
+    {
+        if (theta[2] >= 0)
+        {
+            return INFINITY;
+        }
+        double g1 = -1 / theta[2];
+        double g2 = theta[1] / (theta[2] * theta[2]);
+        double var = residualVar * (g1 * g1 * P[1][1] + 2 * g1 * g2 * P[1][2] + g2 * g2 * P[2][2]);
+        return var > 0 ? sqrt(var) : 0;
+    }
+
+    // Seconds from the last sample until ΔT is within tolerance of the asymptote
+    double timeToEquilibrium(double tolerance) const
+    {
+        if (!valid())
+        {
+            return INFINITY;
+        }
+        double remaining = fabs(asymptote() - lastY);
+        return remaining <= tolerance ? 0 : tau() * log(remaining / tolerance);
+    }
+
+private:
+    double lambda = 0.995;
+    double theta[FORECAST_PARAMS] = {};
+    double P[FORECAST_PARAMS][FORECAST_PARAMS] = {};
+    double residualVar = 0;
+    double integral = 0;
+    double t0 = 0;
+    double lastT = 0;
+    double lastY = 0;
+    bool primed = false;
+    int n = 0;
+};
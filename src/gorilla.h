@@ -0,0 +1,344 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Gorilla-style compression of a multi-channel time series into fixed-size blocks.
+// Timestamps are delta-of-delta coded. Each channel is a 32-bit word, coded either
+//   SERIES_CODEC_XOR:    XOR with the previous value, leading/trailing zeros elided (float bit patterns)
+//   SERIES_CODEC_VARINT: delta to the previous value, zigzag + varint (fixed-point raw values)
+// The first record of a block is stored verbatim, so every block decodes on its own.
+#define SERIES_CODEC_XOR 1
+#define SERIES_CODEC_VARINT 2
+
+// MSB-first bit stream over a caller buffer
+class BitWriter
+{
+public:
+    void begin(uint8_t *buffer, size_t capacityBytes)
+    {
+        buf = buffer;
+        capacity = capacityBytes * 8;
+        bits = 0;
+        memset(buf, 0, capacityBytes);
+    }
+
+    void write(uint32_t value, int n)
+    {
+        for (int i = n - 1; i >= 0; i--)
+        {
+            if (value >> i & 1)
+            {
+                buf[bits >> 3] |= 0x80 >> (bits & 7);
+            }
+            bits++;
+        }
+    }
+
+    size_t bitCount() const { return bits; }
+    size_t freeBits() const { return capacity - bits; }
+    size_t bytes() const { return (bits + 7) / 8; }
+
+private:
+    uint8_t *buf = nullptr;
+    size_t capacity = 0;
+    size_t bits = 0;
+};
+
+class BitReader
+{
+public:
+    void begin(const uint8_t *buffer, size_t lengthBytes)
+    {
+        buf = buffer;
+        length = lengthBytes * 8;
+        pos = 0;
+    }
+
+    uint32_t read(int n)
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < n; i++)
+        {
+            uint32_t bit = pos < length ? buf[pos >> 3] >> (7 - (pos & 7)) & 1 : 0;
+            value = value << 1 | bit;
+            pos++;
+        }
+        return value;
+    }
+
+    bool overrun() const { return pos > length; }
+
+    // Invalid data: marks the reader as overrun, later reads return zeros
+    void fail() { pos = length + 1; }
+
+private:
+    const uint8_t *buf = nullptr;
+    size_t length = 0;
+    size_t pos = 0;
+};
+
+template <int Channels>
+class SeriesEncoder
+{
+public:
+    // Largest record: 36 timestamp bits plus 44 (XOR) or 40 (varint) bits per channel
+    static const size_t MAX_RECORD_BITS = 36 + 44 * Channels;
+
+    void begin(uint8_t *buffer, size_t capacityBytes, uint8_t seriesCodec)
+    {
+        out.begin(buffer, capacityBytes);
+        codec = seriesCodec;
+        records = 0;
+    }
+
+    // Returns false when the record does not fit, the block is then complete
+    bool append(uint32_t t, const uint32_t words[Channels])
+    {
+        if (out.freeBits() < MAX_RECORD_BITS)
+        {
+            return false;
+        }
+
+        if (records == 0)
+        {
+            tFirst = t;
+            prevDelta = 0;
+            for (int c = 0; c < Channels; c++)
+            {
+                out.write(words[c], 32);
+                prev[c] = words[c];
+                leading[c] = 0xFF;
+                trailing[c] = 0;
+            }
+        }
+        else
+        {
+            int32_t delta = (int32_t)(t - tLast);
+            writeTimestamp((int32_t)((uint32_t)delta - (uint32_t)prevDelta));
+            prevDelta = delta;
+            for (int c = 0; c < Channels; c++)
+            {
+                if (codec == SERIES_CODEC_XOR)
+                {
+                    writeXor(c, words[c]);
+                }
+                else
+                {
+                    writeVarint((int32_t)(words[c] - prev[c]));
+                }
+                prev[c] = words[c];
+            }
+        }
+        tLast = t;
+        records++;
+        return true;
+    }
+
+    uint16_t count() const { return records; }
+    uint32_t firstTime() const { return tFirst; }
+    uint32_t lastTime() const { return tLast; }
+    size_t bytes() const { return out.bytes(); }
+    uint8_t seriesCodec() const { return codec; }
+
+private:
+    void writeTimestamp(int32_t dod)
+    {
+        if (dod == 0)
+        {
+            out.write(0, 1);
+        }
+        else if (dod >= -63 && dod <= 64)
+        {
+            out.write(0x2, 2);
+            out.write((uint32_t)(dod + 63), 7);
+        }
+        else if (dod >= -255 && dod <= 256)
+        {
+            out.write(0x6, 3);
+            out.write((uint32_t)(dod + 255), 9);
+        }
+        else if (dod >= -2047 && dod <= 2048)
+        {
+            out.write(0xE, 4);
+            out.write((uint32_t)(dod + 2047), 12);
+        }
+        else
+        {
+            out.write(0xF, 4);
+            out.write((uint32_t)dod, 32);
+        }
+    }
+
+    void writeXor(int c, uint32_t value)
+    {
+        uint32_t x = value ^ prev[c];
+        if (x == 0)
+        {
+            out.write(0, 1);
+            return;
+        }
+        out.write(1, 1);
+
+        int lead = __builtin_clz(x);
+        int trail = __builtin_ctz(x);
+        if (leading[c] != 0xFF && lead >= leading[c] && trail >= trailing[c])
+        {
+            // Fits in the previous window
+            out.write(0, 1);
+            out.write(x >> trailing[c], 32 - leading[c] - trailing[c]);
+            return;
+        }
+        int length = 32 - lead - trail;
+        out.write(1, 1);
+        out.write(lead, 5);
+        out.write(length - 1, 5);
+        out.write(x >> trail, length);
+        leading[c] = lead;
+        trailing[c] = trail;
+    }
+
+    void writeVarint(int32_t delta)
+    {
+        uint32_t zz = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+        while (zz >= 0x80)
+        {
+            out.write((zz & 0x7F) | 0x80, 8);
+            zz >>= 7;
+        }
+        out.write(zz, 8);
+    }
+
+    BitWriter out;
+    uint8_t codec = SERIES_CODEC_XOR;
+    uint16_t records = 0;
+    uint32_t tFirst = 0;
+    uint32_t tLast = 0;
+    int32_t prevDelta = 0;
+    uint32_t prev[Channels];
+    uint8_t leading[Channels];
+    uint8_t trailing[Channels];
+};
+
+template <int Channels>
+class SeriesDecoder
+{
+public:
+    void begin(const uint8_t *buffer, size_t lengthBytes, uint8_t seriesCodec, uint16_t recordCount, uint32_t firstTime)
+    {
+        in.begin(buffer, lengthBytes);
+        codec = seriesCodec;
+        remaining = recordCount;
+        t = firstTime;
+        index = 0;
+        prevDelta = 0;
+    }
+
+    bool next(uint32_t &time, uint32_t words[Channels])
+    {
+        if (remaining == 0)
+        {
+            return false;
+        }
+
+        if (index == 0)
+        {
+            for (int c = 0; c < Channels; c++)
+            {
+                prev[c] = in.read(32);
+                leading[c] = 0;
+                trailing[c] = 0;
+            }
+        }
+        else
+        {
+            prevDelta = (int32_t)((uint32_t)prevDelta + (uint32_t)readTimestamp()); // Wraps on corrupt input
+            t += prevDelta;
+            for (int c = 0; c < Channels; c++)
+            {
+                prev[c] = codec == SERIES_CODEC_XOR ? prev[c] ^ readXor(c) : prev[c] + (uint32_t)readVarint();
+            }
+        }
+
+        time = t;
+        memcpy(words, prev, sizeof(prev));
+        index++;
+        remaining--;
+        if (in.overrun())
+        {
+            remaining = 0; // Corrupt or truncated, nothing after this is trusted
+            return false;
+        }
+        return true;
+    }
+
+private:
+    int32_t readTimestamp()
+    {
+        if (in.read(1) == 0)
+        {
+            return 0;
+        }
+        if (in.read(1) == 0)
+        {
+            return (int32_t)in.read(7) - 63;
+        }
+        if (in.read(1) == 0)
+        {
+            return (int32_t)in.read(9) - 255;
+        }
+        if (in.read(1) == 0)
+        {
+            return (int32_t)in.read(12) - 2047;
+        }
+        return (int32_t)in.read(32);
+    }
+
+    uint32_t readXor(int c)
+    {
+        if (in.read(1) == 0)
+        {
+            return 0;
+        }
+        if (in.read(1) == 0)
+        {
+            return in.read(32 - leading[c] - trailing[c]) << trailing[c];
+        }
+        int lead = in.read(5);
+        int length = in.read(5) + 1;
+        if (lead + length > 32)
+        {
+            in.fail(); // No encoder writes this, the block is corrupt
+            return 0;
+        }
+        leading[c] = lead;
+        trailing[c] = 32 - lead - length;
+        return in.read(length) << trailing[c];
+    }
+
+    int32_t readVarint()
+    {
+        uint32_t zz = 0;
+        for (int shift = 0; shift < 35; shift += 7)
+        {
+            uint32_t byte = in.read(8);
+            zz |= (byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+            {
+                break;
+            }
+        }
+        return (int32_t)(zz >> 1) ^ -(int32_t)(zz & 1);
+    }
+
+    BitReader in;
+    uint8_t codec = SERIES_CODEC_XOR;
+    uint16_t remaining = 0;
+    uint16_t index = 0;
+    uint32_t t = 0;
+    int32_t prevDelta = 0;
+    uint32_t prev[Channels];
+    uint8_t leading[Channels];
+    uint8_t trailing[Channels];
+};
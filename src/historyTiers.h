@@ -0,0 +1,288 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+// Min/max/mean history at several resolutions (e.g. 1 s, 10 s, 1 min, 10 min). Each
+// tier keeps a ring of its newest Buckets buckets plus the one being filled, and add()
+// updates every tier in O(Tiers × Channels). Only buckets that got a sample are stored,
+// so a tier finer than the sampling interval covers more than Buckets × resolution.
+// query() takes the coarsest tier that still resolves the requested number of points
+// over the range (or a coarser one if it does not reach back far enough) and merges its
+// buckets into at most that many points: the cost follows the points, not the samples.
+// NaN readings are left out of min, max and mean. add() and query() from the same task,
+// there is no locking.
+template <int Channels>
+struct HistoryPoint
+{
+    uint32_t tMs;   // Start of the bin
+    uint32_t count; // Samples in it
+    float min[Channels];
+    float max[Channels];
+    float mean[Channels];
+};
+
+template <int Channels, int Tiers, int Buckets>
+class HistoryTiers
+{
+    static_assert(Buckets > 1, "A tier needs at least two buckets");
+
+public:
+    // Resolutions finest first, each a multiple of the one before
+    void begin(const uint32_t resolutionMs[Tiers])
+    {
+        for (int i = 0; i < Tiers; i++)
+        {
+            resolution[i] = resolutionMs[i];
+            head[i] = 0;
+            length[i] = 0;
+            open[i].active = false;
+        }
+        sampleCount = 0;
+    }
+
+    void add(uint32_t tMs, const float values[Channels])
+    {
+        for (int i = 0; i < Tiers; i++)
+        {
+            OpenBucket &o = open[i];
+            uint32_t start = tMs - tMs % resolution[i];
+            if (o.active && start > o.bucket.tMs)
+            {
+                close(i);
+            }
+            if (!o.active)
+            {
+                o.active = true;
+                o.bucket.tMs = start;
+                o.bucket.count = 0;
+                for (int c = 0; c < Channels; c++)
+                {
+                    o.bucket.min[c] = NAN;
+                    o.bucket.max[c] = NAN;
+                    o.sum[c] = 0;
+                    o.valid[c] = 0;
+                }
+            }
+
+            // A sample from before the open bucket (clock step) is counted in it
+            if (o.bucket.count < UINT16_MAX)
+            {
+                o.bucket.count++;
+            }
+            for (int c = 0; c < Channels; c++)
+            {
+                float v = values[c];
+                if (isnan(v))
+                {
+                    continue;
+                }
+                o.bucket.min[c] = fminf(o.bucket.min[c], v);
+                o.bucket.max[c] = fmaxf(o.bucket.max[c], v);
+                o.sum[c] += v;
+                o.valid[c]++;
+            }
+        }
+        sampleCount++;
+    }
+
+    // Calls emit(const HistoryPoint<Channels> &) for every non-empty bin overlapping
+    // [fromMs, toMs], oldest first, the bucket being filled included. Returns the tier
+    // used (binMs gets the bin width), -1 when there is no data.
+    template <typename Emit>
+    int query(uint32_t fromMs, uint32_t toMs, uint32_t points, Emit emit, uint32_t *binMs = nullptr) const
+    {
+        if (toMs < fromMs || points == 0)
+        {
+            return -1;
+        }
+        uint32_t span = toMs - fromMs;
+        uint32_t wanted = span / points;
+
+        int tier = 0;
+        for (int i = Tiers - 1; i > 0; i--)
+        {
+            if (resolution[i] <= wanted)
+            {
+                tier = i;
+                break;
+            }
+        }
+        while (tier < Tiers - 1 && oldestMs(tier) > fromMs)
+        {
+            tier++;
+        }
+        if (size(tier) == 0)
+        {
+            return -1;
+        }
+
+        // Bins are whole buckets, aligned to multiples of bin
+        uint32_t res = resolution[tier];
+        uint32_t bin = wanted > res ? (wanted + res - 1) / res * res : res;
+        while (toMs / bin - fromMs / bin + 1 > points)
+        {
+            bin += res;
+        }
+        if (binMs)
+        {
+            *binMs = bin;
+        }
+
+        // First stored bucket that ends after fromMs
+        int lo = 0, hi = length[tier];
+        while (lo < hi)
+        {
+            int mid = (lo + hi) / 2;
+            if (stored(tier, mid).tMs + res <= fromMs)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+
+        Merge merge;
+        for (int j = lo; j < length[tier]; j++)
+        {
+            const Bucket &b = stored(tier, j);
+            if (b.tMs > toMs)
+            {
+                break;
+            }
+            merge.add(b, b.tMs - b.tMs % bin, emit);
+        }
+        const OpenBucket &o = open[tier];
+        if (o.active && o.bucket.tMs <= toMs && o.bucket.tMs + res > fromMs)
+        {
+            Bucket current = o.bucket;
+            for (int c = 0; c < Channels; c++)
+            {
+                current.mean[c] = o.valid[c] ? o.sum[c] / o.valid[c] : NAN;
+            }
+            merge.add(current, current.tMs - current.tMs % bin, emit);
+        }
+        merge.flush(emit);
+        return tier;
+    }
+
+    int tiers() const { return Tiers; }
+    int capacity() const { return Buckets; }
+    uint32_t resolutionMs(int tier) const { return resolution[tier]; }
+    uint32_t samples() const { return sampleCount; }
+
+    // Buckets held by a tier, the one being filled included
+    int size(int tier) const { return length[tier] + (open[tier].active ? 1 : 0); }
+
+    // Start of the oldest bucket of a tier, UINT32_MAX when it is empty
+    uint32_t oldestMs(int tier) const
+    {
+        if (length[tier] > 0)
+        {
+            return stored(tier, 0).tMs;
+        }
+        return open[tier].active ? open[tier].bucket.tMs : UINT32_MAX;
+    }
+
+private:
+    struct Bucket
+    {
+        uint32_t tMs;
+        uint16_t count;
+        float min[Channels];
+        float max[Channels];
+        float mean[Channels];
+    };
+
+    struct OpenBucket
+    {
+        Bucket bucket;
+        float sum[Channels];
+        uint16_t valid[Channels]; // Non-NaN readings per channel
+        bool active;
+    };
+
+    // Buckets of one bin; means weighted by the bucket counts
+    struct Merge
+    {
+        HistoryPoint<Channels> point = {};
+        float weight[Channels];
+        bool active = false;
+
+        template <typename Emit>
+        void add(const Bucket &b, uint32_t binStart, Emit &emit)
+        {
+            if (active && binStart != point.tMs)
+            {
+                flush(emit);
+            }
+            if (!active)
+            {
+                active = true;
+                point.tMs = binStart;
+                point.count = 0;
+                for (int c = 0; c < Channels; c++)
+                {
+                    point.min[c] = NAN;
+                    point.max[c] = NAN;
+                    point.mean[c] = 0;
+                    weight[c] = 0;
+                }
+            }
+            point.count += b.count;
+            for (int c = 0; c < Channels; c++)
+            {
+                point.min[c] = fminf(point.min[c], b.min[c]);
+                point.max[c] = fmaxf(point.max[c], b.max[c]);
+                if (!isnan(b.mean[c]))
+                {
+                    point.mean[c] += b.mean[c] * b.count;
+                    weight[c] += b.count;
+                }
+            }
+        }
+
+        template <typename Emit>
+        void flush(Emit &emit)
+        {
+            if (!active)
+            {
+                return;
+            }
+            for (int c = 0; c < Channels; c++)
+            {
+                point.mean[c] = weight[c] > 0 ? point.mean[c] / weight[c] : NAN;
+            }
+            emit(point);
+            active = false;
+        }
+    };
+
+    const Bucket &stored(int tier, int index) const { return buckets[tier][(head[tier] + index) % Buckets]; }
+
+    void close(int tier)
+    {
+        OpenBucket &o = open[tier];
+        for (int c = 0; c < Channels; c++)
+        {
+            o.bucket.mean[c] = o.valid[c] ? o.sum[c] / o.valid[c] : NAN;
+        }
+        if (length[tier] == Buckets)
+        {
+            head[tier] = (head[tier] + 1) % Buckets; // Oldest bucket makes room
+            length[tier]--;
+        }
+        buckets[tier][(head[tier] + length[tier]) % Buckets] = o.bucket;
+        length[tier]++;
+        o.active = false;
+    }
+
+    Bucket buckets[Tiers][Buckets];
+    OpenBucket open[Tiers];
+    uint32_t resolution[Tiers];
+    uint16_t head[Tiers];
+    uint16_t length[Tiers];
+    uint32_t sampleCount = 0;
+};
@@ -0,0 +1,411 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <strings.h>
+
+// Non-blocking outbound HTTP/1.1 as explicit state machines. step() advances a flow as
+// far as the socket allows and returns, so one task can drive several flows at once
+// (the role C++20 coroutines would play; the toolchain is gcc 8). The socket layer is a
+// template parameter with this contract, all calls non-blocking:
+//   int  open(const char *host, uint16_t port, bool tls)  1 connected, 0 in progress, -1 error
+//   int  send(const uint8_t *data, size_t length)          bytes sent, 0 would block, -1 error
+//   int  recv(uint8_t *data, size_t length)                bytes read, 0 would block, -1 error, -2 closed
+//   void close()                                           idempotent
+#define HTTP_REQUEST_MAX 768 // Request line, headers and body
+#define HTTP_HOST_MAX 64
+#define HTTP_FIND_MAX 16     // Longest body marker a flow can look for
+
+enum HttpFlowState
+{
+    HTTP_IDLE,
+    HTTP_CONNECTING,
+    HTTP_SENDING,
+    HTTP_HEADERS,
+    HTTP_BODY,
+    HTTP_DONE,      // Response complete (status() holds the code)
+    HTTP_FAILED,    // Connect, send or receive error, or a malformed response
+    HTTP_TIMEOUT,   // Deadline passed
+    HTTP_CANCELLED, // cancel() called
+};
+
+inline const char *httpFlowStateName(HttpFlowState state)
+{
+    static const char *const names[] = {"idle", "connecting", "sending", "headers", "body",
+                                        "done", "failed", "timeout", "cancelled"};
+    return state <= HTTP_CANCELLED ? names[state] : "?";
+}
+
+// Splits http[s]://host[:port]/path; path points into url
+inline bool httpParseUrl(const char *url, char *host, size_t hostSize, uint16_t &port, bool &tls, const char *&path)
+{
+    if (strncmp(url, "https://", 8) == 0)
+    {
+        tls = true;
+        port = 443;
+        url += 8;
+    }
+    else if (strncmp(url, "http://", 7) == 0)
+    {
+        tls = false;
+        port = 80;
+        url += 7;
+    }
+    else
+    {
+        return false;
+    }
+
+    size_t hostLength = strcspn(url, ":/");
+    if (hostLength == 0 || hostLength >= hostSize)
+    {
+        return false;
+    }
+    memcpy(host, url, hostLength);
+    host[hostLength] = '\0';
+    url += hostLength;
+    if (*url == ':')
+    {
+        port = (uint16_t)atoi(url + 1);
+        url += strcspn(url, "/");
+    }
+    path = *url ? url : "/";
+    return port != 0;
+}
+
+template <typename Transport>
+class HttpFlow
+{
+public:
+    // Formats the request and starts connecting; false when it does not fit HTTP_REQUEST_MAX.
+    // With find set, the body is scanned for that marker (found()) instead of being stored.
+    bool begin(const char *url, const char *method, const char *contentType, const char *body,
+               uint32_t nowMs, uint32_t timeoutMs, const char *find = nullptr)
+    {
+        close();
+        startMs = endMs = nowMs;
+        const char *path;
+        if (!httpParseUrl(url, host, sizeof(host), port, tls, path))
+        {
+            finish(HTTP_FAILED);
+            return false;
+        }
+
+        size_t bodyLength = body ? strlen(body) : 0;
+        int n = snprintf(request, sizeof(request),
+                         "%s %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: cryo-esp32\r\nConnection: close\r\n",
+                         method, path, host);
+        if (n > 0 && body)
+        {
+            n += snprintf(request + n, n < (int)sizeof(request) ? sizeof(request) - n : 0,
+                          "Content-Type: %s\r\nContent-Length: %u\r\n", contentType, (unsigned)bodyLength);
+        }
+        if (n < 0 || (size_t)n + 2 + bodyLength >= sizeof(request))
+        {
+            finish(HTTP_FAILED);
+            return false;
+        }
+        memcpy(request + n, "\r\n", 2);
+        memcpy(request + n + 2, body ? body : "", bodyLength);
+        requestLength = n + 2 + bodyLength;
+
+        marker[0] = '\0';
+        if (find)
+        {
+            strncpy(marker, find, sizeof(marker) - 1);
+            marker[sizeof(marker) - 1] = '\0';
+        }
+        sent = 0;
+        statusCode = 0;
+        lineLength = 0;
+        tailLength = 0;
+        contentLength = -1;
+        bodyRead = 0;
+        markerFound = false;
+        deadlineMs = nowMs + timeoutMs;
+        current = HTTP_CONNECTING;
+        return true;
+    }
+
+    // Advances without blocking, returns true while the flow is still running
+    bool step(uint32_t nowMs)
+    {
+        if (!running())
+        {
+            return false;
+        }
+        if ((int32_t)(nowMs - deadlineMs) >= 0)
+        {
+            return finish(HTTP_TIMEOUT, nowMs);
+        }
+
+        if (current == HTTP_CONNECTING)
+        {
+            int r = socket.open(host, port, tls);
+            if (r < 0)
+            {
+                return finish(HTTP_FAILED, nowMs);
+            }
+            if (r == 0)
+            {
+                return true;
+            }
+            current = HTTP_SENDING;
+        }
+
+        while (current == HTTP_SENDING)
+        {
+            int r = socket.send((const uint8_t *)request + sent, requestLength - sent);
+            if (r < 0)
+            {
+                return finish(HTTP_FAILED, nowMs);
+            }
+            if (r == 0)
+            {
+                return true;
+            }
+            sent += r;
+            if (sent == requestLength)
+            {
+                current = HTTP_HEADERS;
+            }
+        }
+
+        uint8_t chunk[128];
+        for (;;)
+        {
+            int r = socket.recv(chunk, sizeof(chunk));
+            if (r == 0)
+            {
+                return true;
+            }
+            if (r == -2)
+            {
+                // Connection: close, the end of the body is the end of the stream
+                return finish(current == HTTP_BODY ? HTTP_DONE : HTTP_FAILED, nowMs);
+            }
+            if (r < 0)
+            {
+                return finish(HTTP_FAILED, nowMs);
+            }
+            if (!consume(chunk, r))
+            {
+                return finish(current == HTTP_DONE ? HTTP_DONE : HTTP_FAILED, nowMs);
+            }
+        }
+    }
+
+    void cancel(uint32_t nowMs)
+    {
+        if (running())
+        {
+            finish(HTTP_CANCELLED, nowMs);
+        }
+    }
+
+    bool running() const { return current >= HTTP_CONNECTING && current <= HTTP_BODY; }
+    HttpFlowState state() const { return current; }
+    int status() const { return statusCode; }
+    bool found() const { return markerFound; }
+    uint32_t bodyBytes() const { return bodyRead; }
+    uint32_t elapsedMs() const { return endMs - startMs; }
+    Transport &transport() { return socket; }
+
+private:
+    void close()
+    {
+        if (current != HTTP_IDLE)
+        {
+            socket.close();
+        }
+    }
+
+    void finish(HttpFlowState state)
+    {
+        socket.close();
+        current = state;
+    }
+
+    bool finish(HttpFlowState state, uint32_t nowMs)
+    {
+        finish(state);
+        endMs = nowMs;
+        return false;
+    }
+
+    // Returns false once the response is complete or malformed
+    bool consume(const uint8_t *data, size_t length)
+    {
+        size_t i = 0;
+        while (current == HTTP_HEADERS && i < length)
+        {
+            char c = data[i++];
+            if (c != '\n')
+            {
+                if (c != '\r' && lineLength < sizeof(line) - 1)
+                {
+                    line[lineLength++] = c;
+                }
+                continue;
+            }
+            line[lineLength] = '\0';
+            if (statusCode == 0)
+            {
+                // HTTP/1.1 302 Found
+                const char *space = strchr(line, ' ');
+                statusCode = space ? atoi(space + 1) : 0;
+                if (statusCode <= 0)
+                {
+                    return false;
+                }
+            }
+            else if (lineLength == 0)
+            {
+                current = HTTP_BODY;
+                if (contentLength == 0 || (marker[0] == '\0' && statusCode >= 300))
+                {
+                    // Nothing to wait for (e.g. the 302 of the Sheets script)
+                    current = HTTP_DONE;
+                    return false;
+                }
+            }
+            else if (strncasecmp(line, "Content-Length:", 15) == 0)
+            {
+                contentLength = atol(line + 15);
+            }
+            lineLength = 0;
+        }
+
+        if (current != HTTP_BODY)
+        {
+            return true;
+        }
+        size_t bodyChunk = length - i;
+        bodyRead += bodyChunk;
+        if (marker[0] != '\0' && !markerFound)
+        {
+            scan(data + i, bodyChunk);
+        }
+        if (markerFound || (contentLength >= 0 && bodyRead >= (uint32_t)contentLength))
+        {
+            current = HTTP_DONE;
+            return false;
+        }
+        return true;
+    }
+
+    // Marker search across chunk boundaries: the last strlen(marker)−1 bytes carry over
+    void scan(const uint8_t *data, size_t length)
+    {
+        size_t markerLength = strlen(marker);
+        char window[HTTP_FIND_MAX + 128];
+        while (length > 0 && !markerFound)
+        {
+            size_t take = length < 128 ? length : 128;
+            memcpy(window, tail, tailLength);
+            memcpy(window + tailLength, data, take);
+            size_t windowLength = tailLength + take;
+            window[windowLength] = '\0';
+            markerFound = windowLength >= markerLength && memmem(window, windowLength, marker, markerLength) != nullptr;
+
+            size_t keep = markerLength - 1 < windowLength ? markerLength - 1 : windowLength;
+            memcpy(tail, window + windowLength - keep, keep);
+            tailLength = keep;
+            data += take;
+            length -= take;
+        }
+    }
+
+    Transport socket;
+    HttpFlowState current = HTTP_IDLE;
+    char host[HTTP_HOST_MAX];
+    uint16_t port = 0;
+    bool tls = false;
+    char request[HTTP_REQUEST_MAX];
+    size_t requestLength = 0;
+    size_t sent = 0;
+    char line[96]; // Header lines past this are truncated, only the status and Content-Length matter
+    size_t lineLength = 0;
+    char marker[HTTP_FIND_MAX];
+    char tail[HTTP_FIND_MAX];
+    size_t tailLength = 0;
+    bool markerFound = false;
+    int statusCode = 0;
+    long contentLength = -1;
+    uint32_t bodyRead = 0;
+    uint32_t startMs = 0;
+    uint32_t endMs = 0;
+    uint32_t deadlineMs = 0;
+};
+
+// Fixed set of flows driven by one task. start() hands out a slot, poll() steps every
+// running flow and reports each one that ended, with the tag given at start().
+template <typename Transport, int N>
+class HttpExecutor
+{
+public:
+    typedef void (*Completion)(int slot, const HttpFlow<Transport> &flow, uint32_t tag);
+
+    // Returns the slot, or -1 when all slots are busy or the request is invalid
+    int start(const char *url, const char *method, const char *contentType, const char *body,
+              uint32_t nowMs, uint32_t timeoutMs, uint32_t tag, const char *find = nullptr)
+    {
+        for (int i = 0; i < N; i++)
+        {
+            if (!busy[i])
+            {
+                tags[i] = tag;
+                busy[i] = true;
+                // A request that cannot be formatted is still reported through poll(), as HTTP_FAILED
+                if (flows[i].begin(url, method, contentType, body, nowMs, timeoutMs, find))
+                {
+                    startedCount++;
+                }
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    void poll(uint32_t nowMs, Completion done)
+    {
+        for (int i = 0; i < N; i++)
+        {
+            if (busy[i] && !flows[i].step(nowMs))
+            {
+                busy[i] = false;
+                done(i, flows[i], tags[i]);
+            }
+        }
+    }
+
+    // Cancels every flow, each is reported to done
+    void cancelAll(uint32_t nowMs, Completion done)
+    {
+        for (int i = 0; i < N; i++)
+        {
+            flows[i].cancel(nowMs);
+        }
+        poll(nowMs, done);
+    }
+
+    int active() const
+    {
+        int count = 0;
+        for (int i = 0; i < N; i++)
+        {
+            count += busy[i];
+        }
+        return count;
+    }
+    bool full() const { return active() == N; }
+    uint32_t started() const { return startedCount; }
+
+private:
+    HttpFlow<Transport> flows[N];
+    uint32_t tags[N] = {};
+    bool busy[N] = {};
+    uint32_t startedCount = 0;
+};
@@ -6,6 +6,7 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/queue.h>
+#include <freertos/semphr.h>
 #include <freertos/timers.h>
 // #include <cmath>
 #include <Update.h>
@@ -13,9 +14,41 @@
 #include <ESPmDNS.h>
 #include <EEPROM.h>
 #include <WiFiClientSecure.h>
+#include <WiFiUdp.h>
+#include <telemetryFrame.h>
+#include <SPI.h>
+#include <decimator.h>
+#include <biquadBank.h>
+#include <uncertainty.h>
+#include <fixedPoint.h>
+#include <spscQueue.h>
+#include <samplePool.h>
+#include <sinkDispatcher.h>
+#include <supervisor.h>
+#include <adaptiveRate.h>
+#include <LittleFS.h>
+#include <gorilla.h>
+#include <esp_task_wdt.h>
+#include <forecast.h>
+#include <binaryLog.h>
+#include <sigmaDelta.h>
+#include <allanVariance.h>
+#include <httpFlow.h>
+#include <timeAlign.h>
+#include <traceBuffer.h>
+#include <responseCache.h>
+#include <historyTiers.h>
+#include <safetyInterlock.h>
+#include <buttonLed.h>
+#include <runCheckpoint.h>
+#include <esp_tls.h>
+#include <soc/rtc_io_reg.h>
 
 #define EEPROM_SIZE 64       // Size in bytes (more than we need)
 #define EEPROM_OFFSET_ADDR 0 // Address to store our offset
+#define EEPROM_NAME_ADDR 8   // Device name (NUL terminated), unset = derived from the MAC
+#define DEVICE_NAME_MAX 24
+#define FIRMWARE_VERSION "1.1.0"
 #define OTA_USER "admin"
 #define OTA_PASS "admin@123"
 
@@ -28,6 +61,13 @@
 
 #define MEDIAN_WINDOW 5 // Odd number (3, 5, or 7 work well)
 
+// 1 = the two RTD conversions (one after the other, ~75 ms apart) are moved to their common
+// midpoint along each channel's slope before the medians, so a ramp makes no fake ΔT
+#define RTD_TIME_ALIGN 1
+
+// Numeric mode of the acquisition/compute path: 0 = float, 1 = Q16.16 fixed point
+#define FIXED_POINT_MODE 0
+
 // LED and Button Pins
 #define WifiLED1 12     // WiFi status LED
 #define MosfetLED2 14   // MOSFET gate status LED
@@ -38,6 +78,131 @@
 #define SAMPLE_COUNT 10 // Average over 10 readings
 #define DAC_GPIO 25
 
+// Heater drive: 1 = 16-bit level dithered onto the 8-bit DAC by a timer ISR, 0 = plain dacWrite()
+#define HEATER_SIGMA_DELTA 1
+#define HEATER_DITHER_HZ 10000 // Worst-case dither pattern repeats every 25.6 ms
+#define HEATER_TIMER 0
+
+// Heater interlock: a hardware timer compares the newest readings with these limits and
+// cuts the MOSFET and the DAC on a fault, latched until /interlock?clear=1
+#define INTERLOCK_TIMER 1
+#define INTERLOCK_PERIOD_US 1000      // Cutoff within one period of the offending reading
+#define INTERLOCK_MAX_TEMP_K 330.0    // Either RTD, i.e. the cryostat warmed up with the heater on
+#define INTERLOCK_MAX_POWER_MW 2000.0
+#define INTERLOCK_MAX_CURRENT_MA 1000.0
+#define INTERLOCK_STALE_MS 15000      // No reading for this long (3 × the slowest interval) is a fault
+
+// Warm restart: the run state is checkpointed to RTC memory after every sample
+#define RUN_STATE_LAYOUT 1        // Bump whenever RunState_t changes
+#define RUN_STATE_RTC_BYTES 4096  // Share of the 8 KB RTC slow memory
+
+// Core plan: networking never shares a core with acquisition
+#define CORE_NET 0 // WiFi stack, HTTP server, cloud upload, mDNS, button worker
+#define CORE_ACQ 1 // Sensor reads, k computation, raw capture
+
+#define MEASURE_INTERVAL_MS 1000 // Acquisition period at boot, adapted from there
+#define SAMPLE_RING_SIZE 16      // Acquisition -> network handoff (power of two)
+#define SAMPLE_POOL_SIZE 32      // Sample blocks shared by all consumers
+#define HTTP_QUEUE_LENGTH 5      // Pending portal login/logout requests (Sheets rows wait in their sink)
+
+// Adaptive sampling: fast during heater steps and ΔT transients, slow at equilibrium
+#define ADAPTIVE_MIN_INTERVAL_MS 500  // One measurement takes ~250 ms (two RTD conversions + current average)
+#define ADAPTIVE_MAX_INTERVAL_MS 5000
+#define ADAPTIVE_SLOPE_K_S 0.003      // Smoothed |dΔT/dt| above this is a transient
+#define ADAPTIVE_POWER_STEP_MW 2.0    // Power change between two samples above this is a heater step
+#define ADAPTIVE_BACKOFF 1.25         // Interval growth per quiet sample
+#define ADAPTIVE_SMOOTHING_MS 10000   // Slope filter time constant
+
+// Change-only cloud logging
+#define LOG_DEADBAND_DT_K 0.05      // ΔT change that makes a new row
+#define LOG_DEADBAND_POWER_MW 1.0   // Power change that makes a new row
+#define LOG_DEADBAND_K_REL 0.01     // Relative k change that makes a new row
+#define LOG_MIN_INTERVAL_MS 5000    // Rows never closer than this (an upload takes seconds)
+#define LOG_MAX_INTERVAL_MS 300000  // Heartbeat row during long equilibrations
+
+// Sample fan-out: every sink has its own queue, overflow policy, rate limit and worker task
+#define SINK_QUEUE_DEPTH 4                              // Pool handles per sink, all a stuck sink can hold
+#define SINK_ARCHIVE_SPOOL 64                           // Copies kept while a block write or /archive request holds the archive
+#define SINK_SHEETS_MIN_INTERVAL_MS LOG_MIN_INTERVAL_MS // A backlog of rows after an outage goes out at this pace
+
+// Deferred-format logging: hot paths store a record, LogDrain formats it onto Serial
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG // Calls above this level compile to nothing
+#define LOG_RING_SIZE 64                  // Records per core (power of two)
+#define LOG_DRAIN_PERIOD_MS 50
+#define LOG_LINE_MAX 160
+
+// Execution trace: scoped begin/end events per core, dumped as Chrome trace JSON at /trace
+#define TRACE_ENABLED 1     // 0 = TRACE_SCOPE compiles to nothing
+#define TRACE_RING_SIZE 128 // Events per core (power of two), the newest are kept
+#define TRACE_HTTP_THREAD 1 // Track ids of the HTTP slots (task handles are addresses, never this small)
+
+// /getData is serialized once per sample and served to every dashboard from that copy
+#define DATA_CACHE_BYTES 320 // Largest /getData body
+
+// Min/max/mean history of every sample at 1 s, 10 s, 1 min and 10 min, for zoomable charts at /history
+#define HISTORY_CHANNELS 5  // temp1, temp2, power, k, u(k)
+#define HISTORY_TIERS 4
+#define HISTORY_BUCKETS 144 // Per tier, 24 h at 10 min
+#define HISTORY_MAX_POINTS 2000
+
+// Allan deviation of temp1, temp2, ΔT and power, to choose averaging times from live data
+#define ALLAN_CHANNELS 4
+#define ALLAN_READING_OCTAVES 10 // Raw capture readings: τ0 = capture period, 2 ms .. 1 s by default
+#define ALLAN_SAMPLE_OCTAVES 11  // Acquisition samples at a constant interval: 5 s .. 85 min at equilibrium
+
+// Steady-state forecast: ΔT∞ and k from the approach to equilibrium
+#define FORECAST_FORGETTING 0.995     // Per sample, ~200 samples of memory
+#define FORECAST_EQUILIBRIUM_K 0.01   // "At equilibrium" once ΔT is this close to ΔT∞
+#define FORECAST_CONVERGED_REL 0.02   // Forecast is reported as converged below this 95 % half-width of k
+
+// Memory layout: 1 = every task stack, queue and timer is a static object sized at compile time
+#define STATIC_MEMORY_LAYOUT 1
+#define STATIC_MEMORY_BUDGET (160 * 1024) // Ceiling for the regions in memoryMap[]
+
+// Task stacks in bytes (StackType_t is one byte on ESP32)
+#define ACQ_STACK_SIZE 4096
+#define CAPTURE_STACK_SIZE 4096
+#define NET_STACK_SIZE 12288
+#define CLOUD_STACK_SIZE 8192
+#define BUTTON_STACK_SIZE 4096
+#define SUPERVISOR_STACK_SIZE 4096
+#define LOG_STACK_SIZE 4096
+#define TELEMETRY_STACK_SIZE 4096
+#define ARCHIVE_STACK_SIZE 6144 // LittleFS block writes
+
+// Supervisor: heartbeat deadlines per task, recovery of the network subsystems
+#define SUPERVISOR_PERIOD_MS 1000
+#define WATCHDOG_TIMEOUT_S 15                     // Hardware task watchdog, fed by the supervisor
+#define ACQ_DEADLINE_MS (3 * ADAPTIVE_MAX_INTERVAL_MS) // Late acquisition is logged...
+#define ACQ_FATAL_MS 60000                        // ...stuck this long (e.g. stalled SPI) lets the watchdog reset the chip
+#define CAPTURE_DEADLINE_MS 1000                  // Between two samples of a burst
+#define NET_DEADLINE_MS 30000                     // Web server/telemetry loop, restarted after this
+#define CLOUD_DEADLINE_MS 45000                   // One upload including the TLS handshake, restarted after this
+#define SINK_DEADLINE_MS 10000                    // One sample in a sink worker (UDP send, archive block write)
+#define WIFI_RECOVERY_MS 20000                    // Link down this long -> reconnect
+#define TASK_RESTART_GRACE_MS 15000               // A task that has not restarted itself by then: shut down its sockets
+#define TASK_SOCKET_GRACE_MS 10000                // Still stuck this long after that: delete and recreate it
+#define NET_SEND_TIMEOUT_S 5                      // Socket timeout for streamed responses, bounds a NetTask stall
+#define HTTP_CONNECT_TIMEOUT_MS 5000
+#define HTTP_TIMEOUT_MS 10000
+
+// Outbound HTTP: CloudTask drives every request as a non-blocking flow
+#define HTTP_MAX_FLOWS 3      // Concurrent requests (Sheets upload + portal login + logout)
+#define HTTP_MAX_TLS_FLOWS 1  // A TLS session holds ~40 KB of mbedTLS heap
+#define HTTP_POLL_MS 10       // Step period while a request is in flight
+#define HTTP_OFFLINE_POLL_MS 1000 // Rows wait in the Sheets sink while WiFi is down
+
+// Button and LED timing
+#define DEBOUNCE_MS 30        // Button must be stable this long after an edge
+#define LONG_PRESS_MS 3000    // Long press runs myFunction()
+#define WIFI_BLINK_ON_MS 10   // Connected: short blink...
+#define WIFI_BLINK_OFF_MS 4990 // ...every 5 seconds
+#define DATA_PULSE_MS 100     // Data LED pulse after a successful upload
+
+// Type B uncertainties of the sample geometry (caliper resolution)
+#define THICKNESS_UNCERTAINTY_MM 0.01
+#define DIAMETER_UNCERTAINTY_MM 0.01
+
 // MAX31865 Setup (PT200)
 #define CS1 5          // Chip Select for Max31865 sensor 1
 #define CS2 4          // Chip Select for Max31865 sensor 2
@@ -47,15 +212,110 @@
 // #define RREF1 427      // Reference Resistor for Max31865 sensor 1
 // #define RREF2 429      // Reference Resistor for Max31865 sensor 2
 
-// Structure for cloud data
+#define TELEMETRY_MAX_SUBSCRIBERS 4 // Lab PCs receiving UDP frames
+
+// Raw capture mode
+#define CAPTURE_MAX_SAMPLES 2048  // Preallocated burst buffer (16 bytes per sample)
+#define CAPTURE_PERIOD_US 2000    // Default 500 Hz sampling during a burst
+#define CAPTURE_FIR_DECIMATION 20 // Second decimation stage, the CIC takes the rest down to 1 Hz
+#define CAPTURE_MAGIC 0x43574152  // "RAWC"
+
+// Biquad cascades ahead of the decimator, one topology per channel (rtd1, rtd2, bus mV,
+// current µA), chosen at runtime from filterTopologies[] and designed for CAPTURE_PERIOD_US
+#define FILTER_CHANNELS 4
+#define FILTER_SECTIONS 3
+#define FILTER_DEFAULT FILTER_MAINS50
+#define FILTER_LOWPASS_HZ 20.0 // 4th-order Butterworth
+#define FILTER_NOTCH_Q 5.0     // 10 Hz wide at 50 Hz
+
+// On-flash sample archive (LittleFS), one data file and one block index per named run
+#define ARCHIVE_DIR "/archive"
+#define ARCHIVE_BLOCK_BYTES 1024   // One block on flash including its header, buffered in RAM until full
+#define ARCHIVE_BLOCK_MAGIC 0x4B42 // "BK"
+#define ARCHIVE_CHANNELS 7         // temp1, temp2, busVoltage, current_mA, power_mW, k, u(k)
+#define ARCHIVE_MAX_RUN_NAME 24
+#if FIXED_POINT_MODE
+#define ARCHIVE_CODEC SERIES_CODEC_VARINT // Q16.16 raw values, delta + zigzag varint
+#else
+#define ARCHIVE_CODEC SERIES_CODEC_XOR // Float bit patterns, Gorilla XOR
+#endif
+
+// One raw sample of a capture burst (RTD codes straight from the MAX31865)
+typedef struct
+{
+    uint32_t t_us;
+    uint16_t rtd1;
+    uint16_t rtd2;
+    float busVoltage;
+    float current_mA;
+} RawSample_t;
+
+// Header of the /captureData binary download, followed by count RawSample_t
 typedef struct
 {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t sampleSize;
+    uint32_t count;
+    uint32_t period_us;
+    float rref1;
+    float rref2;
+    float rnominal;
+} CaptureHeader_t;
+
+// Block in <run>.gor, followed by payloadBytes of SeriesEncoder output
+typedef struct __attribute__((packed))
+{
+    uint16_t magic; // ARCHIVE_BLOCK_MAGIC
+    uint8_t codec;  // SERIES_CODEC_*
+    uint8_t channels;
+    uint16_t count;
+    uint16_t payloadBytes;
+    uint32_t tFirst; // Run time, ms
+    uint32_t tLast;
+    uint32_t crc; // CRC-32 of the payload
+} ArchiveBlockHeader_t;
+
+// Entry of <run>.idx, one per block in time order
+typedef struct __attribute__((packed))
+{
+    uint32_t offset; // Of the block header in <run>.gor
+    uint32_t tFirst;
+    uint32_t tLast;
+    uint16_t count;
+    uint16_t payloadBytes;
+} ArchiveIndexEntry_t;
+
+// One acquisition result, handed from the acquisition core to the network core
+typedef struct
+{
+    uint32_t timestamp_ms;
     float temp1;
     float temp2;
+    float dT;
     float busVoltage;
     float current_mA;
     float power_mW;
-} CloudData_t;
+    float thermalConductivity;
+    float thermalConductivityUnc;
+} Sample_t;
+
+// Entry of the task table in setup()
+typedef struct
+{
+    TaskFunction_t function;
+    const char *name;
+    uint32_t stackSize;
+    UBaseType_t priority;
+    TaskHandle_t *handle;
+    BaseType_t core;
+    StackType_t *stack; // STATIC_MEMORY_LAYOUT only
+    StaticTask_t *tcb;  // STATIC_MEMORY_LAYOUT only
+} TaskSpec_t;
+
+// mDNS identity: <deviceName>.local, unique per rig
+char deviceName[DEVICE_NAME_MAX + 1] = "";
+bool mdnsStarted = false;
 
 // Wi-Fi definitions
 const int NUM_NETWORKS = 5;
@@ -65,8 +325,18 @@ const char *password[NUM_NETWORKS] = {"lab@12345", "", "qqwweeaaaa", "HMDG@123",
 
 float tempBuffer1[MEDIAN_WINDOW] = {0};
 float tempBuffer2[MEDIAN_WINDOW] = {0};
-int bufferIndex1 = 0;
-int bufferIndex2 = 0;
+int bufferIndex = 0; // Both median windows advance together
+
+// Time alignment of the RTD pair; entries of both median windows share tempGridUs
+#if FIXED_POINT_MODE
+TimeAlignerQ<2, MEDIAN_WINDOW> rtdAligner;
+#else
+TimeAligner<2, MEDIAN_WINDOW> rtdAligner;
+#endif
+uint32_t tempGridUs[MEDIAN_WINDOW] = {0};
+int32_t rtdSkewUs = 0;         // Conversion time of temp2 − temp1, last pair
+int32_t rtdResidualSkewUs = 0; // Between the entries the two medians picked
+float rtdAlignCorrectionK = 0; // Added to ΔT by the alignment, last pair
 
 float temperature_offset = 0.00; // To calibrate readings of both pt200
 float temp1 = 0.00;
@@ -74,34 +344,505 @@ float temp2 = 0.00;
 float busVoltage = 0.00;
 float current_mA = 0.00;
 float power_mW = 0.00;
-int dacValue = 0;
+int dacValue = 0;       // DAC code, high byte of heaterLevel
+uint16_t heaterLevel = 0; // 0..HEATER_LEVEL_MAX, LSB = 1/256 DAC step
+SigmaDelta heaterModulator;
+hw_timer_t *heaterTimer = NULL;
+SafetyInterlock safetyInterlock; // Reported by the acquisition and capture tasks, checked by interlockTick()
+hw_timer_t *interlockTimer = NULL;
 
 // Fourier's Law variables
 float thermalConductivity = 0.0;
+float thermalConductivityUnc = 0.0; // Standard uncertainty u(k)
 float sampleThickness = 5.0;   // Default value in mm  Δx
 float crossSectionArea = 0.00; // Default value in mm²+
 float diameter = 10.0;         // Default value in mm
 float dT = 0.00;
+RollingCovariance powerDtStats; // x = power_mW, y = dT
+
+// Allan variance engines: raw readings of the last capture burst, and acquisition samples
+// since the interval last changed (the estimator needs a constant τ0)
+AllanVariance<ALLAN_CHANNELS, ALLAN_READING_OCTAVES> readingAllan;
+AllanVariance<ALLAN_CHANNELS, ALLAN_SAMPLE_OCTAVES> sampleAllan;
+uint32_t readingAllanPeriodUs = 0;
+uint32_t sampleAllanIntervalMs = 0;
+
+// Steady-state forecast, written by the acquisition task
+SteadyStateForecast dtForecast;
+float forecastPower_mW = 0.0;      // Power of the step being fitted
+float forecastDt = 0.0;            // ΔT∞
+float forecastDtUnc = 0.0;         // u(ΔT∞) from the fit
+float forecastK = 0.0;             // k at ΔT∞
+float forecastKUnc = 0.0;          // u(k∞) from the fit
+float forecastTauS = 0.0;          // Time constant of the approach
+float forecastEquilibriumS = -1.0; // Seconds until ΔT is within FORECAST_EQUILIBRIUM_K of ΔT∞, -1 = unknown
+bool forecastValid = false;
+uint32_t forecastResets = 0;
+
+// Fixed-point measurement path, the float globals above are derived from these in FIXED_POINT_MODE
+Q16 tempBufferQ1[MEDIAN_WINDOW];
+Q16 tempBufferQ2[MEDIAN_WINDOW];
+Q16 temp1Q, temp2Q, dTQ, busVoltageQ, current_mAQ, power_mWQ, thermalConductivityQ;
+RtdTable rtdTable1; // RTD code -> K for RREF1
+RtdTable rtdTable2; // RTD code -> K for RREF2
 
 // RTOS Handles
 TaskHandle_t cloudTaskHandle = NULL;
-TaskHandle_t wifiLedTaskHandle = NULL;
-TaskHandle_t dataLedTaskHandle = NULL;
-TaskHandle_t buttonTaskHandle = NULL;
-TaskHandle_t mainTaskHandle = NULL;
-QueueHandle_t cloudDataQueue = NULL;
-QueueHandle_t dataLedQueue = NULL;
-TimerHandle_t wifiLedTimer = NULL;
+TaskHandle_t buttonWorkerTaskHandle = NULL;
+TaskHandle_t acquisitionTaskHandle = NULL;
+TaskHandle_t netTaskHandle = NULL;
+TaskHandle_t captureTaskHandle = NULL;
+TaskHandle_t supervisorTaskHandle = NULL;
+TaskHandle_t logDrainTaskHandle = NULL;
+TaskHandle_t telemetryTaskHandle = NULL;
+TaskHandle_t archiveTaskHandle = NULL;
+QueueHandle_t httpJobQueue = NULL; // Carries HttpJob_t, portal requests only
+
+// Samples live in the pool; the ring and queues only pass handles around
+BlockPool<Sample_t, SAMPLE_POOL_SIZE> samplePool;
+SpscQueue<BlockHandle, SAMPLE_RING_SIZE> sampleRing; // Lock-free, acquisition core -> network core
+BlockHandle latestSample = INVALID_BLOCK;           // Last sample seen by the network core (holds a reference)
+uint32_t samplesPublished = 0;
+
+// Spinlock critical section, for short sections shared by both cores
+struct CriticalSection
+{
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+    void lock() { portENTER_CRITICAL(&mux); }
+    void unlock() { portEXIT_CRITICAL(&mux); }
+};
+
+// NetTask publishes every sample once, each sink is drained by its own worker
+enum SinkId
+{
+    SINK_TELEMETRY, // UDP frames, TelemetryTask
+    SINK_ARCHIVE,   // Flash runs, ArchiveTask
+    SINK_SHEETS,    // Change-only rows, CloudTask
+    SINK_COUNT
+};
+
+SinkDispatcher<Sample_t, SAMPLE_POOL_SIZE, CriticalSection, SINK_COUNT, SINK_QUEUE_DEPTH> sampleSinks;
+decltype(sampleSinks)::SpoolEntry archiveSpool[SINK_ARCHIVE_SPOOL];
+TaskHandle_t *const sinkWorkers[SINK_COUNT] = {&telemetryTaskHandle, &archiveTaskHandle, &cloudTaskHandle};
+// A full ring, latestSample and every sink queue full still leave a block for the next sample
+static_assert(SAMPLE_RING_SIZE + SINK_COUNT * SINK_QUEUE_DEPTH < SAMPLE_POOL_SIZE, "Stuck sinks could exhaust the sample pool");
+
+// Sampling and logging policy (acquisition core / network core respectively)
+AdaptiveRate acquisitionRate;
+DeadbandLogger cloudLogger;
+volatile uint32_t acquisitionIntervalMs = MEASURE_INTERVAL_MS;
+
+// Deferred-format log, one ring per core; a call costs a record copy, never a Serial write
+BinaryLog<LOG_RING_SIZE, portNUM_PROCESSORS> binaryLog;
+volatile uint8_t logLevel = LOG_LEVEL_INFO; // Runtime threshold, /log?level=
+
+#define LOG_AT(level, format, ...)                                                          \
+    do                                                                                      \
+    {                                                                                       \
+        if ((level) <= LOG_COMPILE_LEVEL && (level) <= logLevel)                            \
+        {                                                                                   \
+            binaryLog.write((level), xPortGetCoreID(), millis(), "" format, ##__VA_ARGS__); \
+        }                                                                                   \
+    } while (0)
+#define LOG_ERROR(format, ...) LOG_AT(LOG_LEVEL_ERROR, format, ##__VA_ARGS__)
+#define LOG_WARN(format, ...) LOG_AT(LOG_LEVEL_WARN, format, ##__VA_ARGS__)
+#define LOG_INFO(format, ...) LOG_AT(LOG_LEVEL_INFO, format, ##__VA_ARGS__)
+#define LOG_DEBUG(format, ...) LOG_AT(LOG_LEVEL_DEBUG, format, ##__VA_ARGS__)
+
+// Execution trace, one ring per core; an event costs a cycle-counter read and a 20-byte copy
+TraceBuffer<TRACE_RING_SIZE, portNUM_PROCESSORS> traceBuffer;
+
+// /getData body of latestSample, rebuilt by NetTask when a sample arrives or the heater or
+// MOSFET changes; its ETag lets an unchanged poll be answered with a 304
+ResponseCache<DATA_CACHE_BYTES> dataCache;
+uint32_t dataCacheControl = 0; // dataControlKey() the cached body was built with
+volatile bool traceOn = true; // /trace?enable=
+
+inline void traceEvent(const char *name, char phase, uintptr_t thread)
+{
+    if (TRACE_ENABLED && traceOn)
+    {
+        traceBuffer.write(xPortGetCoreID(), thread, ESP.getCycleCount(), xTaskGetTickCount(), name, phase);
+    }
+}
+
+inline void traceEvent(const char *name, char phase)
+{
+    traceEvent(name, phase, (uintptr_t)xTaskGetCurrentTaskHandle());
+}
+
+// Begin/end pair around the enclosing block (task context only)
+class TraceScope
+{
+public:
+    explicit TraceScope(const char *name) : name(name) { traceEvent(name, TRACE_PHASE_BEGIN); }
+    ~TraceScope() { traceEvent(name, TRACE_PHASE_END); }
+
+private:
+    const char *name;
+};
+
+#if TRACE_ENABLED
+#define TRACE_CONCAT(a, b) a##b
+#define TRACE_SCOPE_AT(name, line) TraceScope TRACE_CONCAT(traceScope, line)(name)
+#define TRACE_SCOPE(name) TRACE_SCOPE_AT("" name, __LINE__)
+#else
+#define TRACE_SCOPE(name) \
+    do                    \
+    {                     \
+    } while (0)
+#endif
+
+// Acquisition period jitter, |actual period - requested period|
+volatile uint32_t jitterMaxUs = 0;
+volatile uint32_t jitterLastUs = 0;
+volatile uint64_t jitterSumUs = 0;
+volatile uint32_t jitterCount = 0;
+volatile uint32_t acquisitionBusyUs = 0; // Duration of the last measure + compute pass
+TimerHandle_t ledTimer = NULL;       // One-shot, re-armed for the next LED transition
+TimerHandle_t debounceTimer = NULL;  // One-shot, restarted by every button edge
+TimerHandle_t longPressTimer = NULL; // One-shot, fires LONG_PRESS_MS into a press
 
 // Shared variables (use atomic operations or mutex for thread safety)
 volatile bool wifiConnected = false;
 volatile bool mosfetState = false;
 volatile bool dataLedActive = false;
-volatile bool buttonLongPress = false;
+
+// Wakeup counters for /wakeups, shows how often button/LED handling runs
+volatile uint32_t buttonIsrWakeups = 0;
+volatile uint32_t debounceWakeups = 0;
+volatile uint32_t longPressWakeups = 0;
+volatile uint32_t ledTimerWakeups = 0;
+
+// LED pattern engine (src/buttonLed.h): each LED has an idle level and an optional blink pattern
+enum LedId
+{
+    LED_WIFI,
+    LED_MOSFET,
+    LED_DATA,
+    LED_COUNT
+};
+
+const uint8_t ledPins[LED_COUNT] = {WifiLED1, MosfetLED2, DataLED3};
+const bool ledIdleLevels[LED_COUNT] = {HIGH, LOW, LOW}; // WiFi solid on while connecting
+LedPatterns<LED_COUNT> leds;
+portMUX_TYPE ledMux = portMUX_INITIALIZER_UNLOCKED;
+ButtonDebouncer button;
 
 // Web Server on port 80
 WebServer server(80);
 
+// UDP telemetry subscribers (port 0 = free slot)
+typedef struct
+{
+    IPAddress ip;
+    uint16_t port;
+} TelemetrySubscriber_t;
+
+WiFiUDP telemetryUdp;
+TelemetrySubscriber_t telemetrySubscribers[TELEMETRY_MAX_SUBSCRIBERS]; // Written by NetTask, sent to by TelemetryTask
+CriticalSection telemetrySubscribersLock;
+uint32_t telemetrySequence = 0;
+uint32_t telemetrySendErrors = 0;
+
+// Raw capture burst
+RawSample_t captureBuffer[CAPTURE_MAX_SAMPLES];
+volatile uint32_t captureCount = 0;
+volatile bool captureActive = false;
+uint32_t captureTarget = 0;
+uint32_t capturePeriodUs = CAPTURE_PERIOD_US;
+CicFirDecimator<4> captureDecimator; // rtd1, rtd2, bus mV, current uA
+
+enum FilterTopology
+{
+    FILTER_NONE,
+    FILTER_NOTCH50, // 50 Hz and its 2nd harmonic
+    FILTER_NOTCH60,
+    FILTER_LOWPASS,
+    FILTER_MAINS50, // 50 Hz notch, then the low-pass
+    FILTER_MAINS60,
+    FILTER_TOPOLOGIES
+};
+
+constexpr double FILTER_FS = 1e6 / CAPTURE_PERIOD_US;
+constexpr BiquadCoefficients_t FILTER_LP1 = biquadLowPass(FILTER_LOWPASS_HZ, FILTER_FS, 0.5411961);
+constexpr BiquadCoefficients_t FILTER_LP2 = biquadLowPass(FILTER_LOWPASS_HZ, FILTER_FS, 1.3065630);
+constexpr BiquadCascade<FILTER_SECTIONS> filterTopologies[FILTER_TOPOLOGIES] = {
+    {{biquadIdentity(), biquadIdentity(), biquadIdentity()}},
+    {{biquadNotch(50, FILTER_FS, FILTER_NOTCH_Q), biquadNotch(100, FILTER_FS, FILTER_NOTCH_Q), biquadIdentity()}},
+    {{biquadNotch(60, FILTER_FS, FILTER_NOTCH_Q), biquadNotch(120, FILTER_FS, FILTER_NOTCH_Q), biquadIdentity()}},
+    {{FILTER_LP1, FILTER_LP2, biquadIdentity()}},
+    {{biquadNotch(50, FILTER_FS, FILTER_NOTCH_Q), FILTER_LP1, FILTER_LP2}},
+    {{biquadNotch(60, FILTER_FS, FILTER_NOTCH_Q), FILTER_LP1, FILTER_LP2}},
+};
+const char *const filterTopologyNames[FILTER_TOPOLOGIES] = {"none", "notch50", "notch60", "lowpass", "mains50", "mains60"};
+const char *const filterChannelNames[FILTER_CHANNELS] = {"rtd1", "rtd2", "voltage", "current"};
+static_assert(FILTER_FS > 2 * 120, "Capture rate too low for the mains harmonics");
+static_assert(biquadDcGain(filterTopologies[FILTER_MAINS50]) > 0.999 && biquadDcGain(filterTopologies[FILTER_MAINS50]) < 1.001,
+              "Filters must pass DC unchanged");
+static_assert(biquadDcGain(filterTopologies[FILTER_MAINS60]) > 0.999 && biquadDcGain(filterTopologies[FILTER_MAINS60]) < 1.001,
+              "Filters must pass DC unchanged");
+
+BiquadBank<FILTER_CHANNELS, FILTER_SECTIONS> captureFilters;
+volatile uint8_t captureFilterTopology[FILTER_CHANNELS] = {FILTER_DEFAULT, FILTER_DEFAULT, FILTER_DEFAULT, FILTER_DEFAULT};
+bool captureFiltered = false;     // Last burst ran at the design rate and went through the filters
+uint32_t filterCyclesPerSample = 0; // All channels, mean over the last burst
+
+// Sample history, added to and queried by NetTask
+const uint32_t historyResolutionMs[HISTORY_TIERS] = {1000, 10000, 60000, 600000};
+const char *const historyChannelNames[HISTORY_CHANNELS] = {"temp1", "temp2", "power_mW", "thermalConductivity",
+                                                          "thermalConductivityUnc"};
+const uint8_t historyDecimals[HISTORY_CHANNELS] = {3, 3, 2, 4, 4};
+HistoryTiers<HISTORY_CHANNELS, HISTORY_TIERS, HISTORY_BUCKETS> sampleHistory;
+uint32_t historyAddUsMax = 0;
+uint32_t historyQueryUs = 0; // Last /history query, without the network writes
+
+// Archive state: ArchiveTask appends, the /archive handlers on NetTask start, stop and
+// flush, both under archiveMutex
+SemaphoreHandle_t archiveMutex = NULL;
+SeriesEncoder<ARCHIVE_CHANNELS> archiveEncoder;
+uint8_t archivePayload[ARCHIVE_BLOCK_BYTES - sizeof(ArchiveBlockHeader_t)]; // Block being filled
+uint8_t archiveReadBuffer[ARCHIVE_BLOCK_BYTES];                             // Block being decoded by /archive/read
+uint8_t archiveTailBuffer[ARCHIVE_BLOCK_BYTES];                             // /archive/read's copy of the block being filled
+char archiveRun[ARCHIVE_MAX_RUN_NAME + 1] = "";                              // Active run, empty = not recording
+bool archiveMounted = false;
+uint32_t archiveTimeBase = 0;     // Run time = archiveTimeBase + (timestamp_ms - archiveSessionStart)
+uint32_t archiveSessionStart = 0;
+uint32_t archiveAppends = 0;
+uint32_t archiveAppendUsSum = 0;
+uint32_t archiveAppendUsMax = 0;
+uint32_t archiveBlocksWritten = 0;
+uint32_t archiveFlushUsMax = 0;
+uint32_t archiveBytesWritten = 0;  // Headers and payload
+uint32_t archiveLastReadRecords = 0;
+uint32_t archiveLastReadUs = 0;
+
+// What a reset must not lose: the median windows, the heater, the geometry, the archive run
+// and the statistics that take minutes to build up again
+typedef struct
+{
+    uint32_t runClockMs; // runClockMs() at the checkpoint
+#if FIXED_POINT_MODE
+    Q16 tempBuffer1[MEDIAN_WINDOW];
+    Q16 tempBuffer2[MEDIAN_WINDOW];
+#else
+    float tempBuffer1[MEDIAN_WINDOW];
+    float tempBuffer2[MEDIAN_WINDOW];
+#endif
+    int bufferIndex;
+    uint16_t heaterLevel;
+    bool mosfetOn;
+    bool interlockTripped; // The heater comes back off
+    float sampleThickness;
+    float diameter;
+    float crossSectionArea;
+    char archiveRun[ARCHIVE_MAX_RUN_NAME + 1];
+    RollingCovariance powerDtStats;
+    SteadyStateForecast dtForecast;
+    float forecastPower_mW;
+} RunState_t;
+
+// Not initialized at boot, kept across software, panic and watchdog resets (written by AcqTask only)
+RTC_NOINIT_ATTR RunCheckpoint<RunState_t> runCheckpoint;
+static_assert(sizeof(runCheckpoint) <= RUN_STATE_RTC_BYTES, "Run state does not fit RUN_STATE_RTC_BYTES");
+uint32_t runClockOffsetMs = 0; // Run clock = millis() + offset, continues across a warm restart
+bool warmStart = false;
+esp_reset_reason_t resetReason = ESP_RST_UNKNOWN;
+uint32_t firstSampleMs = 0; // Time to the first published sample since boot
+uint32_t checkpointUs = 0;  // Cost of the last checkpoint
+
+// Outbound requests, all driven by CloudTask
+enum HttpJobKind
+{
+    HTTP_JOB_SHEETS,
+    HTTP_JOB_PORTAL_LOGIN,
+    HTTP_JOB_PORTAL_LOGOUT,
+};
+
+typedef struct
+{
+    uint8_t kind; // HttpJobKind, portal requests (Sheets rows come from their sink)
+} HttpJob_t;
+
+// esp-tls IDF 4.4 bundle hook; WiFiClientSecure ships its own esp_crt_bundle.h that hides it
+extern "C" esp_err_t esp_crt_bundle_attach(void *conf);
+
+// Sockets of the network tasks, shut down by the supervisor when the task hangs on one
+TaskSockets netSockets;   // The client of the request NetTask is serving
+TaskSockets cloudSockets; // One per flow of CloudTask
+
+// esp-tls in non-blocking mode (plain TCP for http://), the transport of HttpFlow.
+// The connect and TLS handshake advance one step per open() call; DNS still blocks.
+class EspTlsTransport
+{
+public:
+    int open(const char *host, uint16_t port, bool tls)
+    {
+        if (!handle)
+        {
+            handle = esp_tls_init();
+            if (!handle)
+            {
+                return -1;
+            }
+            memset(&config, 0, sizeof(config));
+            config.non_block = true;
+            config.timeout_ms = HTTP_CONNECT_TIMEOUT_MS;
+            config.is_plain_tcp = !tls;
+            config.crt_bundle_attach = tls ? esp_crt_bundle_attach : NULL;
+        }
+        int r = esp_tls_conn_new_async(host, strlen(host), port, &config, handle);
+        if (sockfd < 0 && esp_tls_get_conn_sockfd(handle, &sockfd) == ESP_OK && sockfd >= 0)
+        {
+            cloudSockets.add(sockfd);
+        }
+        return r > 0 ? 1 : r == 0 ? 0 : -1;
+    }
+
+    int send(const uint8_t *data, size_t length)
+    {
+        ssize_t r = esp_tls_conn_write(handle, data, length);
+        return r >= 0 ? (int)r : wouldBlock(r) ? 0 : -1;
+    }
+
+    int recv(uint8_t *data, size_t length)
+    {
+        ssize_t r = esp_tls_conn_read(handle, data, length);
+        return r > 0 ? (int)r : r == 0 ? -2 : wouldBlock(r) ? 0 : -1;
+    }
+
+    void close()
+    {
+        if (sockfd >= 0)
+        {
+            cloudSockets.remove(sockfd);
+            sockfd = -1;
+        }
+        if (handle)
+        {
+            esp_tls_conn_destroy(handle);
+            handle = NULL;
+        }
+    }
+
+private:
+    // mbedTLS reports WANT_READ/WANT_WRITE, plain TCP -1 with errno
+    static bool wouldBlock(ssize_t r)
+    {
+        return r == ESP_TLS_ERR_SSL_WANT_READ || r == ESP_TLS_ERR_SSL_WANT_WRITE ||
+               (r == -1 && (errno == EAGAIN || errno == EWOULDBLOCK));
+    }
+
+    esp_tls_t *handle = NULL;
+    esp_tls_cfg_t config;
+    int sockfd = -1; // Registered in cloudSockets
+};
+
+HttpExecutor<EspTlsTransport, HTTP_MAX_FLOWS> httpFlows;
+uint8_t httpTlsFlows = 0;               // Sheets uploads in flight, the only https job
+uint32_t httpFlowsFailed = 0;
+const char *const httpJobNames[] = {"sheetsUpload", "portalLogin", "portalLogout"}; // By HttpJobKind, also trace names
+
+#if STATIC_MEMORY_LAYOUT
+// Task stacks and control blocks, queue storage and timers, all in .bss
+StackType_t acqStack[ACQ_STACK_SIZE];
+StackType_t captureStack[CAPTURE_STACK_SIZE];
+StackType_t netStack[NET_STACK_SIZE];
+StackType_t cloudStack[CLOUD_STACK_SIZE];
+StackType_t buttonStack[BUTTON_STACK_SIZE];
+StackType_t supervisorStack[SUPERVISOR_STACK_SIZE];
+StackType_t logStack[LOG_STACK_SIZE];
+StackType_t telemetryStack[TELEMETRY_STACK_SIZE];
+StackType_t archiveStack[ARCHIVE_STACK_SIZE];
+StaticTask_t acqTcb, captureTcb, netTcb, cloudTcb, buttonTcb, supervisorTcb, logTcb, telemetryTcb, archiveTcb;
+uint8_t httpQueueStorage[HTTP_QUEUE_LENGTH * sizeof(HttpJob_t)];
+StaticQueue_t httpQueueControl;
+StaticSemaphore_t archiveMutexControl;
+StaticTimer_t ledTimerControl, debounceTimerControl, longPressTimerControl;
+#define TASK_MEMORY(stack, tcb) stack, &tcb
+#else
+#define TASK_MEMORY(stack, tcb) NULL, NULL
+#endif
+
+// Memory map of the statically allocated regions, printed at boot and served at /memmap
+typedef struct
+{
+    const char *name;
+    size_t bytes;
+} MemoryRegion_t;
+
+#define MEMORY_REGION(object) {#object, sizeof(object)}
+
+constexpr MemoryRegion_t memoryMap[] = {
+#if STATIC_MEMORY_LAYOUT
+    MEMORY_REGION(acqStack),
+    MEMORY_REGION(captureStack),
+    MEMORY_REGION(netStack),
+    MEMORY_REGION(cloudStack),
+    MEMORY_REGION(buttonStack),
+    MEMORY_REGION(supervisorStack),
+    MEMORY_REGION(logStack),
+    MEMORY_REGION(telemetryStack),
+    MEMORY_REGION(archiveStack),
+    {"taskControlBlocks", 9 * sizeof(StaticTask_t)},
+    {"httpQueue", sizeof(httpQueueStorage) + sizeof(StaticQueue_t)},
+    {"archiveMutex", sizeof(StaticSemaphore_t)},
+    {"timers", 3 * sizeof(StaticTimer_t)},
+#endif
+    MEMORY_REGION(captureBuffer),
+    MEMORY_REGION(captureDecimator),
+    MEMORY_REGION(captureFilters),
+    MEMORY_REGION(samplePool),
+    MEMORY_REGION(sampleRing),
+    MEMORY_REGION(sampleSinks),
+    MEMORY_REGION(archiveSpool),
+    MEMORY_REGION(rtdTable1),
+    MEMORY_REGION(rtdTable2),
+    MEMORY_REGION(powerDtStats),
+    MEMORY_REGION(telemetrySubscribers),
+    MEMORY_REGION(archiveEncoder),
+    MEMORY_REGION(archivePayload),
+    MEMORY_REGION(archiveReadBuffer),
+    MEMORY_REGION(archiveTailBuffer),
+    MEMORY_REGION(binaryLog),
+    MEMORY_REGION(readingAllan),
+    MEMORY_REGION(sampleAllan),
+    MEMORY_REGION(httpFlows),
+    MEMORY_REGION(traceBuffer),
+    MEMORY_REGION(dataCache),
+    MEMORY_REGION(sampleHistory),
+};
+
+#define MEMORY_MAP_REGIONS (sizeof(memoryMap) / sizeof(memoryMap[0]))
+
+constexpr size_t memoryMapBytes(size_t i = 0)
+{
+    return i < MEMORY_MAP_REGIONS ? memoryMap[i].bytes + memoryMapBytes(i + 1) : 0;
+}
+
+static_assert(memoryMapBytes() <= STATIC_MEMORY_BUDGET, "Static memory layout exceeds STATIC_MEMORY_BUDGET");
+static_assert(sizeof(captureBuffer) <= STATIC_MEMORY_BUDGET / 2, "Capture buffer takes more than half the budget");
+
+// Heap allocations made while an acquisition task is running, must stay 0.
+// Counted by the malloc wrappers below (-Wl,--wrap in platformio.ini).
+volatile uint32_t acquisitionHeapAllocs = 0;
+
+// Supervised tasks, each reports heartbeats to the supervisor
+enum SupervisedId
+{
+    SUP_ACQ,
+    SUP_CAPTURE,
+    SUP_NET,
+    SUP_CLOUD,
+    SUP_TELEMETRY,
+    SUP_ARCHIVE,
+    SUP_COUNT
+};
+
+Supervisor<SUP_COUNT> supervisor;
+volatile bool wifiRecoveryRequested = false; // Set by the supervisor, handled by NetTask
+TaskRecovery taskRecovery[SUP_COUNT]; // Requested by the supervisor, acknowledged by the task once it has reset itself
+
 // Create MAX31865 sensor objects
 Adafruit_MAX31865 max1 = Adafruit_MAX31865(CS1);
 Adafruit_MAX31865 max2 = Adafruit_MAX31865(CS2);
@@ -111,23 +852,110 @@ Adafruit_INA219 ina219;
 
 // Function prototypes
 void cloudTask(void *pvParameters);
-void wifiLedTask(void *pvParameters);
-void dataLedTask(void *pvParameters);
-void buttonTask(void *pvParameters);
-void mainTask(void *pvParameters);
+void buttonWorkerTask(void *pvParameters);
+void ledSetIdle(LedId id, bool level);
+void ledTimerCallback(TimerHandle_t timer);
+void debounceTimerCallback(TimerHandle_t timer);
+void longPressTimerCallback(TimerHandle_t timer);
+void buttonIsr();
+void ledWritePin(uint8_t pin, bool level);
+bool buttonReadPin();
+void ledBlink(LedId id, uint16_t onMs, uint16_t offMs, int16_t count);
+void handleWakeups();
+void acquisitionTask(void *pvParameters);
+void netTask(void *pvParameters);
+void handleJitter();
+void captureTask(void *pvParameters);
+bool captureDecimation(uint32_t periodUs, uint16_t *cicRate, uint16_t *firRate);
 void myFunction();
 void measureParameters();
-void sendDataToCloud();
-void sendDataToGoogleSheets(float t1, float t2, float voltage, float current, float power);
+void notifySinks(uint32_t mask);
+void telemetryTask(void *pvParameters);
+void archiveTask(void *pvParameters);
+void handleSinks();
+void historyAdd(const Sample_t &sample);
+void handleHistory();
+void sendTelemetryFrame(const Sample_t &sample);
+void handleSubscribe();
+void handleUnsubscribe();
+void handleCapture();
+void handleCaptureStatus();
+void handleCaptureData();
+void handleFilters();
+String googleSheetsRow(const Sample_t &sample);
+bool queueHttpJob(uint8_t kind);
+void startHttpJob(uint8_t kind, const Sample_t *row, uint32_t now);
+void httpJobDone(int slot, const HttpFlow<EspTlsTransport> &flow, uint32_t kind);
+void handlePoolStats();
 void handleRoot();
 void handleGetData();
+void buildDataResponse();
 void calculateThermalconductivity();
+void heaterBegin();
+uint32_t runClockMs();
+void saveRunState();
+bool restoreRunState();
+void interlockBegin();
+bool mosfetToggle();
+void handleInterlock();
+void heaterWrite(uint16_t level);
+void updateForecast();
+void handleForecast();
+void handleAllan();
 void handleUpload();
 void handleUpdate();
 void handleUpdatePage();
 bool handleNITJWifiCaptivePortal();
-float readTemperature1(Adafruit_MAX31865 &sensor);
-float readTemperature2(Adafruit_MAX31865 &sensor);
+void readTemperaturePair();
+float readRtdKelvin(Adafruit_MAX31865 &sensor, float rref, float offset, uint32_t &tUs);
+Q16 readRtdKelvinQ(Adafruit_MAX31865 &sensor, const RtdTable &table, Q16 offset, uint32_t &tUs);
+float rtdToKelvin(float rtdCode, float rref);
+String formatValue(float value, unsigned int decimals = 2);
+size_t formatValueTo(char *buf, size_t size, float value, unsigned int decimals = 2);
+bool formatRootPlaceholder(const char *name, size_t length, char *out, size_t size);
+void printMemoryMap();
+void archiveBegin();
+void loadDeviceName();
+bool validDeviceName(const char *name);
+void startMdns();
+void updateMdnsRun();
+void handleSetName();
+bool archiveStart(const char *run);
+void archiveStop();
+void archiveAppend(const Sample_t &sample);
+bool archiveFlush();
+void handleArchiveRuns();
+void handleArchiveStart();
+void handleArchiveStop();
+void handleArchiveRead();
+void handleArchiveDelete();
+void handleMemoryMap();
+void handleBenchNumeric();
+void supervisorTask(void *pvParameters);
+void logDrainTask(void *pvParameters);
+void handleLog();
+void handleTrace();
+void handleSupervisor();
+bool connectWiFi();
+void startNetServices();
+bool startTask(TaskHandle_t *handle);
+void stopTask(TaskHandle_t *handle);
+void superviseRestart(int id, TaskHandle_t *task, TaskSockets &sockets, const char *subsystem, uint32_t now);
+
+// Task plan: acquisition owns CORE_ACQ, everything touching the network runs on CORE_NET
+// next to the WiFi driver. A TLS upload can therefore never preempt a sample.
+const TaskSpec_t taskTable[] = {
+    // function          name            stack  prio  handle                   core      static stack/TCB
+    {acquisitionTask, "AcqTask", ACQ_STACK_SIZE, 3, &acquisitionTaskHandle, CORE_ACQ, TASK_MEMORY(acqStack, acqTcb)},
+    {captureTask, "CaptureTask", CAPTURE_STACK_SIZE, 2, &captureTaskHandle, CORE_ACQ, TASK_MEMORY(captureStack, captureTcb)}, // Only runs during a burst
+    {supervisorTask, "Supervisor", SUPERVISOR_STACK_SIZE, 4, &supervisorTaskHandle, CORE_ACQ, TASK_MEMORY(supervisorStack, supervisorTcb)}, // Short check once per second
+    {netTask, "NetTask", NET_STACK_SIZE, 2, &netTaskHandle, CORE_NET, TASK_MEMORY(netStack, netTcb)},
+    {cloudTask, "CloudTask", CLOUD_STACK_SIZE, 1, &cloudTaskHandle, CORE_NET, TASK_MEMORY(cloudStack, cloudTcb)},
+    {buttonWorkerTask, "ButtonWorker", BUTTON_STACK_SIZE, 1, &buttonWorkerTaskHandle, CORE_NET, TASK_MEMORY(buttonStack, buttonTcb)},
+    {logDrainTask, "LogDrain", LOG_STACK_SIZE, 1, &logDrainTaskHandle, CORE_NET, TASK_MEMORY(logStack, logTcb)}, // Only task that blocks on Serial
+    {telemetryTask, "TelemetryTask", TELEMETRY_STACK_SIZE, 2, &telemetryTaskHandle, CORE_NET, TASK_MEMORY(telemetryStack, telemetryTcb)},
+    {archiveTask, "ArchiveTask", ARCHIVE_STACK_SIZE, 1, &archiveTaskHandle, CORE_NET, TASK_MEMORY(archiveStack, archiveTcb)}, // Blocks on flash writes
+};
 
 // Median Filter Implementation
 float getMedian(float samples[], int size)
@@ -151,14 +979,105 @@ float getMedian(float samples[], int size)
 
 void initMedianFilter()
 {
+    rtdAligner.reset();
     for (int i = 0; i < MEDIAN_WINDOW; i++)
     {
-        tempBuffer1[i] = readTemperature1(max1);
-        tempBuffer2[i] = readTemperature2(max2);
+        readTemperaturePair();
         vTaskDelay(100 / portTICK_PERIOD_MS); // Allow time between readings
     }
 }
 
+// Time base of the forecast, continued across a warm restart (the reset itself is not counted)
+uint32_t runClockMs()
+{
+    return millis() + runClockOffsetMs;
+}
+
+// Checkpoint of the run, after every sample. Two CRCs over about 1 KB, well under the
+// cost of one RTD conversion.
+void saveRunState()
+{
+    uint32_t startUs = micros();
+    RunState_t state;
+    state.runClockMs = runClockMs();
+#if FIXED_POINT_MODE
+    memcpy(state.tempBuffer1, tempBufferQ1, sizeof(state.tempBuffer1));
+    memcpy(state.tempBuffer2, tempBufferQ2, sizeof(state.tempBuffer2));
+#else
+    memcpy(state.tempBuffer1, tempBuffer1, sizeof(state.tempBuffer1));
+    memcpy(state.tempBuffer2, tempBuffer2, sizeof(state.tempBuffer2));
+#endif
+    state.bufferIndex = bufferIndex;
+    state.heaterLevel = heaterLevel;
+    state.mosfetOn = mosfetState;
+    state.interlockTripped = safetyInterlock.tripped();
+    state.sampleThickness = sampleThickness;
+    state.diameter = diameter;
+    state.crossSectionArea = crossSectionArea;
+    strncpy(state.archiveRun, archiveRun, sizeof(state.archiveRun));
+    state.powerDtStats = powerDtStats;
+    state.dtForecast = dtForecast;
+    state.forecastPower_mW = forecastPower_mW;
+    runCheckpoint.save(state, RUN_STATE_LAYOUT);
+    checkpointUs = micros() - startUs;
+}
+
+// Puts the run back after a reset that kept RTC memory, false on a cold boot. Called from
+// setup() once the heater, interlock and archive are up.
+bool restoreRunState()
+{
+    resetReason = esp_reset_reason();
+    bool kept = resetReason == ESP_RST_SW || resetReason == ESP_RST_PANIC || resetReason == ESP_RST_INT_WDT ||
+                resetReason == ESP_RST_TASK_WDT || resetReason == ESP_RST_WDT;
+    RunState_t state;
+    if (!kept || !runCheckpoint.restore(state, RUN_STATE_LAYOUT))
+    {
+        runCheckpoint.invalidate(); // Power-on garbage
+        return false;
+    }
+
+    runClockOffsetMs = state.runClockMs - millis();
+    rtdAligner.reset();
+#if FIXED_POINT_MODE
+    memcpy(tempBufferQ1, state.tempBuffer1, sizeof(state.tempBuffer1));
+    memcpy(tempBufferQ2, state.tempBuffer2, sizeof(state.tempBuffer2));
+#else
+    memcpy(tempBuffer1, state.tempBuffer1, sizeof(state.tempBuffer1));
+    memcpy(tempBuffer2, state.tempBuffer2, sizeof(state.tempBuffer2));
+#endif
+    bufferIndex = (unsigned)state.bufferIndex % MEDIAN_WINDOW;
+    sampleThickness = state.sampleThickness;
+    diameter = state.diameter;
+    crossSectionArea = state.crossSectionArea;
+    powerDtStats = state.powerDtStats;
+    dtForecast = state.dtForecast;
+    forecastPower_mW = state.forecastPower_mW;
+
+    // A latched interlock fault is not cleared by the reset. The heater only comes back
+    // after a deliberate restart: a crash or watchdog reset may have come from the control
+    // path itself, so the run continues with the heater and MOSFET off.
+    if (state.interlockTripped)
+    {
+        safetyInterlock.latch(INTERLOCK_RESTORED);
+    }
+    else if (resetReason == ESP_RST_SW)
+    {
+        heaterWrite(state.heaterLevel);
+        if (state.mosfetOn)
+        {
+            mosfetToggle();
+        }
+    }
+    state.archiveRun[ARCHIVE_MAX_RUN_NAME] = '\0';
+    if (state.archiveRun[0] != '\0')
+    {
+        archiveStart(state.archiveRun);
+    }
+    Serial.printf("[Restart] Warm start (reason %d), run clock %u ms, heater %u%s\n", (int)resetReason,
+                  state.runClockMs, (unsigned)heaterLevel, mosfetState ? " on" : "");
+    return true;
+}
+
 void saveOffsetToEEPROM(float offset)
 {
     // First erase the entire EEPROM section we're using
@@ -168,7 +1087,7 @@ void saveOffsetToEEPROM(float offset)
     }
     EEPROM.put(EEPROM_OFFSET_ADDR, offset);
     EEPROM.commit();
-    Serial.printf("Saved offset to EEPROM: %.3f\n", offset);
+    LOG_INFO("Saved offset to EEPROM: %.3f", offset);
 }
 
 float readOffsetFromEEPROM()
@@ -209,8 +1128,101 @@ void resetEEPROMOffset()
     }
 }
 
+// Lowercase letters, digits and '-', as mDNS host names want
+bool validDeviceName(const char *name)
+{
+    size_t length = strlen(name);
+    if (length == 0 || length > DEVICE_NAME_MAX || name[0] == '-')
+    {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++)
+    {
+        if (!islower((unsigned char)name[i]) && !isdigit((unsigned char)name[i]) && name[i] != '-')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Name saved with /setName, otherwise cryo-xxxxxx from the last three MAC bytes
+void loadDeviceName()
+{
+    for (int i = 0; i <= DEVICE_NAME_MAX; i++)
+    {
+        deviceName[i] = EEPROM.read(EEPROM_NAME_ADDR + i);
+    }
+    deviceName[DEVICE_NAME_MAX] = '\0';
+
+    if (!validDeviceName(deviceName))
+    {
+        uint8_t mac[6];
+        WiFi.macAddress(mac);
+        snprintf(deviceName, sizeof(deviceName), "cryo-%02x%02x%02x", mac[3], mac[4], mac[5]);
+    }
+    Serial.printf("Device name: %s\n", deviceName);
+}
+
+// Advertises <deviceName>.local with the dashboard and the telemetry stream.
+// TXT records let a host tell rigs apart without connecting to them.
+void startMdns()
+{
+    if (mdnsStarted)
+    {
+        MDNS.end();
+    }
+    mdnsStarted = MDNS.begin(deviceName);
+    if (!mdnsStarted)
+    {
+        Serial.println("Error setting up MDNS responder!");
+        return;
+    }
+    MDNS.setInstanceName(deviceName);
+    MDNS.addService("http", "tcp", 80);
+    MDNS.addService("cryo", "udp", TELEMETRY_PORT);
+    MDNS.addServiceTxt("cryo", "udp", "fw", FIRMWARE_VERSION);
+    MDNS.addServiceTxt("cryo", "udp", "frame", String(TELEMETRY_VERSION).c_str());
+    MDNS.addServiceTxt("cryo", "udp", "channels", "temp1,temp2,dT,busVoltage,current_mA,power_mW,k,u_k");
+    MDNS.addServiceTxt("cryo", "udp", "mac", WiFi.macAddress().c_str());
+    updateMdnsRun();
+    Serial.printf("mDNS: http://%s.local\n", deviceName);
+}
+
+// Keeps the "run" TXT record in step with the active archive run
+void updateMdnsRun()
+{
+    if (mdnsStarted)
+    {
+        MDNS.addServiceTxt("cryo", "udp", "run", archiveRun[0] != '\0' ? archiveRun : "-");
+    }
+}
+
+// /setName?name=rig-2 stores the name and re-announces under it
+void handleSetName()
+{
+    TRACE_SCOPE("handleSetName");
+    String name = server.arg("name");
+    if (!validDeviceName(name.c_str()))
+    {
+        server.send(400, "text/plain", "name must be 1-24 characters of a-z 0-9 - (not starting with -)");
+        return;
+    }
+
+    for (int i = 0; i <= DEVICE_NAME_MAX; i++)
+    {
+        EEPROM.write(EEPROM_NAME_ADDR + i, i < (int)name.length() ? name[i] : '\0');
+    }
+    EEPROM.commit();
+
+    strcpy(deviceName, name.c_str());
+    server.send(200, "text/plain", "Renamed to " + name + ".local");
+    startMdns();
+}
+
 void handleResetOffset()
 {
+    TRACE_SCOPE("handleResetOffset");
     resetEEPROMOffset();       // Clears EEPROM and sets to 0.0
     temperature_offset = 0.0f; // Ensure in-memory value is reset
     server.send(200, "text/plain", "Offset reset to zero");
@@ -225,6 +1237,7 @@ void setup()
 
     // Load saved offset
     temperature_offset = readOffsetFromEEPROM();
+    loadDeviceName();
 
     // // Initialize PWM for MOSFET control
     // ledcSetup(0, 5000, 8);    // Channel 0, 5kHz, 8-bit resolution
@@ -232,7 +1245,7 @@ void setup()
     // ledcWrite(0, 255);          // Start with 0% duty cycle
 
     // Improved hardware logic using ESP32 DAC
-    dacWrite(DAC_GPIO, 0);
+    heaterBegin();
     Serial.print("Dac  Initialised to : ");
     Serial.println(dacValue);
 
@@ -243,68 +1256,129 @@ void setup()
     pinMode(BUTTON, INPUT_PULLDOWN);
     pinMode(MOSFET, OUTPUT);
 
-    digitalWrite(WifiLED1, HIGH); // Start with WiFi LED on (solid)
-    digitalWrite(MosfetLED2, LOW);
-    digitalWrite(DataLED3, LOW);
+    leds.begin(ledWritePin, ledPins, ledIdleLevels);
+    button.begin(buttonReadPin, DEBOUNCE_MS, LONG_PRESS_MS);
     digitalWrite(MOSFET, HIGH); // Active low - start with MOSFET off
+    interlockBegin();
+
+    // Button edges and LED patterns are driven by software timers, no polling tasks
+#if STATIC_MEMORY_LAYOUT
+    ledTimer = xTimerCreateStatic("LedTimer", 1, pdFALSE, NULL, ledTimerCallback, &ledTimerControl);
+    debounceTimer = xTimerCreateStatic("Debounce", pdMS_TO_TICKS(DEBOUNCE_MS), pdFALSE, NULL, debounceTimerCallback, &debounceTimerControl);
+    longPressTimer = xTimerCreateStatic("LongPress", pdMS_TO_TICKS(LONG_PRESS_MS), pdFALSE, NULL, longPressTimerCallback, &longPressTimerControl);
+#else
+    ledTimer = xTimerCreate("LedTimer", 1, pdFALSE, NULL, ledTimerCallback);
+    debounceTimer = xTimerCreate("Debounce", pdMS_TO_TICKS(DEBOUNCE_MS), pdFALSE, NULL, debounceTimerCallback);
+    longPressTimer = xTimerCreate("LongPress", pdMS_TO_TICKS(LONG_PRESS_MS), pdFALSE, NULL, longPressTimerCallback);
+#endif
+    attachInterrupt(digitalPinToInterrupt(BUTTON), buttonIsr, CHANGE);
+
+    // Initialize MAX31865 sensors
+    max1.begin(MAX31865_2WIRE);
+    max2.begin(MAX31865_2WIRE);
+
+    // Initialize INA219
+    if (!ina219.begin())
+    {
+        Serial.println("Failed to find INA219!");
+    }
+
+    // RTD conversion tables for the fixed-point path
+    rtdTable1.build([](float code)
+                    { return rtdToKelvin(code, RREF1); });
+    rtdTable2.build([](float code)
+                    { return rtdToKelvin(code, RREF2); });
+
+    archiveBegin();
+
+    dtForecast.begin(FORECAST_FORGETTING);
+    acquisitionRate.begin(ADAPTIVE_MIN_INTERVAL_MS, ADAPTIVE_MAX_INTERVAL_MS, ADAPTIVE_SLOPE_K_S,
+                          ADAPTIVE_POWER_STEP_MW, ADAPTIVE_BACKOFF, ADAPTIVE_SMOOTHING_MS);
+    cloudLogger.begin(LOG_DEADBAND_DT_K, LOG_DEADBAND_POWER_MW, LOG_DEADBAND_K_REL,
+                      LOG_MIN_INTERVAL_MS, LOG_MAX_INTERVAL_MS);
+
+    // A warm restart picks the run up from RTC memory, a cold boot fills the median windows first
+    warmStart = restoreRunState();
+    if (!warmStart)
+    {
+        initMedianFilter();
+    }
+
+    // Create the outbound request queue (samples travel as handles)
+#if STATIC_MEMORY_LAYOUT
+    httpJobQueue = xQueueCreateStatic(HTTP_QUEUE_LENGTH, sizeof(HttpJob_t), httpQueueStorage, &httpQueueControl);
+#else
+    httpJobQueue = xQueueCreate(HTTP_QUEUE_LENGTH, sizeof(HttpJob_t));
+#endif
+
+    // Sample fan-out: live telemetry only wants the newest frames, the archive must not lose
+    // any through a flash stall, Sheets rows are paced after an outage
+    sampleSinks.begin(&samplePool, [](uint32_t ms)
+                      { vTaskDelay(max(pdMS_TO_TICKS(ms), (TickType_t)1)); });
+    sampleSinks.addSink(SINK_TELEMETRY, "telemetry", SINK_DROP_OLDEST, 0);
+    sampleSinks.addSink(SINK_ARCHIVE, "archive", SINK_SPOOL, 0, 0, archiveSpool, SINK_ARCHIVE_SPOOL);
+    sampleSinks.addSink(SINK_SHEETS, "sheets", SINK_DROP_OLDEST, SINK_SHEETS_MIN_INTERVAL_MS);
+    sampleHistory.begin(historyResolutionMs);
+
+    // Deadlines count from here, tasks waiting on a queue or notification report idle
+    uint32_t now = millis();
+    supervisor.watch(SUP_ACQ, "AcqTask", ACQ_DEADLINE_MS, now);
+    supervisor.watch(SUP_CAPTURE, "CaptureTask", CAPTURE_DEADLINE_MS, now);
+    supervisor.watch(SUP_NET, "NetTask", NET_DEADLINE_MS, now);
+    supervisor.watch(SUP_CLOUD, "CloudTask", CLOUD_DEADLINE_MS, now);
+    supervisor.watch(SUP_TELEMETRY, "TelemetryTask", SINK_DEADLINE_MS, now);
+    supervisor.watch(SUP_ARCHIVE, "ArchiveTask", SINK_DEADLINE_MS, now);
+    for (int id = 0; id < SUP_COUNT; id++)
+    {
+        taskRecovery[id].begin(TASK_RESTART_GRACE_MS, TASK_SOCKET_GRACE_MS);
+    }
 
-    // Initialize median filter buffers
-    initMedianFilter();
-
-    // Create a queue for data LED control
-    dataLedQueue = xQueueCreate(5, sizeof(bool));
-
-    // Create cloud data queue (holds 5 entries)
-    cloudDataQueue = xQueueCreate(5, sizeof(CloudData_t));
-
-    // Create cloud task
-    xTaskCreatePinnedToCore(
-        cloudTask,        // Task function
-        "CloudTask",      // Task name
-        8192,             // Stack size
-        NULL,             // Parameters
-        2,                // Priority (lower than button task)
-        &cloudTaskHandle, // Task handle
-        1                 // Core (same as main task)
-    );
-
-    // Create tasks
-    xTaskCreatePinnedToCore(
-        wifiLedTask,        // Task function
-        "WiFiLEDTask",      // Task name
-        2048,               // Stack size
-        NULL,               // Parameters
-        2,                  // Priority
-        &wifiLedTaskHandle, // Task handle
-        0                   // Core (0 or 1)
-    );
-
-    xTaskCreatePinnedToCore(
-        dataLedTask,
-        "DataLEDTask",
-        2048,
-        NULL,
-        2,
-        &dataLedTaskHandle,
-        0);
-
-    xTaskCreatePinnedToCore(
-        buttonTask,
-        "ButtonTask",
-        4096,
-        NULL,
-        3, // Higher priority for responsive button handling
-        &buttonTaskHandle,
-        0);
-
-    xTaskCreatePinnedToCore(
-        mainTask,
-        "MainTask",
-        12288, // 12KB stack
-        NULL,
-        1,
-        &mainTaskHandle,
-        1);
+    for (size_t i = 0; i < sizeof(taskTable) / sizeof(taskTable[0]); i++)
+    {
+        startTask(taskTable[i].handle);
+    }
+
+    printMemoryMap();
+}
+
+// Creates the task of taskTable[] that owns handle
+bool startTask(TaskHandle_t *handle)
+{
+    for (size_t i = 0; i < sizeof(taskTable) / sizeof(taskTable[0]); i++)
+    {
+        const TaskSpec_t &spec = taskTable[i];
+        if (spec.handle != handle)
+        {
+            continue;
+        }
+#if STATIC_MEMORY_LAYOUT
+        *spec.handle = xTaskCreateStaticPinnedToCore(spec.function, spec.name, spec.stackSize, NULL,
+                                                     spec.priority, spec.stack, spec.tcb, spec.core);
+        bool created = *spec.handle != NULL;
+#else
+        bool created = xTaskCreatePinnedToCore(spec.function, spec.name, spec.stackSize, NULL,
+                                               spec.priority, spec.handle, spec.core) == pdPASS;
+#endif
+        if (!created)
+        {
+            Serial.printf("Failed to create %s\n", spec.name);
+        }
+        return created;
+    }
+    return false;
+}
+
+// Deletes a task wherever it is, only for one that holds no heap or socket (acquisition
+// before the OTA reboot), or a network task that is stuck past recovery, see superviseRestart().
+void stopTask(TaskHandle_t *handle)
+{
+    TaskHandle_t task = *handle;
+    *handle = NULL;
+    if (task != NULL)
+    {
+        vTaskDelete(task);
+        vTaskDelay(pdMS_TO_TICKS(50)); // Let the idle task finish with the TCB before its static memory is reused
+    }
 }
 
 void loop()
@@ -313,19 +1387,96 @@ void loop()
     vTaskDelete(NULL); // Delete the loop task
 }
 
-void mainTask(void *pvParameters)
+void acquisitionTask(void *pvParameters)
+{
+    // The median windows are already full, so the first sample is taken right away
+    TickType_t lastWake = xTaskGetTickCount() - pdMS_TO_TICKS(acquisitionIntervalMs);
+    uint32_t previousWakeUs = micros() - acquisitionIntervalMs * 1000;
+
+    for (;;)
+    {
+        uint32_t periodMs = acquisitionIntervalMs;
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(periodMs));
+        supervisor.beat(SUP_ACQ, millis());
+
+        uint32_t wakeUs = micros();
+        int32_t error = (int32_t)(wakeUs - previousWakeUs) - (int32_t)(periodMs * 1000);
+        uint32_t jitter = error < 0 ? -error : error;
+        previousWakeUs = wakeUs;
+        jitterLastUs = jitter;
+        jitterSumUs += jitter;
+        jitterCount++;
+        if (jitter > jitterMaxUs)
+        {
+            jitterMaxUs = jitter;
+        }
+
+        // During a burst the capture task owns the sensors and feeds the decimated values
+        if (!captureActive)
+        {
+            measureParameters();
+        }
+        calculateThermalconductivity();
+        updateForecast();
+
+        // Restart the long-τ analysis whenever the sampling interval changes
+        if (periodMs != sampleAllanIntervalMs)
+        {
+            sampleAllan.reset();
+            sampleAllanIntervalMs = periodMs;
+        }
+        float allanIn[ALLAN_CHANNELS] = {temp1, temp2, dT, power_mW};
+        sampleAllan.push(allanIn);
+        acquisitionIntervalMs = acquisitionRate.update(millis(), dT, power_mW);
+
+        // Fill the block once, every consumer reads it in place
+        BlockHandle handle = samplePool.alloc();
+        if (handle != INVALID_BLOCK)
+        {
+            Sample_t &sample = samplePool[handle];
+            sample.timestamp_ms = millis();
+            sample.temp1 = temp1;
+            sample.temp2 = temp2;
+            sample.dT = dT;
+            sample.busVoltage = busVoltage;
+            sample.current_mA = current_mA;
+            sample.power_mW = power_mW;
+            sample.thermalConductivity = thermalConductivity;
+            sample.thermalConductivityUnc = thermalConductivityUnc;
+            samplesPublished++;
+
+            // Never blocks, a full ring only costs the network side a sample
+            if (!sampleRing.push(handle))
+            {
+                samplePool.release(handle);
+            }
+            if (firstSampleMs == 0)
+            {
+                firstSampleMs = millis();
+                LOG_INFO("[Restart] First sample %u ms after a %s start", firstSampleMs, warmStart ? "warm" : "cold");
+            }
+        }
+        saveRunState();
+
+        acquisitionBusyUs = micros() - wakeUs;
+    }
+}
+
+// Tries every known network once, returns false when none could be joined.
+// Never blocks forever: the supervisor asks for another attempt while the link is down.
+bool connectWiFi()
 {
-    // Connect to Wi-Fi
+    WiFi.disconnect();
+
     bool connected = false;
     for (int i = 0; i < NUM_NETWORKS; i++)
     {
-        Serial.printf("Connecting to: %s\n", ssid[i]);
+        LOG_INFO("[WiFi] Connecting to: %s", ssid[i]);
 
         // Handle open networks
         if (strlen(password[i]) == 0)
         {                        // Empty password
             WiFi.begin(ssid[i]); // No password parameter
-            Serial.println("NITJ WIFI");
         }
         else
         {
@@ -335,8 +1486,8 @@ void mainTask(void *pvParameters)
         int attempts = 0;
         while (WiFi.status() != WL_CONNECTED && attempts < 10)
         {
-            Serial.print(".");
             vTaskDelay(1000 / portTICK_PERIOD_MS);
+            supervisor.beat(SUP_NET, millis());
             attempts++;
         }
 
@@ -345,7 +1496,7 @@ void mainTask(void *pvParameters)
             // Special handling for NITJ-WiFi captive portal
             if (strcmp(ssid[i], "NITJ-WiFi") == 0 || strcmp(ssid[i], "Cryogenics Lab") == 0)
             {
-                Serial.println("\nAttempting captive portal login...");
+                LOG_INFO("[WiFi] Attempting captive portal login");
                 if (!handleNITJWifiCaptivePortal())
                 {
                     WiFi.disconnect();
@@ -360,28 +1511,44 @@ void mainTask(void *pvParameters)
 
     if (!connected)
     {
-        Serial.println("All networks failed!");
-        while (1)
-            ; // Halt
+        LOG_WARN("[WiFi] All networks failed, retrying later");
+        return false;
     }
     wifiConnected = true;
-    Serial.println("\nConnected to Wi-Fi!");
-    Serial.print("ESP32 IP Address: ");
-    Serial.println(WiFi.localIP());
+    ledSetIdle(LED_WIFI, LOW);
+    ledBlink(LED_WIFI, WIFI_BLINK_ON_MS, WIFI_BLINK_OFF_MS, -1);
+    IPAddress ip = WiFi.localIP();
+    LOG_INFO("[WiFi] Connected, IP %u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    return true;
+}
 
-    // Initialize MAX31865 sensors
-    max1.begin(MAX31865_2WIRE);
-    max2.begin(MAX31865_2WIRE);
+// First in the handler chain, never handles anything: it notes the client of each
+// request NetTask parses, so the supervisor can shut it down under a stuck handler
+class RequestSocketTracker : public RequestHandler
+{
+public:
+    bool canHandle(HTTPMethod method, String uri) override
+    {
+        netSockets.clear();
+        netSockets.add(server.client().fd());
+        return false;
+    }
+};
 
-    // Initialize INA219
-    if (!ina219.begin())
+RequestSocketTracker requestSocketTracker;
+
+// Routes and mDNS are registered once, a restarted NetTask only reopens the server
+void startNetServices()
+{
+    static bool started = false;
+    if (started)
     {
-        Serial.println("Failed to find INA219!");
-        // while (1)
-        //     vTaskDelay(1000 / portTICK_PERIOD_MS);
+        return;
     }
+    started = true;
 
     // Define Web Server routes
+    server.addHandler(&requestSocketTracker);
     server.on("/", handleRoot);
     server.on("/setData", HTTP_POST, []()
               {
@@ -402,15 +1569,17 @@ void mainTask(void *pvParameters)
                   {
                       float offset = server.arg("temperatureoffset").toFloat();
                       temperature_offset += offset;
-                      Serial.println("setting offset");
                       saveOffsetToEEPROM(temperature_offset);
                   }
 
-                  // Handle DAC Value
-                  if (server.hasArg("dacValue"))
+                  // Heater: 16-bit level, or the 8-bit DAC code of the slider
+                  if (server.hasArg("heaterLevel"))
+                  {
+                      heaterWrite(constrain(server.arg("heaterLevel").toInt(), 0, HEATER_LEVEL_MAX));
+                  }
+                  else if (server.hasArg("dacValue"))
                   {
-                      dacValue = server.arg("dacValue").toInt();
-                      dacWrite(DAC_GPIO, dacValue);
+                      heaterWrite(constrain(server.arg("dacValue").toInt(), 0, 255) << 8);
                   }
 
                   // server.send(200, "text/plain", "Parameters updated successfully");
@@ -418,318 +1587,991 @@ void mainTask(void *pvParameters)
                   server.send(303); });
 
     server.on("/getData", handleGetData);
-    // server.on("/setDac", HTTP_GET, []()
-    //           {
-    //     if (server.hasArg("value")) {
-    //         dacValue = server.arg("value").toInt();
-    //         dacWrite(DAC_GPIO, dacValue);
-    //         Serial.print("DAC set to ");
-    //         Serial.println(dacValue);
-    //         server.send(200, "text/plain", "DAC set to " + String(dacValue));
-    //     } });
+    const char *cachedHeaders[] = {"If-None-Match"};
+    server.collectHeaders(cachedHeaders, 1);
+    dataCache.begin(esp_random()); // A tag from before a reboot never matches
 
     server.on("/toggleMosfet", HTTP_GET, []()
               {
-            digitalWrite(MOSFET, mosfetState ? HIGH : LOW);
-            mosfetState = !mosfetState;
-            digitalWrite(MosfetLED2, mosfetState);
+            if (!mosfetToggle())
+            {
+                server.send(409, "text/plain", "Interlock tripped");
+                return;
+            }
             server.send(200, "text/plain", mosfetState ? "ON" : "OFF"); });
 
     server.on("/resetOffset", HTTP_GET, handleResetOffset);
+    server.on("/subscribe", HTTP_GET, handleSubscribe);
+    server.on("/unsubscribe", HTTP_GET, handleUnsubscribe);
+    server.on("/capture", HTTP_GET, handleCapture);
+    server.on("/captureStatus", HTTP_GET, handleCaptureStatus);
+    server.on("/captureData", HTTP_GET, handleCaptureData);
+    server.on("/filters", HTTP_GET, handleFilters);
+    server.on("/benchNumeric", HTTP_GET, handleBenchNumeric);
+    server.on("/wakeups", HTTP_GET, handleWakeups);
+    server.on("/jitter", HTTP_GET, handleJitter);
+    server.on("/forecast", HTTP_GET, handleForecast);
+    server.on("/log", HTTP_GET, handleLog);
+    server.on("/trace", HTTP_GET, handleTrace);
+    server.on("/interlock", HTTP_GET, handleInterlock);
+    server.on("/allan", HTTP_GET, handleAllan);
+    server.on("/pool", HTTP_GET, handlePoolStats);
+    server.on("/memmap", HTTP_GET, handleMemoryMap);
+    server.on("/supervisor", HTTP_GET, handleSupervisor);
+    server.on("/sinks", HTTP_GET, handleSinks);
+    server.on("/history", HTTP_GET, handleHistory);
+    server.on("/archive/runs", HTTP_GET, handleArchiveRuns);
+    server.on("/archive/start", HTTP_GET, handleArchiveStart);
+    server.on("/archive/stop", HTTP_GET, handleArchiveStop);
+    server.on("/archive/read", HTTP_GET, handleArchiveRead);
+    server.on("/archive/delete", HTTP_GET, handleArchiveDelete);
     server.on("/update", HTTP_GET, handleUpdatePage);
 
     server.on("/update", HTTP_POST, handleUpdate, handleUpload);
 
+    server.on("/setName", HTTP_GET, handleSetName);
+
     // Enable mDNS
-    if (!MDNS.begin("cryo"))
+    startMdns();
+}
+
+void netTask(void *pvParameters)
+{
+    supervisor.beat(SUP_NET, millis());
+
+    // Also the entry of a NetTask recreated by the supervisor: the routes are kept, the
+    // hung client is dropped with the old listener
+    static bool serverStarted = false;
+    if (serverStarted)
     {
-        Serial.println("Error setting up MDNS responder!");
+        server.stop();
     }
-    MDNS.addService("http", "tcp", 80);
-
+    if (WiFi.status() != WL_CONNECTED)
+    {
+        connectWiFi();
+    }
+    startNetServices();
     server.begin();
-
-    unsigned long previousMeasureMillis = 0;
-    const long measureInterval = 1000; // 1 second interval for measurements
-
-    unsigned long previousSendMillis = 0;
-    const long sendInterval = 30000; // 30 second interval for send data
+    serverStarted = true;
 
     for (;;)
     {
+        supervisor.beat(SUP_NET, millis());
 
-        // Measurement every 1 seconds
-        if (millis() - previousMeasureMillis >= measureInterval)
+        // Asked by the supervisor after a stall: drop the clients and reopen the server
+        if (taskRecovery[SUP_NET].requested())
         {
-            previousMeasureMillis = millis();
-            measureParameters();
-            calculateThermalconductivity();
+            server.stop();
+            if (WiFi.status() != WL_CONNECTED)
+            {
+                connectWiFi();
+            }
+            server.begin();
+            taskRecovery[SUP_NET].acknowledge();
+            LOG_WARN("[Net] Web server restarted");
         }
 
-        if (millis() - previousSendMillis >= sendInterval)
+        if (wifiRecoveryRequested)
         {
-            previousSendMillis = millis();
-            sendDataToCloud();
+            wifiRecoveryRequested = false;
+            if (WiFi.status() != WL_CONNECTED)
+            {
+                connectWiFi();
+            }
         }
 
-        server.handleClient(); // Handle client requests
+        // Samples from the acquisition core go to the sinks, the ring's reference moves to latestSample
+        BlockHandle handle;
+        bool published = false;
+        while (sampleRing.pop(handle))
+        {
+            const Sample_t &sample = samplePool[handle];
+
+            // Change-only logging, every sample still goes to telemetry and the archive
+            uint32_t sinks = SINK_MASK(SINK_TELEMETRY) | SINK_MASK(SINK_ARCHIVE);
+            if (cloudLogger.shouldLog(sample.timestamp_ms, sample.dT, sample.power_mW, sample.thermalConductivity))
+            {
+                sinks |= SINK_MASK(SINK_SHEETS);
+            }
+            notifySinks(sampleSinks.publish(handle, millis(), sinks));
+            historyAdd(sample);
 
-        // Handle long press function call
-        if (buttonLongPress)
+            samplePool.release(latestSample);
+            latestSample = handle;
+            published = true;
+        }
+        // One serialization per batch, however many dashboards poll it
+        if (published)
         {
-            buttonLongPress = false;
-            myFunction();
+            buildDataResponse();
         }
 
+        server.handleClient(); // Handle client requests
+        netSockets.clear();    // Between requests NetTask blocks on no socket
+
         vTaskDelay(10 / portTICK_PERIOD_MS); // Small delay to prevent watchdog trigger
     }
 }
 
+// Executor for all outbound HTTP, the worker of the Sheets sink: starts portal requests
+// and rows while a slot is free and steps every flow in flight, so a slow portal never
+// holds up a Sheets upload
 void cloudTask(void *pvParameters)
 {
-    CloudData_t data;
-
-    for (;;)
-    {
-        // Wait for new data (blocking)
-        if (xQueueReceive(cloudDataQueue, &data, portMAX_DELAY) == pdTRUE)
-        {
-            if (WiFi.status() == WL_CONNECTED)
-            {
-                // Serial.printf("[Cloud] Sending: T1=%.2f, T2=%.2f, V=%.2f\n",
-                //               data.temp1, data.temp2, data.busVoltage);
-                Serial.println("[Cloud] Sending");
-
-                sendDataToGoogleSheets(
-                    data.temp1,
-                    data.temp2,
-                    data.busVoltage,
-                    data.current_mA,
-                    data.power_mW);
-            }
-            else
-            {
-                Serial.println("[Cloud] WiFi disconnected - data not sent");
-            }
-        }
-    }
-}
+    HttpJob_t job;
+    Sample_t row;
 
-void wifiLedTask(void *pvParameters)
-{
-    bool ledState = HIGH;
+    // Recreated by the supervisor: the flows the old task left behind are closed here
+    httpFlows.cancelAll(millis(), httpJobDone);
 
     for (;;)
     {
-        if (!wifiConnected)
+        // Nothing in flight: sleep until a request or row arrives (or a paced row is due),
+        // otherwise come back every HTTP_POLL_MS. Rows stay in the sink while WiFi is down.
+        bool busy = httpFlows.active() > 0;
+        bool online = WiFi.status() == WL_CONNECTED;
+        if (busy)
         {
-            digitalWrite(WifiLED1, HIGH); // Solid on while connecting
+            supervisor.beat(SUP_CLOUD, millis());
         }
         else
         {
-            // Blink pattern: 100ms on, 4900ms off (5 second total period)
-            if (ledState == HIGH)
-            {
-                digitalWrite(WifiLED1, HIGH);
-                vTaskDelay(10 / portTICK_PERIOD_MS);
-                digitalWrite(WifiLED1, LOW);
-                ledState = LOW;
-            }
-            else
-            {
-                vTaskDelay(4900 / portTICK_PERIOD_MS);
-                ledState = HIGH;
-            }
+            supervisor.idle(SUP_CLOUD, millis());
+        }
+        uint32_t dueMs = sampleSinks.waitMs(SINK_SHEETS, millis());
+        if (!online && dueMs != UINT32_MAX)
+        {
+            dueMs = HTTP_OFFLINE_POLL_MS;
+        }
+        TickType_t wait = busy ? pdMS_TO_TICKS(HTTP_POLL_MS) : dueMs == UINT32_MAX ? portMAX_DELAY : pdMS_TO_TICKS(dueMs);
+        ulTaskNotifyTake(pdTRUE, wait);
+        supervisor.beat(SUP_CLOUD, millis());
+
+        // Asked by the supervisor after a stall: the connections are closed here, on CORE_NET
+        if (taskRecovery[SUP_CLOUD].requested())
+        {
+            httpFlows.cancelAll(millis(), httpJobDone); // The rows in flight are lost
+            taskRecovery[SUP_CLOUD].acknowledge();
+            LOG_WARN("[Cloud] Restarted, requests in flight cancelled");
+            continue;
         }
 
-        vTaskDelay(10 / portTICK_PERIOD_MS); // Small delay
+        // Portal requests first: the upload backlog is useless until the login went through
+        while (!httpFlows.full() && xQueueReceive(httpJobQueue, &job, 0) == pdTRUE)
+        {
+            startHttpJob(job.kind, NULL, millis());
+        }
+        while (WiFi.status() == WL_CONNECTED && !httpFlows.full() && httpTlsFlows < HTTP_MAX_TLS_FLOWS &&
+               sampleSinks.take(SINK_SHEETS, row, millis()))
+        {
+            startHttpJob(HTTP_JOB_SHEETS, &row, millis());
+        }
+
+        httpFlows.poll(millis(), httpJobDone);
+    }
+}
+
+bool queueHttpJob(uint8_t kind)
+{
+    HttpJob_t job = {kind};
+    if (xQueueSend(httpJobQueue, &job, 0) != pdTRUE)
+    {
+        return false;
     }
+    if (cloudTaskHandle)
+    {
+        xTaskNotifyGive(cloudTaskHandle);
+    }
+    return true;
 }
 
-void dataLedTask(void *pvParameters)
+// Runs on CloudTask; row is the sample of an HTTP_JOB_SHEETS upload
+void startHttpJob(uint8_t kind, const Sample_t *row, uint32_t now)
 {
-    bool ledCommand;
+    TRACE_SCOPE("httpStart"); // Includes the DNS lookup
+    int slot = -1;
+    if (WiFi.status() != WL_CONNECTED)
+    {
+        LOG_WARN("[Cloud] WiFi disconnected - request %u not sent", kind);
+    }
+    else if (kind == HTTP_JOB_SHEETS)
+    {
+        LOG_DEBUG("[Cloud] Sending");
+        slot = httpFlows.start(GOOGLE_SCRIPT_URL, "POST", "application/json", googleSheetsRow(*row).c_str(),
+                               now, HTTP_CONNECT_TIMEOUT_MS + HTTP_TIMEOUT_MS, kind);
+    }
+    else if (kind == HTTP_JOB_PORTAL_LOGIN)
+    {
+        // The portal sometimes accepts the connection and never answers, the deadline covers that
+        slot = httpFlows.start("http://10.10.11.1:8090/httpclient.html", "POST", "application/x-www-form-urlencoded",
+                               "username=" NITJ_USERNAME "&password=" NITJ_PASSWORD "&mode=191",
+                               now, HTTP_CONNECT_TIMEOUT_MS + HTTP_TIMEOUT_MS, kind, "success");
+    }
+    else if (kind == HTTP_JOB_PORTAL_LOGOUT)
+    {
+        // Alternative endpoint: "http://10.10.11.1:8090/httpclient.html"
+        slot = httpFlows.start("http://10.10.11.1:8090/logout.xml", "POST", "application/x-www-form-urlencoded",
+                               "mode=193&username=" NITJ_USERNAME,
+                               now, HTTP_CONNECT_TIMEOUT_MS + HTTP_TIMEOUT_MS, kind, "logout");
+    }
 
-    for (;;)
+    if (slot < 0)
+    {
+        return;
+    }
+    traceEvent(httpJobNames[kind], TRACE_PHASE_BEGIN, TRACE_HTTP_THREAD + slot); // Flows overlap, one track per slot
+    if (kind == HTTP_JOB_SHEETS)
     {
-        if (xQueueReceive(dataLedQueue, &ledCommand, portMAX_DELAY) == pdTRUE)
+        httpTlsFlows++;
+    }
+}
+
+// Completion of a flow, on CloudTask
+void httpJobDone(int slot, const HttpFlow<EspTlsTransport> &flow, uint32_t kind)
+{
+    traceEvent(httpJobNames[kind], TRACE_PHASE_END, TRACE_HTTP_THREAD + slot);
+
+    bool complete = flow.state() == HTTP_DONE;
+    if (!complete)
+    {
+        httpFlowsFailed++;
+    }
+
+    if (kind == HTTP_JOB_SHEETS)
+    {
+        httpTlsFlows--;
+        LOG_DEBUG("[Cloud] Response code %d after %u ms", flow.status(), flow.elapsedMs());
+        if (complete && flow.status() == 302)
         {
-            if (ledCommand)
-            {
-                digitalWrite(DataLED3, HIGH);
-                vTaskDelay(100 / portTICK_PERIOD_MS);
-                digitalWrite(DataLED3, LOW);
-            }
+            ledBlink(LED_DATA, DATA_PULSE_MS, DATA_PULSE_MS, 1);
+        }
+        else
+        {
+            LOG_WARN("[Cloud] Data not sent (HTTP %d, %s)", flow.status(), httpFlowStateName(flow.state()));
+        }
+    }
+    else if (kind == HTTP_JOB_PORTAL_LOGIN)
+    {
+        // The body can be kilobytes, only its size is logged
+        LOG_INFO("[Portal] Login response %d, %u bytes", flow.status(), flow.bodyBytes());
+        if (flow.found())
+        {
+            LOG_INFO("[Portal] Login successful");
+        }
+        else if (complete)
+        {
+            LOG_WARN("[Portal] Login may have failed");
+        }
+        else
+        {
+            LOG_ERROR("[Portal] Login error (%s)", httpFlowStateName(flow.state()));
+        }
+    }
+    else if (kind == HTTP_JOB_PORTAL_LOGOUT)
+    {
+        LOG_INFO("[Portal] Logout response %d, %u bytes", flow.status(), flow.bodyBytes());
+        if (flow.found())
+        {
+            LOG_INFO("[Portal] Logged out");
+            // Optional: Disconnect WiFi after logout
+            WiFi.disconnect();
+        }
+        else
+        {
+            LOG_WARN("[Portal] Logout may have failed (%s)", httpFlowStateName(flow.state()));
+        }
+    }
+}
+
+// Time base of the button and LED engines: ticks in ms, the base of the software timers
+uint32_t tickMs()
+{
+    return xTaskGetTickCount() * portTICK_PERIOD_MS;
+}
+
+void ledWritePin(uint8_t pin, bool level)
+{
+    digitalWrite(pin, level);
+}
+
+bool buttonReadPin()
+{
+    return digitalRead(BUTTON) == HIGH;
+}
+
+// Re-arm the LED timer for the earliest pending transition, nothing runs while all LEDs are idle
+void ledReschedule(uint32_t waitMs)
+{
+    if (waitMs != LED_NO_CHANGE)
+    {
+        TickType_t wait = pdMS_TO_TICKS(waitMs);
+        xTimerChangePeriod(ledTimer, wait ? wait : 1, 0); // Also (re)starts the timer
+    }
+}
+
+void ledTimerCallback(TimerHandle_t timer)
+{
+    ledTimerWakeups++;
+    portENTER_CRITICAL(&ledMux);
+    uint32_t wait = leds.tick(tickMs());
+    portEXIT_CRITICAL(&ledMux);
+
+    ledReschedule(wait);
+}
+
+// Solid level, cancels any running pattern
+void ledSetIdle(LedId id, bool level)
+{
+    portENTER_CRITICAL(&ledMux);
+    leds.setIdle(id, level);
+    portEXIT_CRITICAL(&ledMux);
+}
+
+// Blink count times (-1 = forever), then return to the idle level
+void ledBlink(LedId id, uint16_t onMs, uint16_t offMs, int16_t count)
+{
+    portENTER_CRITICAL(&ledMux);
+    uint32_t now = tickMs();
+    leds.blink(id, onMs, offMs, count, now);
+    uint32_t wait = leds.nextWait(now);
+    portEXIT_CRITICAL(&ledMux);
+
+    ledReschedule(wait);
+}
+
+// Any edge restarts the debounce timer, the level is read once it has settled
+void IRAM_ATTR buttonIsr()
+{
+    BaseType_t woken = pdFALSE;
+    buttonIsrWakeups++;
+    button.edge(xTaskGetTickCountFromISR() * portTICK_PERIOD_MS);
+    xTimerResetFromISR(debounceTimer, &woken);
+    portYIELD_FROM_ISR(woken);
+}
+
+void debounceTimerCallback(TimerHandle_t timer)
+{
+    debounceWakeups++;
+    ButtonEvent event = button.settle(tickMs());
+    if (event == BUTTON_DOWN)
+    {
+        xTimerStart(longPressTimer, 0);
+    }
+    else if (event != BUTTON_NONE)
+    {
+        xTimerStop(longPressTimer, 0);
+    }
+
+    // Short press toggles the MOSFET, the release after a long press does nothing
+    if (event == BUTTON_SHORT_PRESS)
+    {
+        if (mosfetToggle())
+        {
+            LOG_INFO("MOSFET toggled: %s", mosfetState ? "ON" : "OFF");
+        }
+        else
+        {
+            LOG_WARN("MOSFET stays off, interlock tripped");
         }
     }
 }
 
-void buttonTask(void *pvParameters)
+void longPressTimerCallback(TimerHandle_t timer)
 {
-    TickType_t pressStartTime = 0;
-    bool buttonPressed = false;
-    const TickType_t longPressDuration = 3000 / portTICK_PERIOD_MS; // 3 seconds
+    longPressWakeups++;
+    if (button.longPressDue(tickMs()))
+    {
+        xTaskNotifyGive(buttonWorkerTaskHandle);
+    }
+}
 
+void buttonWorkerTask(void *pvParameters)
+{
     for (;;)
     {
-        if (digitalRead(BUTTON) == HIGH)
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        myFunction();
+    }
+}
+
+// Checks heartbeats once per second and restarts the network subsystems in place.
+// The hardware watchdog is fed from here only, and only while acquisition is alive:
+// a hung supervisor or an acquisition stuck for ACQ_FATAL_MS resets the chip.
+void supervisorTask(void *pvParameters)
+{
+    esp_task_wdt_init(WATCHDOG_TIMEOUT_S, true);
+    esp_task_wdt_add(NULL);
+
+    uint32_t wifiDownSince = millis();
+    uint32_t wifiOutageStart = 0;
+    int wifiEvent = -1; // Logged once per outage, completed when the link is back
+    TickType_t lastWake = xTaskGetTickCount();
+
+    for (;;)
+    {
+        vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(SUPERVISOR_PERIOD_MS));
+        uint32_t now = millis();
+
+        // The ISR has already cut the heater; bring the level, LED and log in line
+        static uint32_t interlockTrips = 0;
+        if (safetyInterlock.trips() != interlockTrips)
+        {
+            interlockTrips = safetyInterlock.trips();
+            heaterWrite(0);
+            ledSetIdle(LED_MOSFET, false);
+            supervisor.logEvent("heater", "interlock cutoff", now, 0);
+            LOG_ERROR("[Interlock] %s on %s, heater cut %u us after the reading",
+                      interlockFaultName(safetyInterlock.fault()), interlockChannelName(safetyInterlock.faultChannel()),
+                      safetyInterlock.tripLatencyUs());
+        }
+
+        uint32_t missed = supervisor.check(now);
+        for (int id = 0; id < SUP_COUNT; id++)
         {
-            if (!buttonPressed)
+            if (missed & (1UL << id))
             {
-                // Button just pressed
-                buttonPressed = true;
-                pressStartTime = xTaskGetTickCount();
+                LOG_WARN("[Supervisor] %s missed its %u ms deadline", supervisor.name(id), supervisor.deadline(id));
             }
-            else
+        }
+
+        superviseRestart(SUP_CLOUD, &cloudTaskHandle, cloudSockets, "cloud", now);
+        superviseRestart(SUP_NET, &netTaskHandle, netSockets, "web", now);
+
+        // WiFi: NetTask reconnects when asked, one request per WIFI_RECOVERY_MS of outage
+        if (WiFi.status() == WL_CONNECTED)
+        {
+            if (wifiEvent >= 0)
             {
-                // Button still pressed - check for long press
-                if ((xTaskGetTickCount() - pressStartTime) >= longPressDuration)
-                {
-                    // Long press detected
-                    buttonLongPress = true;
-                    buttonPressed = false; // Reset to wait for release
-                }
+                supervisor.complete(wifiEvent, now);
+                LOG_INFO("[Supervisor] WiFi restored after %u ms", now - wifiOutageStart);
+                wifiEvent = -1;
             }
+            wifiDownSince = now;
         }
         else
         {
-            if (buttonPressed)
+            if (wifiConnected)
+            {
+                wifiConnected = false;
+                ledSetIdle(LED_WIFI, HIGH);
+                ledBlink(LED_WIFI, 0, 0, 0); // Solid on until reconnected
+            }
+            if (now - wifiDownSince > WIFI_RECOVERY_MS && !wifiRecoveryRequested)
             {
-                // Button released - check if it was a short press
-                if ((xTaskGetTickCount() - pressStartTime) < longPressDuration)
+                LOG_WARN("[Supervisor] WiFi down for %u ms, reconnecting", now - wifiDownSince);
+                if (wifiEvent < 0)
                 {
-                    // // Short press - toggle MOSFET
-                    // if (mosfetState)
-                    // {
-                    //     dacValue = 255;
-                    // }
-                    // else
-                    // {
-                    //     dacValue = 0; // Default to full power when turning on
-                    // }
-                    // ledcWrite(0, dacValue);
-                    digitalWrite(MOSFET, mosfetState ? HIGH : LOW);
-                    mosfetState = !mosfetState;
-
-                    digitalWrite(MosfetLED2, mosfetState);
-                    Serial.println("MOSFET toggled: " + String(mosfetState ? "ON" : "OFF"));
+                    wifiEvent = supervisor.logEvent("wifi", "reconnect", now, now - wifiDownSince);
+                    wifiOutageStart = wifiDownSince;
                 }
-                buttonPressed = false;
+                wifiRecoveryRequested = true;
+                wifiDownSince = now;
             }
         }
 
-        vTaskDelay(50 / portTICK_PERIOD_MS); // Debounce delay
+        // Acquisition is never restarted; a stall (e.g. SPI) is logged and eventually ends in a
+        // reset, the only one the supervisor lets happen
+        if (supervisor.ageMs(SUP_ACQ, now) < ACQ_FATAL_MS)
+        {
+            esp_task_wdt_reset();
+        }
+    }
+}
+
+// A stalled network task is recovered in steps, never by a reboot. It is first asked to
+// reset itself, which it does on CORE_NET where its connections live. After
+// TASK_RESTART_GRACE_MS its sockets are shut down, so a send or recv it is blocked in
+// returns and it gets to the request. Still stuck TASK_SOCKET_GRACE_MS later, it is
+// deleted and created again on its static stack; the new task closes what the old one
+// left open.
+void shutdownSocket(int fd)
+{
+    shutdown(fd, SHUT_RDWR); // Not close(): the fd stays owned by its connection object
+}
+
+void superviseRestart(int id, TaskHandle_t *task, TaskSockets &sockets, const char *subsystem, uint32_t now)
+{
+    RecoveryAction action = taskRecovery[id].step(supervisor.isOverdue(id), now);
+    if (action == RECOVERY_NONE)
+    {
+        return;
+    }
+    uint32_t stalled = supervisor.ageMs(id, now);
+    if (action == RECOVERY_ASK)
+    {
+        supervisor.logEvent(subsystem, "restart task", now, stalled, id);
+        LOG_ERROR("[Supervisor] Restarting %s after %u ms stall", supervisor.name(id), stalled);
+    }
+    else if (action == RECOVERY_SHUTDOWN_SOCKETS)
+    {
+        int count = sockets.forEach(shutdownSocket);
+        supervisor.logEvent(subsystem, "close sockets", now, stalled, id);
+        LOG_ERROR("[Supervisor] %s did not restart within %u ms, shut down %d sockets", supervisor.name(id),
+                  TASK_RESTART_GRACE_MS, count);
+    }
+    else
+    {
+        // Deleted while holding archiveMutex, it would lock the archive out for good
+        if (*task && xSemaphoreGetMutexHolder(archiveMutex) == *task)
+        {
+            taskRecovery[id].postpone(now);
+            LOG_WARN("[Supervisor] %s holds the archive, recreating it later", supervisor.name(id));
+            return;
+        }
+        supervisor.logEvent(subsystem, "recreate task", now, stalled, id);
+        LOG_ERROR("[Supervisor] %s still stuck, recreating it", supervisor.name(id));
+        stopTask(task);
+        sockets.clear();
+        startTask(task);
+        return;
+    }
+    if (*task)
+    {
+        xTaskNotifyGive(*task); // Wakes CloudTask from its wait
     }
 }
 
-// void buttonTask(void *pvParameters)
-// {
-//     TickType_t pressStartTime = 0;
-//     bool buttonPressed = false;
-//     const TickType_t longPressDuration = 3000 / portTICK_PERIOD_MS; // 3 seconds
-
-//     for (;;)
-//     {
-//         if (digitalRead(BUTTON) == HIGH)
-//         {
-//             if (!buttonPressed)
-//             {
-//                 // Button just pressed
-//                 buttonPressed = true;
-//                 pressStartTime = xTaskGetTickCount();
-//             }
-//             else
-//             {
-//                 // Button still pressed - check for long press
-//                 if ((xTaskGetTickCount() - pressStartTime) >= longPressDuration)
-//                 {
-//                     // Long press detected
-//                     buttonLongPress = true;
-//                     buttonPressed = false; // Reset to wait for release
-//                 }
-//             }
-//         }
-//         else
-//         {
-//             if (buttonPressed)
-//             {
-//                 // Button released - check if it was a short press
-//                 if ((xTaskGetTickCount() - pressStartTime) < longPressDuration)
-//                 {
-//                     // Short press - toggle MOSFET
-//                     digitalWrite(MOSFET, mosfetState);
-//                     mosfetState = !mosfetState;
-//                     digitalWrite(MosfetLED2, mosfetState);
-//                     Serial.println("MOSFET toggled: " + String(mosfetState ? "ON" : "OFF"));
-//                 }
-//                 buttonPressed = false;
-//             }
-//         }
-
-//         vTaskDelay(50 / portTICK_PERIOD_MS); // Debounce delay
-//     }
-// }
+void handleSupervisor()
+{
+    TRACE_SCOPE("handleSupervisor");
+    uint32_t now = millis();
+    String json = "{\"tasks\":[";
+    for (int id = 0; id < SUP_COUNT; id++)
+    {
+        json += String(id ? "," : "") + "{\"name\":\"" + supervisor.name(id) + "\"";
+        json += ",\"deadlineMs\":" + String(supervisor.deadline(id));
+        json += ",\"active\":" + String(supervisor.isActive(id));
+        json += ",\"ageMs\":" + String(supervisor.ageMs(id, now));
+        json += ",\"misses\":" + String(supervisor.misses(id));
+        json += ",\"restarts\":" + String(supervisor.restarts(id));
+        json += ",\"worstLateMs\":" + String(supervisor.worstLateMs(id)) + "}";
+    }
+    json += "],\"events\":[";
+    for (uint32_t i = 0; i < supervisor.eventsLogged(); i++)
+    {
+        const RecoveryEvent_t &event = supervisor.event(i);
+        json += String(i ? "," : "") + "{\"t_ms\":" + String(event.t_ms);
+        json += ",\"subsystem\":\"" + String(event.subsystem) + "\"";
+        json += ",\"action\":\"" + String(event.action) + "\"";
+        json += ",\"stalledMs\":" + String(event.stalled_ms);
+        json += ",\"recoveryMs\":" + String(event.recovery_ms) + "}";
+    }
+    json += "],\"totalEvents\":" + String(supervisor.totalEvents());
+    json += ",\"http\":{\"active\":" + String(httpFlows.active());
+    json += ",\"queued\":" + String(uxQueueMessagesWaiting(httpJobQueue));
+    json += ",\"started\":" + String(httpFlows.started());
+    json += ",\"failed\":" + String(httpFlowsFailed) + "}";
+    json += ",\"uptime_ms\":" + String(now);
+    json += "}";
 
-void myFunction()
+    server.send(200, "application/json", json);
+}
+
+// Formats queued log records onto Serial, oldest first across both cores.
+// Runs at the lowest priority on the network core, so only this task waits on the UART.
+void logDrainTask(void *pvParameters)
 {
-    Serial.println("Long press detected - executing myFunction()");
+    static const char levelTags[] = "EWID";
+    char line[LOG_LINE_MAX];
+    for (;;)
+    {
+        int core;
+        const LogRecord_t *record;
+        while ((record = binaryLog.peek(core)) != nullptr)
+        {
+            int prefix = snprintf(line, sizeof(line), "[%u] %c%d ", record->t_ms, levelTags[record->level & 3], core);
+            size_t n = prefix < 0 ? 0 : min((size_t)prefix, sizeof(line) - 2);
+            n += logFormat(*record, line + n, sizeof(line) - n - 1);
+            line[n++] = '\n';
+            binaryLog.pop(core);
+            Serial.write((const uint8_t *)line, n);
+        }
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_PERIOD_MS));
+    }
+}
 
-    // Visual feedback
-    digitalWrite(WifiLED1, HIGH);
-    digitalWrite(MosfetLED2, HIGH);
-    digitalWrite(DataLED3, HIGH);
-    delay(200);
-    digitalWrite(WifiLED1, LOW);
-    digitalWrite(MosfetLED2, LOW);
-    digitalWrite(DataLED3, LOW);
+// Interlock state, limits and measured cutoff latency. ?clear=1 releases the latch when
+// every reading is back within limits (the heater stays off until switched on again);
+// ?maxTempK=, ?maxPowerMw= and ?maxCurrentMa= change the limits until the next boot.
+void handleInterlock()
+{
+    TRACE_SCOPE("handleInterlock");
+    if (server.hasArg("maxTempK"))
+    {
+        safetyInterlock.setLimit(INTERLOCK_TEMP1, server.arg("maxTempK").toFloat());
+        safetyInterlock.setLimit(INTERLOCK_TEMP2, server.arg("maxTempK").toFloat());
+    }
+    if (server.hasArg("maxPowerMw"))
+    {
+        safetyInterlock.setLimit(INTERLOCK_POWER, server.arg("maxPowerMw").toFloat());
+    }
+    if (server.hasArg("maxCurrentMa"))
+    {
+        safetyInterlock.setLimit(INTERLOCK_CURRENT, server.arg("maxCurrentMa").toFloat());
+    }
+    bool cleared = false;
+    if (server.arg("clear") == "1")
+    {
+        cleared = safetyInterlock.clear(micros());
+        if (cleared)
+        {
+            LOG_INFO("[Interlock] Cleared");
+        }
+    }
+    if (server.arg("resetStats") == "1")
+    {
+        safetyInterlock.resetStats();
+    }
 
-    // Only attempt logout if connected to NITJ-WiFi
-    if (WiFi.SSID() == "NITJ-WiFi")
+    float faultValue = safetyInterlock.faultValue();
+    String json = "{";
+    json += "\"tripped\":" + String(safetyInterlock.tripped() ? "true" : "false") + ",";
+    json += "\"cleared\":" + String(cleared ? "true" : "false") + ",";
+    json += "\"fault\":\"" + String(interlockFaultName(safetyInterlock.fault())) + "\",";
+    json += "\"channel\":\"" + String(interlockChannelName(safetyInterlock.faultChannel())) + "\",";
+    json += "\"value\":" + (isnan(faultValue) ? String("null") : String(faultValue, 3)) + ",";
+    json += "\"trips\":" + String(safetyInterlock.trips()) + ",";
+    json += "\"tripLatencyUs\":" + String(safetyInterlock.tripLatencyUs()) + ",";
+    json += "\"maxTripLatencyUs\":" + String(safetyInterlock.maxTripLatencyUs()) + ",";
+    json += "\"maxCheckGapUs\":" + String(safetyInterlock.maxCheckGapUs()) + ",";
+    json += "\"periodUs\":" + String(INTERLOCK_PERIOD_US) + ",";
+    json += "\"checks\":" + String(safetyInterlock.checks()) + ",";
+    json += "\"maxTempK\":" + String(safetyInterlock.limit(INTERLOCK_TEMP1), 3) + ",";
+    json += "\"maxPowerMw\":" + String(safetyInterlock.limit(INTERLOCK_POWER), 3) + ",";
+    json += "\"maxCurrentMa\":" + String(safetyInterlock.limit(INTERLOCK_CURRENT), 3) + ",";
+    json += "\"staleMs\":" + String(safetyInterlock.staleLimitUs() / 1000);
+    json += "}";
+
+    server.send(200, "application/json", json);
+}
+
+// Chrome trace JSON of the newest TRACE_RING_SIZE events per core, for ui.perfetto.dev or
+// chrome://tracing. ?enable=0 stops recording first, so the window of interest is kept.
+void handleTrace()
+{
+    if (server.hasArg("enable"))
+    {
+        traceOn = server.arg("enable").toInt() != 0;
+    }
+
+    server.client().setTimeout(NET_SEND_TIMEOUT_S);
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+
+    // Track names: tasks by handle, the HTTP slots by number
+    char chunk[1024];
+    size_t used = snprintf(chunk, sizeof(chunk), "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for (size_t i = 0; i < sizeof(taskTable) / sizeof(taskTable[0]); i++)
+    {
+        used += snprintf(chunk + used, sizeof(chunk) - used,
+                         "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%lu,\"args\":{\"name\":\"%s\"}},",
+                         taskTable[i].core, (unsigned long)(uintptr_t)*taskTable[i].handle, taskTable[i].name);
+    }
+    for (int slot = 0; slot < HTTP_MAX_FLOWS; slot++)
+    {
+        used += snprintf(chunk + used, sizeof(chunk) - used,
+                         "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"HTTP slot %d\"}},",
+                         CORE_NET, TRACE_HTTP_THREAD + slot, slot);
+    }
+    used = min(used, sizeof(chunk) - 1);
+
+    // Events are batched into chunks instead of one write each
+    uint32_t events = traceBuffer.exportJson(getCpuFrequencyMhz(), portTICK_PERIOD_MS * 1000,
+                                             [&](const char *text, size_t length, bool first)
+                                             {
+                                                 if (used + length + 1 > sizeof(chunk))
+                                                 {
+                                                     server.sendContent(chunk, used);
+                                                     used = 0;
+                                                 }
+                                                 if (!first)
+                                                 {
+                                                     chunk[used++] = ',';
+                                                 }
+                                                 memcpy(chunk + used, text, length);
+                                                 used += length;
+                                             });
+    if (events == 0 && used > 0 && chunk[used - 1] == ',')
     {
-        Serial.println("Attempting to logout from NITJ-WiFi captive portal...");
+        used--; // Only track names
+    }
 
-        WiFiClient client;
-        HTTPClient http;
+    char tail[160];
+    int n = snprintf(tail, sizeof(tail), "],\"otherData\":{\"events\":%u,\"written0\":%u,\"written1\":%u,\"recording\":%d}}",
+                     (unsigned)events, (unsigned)traceBuffer.ring(0).written(),
+                     (unsigned)traceBuffer.ring(portNUM_PROCESSORS - 1).written(), traceOn ? 1 : 0);
+    server.sendContent(chunk, used);
+    server.sendContent(tail, n);
+    server.sendContent("", 0); // Last chunk
+}
+
+// Log ring counters, /log?level=0..3 sets the runtime level (0 = errors only)
+void handleLog()
+{
+    TRACE_SCOPE("handleLog");
+    if (server.hasArg("level"))
+    {
+        int level = server.arg("level").toInt();
+        logLevel = level < LOG_LEVEL_ERROR ? LOG_LEVEL_ERROR : level > LOG_COMPILE_LEVEL ? LOG_COMPILE_LEVEL : level;
+    }
+
+    String json = "{";
+    json += "\"level\":" + String(logLevel) + ",";
+    json += "\"maxLevel\":" + String(LOG_COMPILE_LEVEL) + ",";
+    json += "\"cores\":[";
+    for (int core = 0; core < portNUM_PROCESSORS; core++)
+    {
+        json += String(core ? "," : "") + "{\"written\":" + String(binaryLog.written(core)) +
+                ",\"dropped\":" + String(binaryLog.drops(core)) + "}";
+    }
+    json += "]}";
+
+    server.send(200, "application/json", json);
+}
+
+// Acquisition scheduling latency, /jitter?reset=1 clears it before a load test
+void handleJitter()
+{
+    TRACE_SCOPE("handleJitter");
+    if (server.hasArg("reset"))
+    {
+        jitterMaxUs = 0;
+        jitterSumUs = 0;
+        jitterCount = 0;
+    }
 
-        // Configure logout URL - try both endpoints
-        String logoutURL = "http://10.10.11.1:8090/logout.xml";
-        // Alternative: "http://10.10.11.1:8090/httpclient.html"
+    String json = "{";
+    json += "\"samples\":" + String(jitterCount) + ",";
+    json += "\"lastUs\":" + String(jitterLastUs) + ",";
+    json += "\"meanUs\":" + String(jitterCount ? (uint32_t)(jitterSumUs / jitterCount) : 0) + ",";
+    json += "\"maxUs\":" + String(jitterMaxUs) + ",";
+    json += "\"busyUs\":" + String(acquisitionBusyUs) + ",";
+    json += "\"ringDrops\":" + String(sampleRing.drops()) + ",";
+    json += "\"intervalMs\":" + String(acquisitionIntervalMs) + ",";
+    json += "\"slopeKs\":" + String(acquisitionRate.slope(), 4) + ",";
+    json += "\"transients\":" + String(acquisitionRate.transients()) + ",";
+    json += "\"cloudLogged\":" + String(cloudLogger.logged()) + ",";
+    json += "\"cloudSuppressed\":" + String(cloudLogger.suppressed()) + ",";
+    json += "\"rtdSkewUs\":" + String(rtdSkewUs) + ",";
+    json += "\"rtdResidualSkewUs\":" + String(rtdResidualSkewUs) + ",";
+#if FIXED_POINT_MODE
+    json += "\"rampKs\":" + String(0.5f * (rtdAligner.slope(0) + rtdAligner.slope(1)).toFloat(), 5) + ",";
+#else
+    json += "\"rampKs\":" + String(0.5f * (rtdAligner.slope(0) + rtdAligner.slope(1)), 5) + ",";
+#endif
+    json += "\"dtAlignCorrection_mK\":" + String(rtdAlignCorrectionK * 1000, 3) + ",";
+    json += "\"warmStart\":" + String(warmStart ? "true" : "false") + ",";
+    json += "\"resetReason\":" + String((int)resetReason) + ",";
+    json += "\"firstSampleMs\":" + String(firstSampleMs) + ",";
+    json += "\"checkpoints\":" + String(runCheckpoint.sequence(RUN_STATE_LAYOUT)) + ",";
+    json += "\"checkpointUs\":" + String(checkpointUs) + ",";
+    json += "\"runClockMs\":" + String(runClockMs());
+    json += "}";
 
-        http.begin(client, logoutURL);
-        http.addHeader("Content-Type", "application/x-www-form-urlencoded");
+    server.send(200, "application/json", json);
+}
 
-        // Prepare logout payload
-        String postData = "mode=193&username=" + String(NITJ_USERNAME);
+// Sample pool usage; allocations per published sample should stay at 1
+void handlePoolStats()
+{
+    TRACE_SCOPE("handlePoolStats");
+    String json = "{";
+    json += "\"capacity\":" + String(samplePool.capacity()) + ",";
+    json += "\"inUse\":" + String(samplePool.inUse()) + ",";
+    json += "\"peak\":" + String(samplePool.peak()) + ",";
+    json += "\"allocations\":" + String(samplePool.allocations()) + ",";
+    json += "\"exhausted\":" + String(samplePool.exhaustions()) + ",";
+    json += "\"published\":" + String(samplesPublished) + ",";
+    json += "\"handleBytes\":" + String(sizeof(BlockHandle)) + ",";
+    json += "\"sampleBytes\":" + String(sizeof(Sample_t)) + ",";
+    json += "\"dataVersion\":" + String(dataCache.version()) + ",";
+    json += "\"dataBuilds\":" + String(dataCache.builds()) + ",";
+    json += "\"dataFull\":" + String(dataCache.fullResponses()) + ",";
+    json += "\"dataNotModified\":" + String(dataCache.notModifiedResponses());
+    json += "}";
 
-        int httpResponseCode = http.POST(postData);
-        String response = http.getString();
+    server.send(200, "application/json", json);
+}
 
-        Serial.print("Logout response code: ");
-        Serial.println(httpResponseCode);
-        Serial.print("Response: ");
-        Serial.println(response);
+// Per-sink queue, lag and drop statistics; ?reset=1 clears them
+void handleSinks()
+{
+    TRACE_SCOPE("handleSinks");
+    bool reset = server.hasArg("reset");
+    String json = "{\"depth\":" + String(sampleSinks.depth()) + ",\"sinks\":[";
+    for (int i = 0; i < SINK_COUNT; i++)
+    {
+        SinkStats_t stats = sampleSinks.stats(i);
+        json += String(i ? "," : "") + "{\"name\":\"" + sampleSinks.name(i) + "\"";
+        json += ",\"overflow\":\"" + String(sinkOverflowName(sampleSinks.overflow(i))) + "\"";
+        json += ",\"minIntervalMs\":" + String(sampleSinks.minIntervalMs(i));
+        json += ",\"spoolCapacity\":" + String(sampleSinks.spoolCapacity(i));
+        json += ",\"published\":" + String(stats.published);
+        json += ",\"delivered\":" + String(stats.delivered);
+        json += ",\"dropped\":" + String(stats.dropped);
+        json += ",\"spooled\":" + String(stats.spooled);
+        json += ",\"blocked\":" + String(stats.blocked);
+        json += ",\"backlog\":" + String(stats.backlog);
+        json += ",\"peakBacklog\":" + String(stats.peakBacklog);
+        json += ",\"lagMs\":" + String(stats.lagMs);
+        json += ",\"lagMsMean\":" + String(stats.delivered ? stats.lagMsSum / stats.delivered : 0);
+        json += ",\"lagMsMax\":" + String(stats.maxLagMs) + "}";
+        if (reset)
+        {
+            sampleSinks.resetStats(i);
+        }
+    }
+    json += "]}";
 
-        http.end();
+    server.send(200, "application/json", json);
+}
+
+void historyAdd(const Sample_t &sample)
+{
+    uint32_t startUs = micros();
+    const float values[HISTORY_CHANNELS] = {sample.temp1, sample.temp2, sample.power_mW, sample.thermalConductivity,
+                                            sample.thermalConductivityUnc};
+    sampleHistory.add(sample.timestamp_ms, values);
+    uint32_t us = micros() - startUs;
+    if (us > historyAddUsMax)
+    {
+        historyAddUsMax = us;
+    }
+}
+
+// /history?from=ms&to=ms&points=n: min/max/mean/count of each channel in at most n bins
+// over [from, to] (ms since boot, default the last 24 h, 300 points). The coarsest tier
+// that resolves n points is used, so the cost follows the points, not the samples.
+// Each point is [t, count, then min, max, mean per channel], NaN as null.
+void handleHistory()
+{
+    TRACE_SCOPE("handleHistory");
+    uint32_t now = millis();
+    uint32_t to = server.hasArg("to") ? strtoul(server.arg("to").c_str(), NULL, 10) : now;
+    uint32_t from = server.hasArg("from") ? strtoul(server.arg("from").c_str(), NULL, 10) : (to > 86400000UL ? to - 86400000UL : 0);
+    uint32_t points = server.hasArg("points") ? strtoul(server.arg("points").c_str(), NULL, 10) : 300;
+    points = constrain(points, 1, HISTORY_MAX_POINTS);
+    if (to < from)
+    {
+        server.send(400, "text/plain", "to must not be before from");
+        return;
+    }
+
+    server.client().setTimeout(NET_SEND_TIMEOUT_S);
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "application/json", "");
+
+    char out[1024];
+    size_t used = snprintf(out, sizeof(out), "{\"now\":%u,\"from\":%u,\"to\":%u,\"channels\":[", now, from, to);
+    for (int c = 0; c < HISTORY_CHANNELS; c++)
+    {
+        used += snprintf(out + used, sizeof(out) - used, "%s\"%s\"", c ? "," : "", historyChannelNames[c]);
+    }
+    used += snprintf(out + used, sizeof(out) - used, "],\"points\":[");
+
+    uint32_t sendUs = 0;
+    uint32_t count = 0;
+    uint32_t binMs = 0;
+    uint32_t startUs = micros();
+    int tier = sampleHistory.query(from, to, points, [&](const HistoryPoint<HISTORY_CHANNELS> &p)
+                                   {
+                                       // Flush before a point could overflow the chunk buffer
+                                       if (used > sizeof(out) - 384)
+                                       {
+                                           uint32_t t0 = micros();
+                                           server.sendContent(out, used);
+                                           sendUs += micros() - t0;
+                                           used = 0;
+                                       }
+                                       used += snprintf(out + used, sizeof(out) - used, "%s[%u,%u", count ? "," : "",
+                                                        p.tMs, p.count);
+                                       for (int c = 0; c < HISTORY_CHANNELS; c++)
+                                       {
+                                           const float values[3] = {p.min[c], p.max[c], p.mean[c]};
+                                           for (float value : values)
+                                           {
+                                               out[used++] = ',';
+                                               if (isnan(value))
+                                               {
+                                                   used += snprintf(out + used, sizeof(out) - used, "null");
+                                               }
+                                               else
+                                               {
+                                                   used += formatValueTo(out + used, sizeof(out) - used, value, historyDecimals[c]);
+                                               }
+                                           }
+                                       }
+                                       out[used++] = ']';
+                                       count++;
+                                   },
+                                   &binMs);
+    historyQueryUs = micros() - startUs - sendUs;
+    server.sendContent(out, used);
+
+    used = snprintf(out, sizeof(out),
+                    "],\"tier\":%d,\"resolutionMs\":%u,\"binMs\":%u,\"count\":%u,\"queryUs\":%u,\"addUsMax\":%u,\"samples\":%u,\"tiers\":[",
+                    tier, tier >= 0 ? sampleHistory.resolutionMs(tier) : 0, binMs, count, historyQueryUs, historyAddUsMax,
+                    sampleHistory.samples());
+    for (int i = 0; i < HISTORY_TIERS; i++)
+    {
+        used += snprintf(out + used, sizeof(out) - used, "%s{\"resolutionMs\":%u,\"buckets\":%d,\"oldest\":%u}", i ? "," : "",
+                         sampleHistory.resolutionMs(i), sampleHistory.size(i),
+                         sampleHistory.size(i) ? sampleHistory.oldestMs(i) : 0);
+    }
+    used += snprintf(out + used, sizeof(out) - used, "]}");
+    server.sendContent(out, used);
+    server.sendContent("", 0); // Last chunk
+}
+
+void handleWakeups()
+{
+    TRACE_SCOPE("handleWakeups");
+    String json = "{";
+    json += "\"buttonIsr\":" + String(buttonIsrWakeups) + ",";
+    json += "\"debounce\":" + String(debounceWakeups) + ",";
+    json += "\"longPress\":" + String(longPressWakeups) + ",";
+    json += "\"ledTimer\":" + String(ledTimerWakeups) + ",";
+    json += "\"uptime_ms\":" + String(millis());
+    json += "}";
+
+    server.send(200, "application/json", json);
+}
+
+void myFunction()
+{
+    LOG_INFO("Long press detected - executing myFunction()");
+
+    // Visual feedback, then resume the WiFi heartbeat
+    for (int i = 0; i < LED_COUNT; i++)
+    {
+        ledBlink((LedId)i, 200, 0, 1);
+    }
+    vTaskDelay(200 / portTICK_PERIOD_MS);
+    if (wifiConnected)
+    {
+        ledBlink(LED_WIFI, WIFI_BLINK_ON_MS, WIFI_BLINK_OFF_MS, -1);
+    }
+
+    // Only attempt logout if connected to NITJ-WiFi
+    if (WiFi.SSID() == "NITJ-WiFi")
+    {
+        LOG_INFO("[Portal] Logging out of NITJ-WiFi");
 
-        if (response.indexOf("success") != -1 || response.indexOf("logout") != -1)
-        {
-            Serial.println("Successfully logged out from captive portal");
-            // Optional: Disconnect WiFi after logout
-            WiFi.disconnect();
-        }
-        else
+        // CloudTask sends it and disconnects WiFi on success
+        if (!queueHttpJob(HTTP_JOB_PORTAL_LOGOUT))
         {
-            Serial.println("Logout may have failed - check response");
+            LOG_WARN("[Portal] Request queue full - logout not sent");
         }
     }
     else
     {
-        Serial.println("Not connected to NITJ-WiFi - logout not required");
+        LOG_INFO("[Portal] Not on NITJ-WiFi - logout not required");
     }
 }
 
 float readStableCurrent()
 {
+    TRACE_SCOPE("current");
     float sum = 0;
     float current = 0;
     for (int i = 0; i < SAMPLE_COUNT; i++)
@@ -745,11 +2587,47 @@ float readStableCurrent()
     return sum / SAMPLE_COUNT;
 }
 
+#if FIXED_POINT_MODE
+Q16 readStableCurrentQ()
+{
+    TRACE_SCOPE("current");
+    const Q16 threshold = Q16::fromRaw(Q16::ONE); // 1 mA
+    int32_t sum = 0;
+    for (int i = 0; i < SAMPLE_COUNT; i++)
+    {
+        Q16 current = Q16::fromFloat(ina219.getCurrent_mA());
+        if (!(current > threshold))
+        {
+            current = Q16::fromRaw(0);
+        }
+        sum += current.raw;
+        delay(10); // Small delay between readings
+    }
+    return Q16::fromRaw(sum / SAMPLE_COUNT);
+}
+
+void measureParameters()
+{
+    readTemperaturePair();
+
+    busVoltageQ = Q16::fromFloat(ina219.getBusVoltage_V());
+    current_mAQ = readStableCurrentQ();
+    power_mWQ = busVoltageQ * current_mAQ; // V × mA = mW
+
+    // Float copies for the consumers that have not moved to fixed point
+    temp1 = temp1Q.toFloat();
+    temp2 = temp2Q.toFloat();
+    busVoltage = busVoltageQ.toFloat();
+    current_mA = current_mAQ.toFloat();
+    power_mW = power_mWQ.toFloat();
+    safetyInterlock.report(INTERLOCK_CURRENT, current_mA, micros());
+    safetyInterlock.report(INTERLOCK_POWER, power_mW, micros());
+}
+#else
 void measureParameters()
 {
     // Read temperature
-    temp1 = readTemperature1(max1);
-    temp2 = readTemperature2(max2);
+    readTemperaturePair();
     // Serial.println(temp1);
     // Serial.println(temp2);
 
@@ -758,62 +2636,173 @@ void measureParameters()
     current_mA = readStableCurrent();
     // power_mW = ina219.getPower_mW();
     power_mW = busVoltage * current_mA;
+    safetyInterlock.report(INTERLOCK_CURRENT, current_mA, micros());
+    safetyInterlock.report(INTERLOCK_POWER, power_mW, micros());
 }
+#endif
 
-void sendDataToCloud()
+// Wakes the workers of the sinks that were handed a sample
+void notifySinks(uint32_t mask)
 {
-    CloudData_t cloudData = {
-        .temp1 = temp1,
-        .temp2 = temp2,
-        .busVoltage = busVoltage,
-        .current_mA = current_mA,
-        .power_mW = power_mW};
-
-    // Send to queue (non-blocking)
-    if (xQueueSend(cloudDataQueue, &cloudData, 0) != pdTRUE)
+    for (int i = 0; i < SINK_COUNT; i++)
     {
-        Serial.println("[Cloud] Queue full - data dropped");
+        if ((mask & SINK_MASK(i)) && *sinkWorkers[i])
+        {
+            xTaskNotifyGive(*sinkWorkers[i]);
+        }
     }
 }
 
-void sendDataToGoogleSheets(float t1, float t2, float voltage, float current, float power)
+// Worker of the telemetry sink
+void telemetryTask(void *pvParameters)
 {
-    HTTPClient http;
-    http.begin(GOOGLE_SCRIPT_URL);
-    http.addHeader("Content-Type", "application/json");
+    Sample_t sample;
+    for (;;)
+    {
+        supervisor.idle(SUP_TELEMETRY, millis());
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (sampleSinks.take(SINK_TELEMETRY, sample, millis()))
+        {
+            supervisor.beat(SUP_TELEMETRY, millis());
+            sendTelemetryFrame(sample);
+        }
+    }
+}
 
-    String ipAddress = WiFi.localIP().toString();
+void sendTelemetryFrame(const Sample_t &sample)
+{
+    TelemetryFrame_t frame;
+    frame.magic = TELEMETRY_MAGIC;
+    frame.version = TELEMETRY_VERSION;
+    frame.flags = mosfetState ? TELEMETRY_FLAG_MOSFET : 0;
+    frame.sequence = telemetrySequence++;
+    frame.timestamp_ms = sample.timestamp_ms;
+    frame.temp1 = sample.temp1;
+    frame.temp2 = sample.temp2;
+    frame.dT = sample.dT;
+    frame.busVoltage = sample.busVoltage;
+    frame.current_mA = sample.current_mA;
+    frame.power_mW = sample.power_mW;
+    frame.thermalConductivity = sample.thermalConductivity;
+    frame.thermalConductivityUnc = sample.thermalConductivityUnc;
+    frame.dacValue = dacValue;
+    frame.reserved = 0;
+    telemetrySeal(frame);
+
+    // Snapshot, so a /subscribe during the sends never tears a slot
+    TelemetrySubscriber_t subscribers[TELEMETRY_MAX_SUBSCRIBERS];
+    telemetrySubscribersLock.lock();
+    memcpy(subscribers, telemetrySubscribers, sizeof(subscribers));
+    telemetrySubscribersLock.unlock();
+
+    for (int i = 0; i < TELEMETRY_MAX_SUBSCRIBERS; i++)
+    {
+        const TelemetrySubscriber_t &sub = subscribers[i];
+        if (sub.port == 0)
+        {
+            continue;
+        }
+        if (!telemetryUdp.beginPacket(sub.ip, sub.port) ||
+            telemetryUdp.write((const uint8_t *)&frame, sizeof(frame)) != sizeof(frame) ||
+            !telemetryUdp.endPacket())
+        {
+            telemetrySendErrors++;
+        }
+    }
+}
 
-    String postData = "{\"temp1\":" + String(t1) +
-                      ",\"temp2\":" + String(t2) +
-                      ",\"voltage\":" + String(voltage) +
-                      ",\"current\":" + String(current) +
-                      ",\"power\":" + String(power) +
-                      ",\"thickness\":" + String(sampleThickness) +
-                      ",\"area\":" + String(crossSectionArea) +
-                      ",\"conductivity\":" + String(thermalConductivity, 4) +
-                      ",\"ip\":\"" + ipAddress + "\"" +
-                      "}";
+// /subscribe?port=5005 registers the requesting PC, add &broadcast=1 for the whole subnet
+void handleSubscribe()
+{
+    TRACE_SCOPE("handleSubscribe");
+    long port = TELEMETRY_PORT;
+    if (server.hasArg("port"))
+    {
+        String value = server.arg("port");
+        char *end;
+        port = strtol(value.c_str(), &end, 10);
+        if (end == value.c_str() || *end != '\0')
+        {
+            port = 0;
+        }
+    }
+    IPAddress ip = server.hasArg("broadcast") ? WiFi.broadcastIP() : server.client().remoteIP();
+    if (port < 1 || port > 65535)
+    {
+        server.send(400, "text/plain", "port must be 1-65535");
+        return;
+    }
 
-    int httpResponseCode = http.POST(postData);
-    Serial.println("Response Code: " + String(httpResponseCode));
+    telemetrySubscribersLock.lock();
+    int slot = -1;
+    for (int i = 0; i < TELEMETRY_MAX_SUBSCRIBERS; i++)
+    {
+        if (telemetrySubscribers[i].port != 0 && telemetrySubscribers[i].ip == ip)
+        {
+            slot = i; // Re-subscribe just updates the port
+            break;
+        }
+        if (slot < 0 && telemetrySubscribers[i].port == 0)
+        {
+            slot = i;
+        }
+    }
 
-    if (httpResponseCode == 302)
+    if (slot >= 0)
     {
-        bool ledCommand = true;
-        xQueueSend(dataLedQueue, &ledCommand, portMAX_DELAY);
+        telemetrySubscribers[slot].ip = ip;
+        telemetrySubscribers[slot].port = port;
     }
-    else
+    telemetrySubscribersLock.unlock();
+    if (slot < 0)
     {
-        Serial.println("Data not sent");
+        server.send(503, "text/plain", "Subscriber list full");
+        return;
     }
 
-    http.end();
+    server.send(200, "text/plain", "Subscribed " + ip.toString() + ":" + String(port) +
+                                       " (frame v" + String(TELEMETRY_VERSION) + ", " + String(sizeof(TelemetryFrame_t)) + " bytes)");
+}
+
+void handleUnsubscribe()
+{
+    TRACE_SCOPE("handleUnsubscribe");
+    IPAddress ip = server.hasArg("broadcast") ? WiFi.broadcastIP() : server.client().remoteIP();
+    telemetrySubscribersLock.lock();
+    for (int i = 0; i < TELEMETRY_MAX_SUBSCRIBERS; i++)
+    {
+        if (telemetrySubscribers[i].port != 0 && telemetrySubscribers[i].ip == ip)
+        {
+            telemetrySubscribers[i].port = 0;
+        }
+    }
+    telemetrySubscribersLock.unlock();
+    server.send(200, "text/plain", "Unsubscribed " + ip.toString());
+}
+
+// JSON row for the Sheets script, which answers a POST with a 302
+String googleSheetsRow(const Sample_t &sample)
+{
+    String ipAddress = WiFi.localIP().toString();
+
+    String postData = "{\"temp1\":" + formatValue(sample.temp1) +
+                      ",\"temp2\":" + formatValue(sample.temp2) +
+                      ",\"voltage\":" + formatValue(sample.busVoltage) +
+                      ",\"current\":" + formatValue(sample.current_mA) +
+                      ",\"power\":" + formatValue(sample.power_mW) +
+                      ",\"thickness\":" + formatValue(sampleThickness) +
+                      ",\"area\":" + formatValue(crossSectionArea) +
+                      ",\"conductivity\":" + formatValue(sample.thermalConductivity, 4) +
+                      ",\"conductivity_unc\":" + formatValue(sample.thermalConductivityUnc, 4) +
+                      ",\"ip\":\"" + ipAddress + "\"" +
+                      "}";
+    return postData;
 }
 
 void handleRoot()
 {
-    String html = R"=====(
+    TRACE_SCOPE("handleRoot");
+    static const char html[] PROGMEM = R"=====(
      <!-- Designed and Developed by Rahul Morya https://in.linkedin.com/in/rahul-morya-456a3b233 -->
 
 <!DOCTYPE html>
@@ -928,6 +2917,7 @@ void handleRoot()
     <div class='conductivity-card'>
       <h2>Thermal Conductivity</h2>
       <div class='conductivity-value' id='thermalConductivity'>%THERMAL_CONDUCTIVITY% W/m·K</div>
+      <div class='info' id='thermalConductivityUnc'>± %THERMAL_CONDUCTIVITY_UNC% W/m·K</div>
       <div class='formula'>k = (Q × dx) / (A × ΔT)</div>
       <div class='info'>Where: Q = Power (W), dx = Thickness (m)<br>
       A = Area (m²), ΔT = Temp Difference (K)</div>
@@ -947,6 +2937,7 @@ void handleRoot()
                 document.getElementById('busVoltage').innerHTML = "Bus Voltage: " + data.busVoltage + " V";
                 document.getElementById('current_mA').innerHTML = "Current: " + data.current_mA + " mA";
                 document.getElementById('thermalConductivity').innerHTML = data.thermalConductivity + " W/m·K";
+                document.getElementById('thermalConductivityUnc').innerHTML = "± " + data.thermalConductivityUnc + " W/m·K";
                 document.getElementById('dacValue').innerHTML = data.dacValue;
                 document.getElementById('mosfetState').textContent = data.mosfetState ? "ON" : "OFF";
             })
@@ -998,40 +2989,170 @@ void handleRoot()
 
 )=====";
 
-    // Replace placeholders with actual values
-    html.replace("%THICKNESS%", String(sampleThickness));
-    html.replace("%DIAMETER%", String(diameter));
-    html.replace("%TEMP_OFFSET%", String(temperature_offset));
-    html.replace("%TEMP1%", String(temp1));
-    html.replace("%TEMP2%", String(temp2));
-    html.replace("%DT%", String(dT));
-    html.replace("%POWER%", String(power_mW));
-    html.replace("%BUS_VOLTAGE%", String(busVoltage));
-    html.replace("%CURRENT%", String(current_mA));
-    html.replace("%THERMAL_CONDUCTIVITY%", String(thermalConductivity));
+    // Stream the page in chunks, placeholders are formatted into stack buffers instead of
+    // building the whole page in a heap String
+    char out[512];
+    size_t used = 0;
+    auto emit = [&](const char *data, size_t length)
+    {
+        while (length > 0)
+        {
+            size_t n = min(length, sizeof(out) - used);
+            memcpy(out + used, data, n);
+            used += n;
+            data += n;
+            length -= n;
+            if (used == sizeof(out))
+            {
+                server.sendContent(out, used);
+                used = 0;
+            }
+        }
+    };
+
+    server.client().setTimeout(NET_SEND_TIMEOUT_S);
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/html", "");
+
+    const char *chunk = html;
+    const char *mark;
+    while ((mark = strchr(chunk, '%')) != NULL)
+    {
+        const char *end = strchr(mark + 1, '%');
+        char value[24];
+        if (end != NULL && formatRootPlaceholder(mark + 1, end - mark - 1, value, sizeof(value)))
+        {
+            emit(chunk, mark - chunk);
+            emit(value, strlen(value));
+            chunk = end + 1;
+        }
+        else
+        {
+            emit(chunk, mark - chunk + 1); // Literal '%', e.g. CSS percentages
+            chunk = mark + 1;
+        }
+    }
+    emit(chunk, strlen(chunk));
+    if (used > 0)
+    {
+        server.sendContent(out, used);
+    }
+    server.sendContent("", 0); // Last chunk
+}
+
+// Value of a %NAME% placeholder of the root page, false if the name is not one
+bool formatRootPlaceholder(const char *name, size_t length, char *out, size_t size)
+{
+    static const struct
+    {
+        const char *name;
+        const float *value;
+        uint8_t decimals;
+    } floats[] = {
+        {"THICKNESS", &sampleThickness, 2},
+        {"DIAMETER", &diameter, 2},
+        {"TEMP_OFFSET", &temperature_offset, 2},
+        {"TEMP1", &temp1, 2},
+        {"TEMP2", &temp2, 2},
+        {"DT", &dT, 2},
+        {"POWER", &power_mW, 2},
+        {"BUS_VOLTAGE", &busVoltage, 2},
+        {"CURRENT", &current_mA, 2},
+        {"THERMAL_CONDUCTIVITY", &thermalConductivity, 2},
+        {"THERMAL_CONDUCTIVITY_UNC", &thermalConductivityUnc, 4},
+    };
+
+    for (size_t i = 0; i < sizeof(floats) / sizeof(floats[0]); i++)
+    {
+        if (strlen(floats[i].name) == length && strncmp(floats[i].name, name, length) == 0)
+        {
+            formatValueTo(out, size, *floats[i].value, floats[i].decimals);
+            return true;
+        }
+    }
+
+    if (length == 9 && strncmp(name, "DAC_VALUE", length) == 0)
+    {
+        snprintf(out, size, "%d", dacValue);
+        return true;
+    }
+    if (length == 12 && strncmp(name, "MOSFET_STATE", length) == 0)
+    {
+        snprintf(out, size, "%s", mosfetState ? "ON" : "OFF");
+        return true;
+    }
+    return false;
+}
+
+// Heater level and MOSFET state, the parts of /getData that change between samples
+uint32_t dataControlKey()
+{
+    return ((uint32_t)heaterLevel << 1) | (mosfetState ? 1 : 0);
+}
 
-    html.replace("%DAC_VALUE%", String(dacValue));
-    // html.replace("%PWM_VALUE%", String(ledcRead(0) * 100 / 255)); // Convert to percentage
-    html.replace("%MOSFET_STATE%", mosfetState ? "ON" : "OFF");
+// Serializes latestSample (the live values before the first sample) into dataCache
+void buildDataResponse()
+{
+    TRACE_SCOPE("buildDataResponse");
+    Sample_t sample;
+    if (latestSample != INVALID_BLOCK)
+    {
+        sample = samplePool[latestSample];
+    }
+    else
+    {
+        sample.temp1 = temp1;
+        sample.temp2 = temp2;
+        sample.dT = dT;
+        sample.busVoltage = busVoltage;
+        sample.current_mA = current_mA;
+        sample.power_mW = power_mW;
+        sample.thermalConductivity = thermalConductivity;
+        sample.thermalConductivityUnc = thermalConductivityUnc;
+    }
 
-    server.send(200, "text/html", html);
+    // Formatted on the stack, no heap String per build
+    char v[8][24];
+    formatValueTo(v[0], sizeof(v[0]), sample.temp1);
+    formatValueTo(v[1], sizeof(v[1]), sample.temp2);
+    formatValueTo(v[2], sizeof(v[2]), sample.dT);
+    formatValueTo(v[3], sizeof(v[3]), sample.power_mW);
+    formatValueTo(v[4], sizeof(v[4]), sample.busVoltage);
+    formatValueTo(v[5], sizeof(v[5]), sample.current_mA);
+    formatValueTo(v[6], sizeof(v[6]), sample.thermalConductivity, 4);
+    formatValueTo(v[7], sizeof(v[7]), sample.thermalConductivityUnc, 4);
+
+    // One snapshot, so the body always matches the key it is checked against
+    dataCacheControl = dataControlKey();
+    uint16_t level = dataCacheControl >> 1;
+    int length = snprintf(dataCache.buffer(), dataCache.capacity(),
+                          "{\"temp1\":%s,\"temp2\":%s,\"dT\":%s,\"power_mW\":%s,\"busVoltage\":%s,"
+                          "\"current_mA\":%s,\"thermalConductivity\":%s,\"thermalConductivityUnc\":%s,"
+                          "\"dacValue\":%d,\"heaterLevel\":%u,\"mosfetState\":%d}",
+                          v[0], v[1], v[2], v[3], v[4], v[5], v[6], v[7], level >> 8, (unsigned)level,
+                          (int)(dataCacheControl & 1));
+    dataCache.commit(length > 0 ? (size_t)length : 0);
 }
 
+// Served from dataCache: a copy per request, or a 304 when the client has this version
 void handleGetData()
 {
-    String json = "{";
-    json += "\"temp1\":" + String(temp1) + ",";
-    json += "\"temp2\":" + String(temp2) + ",";
-    json += "\"dT\":" + String(dT) + ",";
-    json += "\"power_mW\":" + String(power_mW) + ",";
-    json += "\"busVoltage\":" + String(busVoltage) + ",";
-    json += "\"current_mA\":" + String(current_mA) + ",";
-    json += "\"thermalConductivity\":" + String(thermalConductivity, 4) + ",";
-    json += "\"dacValue\":" + String(dacValue) + ",";
-    json += "\"mosfetState\":" + String(mosfetState);
-    json += "}";
+    TRACE_SCOPE("handleGetData");
+    if (!dataCache.valid() || dataCacheControl != dataControlKey())
+    {
+        buildDataResponse();
+    }
 
-    server.send(200, "application/json", json);
+    server.sendHeader("ETag", dataCache.etag());
+    server.sendHeader("Cache-Control", "no-cache");
+    if (dataCache.notModified(server.header("If-None-Match").c_str()))
+    {
+        dataCache.served(true);
+        server.send(304);
+        return;
+    }
+    dataCache.served(false);
+    server.send_P(200, "application/json", dataCache.data(), dataCache.length());
 }
 
 // // Function to read temperature from MAX31865
@@ -1058,63 +3179,701 @@ void handleGetData()
 //     // Serial.print("   Temperature T2: ");
 //     // Serial.println(temperature);
 
-//     return temperature;
-// }
+//     return temperature;
+// }
+
+// One-shot conversion in kelvin. tUs is the middle of the call: bias settling and
+// conversion take the same time on both channels, so only the difference matters.
+float readRtdKelvin(Adafruit_MAX31865 &sensor, float rref, float offset, uint32_t &tUs)
+{
+    TRACE_SCOPE("rtdConversion");
+    uint32_t startUs = micros();
+    float kelvin = sensor.temperature(RNOMINAL, rref) + 273.15 + offset;
+    tUs = startUs + (micros() - startUs) / 2;
+    return kelvin;
+}
+
+// Fixed-point variant: raw RTD code through the conversion table
+Q16 readRtdKelvinQ(Adafruit_MAX31865 &sensor, const RtdTable &table, Q16 offset, uint32_t &tUs)
+{
+    TRACE_SCOPE("rtdConversion");
+    uint32_t startUs = micros();
+    Q16 kelvin = table.kelvin(sensor.readRTD()) + offset;
+    tUs = startUs + (micros() - startUs) / 2;
+    return kelvin;
+}
+
+// Converts both RTDs, moves each reading to the midpoint of the pair and takes the
+// medians. The medians pick their entries independently, so some skew can remain
+// between them (rtdResidualSkewUs); on a monotonic ramp both pick the same entry.
+void readTemperaturePair()
+{
+    TRACE_SCOPE("rtdPair");
+    uint32_t t1Us, t2Us;
+#if FIXED_POINT_MODE
+    Q16 reading1 = readRtdKelvinQ(max1, rtdTable1, Q16::fromRaw(0), t1Us);
+    Q16 reading2 = readRtdKelvinQ(max2, rtdTable2, Q16::fromFloat(temperature_offset), t2Us);
+    rtdAligner.push(0, t1Us, reading1);
+    rtdAligner.push(1, t2Us, reading2);
+    safetyInterlock.report(INTERLOCK_TEMP1, reading1.toFloat(), micros());
+    safetyInterlock.report(INTERLOCK_TEMP2, reading2.toFloat(), micros());
+#else
+    float reading1 = readRtdKelvin(max1, RREF1, 0, t1Us);
+    float reading2 = readRtdKelvin(max2, RREF2, temperature_offset, t2Us);
+    rtdAligner.push(0, t1Us, reading1);
+    rtdAligner.push(1, t2Us, reading2);
+    safetyInterlock.report(INTERLOCK_TEMP1, reading1, micros());
+    safetyInterlock.report(INTERLOCK_TEMP2, reading2, micros());
+#endif
+
+    uint32_t gridUs = t1Us + (t2Us - t1Us) / 2;
+#if FIXED_POINT_MODE
+    Q16 shift1 = Q16::fromRaw(0), shift2 = Q16::fromRaw(0);
+#else
+    float shift1 = 0, shift2 = 0;
+#endif
+#if RTD_TIME_ALIGN
+    shift1 = rtdAligner.shift(0, gridUs);
+    shift2 = rtdAligner.shift(1, gridUs);
+#endif
+    rtdSkewUs = (int32_t)(t2Us - t1Us);
+#if FIXED_POINT_MODE
+    rtdAlignCorrectionK = (shift1 - shift2).toFloat(); // Status only, like dT from dTQ
+#else
+    rtdAlignCorrectionK = shift1 - shift2;
+#endif
+    tempGridUs[bufferIndex] = gridUs;
+
+    TRACE_SCOPE("median");
+
+#if FIXED_POINT_MODE
+    tempBufferQ1[bufferIndex] = reading1 + shift1;
+    tempBufferQ2[bufferIndex] = reading2 + shift2;
+    int median1 = medianIndex(tempBufferQ1, MEDIAN_WINDOW);
+    int median2 = medianIndex(tempBufferQ2, MEDIAN_WINDOW);
+    temp1Q = tempBufferQ1[median1];
+    temp2Q = tempBufferQ2[median2];
+#else
+    tempBuffer1[bufferIndex] = reading1 + shift1;
+    tempBuffer2[bufferIndex] = reading2 + shift2;
+    int median1 = medianIndex(tempBuffer1, MEDIAN_WINDOW);
+    int median2 = medianIndex(tempBuffer2, MEDIAN_WINDOW);
+    temp1 = tempBuffer1[median1];
+    temp2 = tempBuffer2[median2];
+#endif
+    rtdResidualSkewUs = (int32_t)(tempGridUs[median2] - tempGridUs[median1]);
+    bufferIndex = (bufferIndex + 1) % MEDIAN_WINDOW;
+}
+
+// Read the RTD register of a MAX31865 in continuous conversion mode without the
+// one-shot delays of readRTD()
+uint16_t readRtdRaw(uint8_t cs)
+{
+    SPI.beginTransaction(SPISettings(1000000, MSBFIRST, SPI_MODE1));
+    digitalWrite(cs, LOW);
+    SPI.transfer(0x01); // RTD MSB register
+    uint16_t rtd = SPI.transfer(0xFF) << 8;
+    rtd |= SPI.transfer(0xFF);
+    digitalWrite(cs, HIGH);
+    SPI.endTransaction();
+    return rtd >> 1; // Drop the fault bit
+}
+
+// Same Callendar-Van Dusen conversion as the Adafruit library, but keeps the
+// fractional RTD code produced by the decimator
+float rtdToKelvin(float rtdCode, float rref)
+{
+    const float A = 3.9083e-3;
+    const float B = -5.775e-7;
+    float Rt = rtdCode / 32768.0 * rref;
+
+    float temp = (sqrtf(A * A - 4 * B * (1 - Rt / RNOMINAL)) - A) / (2 * B);
+    if (temp < 0)
+    {
+        // Below 0°C use the polynomial fit for a 100 Ω normalised RTD
+        Rt = Rt / RNOMINAL * 100;
+        float rpoly = Rt;
+        temp = -242.02;
+        temp += 2.2228 * rpoly;
+        rpoly *= Rt;
+        temp += 2.5859e-3 * rpoly;
+        rpoly *= Rt;
+        temp -= 4.8260e-6 * rpoly;
+        rpoly *= Rt;
+        temp -= 2.8183e-8 * rpoly;
+        rpoly *= Rt;
+        temp += 1.5243e-10 * rpoly;
+    }
+    return temp + 273.15;
+}
+
+// Splits the decimation from the burst rate down to 1 Hz into CIC and FIR rates. False
+// when they cannot multiply to exactly 1 s: the decimated stream would run off 1 Hz.
+bool captureDecimation(uint32_t periodUs, uint16_t *cicRate, uint16_t *firRate)
+{
+    uint32_t decimation = 1000000UL / periodUs;
+    *firRate = decimation >= CAPTURE_FIR_DECIMATION ? CAPTURE_FIR_DECIMATION : decimation;
+    *cicRate = decimation / *firRate;
+    return periodUs * decimation == 1000000UL && (uint32_t)*cicRate * *firRate == decimation;
+}
+
+void captureTask(void *pvParameters)
+{
+    for (;;)
+    {
+        supervisor.idle(SUP_CAPTURE, millis());
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        supervisor.beat(SUP_CAPTURE, millis());
+
+        // Switch both converters to continuous mode so a fresh code is always waiting
+        max1.enableBias(true);
+        max2.enableBias(true);
+        max1.autoConvert(true);
+        max2.autoConvert(true);
+        vTaskDelay(70 / portTICK_PERIOD_MS); // First conversion
+
+        // Total decimation brings the burst rate down to the 1 Hz measurement stream
+        uint16_t cicRate, firRate;
+        captureDecimation(capturePeriodUs, &cicRate, &firRate);
+        captureDecimator.begin(cicRate, firRate);
+        readingAllan.reset();
+        readingAllanPeriodUs = capturePeriodUs;
+
+        // The topologies are designed for CAPTURE_PERIOD_US, bursts at other rates are not filtered
+        captureFiltered = capturePeriodUs == CAPTURE_PERIOD_US;
+        uint32_t filterCycles = 0;
+
+        uint32_t next = micros();
+        for (uint32_t i = 0; i < captureTarget; i++)
+        {
+            // Sleep while there is more than a tick to wait, spin for the rest
+            while ((int32_t)(next - micros()) > 0)
+            {
+                if ((int32_t)(next - micros()) > 1500)
+                {
+                    vTaskDelay(1);
+                }
+            }
+            next += capturePeriodUs;
+            supervisor.beat(SUP_CAPTURE, millis());
+
+            RawSample_t &sample = captureBuffer[i];
+            sample.t_us = micros();
+            sample.rtd1 = readRtdRaw(CS1);
+            sample.rtd2 = readRtdRaw(CS2);
+            sample.busVoltage = ina219.getBusVoltage_V();
+            sample.current_mA = ina219.getCurrent_mA();
+            captureCount = i + 1;
+
+            // Single readings, before any filtering: this is what MEDIAN_WINDOW / SAMPLE_COUNT average
+            float reading1 = rtdTable1.kelvin(sample.rtd1).toFloat();
+            float reading2 = rtdTable2.kelvin(sample.rtd2).toFloat() + temperature_offset;
+            safetyInterlock.report(INTERLOCK_TEMP1, reading1, sample.t_us);
+            safetyInterlock.report(INTERLOCK_TEMP2, reading2, sample.t_us);
+            safetyInterlock.report(INTERLOCK_CURRENT, sample.current_mA, sample.t_us);
+            safetyInterlock.report(INTERLOCK_POWER, sample.busVoltage * sample.current_mA, sample.t_us);
+            float allanIn[ALLAN_CHANNELS] = {reading1, reading2, reading1 - reading2, sample.busVoltage * sample.current_mA};
+            readingAllan.push(allanIn);
+
+            float raw[FILTER_CHANNELS] = {(float)sample.rtd1, (float)sample.rtd2,
+                                          sample.busVoltage * 1000, sample.current_mA * 1000};
+            if (i == 0)
+            {
+                // Settled at the first reading, so the burst starts without a step response
+                for (int c = 0; c < FILTER_CHANNELS; c++)
+                {
+                    captureFilters.select(c, filterTopologies[captureFiltered ? (int)captureFilterTopology[c] : (int)FILTER_NONE], raw[c]);
+                }
+            }
+            float filtered[FILTER_CHANNELS];
+            uint32_t startCycles = ESP.getCycleCount();
+            captureFilters.process(raw, filtered);
+            filterCycles += ESP.getCycleCount() - startCycles;
+
+            int32_t in[4] = {(int32_t)lroundf(filtered[0]), (int32_t)lroundf(filtered[1]),
+                             (int32_t)lroundf(filtered[2]), (int32_t)lroundf(filtered[3])};
+            float out[4];
+            if (captureDecimator.push(in, out))
+            {
+                temp1 = rtdToKelvin(out[0], RREF1);
+                temp2 = rtdToKelvin(out[1], RREF2) + temperature_offset;
+                busVoltage = out[2] / 1000.0;
+                current_mA = out[3] / 1000.0;
+                power_mW = busVoltage * current_mA;
+#if FIXED_POINT_MODE
+                temp1Q = Q16::fromFloat(temp1);
+                temp2Q = Q16::fromFloat(temp2);
+                busVoltageQ = Q16::fromFloat(busVoltage);
+                current_mAQ = Q16::fromFloat(current_mA);
+                power_mWQ = Q16::fromFloat(power_mW);
+#endif
+            }
+        }
+
+        // Back to one-shot conversions used by measureParameters()
+        max1.autoConvert(false);
+        max2.autoConvert(false);
+        max1.enableBias(false);
+        max2.enableBias(false);
+        filterCyclesPerSample = captureCount ? filterCycles / captureCount : 0;
+        captureActive = false;
+        LOG_INFO("[Capture] Done: %u samples", captureCount);
+    }
+}
+
+// /capture?ms=2000&period_us=2000 starts a raw burst
+void handleCapture()
+{
+    TRACE_SCOPE("handleCapture");
+    if (captureActive)
+    {
+        server.send(409, "text/plain", "Capture already running");
+        return;
+    }
+
+    uint32_t periodUs = server.hasArg("period_us") ? server.arg("period_us").toInt() : CAPTURE_PERIOD_US;
+    uint32_t windowMs = server.hasArg("ms") ? server.arg("ms").toInt() : 2000;
+    if (periodUs < 500 || periodUs > 1000000)
+    {
+        server.send(400, "text/plain", "period_us out of range (500-1000000)");
+        return;
+    }
+
+    uint16_t cicRate, firRate;
+    if (!captureDecimation(periodUs, &cicRate, &firRate))
+    {
+        server.send(400, "text/plain", "period_us must divide 1 s into a multiple of " + String(CAPTURE_FIR_DECIMATION) +
+                                           " samples (or fewer than " + String(CAPTURE_FIR_DECIMATION) + ")");
+        return;
+    }
+
+    // A burst shorter than the decimator latency would never produce a 1 Hz value
+    uint32_t samples = (uint64_t)windowMs * 1000 / periodUs;
+    uint32_t latency = (uint32_t)cicRate * (CIC_ORDER + firRate);
+    if (samples < latency || samples > CAPTURE_MAX_SAMPLES)
+    {
+        server.send(400, "text/plain", "Window must hold " + String(latency) + "-" + String(CAPTURE_MAX_SAMPLES) + " samples");
+        return;
+    }
+
+    capturePeriodUs = periodUs;
+    captureTarget = samples;
+    captureCount = 0;
+    captureActive = true;
+    xTaskNotifyGive(captureTaskHandle);
+
+    server.send(202, "text/plain", "Capturing " + String(samples) + " samples");
+}
+
+void handleCaptureStatus()
+{
+    TRACE_SCOPE("handleCaptureStatus");
+    String json = "{";
+    json += "\"active\":" + String(captureActive) + ",";
+    json += "\"count\":" + String(captureCount) + ",";
+    json += "\"target\":" + String(captureTarget) + ",";
+    json += "\"period_us\":" + String(capturePeriodUs);
+    json += "}";
+
+    server.send(200, "application/json", json);
+}
+
+// Capture filter per channel. /filters?rtd1=mains50&current=lowpass (or all=...) picks
+// from filterTopologies[] for the next burst.
+void handleFilters()
+{
+    TRACE_SCOPE("handleFilters");
+    for (int c = -1; c < FILTER_CHANNELS; c++)
+    {
+        const char *channel = c < 0 ? "all" : filterChannelNames[c];
+        if (!server.hasArg(channel))
+        {
+            continue;
+        }
+        int topology = -1;
+        for (int t = 0; t < FILTER_TOPOLOGIES; t++)
+        {
+            if (server.arg(channel) == filterTopologyNames[t])
+            {
+                topology = t;
+            }
+        }
+        if (topology < 0)
+        {
+            server.send(400, "text/plain", "Unknown filter " + server.arg(channel));
+            return;
+        }
+        for (int i = 0; i < FILTER_CHANNELS; i++)
+        {
+            if (c < 0 || i == c)
+            {
+                captureFilterTopology[i] = topology;
+            }
+        }
+    }
+
+    String json = "{\"designRateHz\":" + String(FILTER_FS, 1);
+    json += ",\"lastBurstFiltered\":" + String(captureFiltered ? "true" : "false");
+    json += ",\"cyclesPerSample\":" + String(filterCyclesPerSample);
+    json += ",\"channels\":{";
+    for (int c = 0; c < FILTER_CHANNELS; c++)
+    {
+        json += String(c ? "," : "") + "\"" + filterChannelNames[c] + "\":\"" + filterTopologyNames[captureFilterTopology[c]] + "\"";
+    }
+    json += "},\"topologies\":[";
+    for (int t = 0; t < FILTER_TOPOLOGIES; t++)
+    {
+        json += String(t ? "," : "") + "\"" + filterTopologyNames[t] + "\"";
+    }
+    json += "]}";
+
+    server.send(200, "application/json", json);
+}
+
+void handleCaptureData()
+{
+    TRACE_SCOPE("handleCaptureData");
+    if (captureActive)
+    {
+        server.send(409, "text/plain", "Capture still running");
+        return;
+    }
+
+    CaptureHeader_t header = {
+        .magic = CAPTURE_MAGIC,
+        .version = 1,
+        .sampleSize = sizeof(RawSample_t),
+        .count = captureCount,
+        .period_us = capturePeriodUs,
+        .rref1 = RREF1,
+        .rref2 = RREF2,
+        .rnominal = RNOMINAL};
+
+    server.client().setTimeout(NET_SEND_TIMEOUT_S);
+    server.setContentLength(sizeof(header) + header.count * sizeof(RawSample_t));
+    server.send(200, "application/octet-stream", "");
+    server.sendContent((const char *)&header, sizeof(header));
+    server.sendContent((const char *)captureBuffer, header.count * sizeof(RawSample_t));
+}
+
+void calculateThermalconductivity()
+{
+    TRACE_SCOPE("kCompute");
+#if FIXED_POINT_MODE
+    dTQ = temp1Q - temp2Q;
+    Q16 radius = Q16::fromFloat(diameter / 2.00);
+    Q16 area = Q16::fromFloat(3.14159) * radius * radius;
+    thermalConductivityQ = fixedConductivity(power_mWQ, Q16::fromFloat(sampleThickness), area, dTQ);
+
+    dT = dTQ.toFloat();
+    crossSectionArea = area.toFloat();
+    thermalConductivity = thermalConductivityQ.toFloat();
+#else
+    // Calculate thermal conductivity
+    dT = temp1 - temp2;
+    float absolute_dT = fabs(dT);
+    crossSectionArea = 3.14159 * (diameter / 2.00) * (diameter / 2.00);
+    if (absolute_dT > 0 && sampleThickness > 0 && crossSectionArea > 0)
+    {
+        thermalConductivity = (power_mW * sampleThickness) / (crossSectionArea * absolute_dT * 1000.0000);
+    }
+    else
+    {
+        thermalConductivity = 0.0;
+    }
+#endif
+
+    // Propagate the scatter of P and ΔT over the rolling window into u(k)
+    powerDtStats.push(power_mW, dT);
+    thermalConductivityUnc = conductivityUncertainty(thermalConductivity, power_mW, dT, sampleThickness, diameter,
+                                                     powerDtStats, THICKNESS_UNCERTAINTY_MM, DIAMETER_UNCERTAINTY_MM);
+}
+
+// One dither step: writes the DAC register directly, dacWrite() is too heavy for 10 kHz
+void IRAM_ATTR heaterTick()
+{
+    uint8_t code = heaterModulator.next();
+    SET_PERI_REG_BITS(RTC_IO_PAD_DAC1_REG, RTC_IO_PDAC1_DAC, safetyInterlock.tripped() ? 0 : code, RTC_IO_PDAC1_DAC_S);
+}
+
+// Interlock check. While the fault is latched every tick cuts again, so a MOSFET toggle
+// that raced the trip is undone within one period. In sigma-delta mode heaterTick() writes
+// 0 while the fault is latched; otherwise nothing else writes the DAC until the supervisor
+// does, so it is zeroed here. The trip latency includes the cut.
+void IRAM_ATTR interlockTick()
+{
+    if (safetyInterlock.check(micros()))
+    {
+        digitalWrite(MOSFET, HIGH); // Active low
+        mosfetState = false;
+#if !HEATER_SIGMA_DELTA
+        SET_PERI_REG_BITS(RTC_IO_PAD_DAC1_REG, RTC_IO_PDAC1_DAC, 0, RTC_IO_PDAC1_DAC_S);
+#endif
+        safetyInterlock.cutDone(micros());
+    }
+}
+
+// Limits from the INTERLOCK_* defaults, armed from setup() so the ISR runs on CORE_ACQ
+void interlockBegin()
+{
+    safetyInterlock.setLimit(INTERLOCK_TEMP1, INTERLOCK_MAX_TEMP_K);
+    safetyInterlock.setLimit(INTERLOCK_TEMP2, INTERLOCK_MAX_TEMP_K);
+    safetyInterlock.setLimit(INTERLOCK_POWER, INTERLOCK_MAX_POWER_MW);
+    safetyInterlock.setLimit(INTERLOCK_CURRENT, INTERLOCK_MAX_CURRENT_MA);
+    safetyInterlock.begin(micros(), INTERLOCK_STALE_MS * 1000UL);
+    interlockTimer = timerBegin(INTERLOCK_TIMER, 80, true); // 1 MHz
+    timerAttachInterrupt(interlockTimer, interlockTick, true);
+    timerAlarmWrite(interlockTimer, INTERLOCK_PERIOD_US, true);
+    timerAlarmEnable(interlockTimer);
+}
+
+// Shared by /toggleMosfet and the button; false when the interlock keeps it off
+bool mosfetToggle()
+{
+    if (!mosfetState && safetyInterlock.tripped())
+    {
+        return false;
+    }
+    digitalWrite(MOSFET, mosfetState ? HIGH : LOW);
+    mosfetState = !mosfetState;
+    ledSetIdle(LED_MOSFET, mosfetState);
+    return true;
+}
+
+// Enables the DAC pad at 0 and, in sigma-delta mode, starts the dither timer.
+// Called from setup(), so the ISR runs on CORE_ACQ at about 1 µs per tick.
+void heaterBegin()
+{
+    dacWrite(DAC_GPIO, 0);
+    heaterWrite(0);
+#if HEATER_SIGMA_DELTA
+    heaterTimer = timerBegin(HEATER_TIMER, 80, true); // 1 MHz
+    timerAttachInterrupt(heaterTimer, heaterTick, true);
+    timerAlarmWrite(heaterTimer, 1000000 / HEATER_DITHER_HZ, true);
+    timerAlarmEnable(heaterTimer);
+#endif
+}
+
+// Single entry point for heater output, shared by the slider and the 16-bit level
+void heaterWrite(uint16_t level)
+{
+    if (safetyInterlock.tripped())
+    {
+        level = 0;
+    }
+    heaterLevel = level;
+    dacValue = level >> 8;
+#if HEATER_SIGMA_DELTA
+    heaterModulator.set(level);
+#else
+    dacWrite(DAC_GPIO, dacValue);
+#endif
+}
+
+// Allan deviation per octave. /allan?source=reading covers the last capture burst
+// (single readings), the default source=sample the acquisition stream since its interval
+// last changed. bestTauS is where averaging stops helping.
+void handleAllan()
+{
+    TRACE_SCOPE("handleAllan");
+    static const char *names[ALLAN_CHANNELS] = {"temp1", "temp2", "dT", "power_mW"};
+    bool reading = server.arg("source") == "reading";
+    double tau0S = reading ? readingAllanPeriodUs / 1e6 : sampleAllanIntervalMs / 1e3;
+
+    String json = "{";
+    json += "\"source\":\"" + String(reading ? "reading" : "sample") + "\",";
+    json += "\"tau0S\":" + String(tau0S, 4) + ",";
+    json += "\"samples\":" + String(reading ? readingAllan.count() : sampleAllan.count()) + ",";
+
+    int octaves = reading ? readingAllan.octaves() : sampleAllan.octaves();
+    json += "\"tauS\":[";
+    for (int k = 0; k < octaves; k++)
+    {
+        json += String(k ? "," : "") + String(tau0S * (1UL << k), 4);
+    }
+    json += "],\"terms\":[";
+    for (int k = 0; k < octaves; k++)
+    {
+        json += String(k ? "," : "") + String(reading ? readingAllan.termCount(k) : sampleAllan.termCount(k));
+    }
+    json += "],\"channels\":[";
+    for (int c = 0; c < ALLAN_CHANNELS; c++)
+    {
+        int best = reading ? readingAllan.bestOctave(c) : sampleAllan.bestOctave(c);
+        json += String(c ? "," : "") + "{\"name\":\"" + names[c] + "\",";
+        json += "\"bestTauS\":" + (best < 0 ? String("null") : String(tau0S * (1UL << best), 4)) + ",";
+        json += "\"adev\":[";
+        for (int k = 0; k < octaves; k++)
+        {
+            double adev = reading ? readingAllan.adev(c, k) : sampleAllan.adev(c, k);
+            json += String(k ? "," : "") + String(adev, 6);
+        }
+        json += "]}";
+    }
+    json += "]}";
+
+    server.send(200, "application/json", json);
+}
 
-float readTemperature1(Adafruit_MAX31865 &sensor)
+// Feeds ΔT into the steady-state fit and derives k at the forecast ΔT∞.
+// A heater step starts a new approach, so the fit restarts with it.
+void updateForecast()
 {
-    float rawTemp = sensor.temperature(RNOMINAL, RREF1) + 273.15;
+    TRACE_SCOPE("forecast");
+    if (fabs(power_mW - forecastPower_mW) > ADAPTIVE_POWER_STEP_MW)
+    {
+        dtForecast.reset();
+        forecastPower_mW = power_mW;
+        forecastResets++;
+    }
+    dtForecast.update(runClockMs() / 1000.0, dT);
 
-    // Store in circular buffer
-    tempBuffer1[bufferIndex1] = rawTemp;
-    bufferIndex1 = (bufferIndex1 + 1) % MEDIAN_WINDOW;
+    double dtInf = dtForecast.asymptote();
+    double dtInfUnc = dtForecast.asymptoteUnc();
+    forecastValid = dtForecast.valid() && fabs(dtInf) > 0 && crossSectionArea > 0;
+    if (!forecastValid)
+    {
+        forecastEquilibriumS = -1.0;
+        return;
+    }
 
-    // Return median value
-    float tempCopy[MEDIAN_WINDOW];
-    memcpy(tempCopy, tempBuffer1, sizeof(tempCopy));
-    return getMedian(tempCopy, MEDIAN_WINDOW);
+    // Same Fourier's law as calculateThermalconductivity(), with ΔT∞ for ΔT
+    forecastDt = dtInf;
+    forecastDtUnc = dtInfUnc;
+    forecastK = (power_mW * sampleThickness) / (crossSectionArea * fabs(dtInf) * 1000.0);
+    forecastKUnc = forecastK * dtInfUnc / fabs(dtInf);
+    forecastTauS = dtForecast.tau();
+    forecastEquilibriumS = dtForecast.timeToEquilibrium(FORECAST_EQUILIBRIUM_K);
 }
 
-float readTemperature2(Adafruit_MAX31865 &sensor)
+// Predicted steady state; the interval is ±2u (95 %) from the fit alone, u(k) of the geometry comes on top
+void handleForecast()
 {
-    float rawTemp = sensor.temperature(RNOMINAL, RREF2) + 273.15 + temperature_offset;
-    // float rawTemp = sensor.temperature(RNOMINAL, RREF2) + 273.15;
+    TRACE_SCOPE("handleForecast");
+    float halfWidth = 2 * forecastKUnc;
+    bool converged = forecastValid && forecastK > 0 && halfWidth < FORECAST_CONVERGED_REL * forecastK;
 
-    // Store in circular buffer
-    tempBuffer2[bufferIndex2] = rawTemp;
-    bufferIndex2 = (bufferIndex2 + 1) % MEDIAN_WINDOW;
+    String json = "{";
+    json += "\"valid\":" + String(forecastValid ? "true" : "false") + ",";
+    json += "\"converged\":" + String(converged ? "true" : "false") + ",";
+    json += "\"samples\":" + String(dtForecast.count()) + ",";
+    json += "\"resets\":" + String(forecastResets) + ",";
+    json += "\"dT\":" + formatValue(dT, 4) + ",";
+    json += "\"k\":" + formatValue(thermalConductivity, 4);
+    if (forecastValid)
+    {
+        json += ",\"dTInf\":" + formatValue(forecastDt, 4) + ",";
+        json += "\"dTInfUnc\":" + formatValue(forecastDtUnc, 4) + ",";
+        json += "\"kInf\":" + formatValue(forecastK, 4) + ",";
+        json += "\"kInfUnc\":" + formatValue(forecastKUnc, 4) + ",";
+        json += "\"kInfLow\":" + formatValue(forecastK - halfWidth, 4) + ",";
+        json += "\"kInfHigh\":" + formatValue(forecastK + halfWidth, 4) + ",";
+        json += "\"tauS\":" + String((uint32_t)forecastTauS) + ","; // Can exceed the Q16 range
+        json += "\"equilibriumS\":" + String((uint32_t)forecastEquilibriumS);
+    }
+    json += "}";
 
-    // Return median value
-    float tempCopy[MEDIAN_WINDOW];
-    memcpy(tempCopy, tempBuffer2, sizeof(tempCopy));
-    return getMedian(tempCopy, MEDIAN_WINDOW);
+    server.send(200, "application/json", json);
 }
 
-void calculateThermalconductivity()
+// Number formatting for HTTP and cloud output, integer-only in fixed-point mode
+String formatValue(float value, unsigned int decimals)
 {
-    // Calculate thermal conductivity
-    dT = temp1 - temp2;
-    float absolute_dT = fabs(dT);
-    crossSectionArea = 3.14159 * (diameter / 2.00) * (diameter / 2.00);
-    if (absolute_dT > 0 && sampleThickness > 0 && crossSectionArea > 0)
+    char buf[24];
+    formatValueTo(buf, sizeof(buf), value, decimals);
+    return String(buf);
+}
+
+// Same as formatValue() into a caller buffer, returns the bytes written (truncated to
+// size - 1, 0 for an empty buffer), so a chunk cursor never runs past the buffer
+size_t formatValueTo(char *buf, size_t size, float value, unsigned int decimals)
+{
+    if (size == 0)
     {
-        thermalConductivity = (power_mW * sampleThickness) / (crossSectionArea * absolute_dT * 1000.0000);
+        return 0;
     }
-    else
+#if FIXED_POINT_MODE
+    return formatFixed(buf, size, Q16::fromFloat(value), decimals);
+#else
+    int n = snprintf(buf, size, "%.*f", (int)decimals, value);
+    return n < 0 ? 0 : min((size_t)n, size - 1);
+#endif
+}
+
+// Runs the per-tick compute path (median, conversion, power, k, formatting)
+// in float and in fixed point on the same synthetic input and reports cycles per tick
+void handleBenchNumeric()
+{
+    TRACE_SCOPE("handleBenchNumeric");
+    const int iterations = 200;
+    const uint16_t codes[MEDIAN_WINDOW] = {3100, 3104, 3098, 3102, 3101};
+    char buf[16];
+    volatile float sinkF = 0;
+    volatile int32_t sinkQ = 0;
+
+    uint32_t start = ESP.getCycleCount();
+    for (int n = 0; n < iterations; n++)
     {
-        thermalConductivity = 0.0;
+        float window[MEDIAN_WINDOW];
+        for (int i = 0; i < MEDIAN_WINDOW; i++)
+        {
+            window[i] = rtdToKelvin(codes[i] + (n & 3), RREF1);
+        }
+        float t1 = getMedian(window, MEDIAN_WINDOW);
+        float t2 = t1 - 0.731f;
+        float p = 12.07f * (54.3f + n * 0.01f);
+        float area = 3.14159 * (diameter / 2.00) * (diameter / 2.00);
+        float k = (p * sampleThickness) / (area * fabs(t1 - t2) * 1000.0);
+        String out = String(t1) + String(t2) + String(p) + String(k, 4);
+        sinkF = sinkF + k + out.length();
+    }
+    uint32_t floatCycles = (ESP.getCycleCount() - start) / iterations;
+
+    start = ESP.getCycleCount();
+    for (int n = 0; n < iterations; n++)
+    {
+        Q16 window[MEDIAN_WINDOW];
+        for (int i = 0; i < MEDIAN_WINDOW; i++)
+        {
+            window[i] = rtdTable1.kelvin(codes[i] + (n & 3));
+        }
+        Q16 t1 = fixedMedian(window, MEDIAN_WINDOW);
+        Q16 t2 = t1 - Q16::fromRaw(47907); // 0.731 K
+        Q16 p = Q16::fromRaw(791020) * Q16::fromRaw(3558605 + n * 655); // 12.07 V × 54.3 mA
+        Q16 radius = Q16::fromRaw((int32_t)(diameter * 32768));          // diameter / 2
+        Q16 area = Q16::fromRaw(205887) * radius * radius;                // π r²
+        Q16 k = fixedConductivity(p, Q16::fromRaw((int32_t)(sampleThickness * 65536)), area, t1 - t2);
+        size_t len = formatFixed(buf, sizeof(buf), t1, 2);
+        len += formatFixed(buf, sizeof(buf), t2, 2);
+        len += formatFixed(buf, sizeof(buf), p, 2);
+        len += formatFixed(buf, sizeof(buf), k, 4);
+        sinkQ = sinkQ + k.raw + len;
     }
+    uint32_t fixedCycles = (ESP.getCycleCount() - start) / iterations;
+
+    String json = "{";
+    json += "\"mode\":\"" + String(FIXED_POINT_MODE ? "fixed" : "float") + "\",";
+    json += "\"floatCyclesPerTick\":" + String(floatCycles) + ",";
+    json += "\"fixedCyclesPerTick\":" + String(fixedCycles);
+    json += "}";
+
+    server.send(200, "application/json", json);
 }
 
 void handleUpdate()
 {
+    TRACE_SCOPE("handleUpdate");
     server.sendHeader("Connection", "close");
     server.send(200, "text/plain", (Update.hasError()) ? "FAIL" : "OK");
+    // Acquisition stops first so nothing else writes the checkpoint, the run resumes after the reboot
+    stopTask(&acquisitionTaskHandle);
+    saveRunState();
     ESP.restart();
 }
 
 void handleUpload()
 {
+    TRACE_SCOPE("handleUpload");
     HTTPUpload &upload = server.upload();
     if (upload.status == UPLOAD_FILE_START)
     {
@@ -1127,6 +3886,7 @@ void handleUpload()
     else if (upload.status == UPLOAD_FILE_WRITE)
     {
         // Flashing firmware to ESP
+        TRACE_SCOPE("otaWrite");
         if (Update.write(upload.buf, upload.currentSize) != upload.currentSize)
         {
             Update.printError(Serial);
@@ -1147,6 +3907,7 @@ void handleUpload()
 
 void handleUpdatePage()
 {
+    TRACE_SCOPE("handleUpdatePage");
     if (!server.authenticate(OTA_USER, OTA_PASS))
     {
         return server.requestAuthentication();
@@ -1161,6 +3922,8 @@ bool checkInternetAccess()
     WiFiClient client;
     HTTPClient http;
 
+    http.setConnectTimeout(HTTP_CONNECT_TIMEOUT_MS);
+    http.setTimeout(HTTP_TIMEOUT_MS);
     http.begin(client, "http://www.google.com");
     int httpCode = http.GET();
     http.end();
@@ -1168,48 +3931,14 @@ bool checkInternetAccess()
     return (httpCode == HTTP_CODE_OK);
 }
 
+// Queues the login for CloudTask and returns at once; the result is logged when the flow ends
 bool handleNITJWifiCaptivePortal()
 {
-    HTTPClient http;
-
-    // First make a GET request to establish session (like the Python script)
-    String portalUrl = "http://10.10.11.1:8090/httpclient.html";
-
-    http.begin(portalUrl);
-    http.addHeader("Content-Type", "application/x-www-form-urlencoded");
-    http.addHeader("User-Agent", "Mozilla/5.0");
-
-    String postData = "username=" + String(NITJ_USERNAME) +
-                      "&password=" + String(NITJ_PASSWORD) +
-                      "&mode=191";
-
-    int httpResponseCode = http.POST(postData);
-
-    if (httpResponseCode > 0)
-    {
-        Serial.print("HTTP Response code: ");
-        Serial.println(httpResponseCode);
-
-        String response = http.getString();
-        Serial.println("Response:");
-        Serial.println(response);
-
-        if (response.indexOf("success") != -1)
-        {
-            Serial.println("Login successful!");
-        }
-        else
-        {
-            Serial.println("Login may have failed - check response");
-        }
-    }
-    else
+    if (!queueHttpJob(HTTP_JOB_PORTAL_LOGIN))
     {
-        Serial.print("Error code: ");
-        Serial.println(httpResponseCode);
+        LOG_ERROR("[Portal] Request queue full - login not sent");
     }
 
-    http.end();
     // // Now make the login POST request
     // String loginUrl = "http://10.10.11.1:8090/httpclient.html";
     // http.begin(client, loginUrl);
@@ -1251,3 +3980,549 @@ bool handleNITJWifiCaptivePortal()
     // return false;
     return true;
 }
+
+// Mounts the archive partition (formatted on first use)
+void archiveBegin()
+{
+#if STATIC_MEMORY_LAYOUT
+    archiveMutex = xSemaphoreCreateMutexStatic(&archiveMutexControl);
+#else
+    archiveMutex = xSemaphoreCreateMutex();
+#endif
+    archiveMounted = LittleFS.begin(true);
+    if (!archiveMounted)
+    {
+        Serial.println("[Archive] LittleFS mount failed, archive disabled");
+        return;
+    }
+    if (!LittleFS.exists(ARCHIVE_DIR))
+    {
+        LittleFS.mkdir(ARCHIVE_DIR);
+    }
+    Serial.printf("[Archive] %u of %u bytes used\n", (unsigned)LittleFS.usedBytes(), (unsigned)LittleFS.totalBytes());
+}
+
+static bool archiveValidName(const char *run)
+{
+    size_t length = strlen(run);
+    if (length == 0 || length > ARCHIVE_MAX_RUN_NAME)
+    {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++)
+    {
+        if (!isalnum((unsigned char)run[i]) && run[i] != '_' && run[i] != '-')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void archivePath(char *path, size_t size, const char *run, const char *extension)
+{
+    snprintf(path, size, ARCHIVE_DIR "/%s.%s", run, extension);
+}
+
+// Starts recording into run; an existing run is continued after its last block,
+// so run time stays monotonic across reboots (the time the device was off is not counted)
+bool archiveStart(const char *run)
+{
+    if (!archiveMounted || !archiveValidName(run))
+    {
+        return false;
+    }
+    archiveStop();
+
+    char path[48];
+    archivePath(path, sizeof(path), run, "idx");
+    archiveTimeBase = 0;
+    File index = LittleFS.open(path, "r");
+    if (index && index.size() >= sizeof(ArchiveIndexEntry_t))
+    {
+        ArchiveIndexEntry_t last;
+        index.seek(index.size() - sizeof(last));
+        if (index.read((uint8_t *)&last, sizeof(last)) == sizeof(last))
+        {
+            archiveTimeBase = last.tLast + 1;
+        }
+    }
+    if (index)
+    {
+        index.close();
+    }
+
+    strcpy(archiveRun, run);
+    archiveSessionStart = millis();
+    archiveEncoder.begin(archivePayload, sizeof(archivePayload), ARCHIVE_CODEC);
+    Serial.printf("[Archive] Recording run '%s' from t=%u ms\n", archiveRun, archiveTimeBase);
+    updateMdnsRun();
+    return true;
+}
+
+void archiveStop()
+{
+    if (archiveRun[0] != '\0')
+    {
+        archiveFlush();
+        Serial.printf("[Archive] Run '%s' closed\n", archiveRun);
+        archiveRun[0] = '\0';
+        updateMdnsRun();
+    }
+}
+
+void archiveAppend(const Sample_t &sample)
+{
+    // Samples spooled or queued before /archive/start belong to no run
+    if (archiveRun[0] == '\0' || (int32_t)(sample.timestamp_ms - archiveSessionStart) < 0)
+    {
+        return;
+    }
+
+    uint32_t startUs = micros();
+    const float values[ARCHIVE_CHANNELS] = {sample.temp1, sample.temp2, sample.busVoltage, sample.current_mA,
+                                            sample.power_mW, sample.thermalConductivity, sample.thermalConductivityUnc};
+    uint32_t words[ARCHIVE_CHANNELS];
+    for (int c = 0; c < ARCHIVE_CHANNELS; c++)
+    {
+#if FIXED_POINT_MODE
+        words[c] = (uint32_t)Q16::fromFloat(values[c]).raw;
+#else
+        memcpy(&words[c], &values[c], sizeof(float));
+#endif
+    }
+
+    uint32_t t = archiveTimeBase + (sample.timestamp_ms - archiveSessionStart);
+    if (!archiveEncoder.append(t, words))
+    {
+        archiveFlush();
+        archiveEncoder.append(t, words);
+    }
+
+    uint32_t us = micros() - startUs;
+    archiveAppends++;
+    archiveAppendUsSum += us;
+    if (us > archiveAppendUsMax)
+    {
+        archiveAppendUsMax = us;
+    }
+}
+
+// Worker of the archive sink. Samples that arrive while a block write or an /archive
+// request holds the archive wait in the sink's spool.
+void archiveTask(void *pvParameters)
+{
+    Sample_t sample;
+    for (;;)
+    {
+        supervisor.idle(SUP_ARCHIVE, millis());
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (sampleSinks.take(SINK_ARCHIVE, sample, millis()))
+        {
+            supervisor.beat(SUP_ARCHIVE, millis());
+            xSemaphoreTake(archiveMutex, portMAX_DELAY);
+            archiveAppend(sample);
+            xSemaphoreGive(archiveMutex);
+        }
+    }
+}
+
+// Writes the block being filled and its index entry, then starts a new block
+bool archiveFlush()
+{
+    if (archiveEncoder.count() == 0)
+    {
+        return true;
+    }
+    TRACE_SCOPE("archiveFlush");
+
+    uint32_t startUs = micros();
+    ArchiveBlockHeader_t header;
+    header.magic = ARCHIVE_BLOCK_MAGIC;
+    header.codec = archiveEncoder.seriesCodec();
+    header.channels = ARCHIVE_CHANNELS;
+    header.count = archiveEncoder.count();
+    header.payloadBytes = archiveEncoder.bytes();
+    header.tFirst = archiveEncoder.firstTime();
+    header.tLast = archiveEncoder.lastTime();
+    header.crc = telemetryCrc32(archivePayload, header.payloadBytes);
+
+    char path[48];
+    archivePath(path, sizeof(path), archiveRun, "gor");
+    File data = LittleFS.open(path, "a");
+    archivePath(path, sizeof(path), archiveRun, "idx");
+    File index = LittleFS.open(path, "a");
+    bool ok = data && index;
+    if (ok)
+    {
+        ArchiveIndexEntry_t entry = {(uint32_t)data.size(), header.tFirst, header.tLast, header.count, header.payloadBytes};
+        ok = data.write((const uint8_t *)&header, sizeof(header)) == sizeof(header) &&
+             data.write(archivePayload, header.payloadBytes) == header.payloadBytes;
+        // The index entry is only written for a complete block
+        ok = ok && index.write((const uint8_t *)&entry, sizeof(entry)) == sizeof(entry);
+    }
+    if (data)
+    {
+        data.close();
+    }
+    if (index)
+    {
+        index.close();
+    }
+
+    archiveEncoder.begin(archivePayload, sizeof(archivePayload), ARCHIVE_CODEC);
+    if (!ok)
+    {
+        LOG_ERROR("[Archive] Block write failed (flash full?), block dropped");
+        return false;
+    }
+
+    uint32_t us = micros() - startUs;
+    archiveBlocksWritten++;
+    archiveBytesWritten += sizeof(header) + header.payloadBytes;
+    if (us > archiveFlushUsMax)
+    {
+        archiveFlushUsMax = us;
+    }
+    return true;
+}
+
+// /archive/runs: every run with its blocks, samples, time span and compression
+void handleArchiveRuns()
+{
+    TRACE_SCOPE("handleArchiveRuns");
+    String json = "{\"mounted\":" + String(archiveMounted);
+    json += ",\"active\":\"" + String(archiveRun) + "\"";
+    json += ",\"usedBytes\":" + String(archiveMounted ? (uint32_t)LittleFS.usedBytes() : 0);
+    json += ",\"totalBytes\":" + String(archiveMounted ? (uint32_t)LittleFS.totalBytes() : 0);
+    json += ",\"appends\":" + String(archiveAppends);
+    json += ",\"appendUsMean\":" + String(archiveAppends ? archiveAppendUsSum / archiveAppends : 0);
+    json += ",\"appendUsMax\":" + String(archiveAppendUsMax);
+    json += ",\"flushUsMax\":" + String(archiveFlushUsMax);
+    json += ",\"lastReadRecords\":" + String(archiveLastReadRecords);
+    json += ",\"lastReadUs\":" + String(archiveLastReadUs);
+    json += ",\"runs\":[";
+
+    File dir = archiveMounted ? LittleFS.open(ARCHIVE_DIR) : File();
+    bool first = true;
+    while (dir)
+    {
+        File file = dir.openNextFile();
+        if (!file)
+        {
+            break;
+        }
+        String name = file.name();
+        if (!name.endsWith(".idx"))
+        {
+            file.close();
+            continue;
+        }
+
+        uint32_t blocks = 0, samples = 0, bytes = 0, tFirst = 0, tLast = 0;
+        ArchiveIndexEntry_t entry;
+        while (file.read((uint8_t *)&entry, sizeof(entry)) == sizeof(entry))
+        {
+            if (blocks == 0)
+            {
+                tFirst = entry.tFirst;
+            }
+            tLast = entry.tLast;
+            blocks++;
+            samples += entry.count;
+            bytes += sizeof(ArchiveBlockHeader_t) + entry.payloadBytes;
+        }
+        file.close();
+
+        json += String(first ? "" : ",") + "{\"run\":\"" + name.substring(0, name.length() - 4) + "\"";
+        json += ",\"blocks\":" + String(blocks);
+        json += ",\"samples\":" + String(samples);
+        json += ",\"bytes\":" + String(bytes);
+        json += ",\"bytesPerSample\":" + String(samples ? (float)bytes / samples : 0.0f, 2);
+        json += ",\"ratio\":" + String(bytes ? (float)samples * (4 + 4 * ARCHIVE_CHANNELS) / bytes : 0.0f, 2);
+        json += ",\"tFirst\":" + String(tFirst);
+        json += ",\"tLast\":" + String(tLast) + "}";
+        first = false;
+    }
+    if (dir)
+    {
+        dir.close();
+    }
+    json += "]}";
+
+    server.send(200, "application/json", json);
+}
+
+// /archive/start?run=name
+void handleArchiveStart()
+{
+    TRACE_SCOPE("handleArchiveStart");
+    String run = server.arg("run");
+    xSemaphoreTake(archiveMutex, portMAX_DELAY);
+    bool started = archiveStart(run.c_str());
+    xSemaphoreGive(archiveMutex);
+    if (!started)
+    {
+        server.send(400, "text/plain", archiveMounted ? "run must be 1-24 characters of A-Z a-z 0-9 _ -" : "Archive not mounted");
+        return;
+    }
+    server.send(200, "text/plain", "Recording " + run);
+}
+
+void handleArchiveStop()
+{
+    TRACE_SCOPE("handleArchiveStop");
+    xSemaphoreTake(archiveMutex, portMAX_DELAY);
+    archiveStop();
+    xSemaphoreGive(archiveMutex);
+    server.send(200, "text/plain", "Stopped");
+}
+
+// /archive/delete?run=name
+void handleArchiveDelete()
+{
+    TRACE_SCOPE("handleArchiveDelete");
+    String run = server.arg("run");
+    xSemaphoreTake(archiveMutex, portMAX_DELAY);
+    if (!archiveValidName(run.c_str()) || run == archiveRun)
+    {
+        xSemaphoreGive(archiveMutex);
+        server.send(400, "text/plain", "Unknown or active run");
+        return;
+    }
+    char path[48];
+    archivePath(path, sizeof(path), run.c_str(), "gor");
+    LittleFS.remove(path);
+    archivePath(path, sizeof(path), run.c_str(), "idx");
+    LittleFS.remove(path);
+    xSemaphoreGive(archiveMutex);
+    server.send(200, "text/plain", "Deleted " + run);
+}
+
+// /archive/read?run=name&from=ms&to=ms streams the records in [from, to] as CSV.
+// The block index is binary searched for the first block, only blocks that
+// overlap the range are read and decoded.
+void handleArchiveRead()
+{
+    TRACE_SCOPE("handleArchiveRead");
+    String run = server.arg("run");
+    uint32_t from = server.hasArg("from") ? strtoul(server.arg("from").c_str(), NULL, 10) : 0;
+    uint32_t to = server.hasArg("to") ? strtoul(server.arg("to").c_str(), NULL, 10) : UINT32_MAX;
+    if (!archiveMounted || !archiveValidName(run.c_str()))
+    {
+        server.send(400, "text/plain", "Unknown run");
+        return;
+    }
+    // The files are only read under archiveMutex, ArchiveTask appends to the active run.
+    // It is released while a block is decoded and sent, the spool covers that time.
+    xSemaphoreTake(archiveMutex, portMAX_DELAY);
+
+    char path[48];
+    archivePath(path, sizeof(path), run.c_str(), "idx");
+    File index = LittleFS.open(path, "r");
+    archivePath(path, sizeof(path), run.c_str(), "gor");
+    File data = LittleFS.open(path, "r");
+    if (!index || !data)
+    {
+        xSemaphoreGive(archiveMutex);
+        server.send(404, "text/plain", "Unknown run");
+        return;
+    }
+
+    // The samples of the active run still in RAM are served from a copy of the block being
+    // filled. Flushing it instead would cut the block short on every poll of a live run and
+    // lose the compression. Blocks written after this point are left out, their samples are
+    // in the copy.
+    ArchiveIndexEntry_t entry;
+    uint32_t blocks = index.size() / sizeof(entry);
+    ArchiveBlockHeader_t &tail = *(ArchiveBlockHeader_t *)archiveTailBuffer;
+    tail.count = 0;
+    if (run == archiveRun && archiveEncoder.count() > 0)
+    {
+        tail.magic = ARCHIVE_BLOCK_MAGIC;
+        tail.codec = archiveEncoder.seriesCodec();
+        tail.channels = ARCHIVE_CHANNELS;
+        tail.count = archiveEncoder.count();
+        tail.payloadBytes = archiveEncoder.bytes();
+        tail.tFirst = archiveEncoder.firstTime();
+        tail.tLast = archiveEncoder.lastTime();
+        memcpy(archiveTailBuffer + sizeof(tail), archivePayload, tail.payloadBytes);
+    }
+
+    // First block whose tLast >= from, entries are in time order
+    uint32_t lo = 0, hi = blocks;
+    while (lo < hi)
+    {
+        uint32_t mid = (lo + hi) / 2;
+        index.seek(mid * sizeof(entry));
+        index.read((uint8_t *)&entry, sizeof(entry));
+        if (entry.tLast < from)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    xSemaphoreGive(archiveMutex);
+
+    server.client().setTimeout(NET_SEND_TIMEOUT_S);
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(200, "text/csv", "");
+    server.sendContent("t_ms,temp1,temp2,busVoltage,current_mA,power_mW,thermalConductivity,thermalConductivityUnc\n");
+
+    uint32_t startUs = micros();
+    uint32_t records = 0;
+    char out[512];
+    size_t used = 0;
+    for (uint32_t i = lo; i <= blocks; i++)
+    {
+        const uint8_t *block = archiveReadBuffer;
+        if (i == blocks)
+        {
+            if (tail.count == 0 || tail.tFirst > to)
+            {
+                break;
+            }
+            block = archiveTailBuffer; // Copied above, no CRC yet
+        }
+        else
+        {
+            const ArchiveBlockHeader_t &stored = *(const ArchiveBlockHeader_t *)archiveReadBuffer;
+            xSemaphoreTake(archiveMutex, portMAX_DELAY);
+            index.seek(i * sizeof(entry));
+            bool more = index.read((uint8_t *)&entry, sizeof(entry)) == sizeof(entry) && entry.tFirst <= to;
+            bool complete = more && entry.payloadBytes <= sizeof(archiveReadBuffer) - sizeof(stored) && data.seek(entry.offset) &&
+                            data.read(archiveReadBuffer, sizeof(stored) + entry.payloadBytes) == sizeof(stored) + entry.payloadBytes;
+            xSemaphoreGive(archiveMutex);
+            if (!more)
+            {
+                break;
+            }
+            // The header length must match the index before it is trusted for the CRC and the decoder
+            if (!complete || stored.magic != ARCHIVE_BLOCK_MAGIC || stored.channels != ARCHIVE_CHANNELS ||
+                stored.payloadBytes != entry.payloadBytes ||
+                stored.crc != telemetryCrc32(archiveReadBuffer + sizeof(stored), stored.payloadBytes))
+            {
+                LOG_WARN("[Archive] Skipping corrupt block at %u", entry.offset);
+                continue;
+            }
+        }
+        const ArchiveBlockHeader_t &header = *(const ArchiveBlockHeader_t *)block;
+        const uint8_t *payload = block + sizeof(ArchiveBlockHeader_t);
+
+        SeriesDecoder<ARCHIVE_CHANNELS> decoder;
+        decoder.begin(payload, header.payloadBytes, header.codec, header.count, header.tFirst);
+        uint32_t t;
+        uint32_t words[ARCHIVE_CHANNELS];
+        while (decoder.next(t, words))
+        {
+            if (t < from || t > to)
+            {
+                continue;
+            }
+            // Flush before a line could overflow the chunk buffer
+            if (used > sizeof(out) - 160)
+            {
+                server.sendContent(out, used);
+                used = 0;
+            }
+            used += snprintf(out + used, sizeof(out) - used, "%u", t);
+            for (int c = 0; c < ARCHIVE_CHANNELS; c++)
+            {
+                float value;
+                if (header.codec == SERIES_CODEC_VARINT)
+                {
+                    value = Q16::fromRaw((int32_t)words[c]).toFloat();
+                }
+                else
+                {
+                    memcpy(&value, &words[c], sizeof(float));
+                }
+                out[used++] = ',';
+                used += formatValueTo(out + used, sizeof(out) - used, value, 4);
+            }
+            out[used++] = '\n';
+            records++;
+        }
+    }
+    if (used > 0)
+    {
+        server.sendContent(out, used);
+    }
+    server.sendContent("", 0); // Last chunk
+    index.close();
+    data.close();
+
+    archiveLastReadRecords = records;
+    archiveLastReadUs = micros() - startUs;
+}
+
+void printMemoryMap()
+{
+    Serial.println("Static memory map:");
+    for (size_t i = 0; i < MEMORY_MAP_REGIONS; i++)
+    {
+        Serial.printf("  %-22s %6u\n", memoryMap[i].name, (unsigned)memoryMap[i].bytes);
+    }
+    Serial.printf("  total %u of %u bytes, free heap %u\n",
+                  (unsigned)memoryMapBytes(), (unsigned)STATIC_MEMORY_BUDGET, (unsigned)ESP.getFreeHeap());
+}
+
+void handleMemoryMap()
+{
+    TRACE_SCOPE("handleMemoryMap");
+    char json[768];
+    size_t length = snprintf(json, sizeof(json), "{\"static\":%d,\"regions\":{", STATIC_MEMORY_LAYOUT);
+    for (size_t i = 0; i < MEMORY_MAP_REGIONS && length < sizeof(json); i++)
+    {
+        length += snprintf(json + length, sizeof(json) - length, "%s\"%s\":%u", i ? "," : "",
+                           memoryMap[i].name, (unsigned)memoryMap[i].bytes);
+    }
+    if (length < sizeof(json))
+    {
+        length += snprintf(json + length, sizeof(json) - length,
+                           "},\"total\":%u,\"budget\":%u,\"freeHeap\":%u,\"minFreeHeap\":%u,\"acqHeapAllocs\":%u}",
+                           (unsigned)memoryMapBytes(), (unsigned)STATIC_MEMORY_BUDGET, (unsigned)ESP.getFreeHeap(),
+                           (unsigned)ESP.getMinFreeHeap(), (unsigned)acquisitionHeapAllocs);
+    }
+
+    server.send_P(200, "application/json", json, min(length, sizeof(json) - 1));
+}
+
+// Heap accounting for the acquisition path: every malloc/calloc/realloc in the image is
+// routed through these wrappers by the linker, allocations from AcqTask or CaptureTask are counted
+extern "C"
+{
+    void *__real_malloc(size_t size);
+    void *__real_calloc(size_t count, size_t size);
+    void *__real_realloc(void *ptr, size_t size);
+
+    static inline void countAcquisitionAlloc()
+    {
+        TaskHandle_t current = xTaskGetCurrentTaskHandle();
+        if (current != NULL && (current == acquisitionTaskHandle || current == captureTaskHandle))
+        {
+            acquisitionHeapAllocs++;
+        }
+    }
+
+    void *__wrap_malloc(size_t size)
+    {
+        countAcquisitionAlloc();
+        return __real_malloc(size);
+    }
+
+    void *__wrap_calloc(size_t count, size_t size)
+    {
+        countAcquisitionAlloc();
+        return __real_calloc(count, size);
+    }
+
+    void *__wrap_realloc(void *ptr, size_t size)
+    {
+        countAcquisitionAlloc();
+        return __real_realloc(ptr, size);
+    }
+}
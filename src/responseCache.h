@@ -0,0 +1,90 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// Serialized response of the current data version, built once and served to every
+// client. The ETag is a boot id plus the version, so a poll without new data costs a
+// string compare and a 304; the boot id keeps a tag from before a reboot from matching.
+// Build and serve from the same task, there is no locking.
+template <size_t Capacity>
+class ResponseCache
+{
+public:
+    void begin(uint32_t bootId)
+    {
+        boot = bootId;
+        versionCount = 0;
+        bodyLength = 0;
+        tag[0] = '\0';
+    }
+
+    // Write the body of the next version into buffer(), then commit() its length
+    char *buffer() { return body; }
+    size_t capacity() const { return Capacity; }
+
+    void commit(size_t length)
+    {
+        bodyLength = length < Capacity ? length : Capacity - 1;
+        body[bodyLength] = '\0';
+        versionCount++;
+        snprintf(tag, sizeof(tag), "\"%08lx-%lx\"", (unsigned long)boot, (unsigned long)versionCount);
+        buildCount++;
+    }
+
+    bool valid() const { return versionCount > 0; }
+    const char *data() const { return body; }
+    size_t length() const { return bodyLength; }
+    const char *etag() const { return tag; }
+    uint32_t version() const { return versionCount; }
+
+    // If-None-Match holds * or a comma-separated list of tags, weak (W/) ones included
+    bool notModified(const char *ifNoneMatch) const
+    {
+        if (!valid() || !ifNoneMatch)
+        {
+            return false;
+        }
+        size_t tagLength = strlen(tag);
+        const char *p = ifNoneMatch;
+        while (*p)
+        {
+            while (*p == ' ' || *p == ',')
+            {
+                p++;
+            }
+            if (*p == '*')
+            {
+                return true;
+            }
+            if (p[0] == 'W' && p[1] == '/')
+            {
+                p += 2;
+            }
+            size_t length = strcspn(p, ", ");
+            if (length == tagLength && memcmp(p, tag, length) == 0)
+            {
+                return true;
+            }
+            p += length;
+        }
+        return false;
+    }
+
+    // Served counts, as reported by the caller
+    void served(bool notModifiedResponse) { notModifiedResponse ? notModifiedCount++ : fullCount++; }
+    uint32_t builds() const { return buildCount; }
+    uint32_t fullResponses() const { return fullCount; }
+    uint32_t notModifiedResponses() const { return notModifiedCount; }
+
+private:
+    char body[Capacity];
+    size_t bodyLength = 0;
+    char tag[24] = "";
+    uint32_t boot = 0;
+    uint32_t versionCount = 0;
+    uint32_t buildCount = 0;
+    uint32_t fullCount = 0;
+    uint32_t notModifiedCount = 0;
+};
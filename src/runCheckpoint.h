@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+#include <telemetryFrame.h>
+
+// Copy of the run state that survives a reset, for an object in RTC_NOINIT memory
+// (kept across software, panic and watchdog resets, garbage after power-on). There are
+// two slots written alternately, each with a sequence number and a CRC-32. A reset in
+// the middle of save() tears at most the slot being written, restore() takes the newest
+// intact one. The object must not have a constructor: static initialization at boot
+// would wipe the very state it is meant to keep.
+#define CHECKPOINT_MAGIC 0x52554E53 // "RUNS"
+
+template <typename T>
+class RunCheckpoint
+{
+    static_assert(std::is_trivially_copyable<T>::value, "State is copied as bytes");
+
+public:
+    // layout changes whenever T does, so a firmware update never restores a stale layout
+    void save(const T &state, uint32_t layout)
+    {
+        int newest = newestSlot(layout);
+        Slot &slot = slots[newest == 0 ? 1 : 0];
+        slot.magic = 0; // Invalid until the CRC is in place
+        slot.layout = layout;
+        slot.sequence = newest < 0 ? 1 : slots[newest].sequence + 1;
+        memcpy(slot.state, &state, sizeof(T));
+        slot.crc = crc(slot);
+        slot.magic = CHECKPOINT_MAGIC;
+    }
+
+    bool restore(T &state, uint32_t layout) const
+    {
+        int newest = newestSlot(layout);
+        if (newest < 0)
+        {
+            return false;
+        }
+        memcpy(&state, slots[newest].state, sizeof(T));
+        return true;
+    }
+
+    // Sequence of the newest intact slot, 0 when there is none
+    uint32_t sequence(uint32_t layout) const
+    {
+        int newest = newestSlot(layout);
+        return newest < 0 ? 0 : slots[newest].sequence;
+    }
+
+    void invalidate()
+    {
+        slots[0].magic = 0;
+        slots[1].magic = 0;
+    }
+
+private:
+    struct Slot
+    {
+        uint32_t magic;
+        uint32_t layout;
+        uint32_t sequence;
+        uint32_t crc;
+        uint8_t state[sizeof(T)];
+    };
+
+    static uint32_t crc(const Slot &slot)
+    {
+        uint32_t header[2] = {slot.layout, slot.sequence};
+        uint32_t headerCrc = telemetryCrc32((const uint8_t *)header, sizeof(header));
+        return headerCrc ^ telemetryCrc32(slot.state, sizeof(T));
+    }
+
+    bool intact(const Slot &slot, uint32_t layout) const
+    {
+        return slot.magic == CHECKPOINT_MAGIC && slot.layout == layout && slot.crc == crc(slot);
+    }
+
+    int newestSlot(uint32_t layout) const
+    {
+        bool valid0 = intact(slots[0], layout);
+        bool valid1 = intact(slots[1], layout);
+        if (valid0 && valid1)
+        {
+            return (int32_t)(slots[1].sequence - slots[0].sequence) > 0 ? 1 : 0;
+        }
+        return valid0 ? 0 : valid1 ? 1 : -1;
+    }
+
+    Slot slots[2];
+};
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+
+// Heater interlock. The acquisition code report()s every reading, check() runs from a
+// hardware-timer ISR: the newest reading of each channel is compared with its limit, a
+// channel that stops reporting counts as a fault, and a fault is latched until clear().
+// A reading past its limit is acted on by the next check(), so the cutoff latency is at
+// most one timer period (plus ISR jitter, tracked by maxCheckGapUs()). The ISR side is
+// integer-only, there is no FPU in ISRs: report() scales to milli-units and turns a
+// non-finite reading into a sensor fault.
+enum InterlockChannel
+{
+    INTERLOCK_TEMP1,   // K
+    INTERLOCK_TEMP2,   // K
+    INTERLOCK_POWER,   // mW
+    INTERLOCK_CURRENT, // mA
+    INTERLOCK_CHANNELS
+};
+
+enum InterlockFault
+{
+    INTERLOCK_OK,
+    INTERLOCK_OVER_LIMIT,
+    INTERLOCK_STALE,    // No reading for staleUs
+    INTERLOCK_SENSOR,   // NaN or infinite reading
+    INTERLOCK_RESTORED, // Latched before a reset
+};
+
+inline const char *interlockChannelName(int channel)
+{
+    static const char *const names[] = {"temp1", "temp2", "power", "current"};
+    return channel >= 0 && channel < INTERLOCK_CHANNELS ? names[channel] : "?";
+}
+
+inline const char *interlockFaultName(InterlockFault fault)
+{
+    static const char *const names[] = {"ok", "overLimit", "stale", "sensor", "restored"};
+    return fault <= INTERLOCK_RESTORED ? names[fault] : "?";
+}
+
+class SafetyInterlock
+{
+public:
+    // Arms the interlock, every channel must report within staleUs from now on
+    void begin(uint32_t nowUs, uint32_t staleUs)
+    {
+        stale = staleUs;
+        for (int c = 0; c < INTERLOCK_CHANNELS; c++)
+        {
+            reportUs[c] = nowUs;
+            values[c] = 0;
+        }
+        lastCheckUs = nowUs;
+        checked = false;
+        armed = true;
+    }
+
+    void setLimit(int channel, float limit) { limits[channel] = toMilli(limit); }
+    float limit(int channel) const { return limits[channel] / 1000.0f; }
+    uint32_t staleLimitUs() const { return stale; }
+
+    // Task side, after each reading. A check() between the two stores can pair the new time
+    // with the previous value for one period; the value is checked against the limit either
+    // way, only its staleness is judged by the newer time.
+    void report(int channel, float value, uint32_t nowUs)
+    {
+        reportUs[channel] = nowUs;
+        values[channel] = toMilli(value);
+    }
+
+    // ISR side, returns true while the fault is latched
+    inline __attribute__((always_inline)) bool check(uint32_t nowUs)
+    {
+        if (!armed)
+        {
+            return false;
+        }
+        checkCount++;
+        uint32_t gap = nowUs - lastCheckUs;
+        if (checked && gap > maxGapUs)
+        {
+            maxGapUs = gap;
+        }
+        lastCheckUs = nowUs;
+        checked = true;
+        if (latched)
+        {
+            return true;
+        }
+
+        for (int c = 0; c < INTERLOCK_CHANNELS; c++)
+        {
+            // A report from the other core can be stamped just after nowUs
+            int32_t signedAge = (int32_t)(nowUs - reportUs[c]);
+            uint32_t age = signedAge > 0 ? signedAge : 0;
+            int32_t value = values[c];
+            if (value == SENSOR_FAULT)
+            {
+                trip(INTERLOCK_SENSOR, c, value, age);
+            }
+            else if (value > limits[c])
+            {
+                trip(INTERLOCK_OVER_LIMIT, c, value, age);
+            }
+            else if (age > stale)
+            {
+                trip(INTERLOCK_STALE, c, value, age - stale);
+            }
+            if (latched)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Releases the latch once every channel is fresh and within its limit
+    bool clear(uint32_t nowUs)
+    {
+        for (int c = 0; c < INTERLOCK_CHANNELS; c++)
+        {
+            int32_t value = values[c];
+            if (value == SENSOR_FAULT || value > limits[c] || (int32_t)(nowUs - reportUs[c]) > (int32_t)stale)
+            {
+                return false;
+            }
+        }
+        latched = false;
+        return true;
+    }
+
+    // ISR side, once the heater drive is cut after a check() that tripped: the time the cut
+    // took is added to that trip's latency. Later calls while latched change nothing.
+    inline __attribute__((always_inline)) void cutDone(uint32_t nowUs)
+    {
+        if (!cutPending)
+        {
+            return;
+        }
+        cutPending = false;
+        uint32_t latency = lastLatencyUs + (nowUs - lastCheckUs);
+        lastLatencyUs = latency;
+        if (latency > maxLatencyUs)
+        {
+            maxLatencyUs = latency;
+        }
+    }
+
+    // Latches without a reading, for a fault that was latched before a reset
+    void latch(InterlockFault fault)
+    {
+        trip(fault, -1, 0, 0);
+        cutPending = false;
+    }
+
+    bool tripped() const { return latched; }
+    InterlockFault fault() const { return lastFault; }
+    int faultChannel() const { return lastChannel; }
+    float faultValue() const { return lastFault == INTERLOCK_SENSOR || lastFault == INTERLOCK_RESTORED ? NAN : lastValue / 1000.0f; }
+    uint32_t tripLatencyUs() const { return lastLatencyUs; } // Reading (or stale deadline) to cutoff, see cutDone()
+    uint32_t maxTripLatencyUs() const { return maxLatencyUs; }
+    uint32_t maxCheckGapUs() const { return maxGapUs; } // Bound on the latency, as measured
+    uint32_t trips() const { return tripCount; }
+    uint32_t checks() const { return checkCount; }
+    void resetStats()
+    {
+        maxGapUs = 0;
+        maxLatencyUs = 0;
+        checked = false;
+    }
+
+private:
+    static const int32_t SENSOR_FAULT = INT32_MIN;
+
+    static int32_t toMilli(float value)
+    {
+        if (!isfinite(value))
+        {
+            return SENSOR_FAULT;
+        }
+        float milli = value * 1000.0f;
+        return milli >= 2147483520.0f ? INT32_MAX : milli <= -2147483520.0f ? INT32_MIN + 1 : (int32_t)milli;
+    }
+
+    inline __attribute__((always_inline)) void trip(InterlockFault fault, int channel, int32_t value, uint32_t latencyUs)
+    {
+        lastFault = fault;
+        lastChannel = channel;
+        lastValue = value;
+        lastLatencyUs = latencyUs;
+        if (latencyUs > maxLatencyUs)
+        {
+            maxLatencyUs = latencyUs;
+        }
+        tripCount++;
+        cutPending = true;
+        latched = true;
+    }
+
+    volatile int32_t values[INTERLOCK_CHANNELS] = {};
+    volatile uint32_t reportUs[INTERLOCK_CHANNELS] = {};
+    volatile int32_t limits[INTERLOCK_CHANNELS] = {INT32_MAX, INT32_MAX, INT32_MAX, INT32_MAX};
+    uint32_t stale = INT32_MAX;
+    volatile bool armed = false;
+    volatile bool latched = false;
+    volatile bool cutPending = false; // Tripped, cutDone() not called yet
+    volatile InterlockFault lastFault = INTERLOCK_OK;
+    volatile int lastChannel = -1;
+    volatile int32_t lastValue = 0;
+    volatile uint32_t lastLatencyUs = 0;
+    volatile uint32_t maxLatencyUs = 0;
+    volatile uint32_t maxGapUs = 0;
+    volatile uint32_t lastCheckUs = 0;
+    volatile bool checked = false;
+    volatile uint32_t tripCount = 0;
+    volatile uint32_t checkCount = 0;
+};
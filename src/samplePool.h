@@ -0,0 +1,101 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+// Statically sized pool of reference-counted blocks. Queues carry the 16-bit
+// handle instead of the block, so a sample is written once and every consumer
+// reads the same memory. alloc()/release() are O(1) and lock-free: the free
+// list is a Treiber stack whose head packs a 16-bit ABA tag with the index.
+typedef uint16_t BlockHandle;
+#define INVALID_BLOCK 0xFFFF
+
+template <typename T, uint16_t N>
+class BlockPool
+{
+    static_assert(N > 0 && N < INVALID_BLOCK, "Pool too large for 16-bit handles");
+
+public:
+    BlockPool()
+    {
+        for (uint16_t i = 0; i < N; i++)
+        {
+            nextFree[i].store(i + 1 < N ? i + 1 : INVALID_BLOCK, std::memory_order_relaxed);
+            refCount[i].store(0, std::memory_order_relaxed);
+        }
+        freeHead.store(0, std::memory_order_relaxed);
+    }
+
+    // Returns a block with one reference, or INVALID_BLOCK when the pool is exhausted
+    BlockHandle alloc()
+    {
+        uint32_t head = freeHead.load(std::memory_order_acquire);
+        uint32_t next;
+        uint16_t index;
+        do
+        {
+            index = head & 0xFFFF;
+            if (index == INVALID_BLOCK)
+            {
+                exhaustedCount.fetch_add(1, std::memory_order_relaxed);
+                return INVALID_BLOCK;
+            }
+            next = (((head >> 16) + 1) << 16) | nextFree[index].load(std::memory_order_relaxed);
+        } while (!freeHead.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire));
+
+        refCount[index].store(1, std::memory_order_relaxed);
+        allocCount.fetch_add(1, std::memory_order_relaxed);
+        uint32_t used = inUseCount.fetch_add(1, std::memory_order_relaxed) + 1;
+        uint32_t peak = peakInUse.load(std::memory_order_relaxed);
+        while (used > peak && !peakInUse.compare_exchange_weak(peak, used, std::memory_order_relaxed))
+        {
+        }
+        return index;
+    }
+
+    // Extra reference for another consumer (e.g. before queueing the handle)
+    void retain(BlockHandle h)
+    {
+        if (h != INVALID_BLOCK)
+        {
+            refCount[h].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Drops one reference, the block returns to the pool with the last one
+    void release(BlockHandle h)
+    {
+        if (h == INVALID_BLOCK || refCount[h].fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            return;
+        }
+
+        uint32_t head = freeHead.load(std::memory_order_acquire);
+        uint32_t next;
+        do
+        {
+            nextFree[h].store(head & 0xFFFF, std::memory_order_relaxed);
+            next = (((head >> 16) + 1) << 16) | h;
+        } while (!freeHead.compare_exchange_weak(head, next, std::memory_order_acq_rel, std::memory_order_acquire));
+        inUseCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    T &operator[](BlockHandle h) { return blocks[h]; }
+    const T &operator[](BlockHandle h) const { return blocks[h]; }
+
+    uint16_t capacity() const { return N; }
+    uint32_t allocations() const { return allocCount.load(std::memory_order_relaxed); }
+    uint32_t exhaustions() const { return exhaustedCount.load(std::memory_order_relaxed); }
+    uint32_t inUse() const { return inUseCount.load(std::memory_order_relaxed); }
+    uint32_t peak() const { return peakInUse.load(std::memory_order_relaxed); }
+
+private:
+    T blocks[N];
+    std::atomic<uint16_t> nextFree[N];
+    std::atomic<uint16_t> refCount[N];
+    std::atomic<uint32_t> freeHead;
+    std::atomic<uint32_t> allocCount{0};
+    std::atomic<uint32_t> exhaustedCount{0};
+    std::atomic<uint32_t> inUseCount{0};
+    std::atomic<uint32_t> peakInUse{0};
+};
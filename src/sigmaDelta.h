@@ -0,0 +1,56 @@
+#pragma once
+
+#include <stdint.h>
+
+// First-order sigma-delta between two adjacent codes of the 8-bit DAC. The heater
+// level is 16-bit: the high byte is the DAC code, the low byte the fraction of an LSB
+// that the modulator dithers in. Heater power goes with V², so by default the duty of
+// the upper code is chosen to make the mean power, not the mean voltage, land on
+// (code + fraction)². next() is integer-only and meant for a timer ISR.
+#define HEATER_LEVEL_MAX 0xFFFF
+
+class SigmaDelta
+{
+public:
+    void set(uint16_t level, bool powerLinear = true)
+    {
+        uint32_t code = level >> 8;
+        uint32_t fraction = level & 0xFF;
+        uint32_t duty; // Of code + 1, in 1/65536
+        if (powerLinear)
+        {
+            // (1 − d)·n² + d·(n + 1)² = (n + f)²  →  d = (2n·f + f²) / (2n + 1)
+            duty = (2 * code * fraction * 256 + fraction * fraction) / (2 * code + 1);
+        }
+        else
+        {
+            duty = fraction << 8;
+        }
+        if (code >= 255)
+        {
+            code = 255;
+            duty = 0;
+        }
+        setting = code << 16 | duty; // One word, so the ISR never sees half an update
+    }
+
+    // Next DAC code, one call per timer tick (always inlined into the IRAM ISR)
+    inline __attribute__((always_inline)) uint8_t next()
+    {
+        uint32_t s = setting;
+        accumulator += s & 0xFFFF;
+        if (accumulator >= 0x10000)
+        {
+            accumulator -= 0x10000;
+            return (s >> 16) + 1;
+        }
+        return s >> 16;
+    }
+
+    uint8_t code() const { return setting >> 16; }
+    uint16_t duty() const { return setting & 0xFFFF; }
+
+private:
+    volatile uint32_t setting = 0;
+    uint32_t accumulator = 0;
+};
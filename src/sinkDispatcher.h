@@ -0,0 +1,288 @@
+#pragma once
+
+#include <stdint.h>
+#include <samplePool.h>
+
+// Fan-out of published samples to independent sinks (UDP, archive, uploads). Every sink
+// has its own bounded queue of pool handles and its own worker, so a slow sink only
+// backs up its own queue. A full queue is handled per sink:
+//   SINK_DROP_OLDEST  the oldest entry makes room, the worker always gets the newest data
+//   SINK_BLOCK        publish() waits up to blockMs for the worker, then drops the new
+//                     sample; back-pressure on every sink, only for a worker known to be quick
+//   SINK_SPOOL        copies go to a caller-provided buffer until the worker catches up,
+//                     nothing is lost and no pool block is held (oldest copy dropped when full)
+// A sink also has a minimum interval between deliveries: a backlog after an outage drains
+// at that pace instead of in one burst. The state is shared between the publisher and the
+// workers under Lock (lock()/unlock(), held for a few copies at most).
+enum SinkOverflow
+{
+    SINK_DROP_OLDEST,
+    SINK_BLOCK,
+    SINK_SPOOL,
+};
+
+inline const char *sinkOverflowName(SinkOverflow overflow)
+{
+    static const char *const names[] = {"dropOldest", "block", "spool"};
+    return overflow <= SINK_SPOOL ? names[overflow] : "?";
+}
+
+#define SINK_MASK(sink) (1UL << (sink))
+
+typedef struct
+{
+    uint32_t published; // Samples offered to the sink
+    uint32_t delivered; // Taken by its worker
+    uint32_t dropped;   // Lost to the overflow policy
+    uint32_t spooled;   // Went through the spool
+    uint32_t blocked;   // Publishes that had to wait for the worker
+    uint32_t lagMs;     // Publish to take, last delivery
+    uint32_t maxLagMs;
+    uint32_t lagMsSum;  // Over delivered, for the mean
+    uint16_t backlog;   // Queued and spooled now
+    uint16_t peakBacklog;
+} SinkStats_t;
+
+template <typename T, uint16_t PoolSize, typename Lock, int Sinks, int Depth>
+class SinkDispatcher
+{
+    static_assert(Sinks > 0 && Sinks <= 32, "Sinks are selected by a 32-bit mask");
+    static_assert(Depth > 0 && Depth < 0x8000, "Queue depth out of range");
+
+public:
+    // Spool entries, the buffer is declared by the caller with the sink's capacity
+    typedef struct
+    {
+        T item;
+        uint32_t publishedMs;
+    } SpoolEntry;
+
+    // wait(ms) sleeps the publisher while a SINK_BLOCK queue is full
+    void begin(BlockPool<T, PoolSize> *blockPool, void (*wait)(uint32_t ms))
+    {
+        pool = blockPool;
+        waitFn = wait;
+    }
+
+    void addSink(int sink, const char *name, SinkOverflow overflow, uint32_t minIntervalMs,
+                 uint32_t blockMs = 0, SpoolEntry *spool = nullptr, uint16_t spoolCapacity = 0)
+    {
+        Sink &s = sinks[sink];
+        s.name = name;
+        s.overflow = overflow;
+        s.minIntervalMs = minIntervalMs;
+        s.blockMs = blockMs;
+        s.spool = spool;
+        s.spoolCapacity = spool ? spoolCapacity : 0;
+    }
+
+    // Publisher side: each sink in mask gets its own reference to h (the caller keeps
+    // its own). Returns the sinks that got the sample, whose workers need a wake-up.
+    uint32_t publish(BlockHandle h, uint32_t nowMs, uint32_t mask = 0xFFFFFFFFUL)
+    {
+        uint32_t queued = 0;
+        for (int i = 0; i < Sinks; i++)
+        {
+            Sink &s = sinks[i];
+            if (!(mask & SINK_MASK(i)) || !s.name || h == INVALID_BLOCK)
+            {
+                continue;
+            }
+
+            lock.lock();
+            if (s.overflow == SINK_BLOCK && s.length == Depth)
+            {
+                s.stats.blocked++;
+                for (uint32_t waited = 0; s.length == Depth && waited < s.blockMs; waited++)
+                {
+                    lock.unlock();
+                    waitFn(1);
+                    lock.lock();
+                }
+            }
+            s.stats.published++;
+
+            if (s.overflow == SINK_SPOOL && (s.spoolLength > 0 || s.length == Depth) && s.spoolCapacity > 0)
+            {
+                // Behind the queue in delivery order, so once spooling, keep spooling until it drains
+                if (s.spoolLength == s.spoolCapacity)
+                {
+                    s.spoolHead = (s.spoolHead + 1) % s.spoolCapacity;
+                    s.spoolLength--;
+                    s.stats.dropped++;
+                }
+                SpoolEntry &entry = s.spool[(s.spoolHead + s.spoolLength) % s.spoolCapacity];
+                entry.item = (*pool)[h];
+                entry.publishedMs = nowMs;
+                s.spoolLength++;
+                s.stats.spooled++;
+                queued |= SINK_MASK(i);
+            }
+            else if (s.length < Depth || s.overflow == SINK_DROP_OLDEST || s.overflow == SINK_SPOOL)
+            {
+                if (s.length == Depth)
+                {
+                    pool->release(s.queue[s.head].handle);
+                    s.head = (s.head + 1) % Depth;
+                    s.length--;
+                    s.stats.dropped++;
+                }
+                pool->retain(h);
+                s.queue[(s.head + s.length) % Depth] = {h, nowMs};
+                s.length++;
+                queued |= SINK_MASK(i);
+            }
+            else
+            {
+                s.stats.dropped++; // Blocked for blockMs, the worker is stuck
+            }
+
+            uint16_t backlog = s.length + s.spoolLength;
+            if (backlog > s.stats.peakBacklog)
+            {
+                s.stats.peakBacklog = backlog;
+            }
+            lock.unlock();
+        }
+        return queued;
+    }
+
+    // Worker side: a copy of the sink's next sample. False when nothing is queued or the
+    // rate limit says not yet (waitMs() tells how long).
+    bool take(int sink, T &out, uint32_t nowMs)
+    {
+        Sink &s = sinks[sink];
+        lock.lock();
+        if (s.length + s.spoolLength == 0 || (s.taken && nowMs - s.lastTakeMs < s.minIntervalMs))
+        {
+            lock.unlock();
+            return false;
+        }
+
+        uint32_t publishedMs;
+        BlockHandle h = INVALID_BLOCK;
+        if (s.length > 0)
+        {
+            h = s.queue[s.head].handle;
+            publishedMs = s.queue[s.head].publishedMs;
+            s.head = (s.head + 1) % Depth;
+            s.length--;
+        }
+        else
+        {
+            // The publisher may overwrite a spool entry as soon as the lock is released
+            const SpoolEntry &entry = s.spool[s.spoolHead];
+            out = entry.item;
+            publishedMs = entry.publishedMs;
+            s.spoolHead = (s.spoolHead + 1) % s.spoolCapacity;
+            s.spoolLength--;
+        }
+
+        uint32_t lag = nowMs - publishedMs;
+        s.taken = true;
+        s.lastTakeMs = nowMs;
+        s.stats.delivered++;
+        s.stats.lagMs = lag;
+        s.stats.lagMsSum += lag;
+        if (lag > s.stats.maxLagMs)
+        {
+            s.stats.maxLagMs = lag;
+        }
+        lock.unlock();
+
+        // The queue's reference keeps the block alive for the copy
+        if (h != INVALID_BLOCK)
+        {
+            out = (*pool)[h];
+            pool->release(h);
+        }
+        return true;
+    }
+
+    // How long the worker may sleep: 0 = take() now, UINT32_MAX = until the next publish
+    uint32_t waitMs(int sink, uint32_t nowMs)
+    {
+        const Sink &s = sinks[sink];
+        lock.lock();
+        uint32_t wait = UINT32_MAX;
+        if (s.length + s.spoolLength > 0)
+        {
+            uint32_t since = nowMs - s.lastTakeMs;
+            wait = !s.taken || since >= s.minIntervalMs ? 0 : s.minIntervalMs - since;
+        }
+        lock.unlock();
+        return wait;
+    }
+
+    // Drops everything the sink has queued
+    void clear(int sink)
+    {
+        Sink &s = sinks[sink];
+        lock.lock();
+        while (s.length > 0)
+        {
+            pool->release(s.queue[s.head].handle);
+            s.head = (s.head + 1) % Depth;
+            s.length--;
+            s.stats.dropped++;
+        }
+        s.stats.dropped += s.spoolLength;
+        s.spoolLength = 0;
+        lock.unlock();
+    }
+
+    SinkStats_t stats(int sink)
+    {
+        const Sink &s = sinks[sink];
+        lock.lock();
+        SinkStats_t copy = s.stats;
+        copy.backlog = s.length + s.spoolLength;
+        lock.unlock();
+        return copy;
+    }
+
+    void resetStats(int sink)
+    {
+        Sink &s = sinks[sink];
+        lock.lock();
+        s.stats = SinkStats_t();
+        lock.unlock();
+    }
+
+    int count() const { return Sinks; }
+    int depth() const { return Depth; }
+    const char *name(int sink) const { return sinks[sink].name ? sinks[sink].name : ""; }
+    SinkOverflow overflow(int sink) const { return sinks[sink].overflow; }
+    uint32_t minIntervalMs(int sink) const { return sinks[sink].minIntervalMs; }
+    uint16_t spoolCapacity(int sink) const { return sinks[sink].spoolCapacity; }
+
+private:
+    struct Entry
+    {
+        BlockHandle handle;
+        uint32_t publishedMs;
+    };
+
+    struct Sink
+    {
+        const char *name = nullptr; // Unset sinks are skipped
+        SinkOverflow overflow = SINK_DROP_OLDEST;
+        uint32_t minIntervalMs = 0;
+        uint32_t blockMs = 0;
+        Entry queue[Depth];
+        uint16_t head = 0;
+        uint16_t length = 0;
+        SpoolEntry *spool = nullptr;
+        uint16_t spoolCapacity = 0;
+        uint16_t spoolHead = 0;
+        uint16_t spoolLength = 0;
+        bool taken = false; // The rate limit starts with the first delivery
+        uint32_t lastTakeMs = 0;
+        SinkStats_t stats = {};
+    };
+
+    BlockPool<T, PoolSize> *pool = nullptr;
+    void (*waitFn)(uint32_t ms) = nullptr;
+    Sink sinks[Sinks];
+    Lock lock;
+};
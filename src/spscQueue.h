@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Lock-free single-producer/single-consumer ring for handing samples between cores.
+// One slot is kept empty to tell full from empty, so it holds N - 1 items.
+template <typename T, size_t N>
+class SpscQueue
+{
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+    // Producer side only; returns false (and counts a drop) when the consumer is behind
+    bool push(const T &item)
+    {
+        uint32_t head = headIndex.load(std::memory_order_relaxed);
+        uint32_t next = (head + 1) & (N - 1);
+        if (next == tailIndex.load(std::memory_order_acquire))
+        {
+            dropCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        items[head] = item;
+        headIndex.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side only
+    bool pop(T &item)
+    {
+        uint32_t tail = tailIndex.load(std::memory_order_relaxed);
+        if (tail == headIndex.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        item = items[tail];
+        tailIndex.store((tail + 1) & (N - 1), std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const
+    {
+        return (headIndex.load(std::memory_order_acquire) - tailIndex.load(std::memory_order_acquire)) & (N - 1);
+    }
+
+    uint32_t drops() const { return dropCount.load(std::memory_order_relaxed); }
+
+private:
+    T items[N];
+    std::atomic<uint32_t> headIndex{0};
+    std::atomic<uint32_t> tailIndex{0};
+    std::atomic<uint32_t> dropCount{0};
+};
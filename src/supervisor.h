@@ -0,0 +1,296 @@
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+
+// Per-task heartbeats with deadlines, plus a log of recovery actions.
+// Tasks only store a timestamp (beat/idle), all bookkeeping runs in the
+// supervisor's check(), so a hung task can never block the supervisor.
+// Times are passed in by the caller (millis() on target).
+#define SUPERVISOR_LOG_SIZE 16
+
+typedef struct
+{
+    uint32_t t_ms;        // When the recovery started
+    const char *subsystem;
+    const char *action;
+    uint32_t stalled_ms;  // Heartbeat age / outage length when it was detected
+    uint32_t recovery_ms; // Until the subsystem was healthy again, 0 = pending
+} RecoveryEvent_t;
+
+template <int N>
+class Supervisor
+{
+public:
+    void watch(int id, const char *name, uint32_t deadlineMs, uint32_t nowMs)
+    {
+        tasks[id].name = name;
+        tasks[id].deadlineMs = deadlineMs;
+        tasks[id].lastBeatMs.store(nowMs, std::memory_order_relaxed);
+        tasks[id].active.store(true, std::memory_order_release);
+    }
+
+    // Called by the task: alive, deadline enforced until the next beat
+    void beat(int id, uint32_t nowMs)
+    {
+        tasks[id].lastBeatMs.store(nowMs, std::memory_order_relaxed);
+        tasks[id].active.store(true, std::memory_order_release);
+    }
+
+    // Called by the task before an unbounded wait (queue, notification)
+    void idle(int id, uint32_t nowMs)
+    {
+        tasks[id].lastBeatMs.store(nowMs, std::memory_order_relaxed);
+        tasks[id].active.store(false, std::memory_order_release);
+    }
+
+    // Bitmask of tasks that went past their deadline since the last call. A stall
+    // is reported once; it counts as one miss however long it lasts.
+    uint32_t check(uint32_t nowMs)
+    {
+        uint32_t missed = 0;
+        for (int i = 0; i < N; i++)
+        {
+            Task &t = tasks[i];
+            if (t.name == nullptr)
+            {
+                continue;
+            }
+
+            uint32_t last = t.lastBeatMs.load(std::memory_order_relaxed);
+            if (t.pendingEvent >= 0 && (int32_t)(last - events[t.pendingEvent].t_ms) > 0)
+            {
+                // First heartbeat after a recovery
+                events[t.pendingEvent].recovery_ms = last - events[t.pendingEvent].t_ms;
+                t.pendingEvent = -1;
+            }
+
+            uint32_t age = nowMs - last;
+            bool late = t.active.load(std::memory_order_acquire) && age > t.deadlineMs;
+            if (late && !t.overdue)
+            {
+                t.misses++;
+                missed |= 1UL << i;
+            }
+            if (late && age - t.deadlineMs > t.worstLateMs)
+            {
+                t.worstLateMs = age - t.deadlineMs;
+            }
+            t.overdue = late;
+        }
+        return missed;
+    }
+
+    // Records a recovery; for a task the event completes on its next heartbeat,
+    // otherwise the caller completes it with complete()
+    int logEvent(const char *subsystem, const char *action, uint32_t nowMs, uint32_t stalledMs, int id = -1)
+    {
+        int slot = eventCount % SUPERVISOR_LOG_SIZE;
+        events[slot].t_ms = nowMs;
+        events[slot].subsystem = subsystem;
+        events[slot].action = action;
+        events[slot].stalled_ms = stalledMs;
+        events[slot].recovery_ms = 0;
+        eventCount++;
+        if (id >= 0)
+        {
+            // The restarted task gets a full deadline before it can be reported again
+            tasks[id].lastBeatMs.store(nowMs, std::memory_order_relaxed);
+            tasks[id].restarts++;
+            tasks[id].pendingEvent = slot;
+            tasks[id].overdue = false;
+        }
+        return slot;
+    }
+
+    void complete(int slot, uint32_t nowMs)
+    {
+        if (slot >= 0 && events[slot].recovery_ms == 0)
+        {
+            events[slot].recovery_ms = (nowMs - events[slot].t_ms) | 1; // Never 0 once complete
+        }
+    }
+
+    uint32_t ageMs(int id, uint32_t nowMs) const { return nowMs - tasks[id].lastBeatMs.load(std::memory_order_relaxed); }
+    bool isActive(int id) const { return tasks[id].active.load(std::memory_order_acquire); }
+    bool isOverdue(int id) const { return tasks[id].overdue; }
+    const char *name(int id) const { return tasks[id].name; }
+    uint32_t deadline(int id) const { return tasks[id].deadlineMs; }
+    uint32_t misses(int id) const { return tasks[id].misses; }
+    uint32_t restarts(int id) const { return tasks[id].restarts; }
+    uint32_t worstLateMs(int id) const { return tasks[id].worstLateMs; }
+
+    // Events oldest first, i < eventsLogged()
+    uint32_t eventsLogged() const { return eventCount < SUPERVISOR_LOG_SIZE ? eventCount : SUPERVISOR_LOG_SIZE; }
+    const RecoveryEvent_t &event(uint32_t i) const
+    {
+        uint32_t first = eventCount < SUPERVISOR_LOG_SIZE ? 0 : eventCount - SUPERVISOR_LOG_SIZE;
+        return events[(first + i) % SUPERVISOR_LOG_SIZE];
+    }
+    uint32_t totalEvents() const { return eventCount; }
+
+private:
+    struct Task
+    {
+        const char *name = nullptr;
+        uint32_t deadlineMs = 0;
+        std::atomic<uint32_t> lastBeatMs{0};
+        std::atomic<bool> active{false};
+        bool overdue = false;
+        uint32_t misses = 0;
+        uint32_t restarts = 0;
+        uint32_t worstLateMs = 0;
+        int pendingEvent = -1;
+    };
+
+    Task tasks[N];
+    RecoveryEvent_t events[SUPERVISOR_LOG_SIZE] = {};
+    uint32_t eventCount = 0;
+};
+
+// Sockets a task is blocked on, so the supervisor can unblock it. The owning task
+// adds and removes its fds; the supervisor only reads them while that task is stuck.
+#define TASK_SOCKETS_MAX 4
+
+class TaskSockets
+{
+public:
+    TaskSockets()
+    {
+        clear();
+    }
+
+    // False when all slots are taken, the socket is then not recoverable
+    bool add(int fd)
+    {
+        for (int i = 0; i < TASK_SOCKETS_MAX; i++)
+        {
+            int free = -1;
+            if (fds[i].compare_exchange_strong(free, fd, std::memory_order_release))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void remove(int fd)
+    {
+        for (int i = 0; i < TASK_SOCKETS_MAX; i++)
+        {
+            int expected = fd;
+            fds[i].compare_exchange_strong(expected, -1, std::memory_order_release);
+        }
+    }
+
+    void clear()
+    {
+        for (int i = 0; i < TASK_SOCKETS_MAX; i++)
+        {
+            fds[i].store(-1, std::memory_order_release);
+        }
+    }
+
+    // Calls action(fd) for each registered socket, returns how many
+    int forEach(void (*action)(int fd)) const
+    {
+        int count = 0;
+        for (int i = 0; i < TASK_SOCKETS_MAX; i++)
+        {
+            int fd = fds[i].load(std::memory_order_acquire);
+            if (fd >= 0)
+            {
+                action(fd);
+                count++;
+            }
+        }
+        return count;
+    }
+
+private:
+    std::atomic<int> fds[TASK_SOCKETS_MAX];
+};
+
+// Escalation for a task past its deadline, one step per supervisor check:
+// ask the task to reset itself; if it does not within askGraceMs, shut down its
+// sockets so a call blocked on them returns and the task can see the request;
+// if it is still stuck socketGraceMs later, delete and recreate it.
+enum RecoveryAction
+{
+    RECOVERY_NONE,
+    RECOVERY_ASK,              // Set the request and wake the task
+    RECOVERY_SHUTDOWN_SOCKETS, // Unblock its socket calls
+    RECOVERY_RECREATE          // Delete the task and create it again
+};
+
+class TaskRecovery
+{
+public:
+    void begin(uint32_t askGraceMs, uint32_t socketGraceMs)
+    {
+        askGrace = askGraceMs;
+        socketGrace = socketGraceMs;
+        stage = STAGE_IDLE;
+        pending.store(false, std::memory_order_relaxed);
+    }
+
+    // Supervisor side: overdue as reported by Supervisor::isOverdue()
+    RecoveryAction step(bool overdue, uint32_t nowMs)
+    {
+        if (stage != STAGE_IDLE && !pending.load(std::memory_order_acquire))
+        {
+            stage = STAGE_IDLE; // The task acknowledged
+            return RECOVERY_NONE;
+        }
+        if (stage == STAGE_IDLE)
+        {
+            if (!overdue)
+            {
+                return RECOVERY_NONE;
+            }
+            stage = STAGE_ASKED;
+            stageMs = nowMs;
+            pending.store(true, std::memory_order_release);
+            return RECOVERY_ASK;
+        }
+        if (stage == STAGE_ASKED && nowMs - stageMs > askGrace)
+        {
+            stage = STAGE_SOCKETS_SHUT;
+            stageMs = nowMs;
+            return RECOVERY_SHUTDOWN_SOCKETS;
+        }
+        if (stage == STAGE_SOCKETS_SHUT && nowMs - stageMs > socketGrace)
+        {
+            stage = STAGE_IDLE;
+            pending.store(false, std::memory_order_release); // The new task starts clean
+            return RECOVERY_RECREATE;
+        }
+        return RECOVERY_NONE;
+    }
+
+    // Task side: poll, reset the task's own state, then acknowledge
+    bool requested() const { return pending.load(std::memory_order_acquire); }
+    void acknowledge() { pending.store(false, std::memory_order_release); }
+
+    // Supervisor side, when RECREATE cannot be done yet: offered again socketGraceMs later
+    void postpone(uint32_t nowMs)
+    {
+        stage = STAGE_SOCKETS_SHUT;
+        stageMs = nowMs;
+        pending.store(true, std::memory_order_release);
+    }
+
+private:
+    enum Stage
+    {
+        STAGE_IDLE,
+        STAGE_ASKED,
+        STAGE_SOCKETS_SHUT
+    };
+
+    uint32_t askGrace = 0;
+    uint32_t socketGrace = 0;
+    Stage stage = STAGE_IDLE;
+    uint32_t stageMs = 0;
+    std::atomic<bool> pending{false};
+};
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Binary telemetry frame broadcast over UDP once per sample.
+// Layout is fixed, packed and little-endian (native on ESP32 and x86 hosts),
+// so a lab PC can read it straight into the same struct.
+#define TELEMETRY_MAGIC 0x4354 // "TC"
+#define TELEMETRY_VERSION 2
+#define TELEMETRY_PORT 5005 // Default UDP port for subscribers
+
+// flags bits
+#define TELEMETRY_FLAG_MOSFET 0x01
+
+typedef struct __attribute__((packed))
+{
+    uint16_t magic;    // TELEMETRY_MAGIC
+    uint8_t version;   // TELEMETRY_VERSION
+    uint8_t flags;     // TELEMETRY_FLAG_*
+    uint32_t sequence; // Incremented per frame, gaps mean lost frames
+    uint32_t timestamp_ms;
+    float temp1; // K
+    float temp2; // K
+    float dT;    // K
+    float busVoltage;
+    float current_mA;
+    float power_mW;
+    float thermalConductivity; // W/m·K
+    float thermalConductivityUnc; // Standard uncertainty u(k), W/m·K
+    uint16_t dacValue;
+    uint16_t reserved;
+    uint32_t crc; // CRC-32 (IEEE) over all preceding bytes
+} TelemetryFrame_t;
+
+static_assert(sizeof(TelemetryFrame_t) == 52, "TelemetryFrame_t layout changed - bump TELEMETRY_VERSION");
+
+// CRC-32 (IEEE 802.3, reflected), nibble table keeps it small and fast
+inline uint32_t telemetryCrc32(const uint8_t *data, size_t length)
+{
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+        crc = (crc >> 4) ^ table[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+inline void telemetrySeal(TelemetryFrame_t &frame)
+{
+    frame.crc = telemetryCrc32((const uint8_t *)&frame, offsetof(TelemetryFrame_t, crc));
+}
+
+inline bool telemetryValid(const TelemetryFrame_t &frame)
+{
+    return frame.magic == TELEMETRY_MAGIC &&
+           frame.version == TELEMETRY_VERSION &&
+           frame.crc == telemetryCrc32((const uint8_t *)&frame, offsetof(TelemetryFrame_t, crc));
+}
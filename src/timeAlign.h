@@ -0,0 +1,221 @@
+#pragma once
+
+#include <stdint.h>
+#include <fixedPoint.h>
+
+// Resampling of channels that are converted one after the other onto a common time.
+// Each channel keeps its last History readings with their conversion times; its slope
+// is the least-squares line through them, and the newest reading is moved to the
+// common time along that slope:
+//   T(tc) = T(tn) + slope·(tc − tn)
+// On a ramp this removes the fake ΔT = slope·(t2 − t1) of sequential conversions to
+// first order. Timestamps are micros(), only differences are used (wrap-safe).
+#define TIME_ALIGN_MAX_SHIFT_US 500000 // Readings further than this from tc are not moved
+
+template <int Channels, int History>
+class TimeAligner
+{
+    static_assert(History >= 2, "A slope needs two readings");
+
+public:
+    TimeAligner() { reset(); }
+
+    void reset()
+    {
+        for (int c = 0; c < Channels; c++)
+        {
+            counts[c] = 0;
+            heads[c] = History - 1; // The first push lands in slot 0, the fit reads slots 0 .. count − 1
+            slopes[c] = 0;
+        }
+    }
+
+    void push(int c, uint32_t tUs, float value)
+    {
+        heads[c] = (heads[c] + 1) % History;
+        times[c][heads[c]] = tUs;
+        values[c][heads[c]] = value;
+        if (counts[c] < History)
+        {
+            counts[c]++;
+        }
+        slopes[c] = fitSlope(c);
+    }
+
+    // Change of channel c from its newest reading to tUs (add it to the reading)
+    float shift(int c, uint32_t tUs) const
+    {
+        int32_t dtUs = (int32_t)(tUs - times[c][heads[c]]);
+        if (counts[c] < 2 || dtUs > TIME_ALIGN_MAX_SHIFT_US || dtUs < -TIME_ALIGN_MAX_SHIFT_US)
+        {
+            return 0;
+        }
+        return slopes[c] * dtUs * 1e-6f;
+    }
+
+    float slope(int c) const { return slopes[c]; } // Units per second
+    int count(int c) const { return counts[c]; }
+
+private:
+    // Least squares over the stored readings, times relative to the newest in seconds
+    float fitSlope(int c) const
+    {
+        if (counts[c] < 2)
+        {
+            return 0;
+        }
+        uint32_t newest = times[c][heads[c]];
+        float sumT = 0, sumV = 0;
+        for (int i = 0; i < counts[c]; i++)
+        {
+            sumT += (int32_t)(times[c][i] - newest) * 1e-6f;
+            sumV += values[c][i];
+        }
+        float meanT = sumT / counts[c];
+        float meanV = sumV / counts[c];
+        float stt = 0, stv = 0;
+        for (int i = 0; i < counts[c]; i++)
+        {
+            float t = (int32_t)(times[c][i] - newest) * 1e-6f - meanT;
+            stt += t * t;
+            stv += t * (values[c][i] - meanV);
+        }
+        return stt > 0 ? stv / stt : 0;
+    }
+
+    uint32_t times[Channels][History];
+    float values[Channels][History];
+    float slopes[Channels] = {};
+    int counts[Channels] = {};
+    int heads[Channels] = {};
+};
+
+// TimeAligner for FIXED_POINT_MODE: Q16 readings, slope in Q16 units per second, integer
+// only. Times are scaled to at most 2^TIME_ALIGN_Q_TIME_BITS steps over the window and
+// differences to the newest reading are capped at ±256, which keeps the least-squares
+// sums in 64 bits; the scaling costs about 0.1 % of the slope.
+#define TIME_ALIGN_Q_TIME_BITS 10
+#define TIME_ALIGN_Q_MAX_DIFF ((int64_t)1 << 24) // 256 in Q16
+
+template <int Channels, int History>
+class TimeAlignerQ
+{
+    static_assert(History >= 2, "A slope needs two readings");
+    static_assert(History <= 8, "The sums are sized for at most 8 readings");
+
+public:
+    TimeAlignerQ() { reset(); }
+
+    void reset()
+    {
+        for (int c = 0; c < Channels; c++)
+        {
+            counts[c] = 0;
+            heads[c] = History - 1; // The first push lands in slot 0, the fit reads slots 0 .. count − 1
+            slopes[c] = Q16::fromRaw(0);
+        }
+    }
+
+    void push(int c, uint32_t tUs, Q16 value)
+    {
+        heads[c] = (heads[c] + 1) % History;
+        times[c][heads[c]] = tUs;
+        values[c][heads[c]] = value;
+        if (counts[c] < History)
+        {
+            counts[c]++;
+        }
+        slopes[c] = fitSlope(c);
+    }
+
+    // Change of channel c from its newest reading to tUs (add it to the reading)
+    Q16 shift(int c, uint32_t tUs) const
+    {
+        int32_t dtUs = (int32_t)(tUs - times[c][heads[c]]);
+        if (counts[c] < 2 || dtUs > TIME_ALIGN_MAX_SHIFT_US || dtUs < -TIME_ALIGN_MAX_SHIFT_US)
+        {
+            return Q16::fromRaw(0);
+        }
+        return Q16::fromRaw((int32_t)((int64_t)slopes[c].raw * dtUs / 1000000));
+    }
+
+    Q16 slope(int c) const { return slopes[c]; } // Units per second
+    int count(int c) const { return counts[c]; }
+
+private:
+    Q16 fitSlope(int c) const
+    {
+        if (counts[c] < 2)
+        {
+            return Q16::fromRaw(0);
+        }
+        uint32_t newest = times[c][heads[c]];
+        uint32_t span = 0;
+        for (int i = 0; i < counts[c]; i++)
+        {
+            uint32_t age = newest - times[c][i];
+            span = age > span ? age : span;
+        }
+        int timeShift = 0;
+        while ((span >> timeShift) >= (1u << TIME_ALIGN_Q_TIME_BITS))
+        {
+            timeShift++;
+        }
+
+        // Times in steps of 2^timeShift µs and values relative to the newest reading
+        int64_t n = counts[c], sumT = 0, sumV = 0, sumTT = 0, sumTV = 0;
+        for (int i = 0; i < counts[c]; i++)
+        {
+            int64_t t = -(int64_t)((newest - times[c][i]) >> timeShift);
+            int64_t v = (int64_t)values[c][i].raw - values[c][heads[c]].raw;
+            v = v > TIME_ALIGN_Q_MAX_DIFF ? TIME_ALIGN_Q_MAX_DIFF : v < -TIME_ALIGN_Q_MAX_DIFF ? -TIME_ALIGN_Q_MAX_DIFF : v;
+            sumT += t;
+            sumV += v;
+            sumTT += t * t;
+            sumTV += t * v;
+        }
+        int64_t stt = n * sumTT - sumT * sumT;
+        int64_t stv = n * sumTV - sumT * sumV;
+        if (stt <= 0)
+        {
+            return Q16::fromRaw(0);
+        }
+        // stv / stt per step, a step is 2^timeShift µs: per second ×10^6 = ×15625·2^6
+        int64_t num = stv * 15625;
+        int64_t slope = timeShift >= 6 ? num / (stt << (timeShift - 6)) : (num << (6 - timeShift)) / stt;
+        return Q16::fromRaw(slope > INT32_MAX ? INT32_MAX : slope < -INT32_MAX ? -INT32_MAX : (int32_t)slope);
+    }
+
+    uint32_t times[Channels][History];
+    Q16 values[Channels][History];
+    Q16 slopes[Channels] = {};
+    int counts[Channels] = {};
+    int heads[Channels] = {};
+};
+
+// Index of the median of a small window, which is left untouched (ties go to the lowest index)
+template <typename T>
+int medianIndex(const T values[], int size)
+{
+    for (int i = 0; i < size; i++)
+    {
+        int below = 0, equal = 0;
+        for (int j = 0; j < size; j++)
+        {
+            if (values[j] < values[i])
+            {
+                below++;
+            }
+            else if (!(values[i] < values[j]))
+            {
+                equal++;
+            }
+        }
+        // Sorted, values[i] and its ties fill ranks below .. below + equal − 1
+        if (below <= size / 2 && size / 2 < below + equal)
+        {
+            return i;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <math.h>
+#include <atomic>
+
+// Flight recorder of begin/end events, exported in Chrome trace format (chrome://tracing,
+// ui.perfetto.dev). A write is one atomic increment and a 20-byte copy, so tracing can
+// stay on: the ring overwrites its oldest events and never blocks.
+//
+// Each event carries two clocks. The cycle counter of the writing core gives the
+// resolution, but it wraps every few seconds and the cores' counters are not in sync.
+// A coarse tick shared by all cores (the FreeRTOS tick) resolves the wraps and places
+// every core on one time origin when the ring is exported.
+#define TRACE_PHASE_BEGIN 'B'
+#define TRACE_PHASE_END 'E'
+#define TRACE_PHASE_INSTANT 'i'
+
+typedef struct
+{
+    uint32_t cycles;  // Cycle counter of the writing core
+    uint32_t tick;    // Shared coarse clock
+    const char *name; // Must be a literal, only the pointer is stored
+    uintptr_t thread; // Writer's thread id (task handle)
+    char phase;       // TRACE_PHASE_*
+    uint8_t core;
+} TraceEvent_t;
+
+// Multi-producer ring that keeps the newest N events. Every slot has a sequence word
+// (odd while being written), so the exporter skips a slot that is torn or overwritten.
+template <uint16_t N>
+class TraceRing
+{
+    static_assert((N & (N - 1)) == 0, "Ring size must be a power of two");
+
+public:
+    TraceRing()
+    {
+        for (uint16_t i = 0; i < N; i++)
+        {
+            seq[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void write(const TraceEvent_t &event)
+    {
+        uint32_t h = head.fetch_add(1, std::memory_order_relaxed);
+        std::atomic<uint32_t> &s = seq[h & (N - 1)];
+        s.store(2 * h + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slots[h & (N - 1)] = event;
+        s.store(2 * h + 2, std::memory_order_release);
+    }
+
+    // Event number index (0 = first ever written), false when not (or no longer) readable
+    bool read(uint32_t index, TraceEvent_t &out) const
+    {
+        const std::atomic<uint32_t> &s = seq[index & (N - 1)];
+        uint32_t before = s.load(std::memory_order_acquire);
+        if (before != 2 * index + 2)
+        {
+            return false;
+        }
+        out = slots[index & (N - 1)];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return s.load(std::memory_order_relaxed) == before;
+    }
+
+    uint32_t written() const { return head.load(std::memory_order_relaxed); }
+    uint32_t oldest() const { return written() > N ? written() - N : 0; }
+    uint16_t capacity() const { return N; }
+
+private:
+    TraceEvent_t slots[N];
+    std::atomic<uint32_t> seq[N];
+    std::atomic<uint32_t> head{0};
+};
+
+// Microsecond timeline of one core's events. add() every event once to fix the origin,
+// then timeUs() places each on the shared clock, within one cycle of each other and
+// within a fraction of a tick across cores (the more events, the tighter).
+class TraceTimeline
+{
+public:
+    TraceTimeline(uint32_t cyclesPerUs, uint32_t usPerTick) : cyclesPerUs(cyclesPerUs), usPerTick(usPerTick) {}
+
+    void add(const TraceEvent_t &event)
+    {
+        if (!anchored)
+        {
+            anchored = true;
+            cycles0 = event.cycles;
+            tick0 = event.tick;
+            offsetUs = 0;
+        }
+        // The event happened no earlier than the start of its tick
+        double floorUs = (double)(int32_t)(event.tick - tick0) * usPerTick - relativeUs(event);
+        if (floorUs > offsetUs)
+        {
+            offsetUs = floorUs;
+        }
+    }
+
+    // On the tick clock, in µs
+    double timeUs(const TraceEvent_t &event) const
+    {
+        return (double)tick0 * usPerTick + offsetUs + relativeUs(event);
+    }
+
+private:
+    // µs since the anchor event; the wrap count is whatever agrees with the tick
+    double relativeUs(const TraceEvent_t &event) const
+    {
+        double predicted = (double)(int32_t)(event.tick - tick0) * usPerTick * cyclesPerUs;
+        double delta = (uint32_t)(event.cycles - cycles0);
+        double wraps = floor((predicted - delta) / 4294967296.0 + 0.5);
+        return (delta + wraps * 4294967296.0) / cyclesPerUs;
+    }
+
+    uint32_t cyclesPerUs;
+    uint32_t usPerTick;
+    bool anchored = false;
+    uint32_t cycles0 = 0;
+    uint32_t tick0 = 0;
+    double offsetUs = 0;
+};
+
+// One Chrome trace event object, pid = core and tid = thread
+inline int traceFormatEvent(char *out, size_t size, const TraceEvent_t &event, double tsUs)
+{
+    return snprintf(out, size, "{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%u,\"tid\":%lu%s}",
+                    event.name, event.phase, tsUs, (unsigned)event.core, (unsigned long)event.thread,
+                    event.phase == TRACE_PHASE_INSTANT ? ",\"s\":\"t\"" : "");
+}
+
+// One ring per core, written by the tasks (not ISRs) of that core
+template <uint16_t N, int Cores>
+class TraceBuffer
+{
+public:
+    void write(uint8_t core, uintptr_t thread, uint32_t cycles, uint32_t tick, const char *name, char phase)
+    {
+        TraceEvent_t event;
+        event.cycles = cycles;
+        event.tick = tick;
+        event.name = name;
+        event.thread = thread;
+        event.phase = phase;
+        event.core = core;
+        rings[core].write(event);
+    }
+
+    const TraceRing<N> &ring(int core) const { return rings[core]; }
+
+    // Formats every readable event through emit(text, length, first), returns how many
+    template <typename Emit>
+    uint32_t exportJson(uint32_t cyclesPerUs, uint32_t usPerTick, Emit emit) const
+    {
+        uint32_t count = 0;
+        char line[160];
+        for (int c = 0; c < Cores; c++)
+        {
+            // Pass 1 fixes the origin, pass 2 prints; events overwritten in between are skipped
+            TraceTimeline timeline(cyclesPerUs, usPerTick);
+            uint32_t end = rings[c].written();
+            TraceEvent_t event;
+            for (uint32_t i = rings[c].oldest(); (int32_t)(end - i) > 0; i++)
+            {
+                if (rings[c].read(i, event))
+                {
+                    timeline.add(event);
+                }
+            }
+            for (uint32_t i = rings[c].oldest(); (int32_t)(end - i) > 0; i++)
+            {
+                if (rings[c].read(i, event))
+                {
+                    int n = traceFormatEvent(line, sizeof(line), event, timeline.timeUs(event));
+                    if (n > 0 && (size_t)n < sizeof(line))
+                    {
+                        emit(line, (size_t)n, count++ == 0);
+                    }
+                }
+            }
+        }
+        return count;
+    }
+
+private:
+    TraceRing<N> rings[Cores];
+};
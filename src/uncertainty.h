@@ -0,0 +1,96 @@
+#pragma once
+
+#include <math.h>
+
+// Rolling mean, variance and covariance of two signals (Welford with removal),
+// O(1) per sample over the last UNCERTAINTY_WINDOW samples.
+#define UNCERTAINTY_WINDOW 30
+
+class RollingCovariance
+{
+public:
+    void reset()
+    {
+        n = 0;
+        head = 0;
+        meanX = meanY = 0;
+        m2x = m2y = cxy = 0;
+    }
+
+    void push(float x, float y)
+    {
+        if (n == UNCERTAINTY_WINDOW)
+        {
+            remove(bufX[head], bufY[head]);
+        }
+        bufX[head] = x;
+        bufY[head] = y;
+        head = (head + 1) % UNCERTAINTY_WINDOW;
+
+        n++;
+        double dx = x - meanX;
+        double dy = y - meanY;
+        meanX += dx / n;
+        meanY += dy / n;
+        m2x += dx * (x - meanX);
+        m2y += dy * (y - meanY);
+        cxy += dx * (y - meanY);
+    }
+
+    int count() const { return n; }
+    double meanOfX() const { return meanX; }
+    double meanOfY() const { return meanY; }
+    // Sample (n-1) statistics, i.e. the dispersion of a single reading
+    double varX() const { return n > 1 ? m2x / (n - 1) : 0; }
+    double varY() const { return n > 1 ? m2y / (n - 1) : 0; }
+    double covXY() const { return n > 1 ? cxy / (n - 1) : 0; }
+
+private:
+    void remove(float x, float y)
+    {
+        if (n <= 1)
+        {
+            n = 0;
+            meanX = meanY = 0;
+            m2x = m2y = cxy = 0;
+            return;
+        }
+        double oldMeanY = meanY;
+        n--;
+        double dx = x - meanX;
+        double dy = y - meanY;
+        meanX -= dx / n;
+        meanY -= dy / n;
+        m2x -= dx * (x - meanX);
+        m2y -= dy * (y - meanY);
+        cxy -= (x - meanX) * (y - oldMeanY);
+    }
+
+    float bufX[UNCERTAINTY_WINDOW];
+    float bufY[UNCERTAINTY_WINDOW];
+    int head = 0;
+    int n = 0;
+    double meanX = 0, meanY = 0;
+    double m2x = 0, m2y = 0, cxy = 0;
+};
+
+// GUM propagation for k = 4·P·L / (π·d²·ΔT) with correlated P and ΔT:
+//   (u_k/k)² = (u_P/P)² + (u_L/L)² + (2·u_d/d)² + (u_ΔT/ΔT)² − 2·cov(P,ΔT)/(P·ΔT)
+// P and ΔT variances come from the rolling stats, L and d from the caliper resolution.
+inline float conductivityUncertainty(float k, float power, float dT, float thickness, float diameter,
+                                     const RollingCovariance &stats, float uThickness, float uDiameter)
+{
+    if (k == 0 || power == 0 || dT == 0 || thickness <= 0 || diameter <= 0)
+    {
+        return 0;
+    }
+
+    double relP = stats.varX() / ((double)power * power);
+    double relT = stats.varY() / ((double)dT * dT);
+    double relCov = 2 * stats.covXY() / ((double)power * dT);
+    double relL = (double)uThickness / thickness;
+    double relD = 2.0 * uDiameter / diameter;
+
+    double rel2 = relP + relT - relCov + relL * relL + relD * relD;
+    return rel2 > 0 ? fabsf(k) * sqrt(rel2) : 0;
+}
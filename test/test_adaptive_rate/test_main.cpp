@@ -0,0 +1,209 @@
+#include <stdint.h>
+#include <math.h>
+#include <unity.h>
+#include <adaptiveRate.h>
+
+// The firmware's settings (main.cpp)
+#define MIN_MS 500
+#define MAX_MS 5000
+#define SLOPE_K_S 0.003f
+#define POWER_STEP_MW 2.0f
+#define BACKOFF 1.25f
+#define SMOOTHING_MS 10000
+#define DEADBAND_DT_K 0.05f
+#define DEADBAND_POWER_MW 1.0f
+#define DEADBAND_K_REL 0.01f
+#define LOG_MIN_MS 5000
+#define LOG_MAX_MS 300000
+
+static uint32_t lcgState = 1;
+
+// RTD noise, uniform in ±amplitude, reproducible
+static float noise(float amplitude)
+{
+    lcgState = lcgState * 1664525u + 1013904223u;
+    return amplitude * ((lcgState >> 8) / 8388608.0f - 1);
+}
+
+static AdaptiveRate rate;
+
+void setUp(void)
+{
+    lcgState = 1;
+    rate.begin(MIN_MS, MAX_MS, SLOPE_K_S, POWER_STEP_MW, BACKOFF, SMOOTHING_MS);
+}
+
+void tearDown(void) {}
+
+// Quiet samples stretch the interval by the backoff factor up to the maximum
+static void test_backoff_sequence(void)
+{
+    const uint32_t expected[] = {500, 625, 781, 976, 1220, 1525, 1906, 2382, 2977, 3721, 4651, 5000, 5000};
+    uint32_t t = 0;
+    TEST_ASSERT_EQUAL_UINT32(500, rate.update(t, 1.0f, 50));
+    for (int i = 1; i < 13; i++)
+    {
+        t += rate.interval();
+        TEST_ASSERT_EQUAL_UINT32(expected[i], rate.update(t, 1.0f, 50));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, rate.transients());
+}
+
+// RTD noise alone never holds the fast rate once the filter has settled
+static void test_noise_only_settles_at_max(void)
+{
+    uint32_t t = 0;
+    int atMax = 0, samples = 0;
+    while (t < 3600000)
+    {
+        uint32_t interval = rate.update(t, 1.0f + noise(0.002f), 50 + noise(0.2f));
+        if (t > 120000)
+        {
+            samples++;
+            atMax += interval == MAX_MS;
+        }
+        t += interval;
+    }
+    TEST_ASSERT_EQUAL_INT(samples, atMax);
+    TEST_ASSERT_FLOAT_WITHIN(SLOPE_K_S, 0, rate.slope());
+}
+
+// Runs the loop to t = untilMs on signal(t), returns the last interval
+template <typename Signal>
+static uint32_t runUntil(uint32_t &t, uint32_t untilMs, Signal signal, uint32_t *minSeen = nullptr)
+{
+    uint32_t interval = rate.interval();
+    while (t < untilMs)
+    {
+        float dT, power;
+        signal(t, dT, power);
+        interval = rate.update(t, dT, power);
+        if (minSeen && interval < *minSeen)
+        {
+            *minSeen = interval;
+        }
+        t += interval;
+    }
+    return interval;
+}
+
+// A heater step drops to the minimum at the first sample that sees it; the thermal
+// response holds it there, then the rate backs off to the maximum again
+static void test_power_step(void)
+{
+    uint32_t t = 0;
+    const uint32_t stepMs = 600000;
+    auto signal = [&](uint32_t now, float &dT, float &power) {
+        float since = now >= stepMs ? (now - stepMs) / 1000.0f : -1;
+        power = since >= 0 ? 60 : 50;
+        dT = 1.0f + (since >= 0 ? 0.5f * (1 - expf(-since / 60.0f)) : 0) + noise(0.002f);
+    };
+    TEST_ASSERT_EQUAL_UINT32(MAX_MS, runUntil(t, stepMs, signal));
+
+    float dT, power;
+    signal(t, dT, power);
+    TEST_ASSERT_EQUAL_UINT32(MIN_MS, rate.update(t, dT, power));
+    TEST_ASSERT_TRUE(rate.transient());
+    TEST_ASSERT_EQUAL_UINT32(1, rate.transients());
+
+    // τ = 60 s: the slope stays above 3 mK/s for ~3 minutes
+    t += MIN_MS;
+    TEST_ASSERT_EQUAL_UINT32(MIN_MS, runUntil(t, stepMs + 60000, signal));
+    TEST_ASSERT_EQUAL_UINT32(MAX_MS, runUntil(t, stepMs + 900000, signal));
+    TEST_ASSERT_FALSE(rate.transient());
+}
+
+// A slope without any power change (e.g. the bath drifting) is caught by the filter
+static void test_ramp_transient(void)
+{
+    uint32_t t = 0;
+    const uint32_t rampStart = 600000, rampEnd = 900000;
+    auto signal = [&](uint32_t now, float &dT, float &power) {
+        uint32_t into = now < rampStart ? 0 : now < rampEnd ? now - rampStart : rampEnd - rampStart;
+        dT = 1.0f + 0.01f * into / 1000.0f + noise(0.002f); // 10 mK/s
+        power = 50;
+    };
+    TEST_ASSERT_EQUAL_UINT32(MAX_MS, runUntil(t, rampStart, signal));
+
+    // Within three samples of the ramp start (at most 15 s)
+    uint32_t minSeen = MAX_MS;
+    runUntil(t, rampStart + 3 * MAX_MS, signal, &minSeen);
+    TEST_ASSERT_EQUAL_UINT32(MIN_MS, minSeen);
+    TEST_ASSERT_EQUAL_UINT32(MIN_MS, runUntil(t, rampEnd, signal));
+    TEST_ASSERT_TRUE(rate.slope() > 0.008f);
+
+    // Flat again: back to the maximum within a couple of minutes
+    TEST_ASSERT_EQUAL_UINT32(MAX_MS, runUntil(t, rampEnd + 120000, signal));
+    TEST_ASSERT_EQUAL_UINT32(1, rate.transients());
+}
+
+// Power drift below the step size is not a transient
+static void test_small_power_change_is_not_a_step(void)
+{
+    uint32_t t = 0;
+    auto signal = [&](uint32_t now, float &dT, float &power) {
+        dT = 1.0f;
+        power = 50 + (now / 5000) * 0.5f; // +0.5 mW per sample at 5 s
+    };
+    TEST_ASSERT_EQUAL_UINT32(MAX_MS, runUntil(t, 600000, signal));
+    TEST_ASSERT_EQUAL_UINT32(0, rate.transients());
+}
+
+static DeadbandLogger logger;
+
+static void beginLogger() { logger.begin(DEADBAND_DT_K, DEADBAND_POWER_MW, DEADBAND_K_REL, LOG_MIN_MS, LOG_MAX_MS); }
+
+// Steady run sampled every second: only the first row and the heartbeat rows
+static void test_deadband_suppresses_steady_rows(void)
+{
+    beginLogger();
+    for (uint32_t t = 0; t < 3600000; t += 1000)
+    {
+        bool log = logger.shouldLog(t, 1.0f + noise(0.01f), 50 + noise(0.3f), 0.3f * (1 + noise(0.005f)));
+        TEST_ASSERT_EQUAL_INT(t % LOG_MAX_MS == 0, log);
+    }
+    TEST_ASSERT_EQUAL_UINT32(12, logger.logged());
+    TEST_ASSERT_EQUAL_UINT32(3600 - 12, logger.suppressed());
+}
+
+// Leaving the band logs, but no sooner than the minimum interval after the last row
+static void test_deadband_logs_moves_after_min_interval(void)
+{
+    beginLogger();
+    TEST_ASSERT_TRUE(logger.shouldLog(0, 1.0f, 50, 0.3f));
+    TEST_ASSERT_FALSE(logger.shouldLog(1000, 1.2f, 50, 0.3f)); // Moved, too soon
+    TEST_ASSERT_FALSE(logger.shouldLog(4999, 1.2f, 50, 0.3f));
+    TEST_ASSERT_TRUE(logger.shouldLog(5000, 1.2f, 50, 0.3f));
+    TEST_ASSERT_FALSE(logger.shouldLog(20000, 1.24f, 50, 0.3f)); // Within the band of the new row
+
+    TEST_ASSERT_TRUE(logger.shouldLog(30000, 1.2f, 51.5f, 0.3f)); // Power
+    TEST_ASSERT_FALSE(logger.shouldLog(40000, 1.2f, 51.5f, 0.302f)); // k +0.7 %
+    TEST_ASSERT_TRUE(logger.shouldLog(50000, 1.2f, 51.5f, 0.304f));  // k +1.3 %
+    TEST_ASSERT_EQUAL_UINT32(4, logger.logged());
+}
+
+// The heartbeat row comes every maxMs even while nothing moves, across the clock wrap
+static void test_deadband_heartbeat_across_wrap(void)
+{
+    beginLogger();
+    uint32_t t = 0xFFFFFFFFu - 100000;
+    TEST_ASSERT_TRUE(logger.shouldLog(t, 1.0f, 50, 0.3f));
+    TEST_ASSERT_FALSE(logger.shouldLog(t + LOG_MAX_MS - 1, 1.0f, 50, 0.3f));
+    TEST_ASSERT_TRUE(logger.shouldLog(t + LOG_MAX_MS, 1.0f, 50, 0.3f));
+    TEST_ASSERT_EQUAL_UINT32(2, logger.logged());
+    TEST_ASSERT_EQUAL_UINT32(1, logger.suppressed());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_backoff_sequence);
+    RUN_TEST(test_noise_only_settles_at_max);
+    RUN_TEST(test_power_step);
+    RUN_TEST(test_ramp_transient);
+    RUN_TEST(test_small_power_change_is_not_a_step);
+    RUN_TEST(test_deadband_suppresses_steady_rows);
+    RUN_TEST(test_deadband_logs_moves_after_min_interval);
+    RUN_TEST(test_deadband_heartbeat_across_wrap);
+    return UNITY_END();
+}
@@ -0,0 +1,128 @@
+#include <stdint.h>
+#include <math.h>
+#include <vector>
+#include <unity.h>
+#include <allanVariance.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#define OCTAVES 12
+
+static uint32_t seed;
+
+static float gaussian()
+{
+    // Box-Muller over the LCG
+    seed = seed * 1664525 + 1013904223;
+    double u1 = ((seed >> 8) + 1) / 16777217.0;
+    seed = seed * 1664525 + 1013904223;
+    double u2 = (seed >> 8) / 16777216.0;
+    return (float)(sqrt(-2 * log(u1)) * cos(2 * M_PI * u2));
+}
+
+// Fully overlapping Allan variance straight from the definition
+static double bruteForce(const std::vector<float> &y, int m)
+{
+    std::vector<double> s(y.size() + 1, 0);
+    for (size_t i = 0; i < y.size(); i++)
+    {
+        s[i + 1] = s[i] + (y[i] - y[0]);
+    }
+    double acc = 0;
+    size_t terms = 0;
+    for (size_t n = 2 * m; n < s.size(); n++)
+    {
+        double d = (s[n] - 2 * s[n - m] + s[n - 2 * m]) / m;
+        acc += d * d;
+        terms++;
+    }
+    return acc / (2.0 * terms);
+}
+
+void test_low_octaves_match_definition(void)
+{
+    seed = 1;
+    static AllanVariance<2, OCTAVES> allan;
+    allan.reset();
+    std::vector<float> y0, y1;
+    for (int i = 0; i < 5000; i++)
+    {
+        float sample[2] = {80.0f + 0.01f * gaussian(), 0.002f * i + 0.01f * gaussian()};
+        allan.push(sample);
+        y0.push_back(sample[0]);
+        y1.push_back(sample[1]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(5000, allan.count());
+    for (int k = 0; k <= ALLAN_OVERLAP_LOG2; k++)
+    {
+        double expected0 = bruteForce(y0, 1 << k), expected1 = bruteForce(y1, 1 << k);
+        TEST_ASSERT_DOUBLE_WITHIN(1e-6 * expected0, expected0, allan.avar(0, k));
+        TEST_ASSERT_DOUBLE_WITHIN(1e-6 * expected1, expected1, allan.avar(1, k));
+        TEST_ASSERT_EQUAL_UINT32(5000 + 1 - 2 * (1 << k), allan.termCount(k)); // S[0] = 0 counts
+    }
+}
+
+void test_white_noise_falls_as_inverse_sqrt_tau(void)
+{
+    seed = 7;
+    static AllanVariance<1, OCTAVES> allan;
+    allan.reset();
+    for (int i = 0; i < 200000; i++)
+    {
+        float sample[1] = {gaussian()};
+        allan.push(sample);
+    }
+    for (int k = 0; k < 9; k++)
+    {
+        double expected = 1 / sqrt((double)allan.tauFactor(k));
+        TEST_ASSERT_DOUBLE_WITHIN(0.12 * expected, expected, allan.adev(0, k));
+    }
+}
+
+void test_best_octave_between_noise_and_drift(void)
+{
+    // White noise averages down, a slow ramp grows with τ: the optimum is in between
+    seed = 3;
+    static AllanVariance<1, OCTAVES> allan;
+    allan.reset();
+    TEST_ASSERT_EQUAL_INT(-1, allan.bestOctave(0));
+    for (int i = 0; i < 20000; i++)
+    {
+        float sample[1] = {0.01f * gaussian() + 2e-6f * i};
+        allan.push(sample);
+    }
+    int best = allan.bestOctave(0);
+    TEST_ASSERT_GREATER_THAN(1, best);
+    TEST_ASSERT_LESS_THAN(OCTAVES - 2, best);
+    TEST_ASSERT_TRUE(allan.adev(0, best) < allan.adev(0, 0));
+    TEST_ASSERT_TRUE(allan.adev(0, best) < allan.adev(0, OCTAVES - 2));
+}
+
+void test_constant_input_and_reset(void)
+{
+    static AllanVariance<1, OCTAVES> allan;
+    allan.reset();
+    for (int i = 0; i < 3000; i++)
+    {
+        float sample[1] = {123456.0f}; // Large offset, removed before the sums
+        allan.push(sample);
+    }
+    for (int k = 0; k < OCTAVES; k++)
+    {
+        TEST_ASSERT_DOUBLE_WITHIN(1e-12, 0, allan.avar(0, k));
+    }
+    allan.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, allan.count());
+    TEST_ASSERT_EQUAL_UINT32(0, allan.termCount(0));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_low_octaves_match_definition);
+    RUN_TEST(test_white_noise_falls_as_inverse_sqrt_tau);
+    RUN_TEST(test_best_octave_between_noise_and_drift);
+    RUN_TEST(test_constant_input_and_reset);
+    return UNITY_END();
+}
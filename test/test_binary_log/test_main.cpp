@@ -0,0 +1,282 @@
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <unity.h>
+#include <binaryLog.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Packs the arguments as BinaryLog::write() does and formats the record
+template <typename... Args>
+static size_t format(char *out, size_t size, const char *fmt, Args... args)
+{
+    static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "Too many log arguments");
+    LogRecord_t record = {};
+    record.format = fmt;
+    logPack(record, args...);
+    return logFormat(record, out, size);
+}
+
+#define EXPECT_FORMAT(expected, ...)                                  \
+    do                                                                \
+    {                                                                 \
+        char line[128];                                               \
+        size_t n = format(line, sizeof(line), __VA_ARGS__);           \
+        TEST_ASSERT_EQUAL_STRING(expected, line);                     \
+        TEST_ASSERT_EQUAL_INT((int)strlen(expected), (int)n);         \
+    } while (0)
+
+void test_plain_text_and_percent(void)
+{
+    EXPECT_FORMAT("no arguments", "no arguments");
+    EXPECT_FORMAT("100%", "100%%");
+    EXPECT_FORMAT("50% of 8", "%d%% of %u", 50, 8u);
+    EXPECT_FORMAT("%%", "%%%%");
+}
+
+void test_integer_conversions(void)
+{
+    EXPECT_FORMAT("-42 42 ff 00FF", "%d %i %x %04X", -42, 42, 255, 255);
+    EXPECT_FORMAT("x", "%c", 'x');
+    EXPECT_FORMAT("4294967295", "%u", 0xFFFFFFFFu);
+    EXPECT_FORMAT("[   -7]", "[%5d]", -7);
+    EXPECT_FORMAT("[-7   ]", "[%-5d]", -7);
+}
+
+// Every argument is stored as 32 bits, so the length modifiers go
+void test_length_modifiers_stripped(void)
+{
+    EXPECT_FORMAT("123 4000000000 -5", "%lu %llu %ld", 123ul, 4000000000ul, -5l);
+    EXPECT_FORMAT("7 8 9", "%zu %hd %hhu", 7u, 8, 9u);
+    EXPECT_FORMAT("[    12]", "[%6lu]", 12ul);
+}
+
+void test_floats(void)
+{
+    EXPECT_FORMAT("3.14 -0.500 2.5e+03", "%.2f %.3f %.1e", 3.14159, -0.5, 2500.0);
+    EXPECT_FORMAT("1.5 K", "%g K", 1.5f);
+    // Integers under a float conversion keep their sign
+    EXPECT_FORMAT("-3.0 7.0", "%.1f %.1f", -3, 7u);
+}
+
+// A float under an integer conversion prints its integer part, not its bit pattern
+void test_float_as_int(void)
+{
+    EXPECT_FORMAT("21 -3 7", "%d %i %u", 21.9, -3.7, 7.2);
+    EXPECT_FORMAT("10", "%x", 16.0);
+}
+
+void test_strings(void)
+{
+    static const char name[] = "NetTask";
+    EXPECT_FORMAT("[Supervisor] NetTask stalled", "[Supervisor] %s stalled", name);
+    EXPECT_FORMAT("[   ab]", "[%5s]", "ab");
+    EXPECT_FORMAT("?", "%s", (const char *)nullptr);
+    EXPECT_FORMAT("?", "%s", 5); // Not a string: never dereferenced
+}
+
+void test_missing_arguments(void)
+{
+    EXPECT_FORMAT("a=1 b=? c=?", "a=%d b=%d c=%s", 1);
+    EXPECT_FORMAT("?", "%.2f");
+    EXPECT_FORMAT("x ", "x %"); // Unterminated conversion is dropped
+}
+
+// The returned length always matches what is in the buffer, however the text is cut
+void test_truncation(void)
+{
+    char line[8];
+    size_t n = format(line, sizeof(line), "%s", "abcdefghijkl");
+    TEST_ASSERT_EQUAL_STRING("abcdefg", line);
+    TEST_ASSERT_EQUAL_INT(7, (int)n);
+
+    n = format(line, sizeof(line), "ab%dxyz", 123456);
+    TEST_ASSERT_EQUAL_STRING("ab12345", line);
+    TEST_ASSERT_EQUAL_INT(7, (int)n);
+
+    n = format(line, sizeof(line), "abcdef%.3f", 1.5);
+    TEST_ASSERT_EQUAL_STRING("abcdef1", line);
+    TEST_ASSERT_EQUAL_INT(7, (int)n);
+
+    n = format(line, sizeof(line), "abcdefgh%%");
+    TEST_ASSERT_EQUAL_STRING("abcdefg", line);
+    TEST_ASSERT_EQUAL_INT(7, (int)n);
+
+    for (size_t size = 1; size <= 12; size++)
+    {
+        char small[12];
+        n = format(small, size, "t=%u %s", 42u, "ok");
+        TEST_ASSERT_EQUAL_INT((int)strlen(small), (int)n);
+        TEST_ASSERT_TRUE(n < size);
+        TEST_ASSERT_EQUAL_INT(0, strncmp("t=42 ok", small, n));
+    }
+}
+
+static LogRecord_t record(uint32_t tMs)
+{
+    LogRecord_t r = {};
+    r.t_ms = tMs;
+    r.format = "r%u";
+    logPack(r, (unsigned)tMs);
+    return r;
+}
+
+void test_ring_push_peek_pop(void)
+{
+    LogRing<4> ring;
+    TEST_ASSERT_TRUE(ring.peek() == nullptr);
+    TEST_ASSERT_TRUE(ring.push(record(1)));
+    TEST_ASSERT_TRUE(ring.push(record(2)));
+    TEST_ASSERT_EQUAL_UINT32(1, ring.peek()->t_ms);
+    TEST_ASSERT_EQUAL_UINT32(1, ring.peek()->t_ms); // Peek does not consume
+    ring.pop();
+    TEST_ASSERT_EQUAL_UINT32(2, ring.peek()->t_ms);
+    ring.pop();
+    TEST_ASSERT_TRUE(ring.peek() == nullptr);
+    TEST_ASSERT_EQUAL_UINT32(2, ring.written());
+    TEST_ASSERT_EQUAL_UINT32(0, ring.drops());
+}
+
+// Full ring: the new record is dropped and counted, the queued ones stay in order
+void test_ring_drops_when_full(void)
+{
+    LogRing<4> ring;
+    for (uint32_t t = 0; t < 4; t++)
+    {
+        TEST_ASSERT_TRUE(ring.push(record(t)));
+    }
+    TEST_ASSERT_FALSE(ring.push(record(99)));
+    TEST_ASSERT_FALSE(ring.push(record(100)));
+    TEST_ASSERT_EQUAL_UINT32(4, ring.written());
+    TEST_ASSERT_EQUAL_UINT32(2, ring.drops());
+
+    ring.pop();
+    TEST_ASSERT_TRUE(ring.push(record(4))); // Room again
+    for (uint32_t t = 1; t <= 4; t++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(t, ring.peek()->t_ms);
+        ring.pop();
+    }
+    TEST_ASSERT_TRUE(ring.peek() == nullptr);
+    TEST_ASSERT_EQUAL_UINT32(2, ring.drops());
+}
+
+// Many laps: the slot sequence numbers keep publishing and consuming apart
+void test_ring_wraps(void)
+{
+    LogRing<8> ring;
+    uint32_t next = 0;
+    for (uint32_t t = 0; t < 10000; t++)
+    {
+        TEST_ASSERT_TRUE(ring.push(record(t)));
+        if (t % 3 != 0 || t == 9999)
+        {
+            while (ring.peek())
+            {
+                TEST_ASSERT_EQUAL_UINT32(next++, ring.peek()->t_ms);
+                ring.pop();
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(10000, next);
+    TEST_ASSERT_EQUAL_UINT32(0, ring.drops());
+}
+
+// Producers racing for slots while the drain runs: every record is either delivered
+// intact, in order per producer, or counted as a drop
+#define PRODUCERS 4
+#define RECORDS_PER_PRODUCER 20000
+void test_ring_concurrent_producers(void)
+{
+    static LogRing<64> ring;
+    std::atomic<int> running{PRODUCERS};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < PRODUCERS; p++)
+    {
+        producers.emplace_back([&, p] {
+            for (uint32_t i = 0; i < RECORDS_PER_PRODUCER; i++)
+            {
+                LogRecord_t r = {};
+                r.t_ms = i;
+                r.core = (uint8_t)p;
+                r.format = "%u %u";
+                logPack(r, (unsigned)p, (unsigned)i);
+                ring.push(r);
+            }
+            running.fetch_sub(1);
+        });
+    }
+
+    uint32_t delivered = 0;
+    int64_t last[PRODUCERS] = {-1, -1, -1, -1};
+    while (running.load() > 0 || ring.peek())
+    {
+        const LogRecord_t *r = ring.peek();
+        if (!r)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        TEST_ASSERT_TRUE(r->core < PRODUCERS);
+        TEST_ASSERT_EQUAL_UINT32(r->core, (uint32_t)r->args[0]);
+        TEST_ASSERT_EQUAL_UINT32(r->t_ms, (uint32_t)r->args[1]);
+        TEST_ASSERT_TRUE((int64_t)r->t_ms > last[r->core]);
+        last[r->core] = r->t_ms;
+        ring.pop();
+        delivered++;
+    }
+    for (std::thread &t : producers)
+    {
+        t.join();
+    }
+    TEST_ASSERT_EQUAL_UINT32(delivered, ring.written());
+    TEST_ASSERT_EQUAL_UINT32(PRODUCERS * RECORDS_PER_PRODUCER, ring.written() + ring.drops());
+}
+
+// BinaryLog merges the cores by timestamp, across a millis() wrap
+void test_binary_log_merges_cores(void)
+{
+    static BinaryLog<8, 2> log;
+    log.write(LOG_LEVEL_INFO, 0, 0xFFFFFFF0u, "a");
+    log.write(LOG_LEVEL_WARN, 1, 0xFFFFFFF8u, "b %d", 1);
+    log.write(LOG_LEVEL_INFO, 0, 0x00000004u, "c");
+    log.write(LOG_LEVEL_ERROR, 1, 0x00000002u, "d %s", "x");
+
+    const char *order[] = {"a", "b 1", "d x", "c"};
+    for (const char *expected : order)
+    {
+        int core = -1;
+        const LogRecord_t *r = log.peek(core);
+        TEST_ASSERT_NOT_NULL(r);
+        char line[16];
+        logFormat(*r, line, sizeof(line));
+        TEST_ASSERT_EQUAL_STRING(expected, line);
+        log.pop(core);
+    }
+    int core;
+    TEST_ASSERT_TRUE(log.peek(core) == nullptr);
+    TEST_ASSERT_EQUAL_UINT32(2, log.written(0));
+    TEST_ASSERT_EQUAL_UINT32(0, log.drops(1));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_plain_text_and_percent);
+    RUN_TEST(test_integer_conversions);
+    RUN_TEST(test_length_modifiers_stripped);
+    RUN_TEST(test_floats);
+    RUN_TEST(test_float_as_int);
+    RUN_TEST(test_strings);
+    RUN_TEST(test_missing_arguments);
+    RUN_TEST(test_truncation);
+    RUN_TEST(test_ring_push_peek_pop);
+    RUN_TEST(test_ring_drops_when_full);
+    RUN_TEST(test_ring_wraps);
+    RUN_TEST(test_ring_concurrent_producers);
+    RUN_TEST(test_binary_log_merges_cores);
+    return UNITY_END();
+}
@@ -0,0 +1,160 @@
+#include <stdint.h>
+#include <math.h>
+#include <complex>
+#include <unity.h>
+#include <biquadBank.h>
+
+// The capture topologies from main.cpp at the default 500 Hz
+#define FS 500.0
+#define SECTIONS 3
+
+constexpr BiquadCoefficients_t LP1 = biquadLowPass(20, FS, 0.5411961);
+constexpr BiquadCoefficients_t LP2 = biquadLowPass(20, FS, 1.3065630);
+constexpr BiquadCascade<SECTIONS> NONE = {{biquadIdentity(), biquadIdentity(), biquadIdentity()}};
+constexpr BiquadCascade<SECTIONS> NOTCH50 = {{biquadNotch(50, FS, 5), biquadNotch(100, FS, 5), biquadIdentity()}};
+constexpr BiquadCascade<SECTIONS> LOWPASS = {{LP1, LP2, biquadIdentity()}};
+constexpr BiquadCascade<SECTIONS> MAINS50 = {{biquadNotch(50, FS, 5), LP1, LP2}};
+constexpr BiquadCascade<SECTIONS> MAINS60 = {{biquadNotch(60, FS, 5), LP1, LP2}};
+
+static_assert(biquad::sin(1.0) - 0.8414709848078965 < 1e-12 && biquad::sin(1.0) - 0.8414709848078965 > -1e-12,
+              "constexpr sin");
+static_assert(biquadDcGain(MAINS50) > 0.999 && biquadDcGain(MAINS50) < 1.001, "DC gain");
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// |H| of the cascade from its (float) coefficients
+static double analyticGain(const BiquadCascade<SECTIONS> &cascade, double f)
+{
+    std::complex<double> z = std::polar(1.0, -2 * M_PI * f / FS), h = 1;
+    for (const BiquadCoefficients_t &s : cascade.sections)
+    {
+        h *= ((double)s.b0 + (double)s.b1 * z + (double)s.b2 * z * z) / (1.0 + (double)s.a1 * z + (double)s.a2 * z * z);
+    }
+    return std::abs(h);
+}
+
+// Amplitude out of one lane of a 4-channel bank for a unit sine (from the RMS over whole
+// cycles, after settling)
+static double measuredGain(const BiquadCascade<SECTIONS> &cascade, double f)
+{
+    BiquadBank<4, SECTIONS> bank;
+    for (int c = 0; c < 4; c++)
+    {
+        bank.select(c, cascade, 0);
+    }
+    double power = 0;
+    for (int n = 0; n < 5000; n++)
+    {
+        float in[4], out[4];
+        for (int c = 0; c < 4; c++)
+        {
+            in[c] = f == 0 ? 1.0f : (float)sin(2 * M_PI * f * n / FS);
+        }
+        bank.process(in, out);
+        if (n >= 2500)
+        {
+            power += (double)out[1] * out[1];
+        }
+    }
+    return sqrt(power / 2500 * (f == 0 ? 1 : 2));
+}
+
+static double dB(double gain) { return 20 * log10(fmax(gain, 1e-9)); }
+
+void test_constexpr_coefficients_match_libm(void)
+{
+    const double f0[] = {20, 50, 60, 100, 120};
+    for (double f : f0)
+    {
+        double w = 2 * M_PI * f / FS, c = cos(w), alpha = sin(w) / (2 * 5.0);
+        BiquadCoefficients_t notch = biquadNotch(f, FS, 5);
+        TEST_ASSERT_FLOAT_WITHIN(1e-6, -2 * c / (1 + alpha), notch.a1);
+        TEST_ASSERT_FLOAT_WITHIN(1e-6, (1 - alpha) / (1 + alpha), notch.a2);
+        TEST_ASSERT_FLOAT_WITHIN(1e-6, 1 / (1 + alpha), notch.b0);
+    }
+}
+
+void test_response_matches_design(void)
+{
+    const BiquadCascade<SECTIONS> *cascades[] = {&NONE, &NOTCH50, &LOWPASS, &MAINS50, &MAINS60};
+    const double freqs[] = {0, 1, 5, 20, 45, 50, 55, 60, 100, 120, 200};
+    for (const BiquadCascade<SECTIONS> *cascade : cascades)
+    {
+        for (double f : freqs)
+        {
+            double expected = dB(analyticGain(*cascade, f));
+            if (expected > -60)
+            {
+                TEST_ASSERT_DOUBLE_WITHIN(0.05, expected, dB(measuredGain(*cascade, f)));
+            }
+        }
+    }
+}
+
+void test_filter_shapes(void)
+{
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, 0, dB(measuredGain(MAINS50, 0)));
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, 0, dB(measuredGain(NONE, 50)));
+    TEST_ASSERT_DOUBLE_WITHIN(0.05, -3.01, dB(analyticGain(LOWPASS, 20))); // Butterworth corner
+    TEST_ASSERT_DOUBLE_WITHIN(0.2, 0, dB(measuredGain(NOTCH50, 1)));
+    TEST_ASSERT_TRUE(dB(measuredGain(NOTCH50, 50)) < -40);
+    TEST_ASSERT_TRUE(dB(measuredGain(NOTCH50, 100)) < -40);
+    TEST_ASSERT_TRUE(dB(measuredGain(MAINS60, 60)) < -60);
+    TEST_ASSERT_TRUE(dB(measuredGain(LOWPASS, 100)) < -50); // 24 dB/octave past 20 Hz
+}
+
+void test_channels_are_independent(void)
+{
+    // Each lane of a mixed bank gives bit-identical output to a bank of its own
+    const BiquadCascade<SECTIONS> *mixed[4] = {&NONE, &NOTCH50, &LOWPASS, &MAINS60};
+    BiquadBank<4, SECTIONS> bank;
+    BiquadBank<1, SECTIONS> single[4];
+    for (int c = 0; c < 4; c++)
+    {
+        bank.select(c, *mixed[c], 10.0f * c);
+        single[c].select(0, *mixed[c], 10.0f * c);
+    }
+    for (int n = 0; n < 2000; n++)
+    {
+        float in[4], out[4];
+        for (int c = 0; c < 4; c++)
+        {
+            in[c] = 10.0f * c + (float)sin(2 * M_PI * (7 + 13 * c) * n / FS) + ((n * 7919) % 101) * 0.01f;
+        }
+        bank.process(in, out);
+        for (int c = 0; c < 4; c++)
+        {
+            float one;
+            single[c].process(&in[c], &one);
+            TEST_ASSERT_EQUAL_FLOAT(one, out[c]);
+        }
+    }
+}
+
+void test_prime_has_no_step_response(void)
+{
+    BiquadBank<4, SECTIONS> bank;
+    for (int c = 0; c < 4; c++)
+    {
+        bank.select(c, MAINS50, 6000.0f);
+    }
+    float in[4] = {6000, 6000, 6000, 6000}, out[4];
+    for (int n = 0; n < 1000; n++)
+    {
+        bank.process(in, out);
+        TEST_ASSERT_FLOAT_WITHIN(0.05f, 6000, out[0]); // A few float ULPs
+        TEST_ASSERT_FLOAT_WITHIN(0.05f, 6000, out[3]);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_constexpr_coefficients_match_libm);
+    RUN_TEST(test_response_matches_design);
+    RUN_TEST(test_filter_shapes);
+    RUN_TEST(test_channels_are_independent);
+    RUN_TEST(test_prime_has_no_step_response);
+    return UNITY_END();
+}
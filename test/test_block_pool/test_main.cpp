@@ -0,0 +1,106 @@
+#include <stdint.h>
+#include <thread>
+#include <vector>
+#include <unity.h>
+#include <samplePool.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_alloc_until_exhausted(void)
+{
+    static BlockPool<uint32_t, 4> pool;
+    BlockHandle handles[4];
+    for (int i = 0; i < 4; i++)
+    {
+        handles[i] = pool.alloc();
+        TEST_ASSERT_TRUE(handles[i] != INVALID_BLOCK);
+        pool[handles[i]] = 100 + i;
+    }
+    TEST_ASSERT_EQUAL_UINT16(INVALID_BLOCK, pool.alloc());
+    TEST_ASSERT_EQUAL_UINT32(1, pool.exhaustions());
+    TEST_ASSERT_EQUAL_UINT32(4, pool.inUse());
+    for (int i = 0; i < 4; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(100 + i, pool[handles[i]]); // Distinct blocks
+        pool.release(handles[i]);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, pool.inUse());
+    TEST_ASSERT_EQUAL_UINT32(4, pool.peak());
+}
+
+void test_block_returns_with_last_reference(void)
+{
+    static BlockPool<uint32_t, 2> pool;
+    BlockHandle h = pool.alloc();
+    pool.retain(h); // A queue takes a reference
+    pool.retain(h); // And another
+    pool.release(h);
+    pool.release(h);
+    TEST_ASSERT_EQUAL_UINT32(1, pool.inUse());
+    pool.release(h);
+    TEST_ASSERT_EQUAL_UINT32(0, pool.inUse());
+    pool.release(INVALID_BLOCK); // Ignored
+    pool.retain(INVALID_BLOCK);
+    TEST_ASSERT_EQUAL_UINT32(0, pool.inUse());
+    TEST_ASSERT_TRUE(pool.alloc() != INVALID_BLOCK);
+    TEST_ASSERT_TRUE(pool.alloc() != INVALID_BLOCK);
+}
+
+// Producers on several threads alloc, share and release blocks concurrently: no block
+// is ever handed out twice and all of them come back
+void test_concurrent_alloc_release(void)
+{
+    static BlockPool<uint32_t, 16> pool;
+    static std::atomic<uint32_t> owner[16];
+    std::atomic<bool> duplicate{false};
+    std::vector<std::thread> threads;
+    for (uint32_t t = 1; t <= 4; t++)
+    {
+        threads.emplace_back([&, t]
+                             {
+            for (int i = 0; i < 50000; i++)
+            {
+                BlockHandle h = pool.alloc();
+                if (h == INVALID_BLOCK)
+                {
+                    continue;
+                }
+                uint32_t expected = 0;
+                if (!owner[h].compare_exchange_strong(expected, t))
+                {
+                    duplicate = true;
+                }
+                pool[h] = t;
+                pool.retain(h);
+                pool.release(h);
+                if (pool[h] != t)
+                {
+                    duplicate = true;
+                }
+                owner[h].store(0);
+                pool.release(h);
+            } });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    TEST_ASSERT_FALSE(duplicate);
+    TEST_ASSERT_EQUAL_UINT32(0, pool.inUse());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(16, pool.peak());
+    for (int i = 0; i < 16; i++)
+    {
+        TEST_ASSERT_TRUE(pool.alloc() != INVALID_BLOCK);
+    }
+    TEST_ASSERT_EQUAL_UINT16(INVALID_BLOCK, pool.alloc());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_alloc_until_exhausted);
+    RUN_TEST(test_block_returns_with_last_reference);
+    RUN_TEST(test_concurrent_alloc_release);
+    return UNITY_END();
+}
@@ -0,0 +1,321 @@
+#include <stdint.h>
+#include <string.h>
+#include <unity.h>
+#include <buttonLed.h>
+
+#define DEBOUNCE_MS 30
+#define LONG_PRESS_MS 3000
+
+// Fake pin and one-shot debounce timer: every edge restarts it, like xTimerResetFromISR
+static bool pinLevel = false;
+static uint32_t nowMs = 0;
+static uint32_t debounceDueMs = 0;
+static bool debounceArmed = false;
+static ButtonDebouncer button;
+
+static bool readPin() { return pinLevel; }
+
+static void setPin(bool level)
+{
+    pinLevel = level;
+    button.edge(nowMs);
+    debounceDueMs = nowMs + DEBOUNCE_MS;
+    debounceArmed = true;
+}
+
+// Advances the clock 1 ms at a time, collecting what the expired timer reports
+static ButtonEvent runUntil(uint32_t untilMs)
+{
+    ButtonEvent last = BUTTON_NONE;
+    while (nowMs < untilMs)
+    {
+        nowMs++;
+        if (debounceArmed && nowMs == debounceDueMs)
+        {
+            debounceArmed = false;
+            ButtonEvent event = button.settle(nowMs);
+            last = event != BUTTON_NONE ? event : last;
+        }
+    }
+    return last;
+}
+
+// Contact bounce: level flips every few ms before it settles at final
+static void bounce(bool final)
+{
+    const uint32_t gaps[] = {1, 3, 2, 5, 4};
+    for (uint32_t gap : gaps)
+    {
+        setPin(!pinLevel);
+        runUntil(nowMs + gap);
+    }
+    if (pinLevel != final)
+    {
+        setPin(final);
+    }
+}
+
+void setUp(void)
+{
+    pinLevel = false;
+    nowMs = 1000;
+    debounceArmed = false;
+    button.begin(readPin, DEBOUNCE_MS, LONG_PRESS_MS);
+}
+
+void tearDown(void) {}
+
+static void test_bounce_gives_one_press_and_one_release(void)
+{
+    bounce(true);
+    TEST_ASSERT_FALSE(button.isPressed()); // Still bouncing, nothing read yet
+    TEST_ASSERT_EQUAL_INT(BUTTON_DOWN, runUntil(nowMs + 100));
+    TEST_ASSERT_TRUE(button.isPressed());
+
+    bounce(false);
+    TEST_ASSERT_EQUAL_INT(BUTTON_SHORT_PRESS, runUntil(nowMs + 100));
+    TEST_ASSERT_FALSE(button.isPressed());
+    TEST_ASSERT_EQUAL_UINT32(10, button.edges());
+}
+
+// A glitch shorter than the debounce time reads the unchanged level, no event
+static void test_glitch_is_ignored(void)
+{
+    setPin(true);
+    runUntil(nowMs + 5);
+    setPin(false);
+    TEST_ASSERT_EQUAL_INT(BUTTON_NONE, runUntil(nowMs + 100));
+    TEST_ASSERT_FALSE(button.isPressed());
+}
+
+// A timer that expires early (an edge after it was armed) does not read the pin
+static void test_settle_before_debounce_time_does_nothing(void)
+{
+    setPin(true);
+    TEST_ASSERT_EQUAL_INT(BUTTON_NONE, button.settle(nowMs + DEBOUNCE_MS - 1));
+    TEST_ASSERT_EQUAL_INT(BUTTON_DOWN, button.settle(nowMs + DEBOUNCE_MS));
+    TEST_ASSERT_EQUAL_INT(BUTTON_NONE, button.settle(nowMs + DEBOUNCE_MS + 10)); // Level unchanged
+}
+
+static void test_short_press(void)
+{
+    setPin(true);
+    TEST_ASSERT_EQUAL_INT(BUTTON_DOWN, runUntil(nowMs + 50));
+    TEST_ASSERT_FALSE(button.longPressDue(nowMs + 500));
+    runUntil(nowMs + 1000);
+    setPin(false);
+    TEST_ASSERT_EQUAL_INT(BUTTON_SHORT_PRESS, runUntil(nowMs + 50));
+}
+
+static void test_long_press_fires_once(void)
+{
+    setPin(true);
+    TEST_ASSERT_EQUAL_INT(BUTTON_DOWN, runUntil(nowMs + DEBOUNCE_MS));
+    uint32_t pressMs = nowMs;
+    TEST_ASSERT_FALSE(button.longPressDue(pressMs + LONG_PRESS_MS - 1));
+    TEST_ASSERT_TRUE(button.longPressDue(pressMs + LONG_PRESS_MS));
+    TEST_ASSERT_FALSE(button.longPressDue(pressMs + LONG_PRESS_MS + 1000));
+
+    runUntil(pressMs + LONG_PRESS_MS + 2000);
+    setPin(false);
+    TEST_ASSERT_EQUAL_INT(BUTTON_RELEASED, runUntil(nowMs + 50)); // Not also a short press
+
+    // The next press starts over
+    setPin(true);
+    runUntil(nowMs + 50);
+    TEST_ASSERT_TRUE(button.longPressDue(nowMs + LONG_PRESS_MS));
+}
+
+// Held past the long-press time but the timer was late: still not a short press
+static void test_slow_release_without_long_press_timer(void)
+{
+    setPin(true);
+    runUntil(nowMs + 50);
+    runUntil(nowMs + LONG_PRESS_MS + 10);
+    setPin(false);
+    TEST_ASSERT_EQUAL_INT(BUTTON_RELEASED, runUntil(nowMs + 50));
+}
+
+static void test_long_press_needs_the_button_down(void)
+{
+    TEST_ASSERT_FALSE(button.longPressDue(nowMs + LONG_PRESS_MS * 2));
+}
+
+static void test_clock_wrap(void)
+{
+    nowMs = 0xFFFFFFFFu - 10;
+    setPin(true);
+    TEST_ASSERT_EQUAL_INT(BUTTON_NONE, button.settle(nowMs + 5));
+    TEST_ASSERT_EQUAL_INT(BUTTON_DOWN, button.settle(nowMs + DEBOUNCE_MS));
+    TEST_ASSERT_TRUE(button.longPressDue(nowMs + DEBOUNCE_MS + LONG_PRESS_MS));
+}
+
+// LEDs: record every write to check the sequence
+#define WRITE_LOG_SIZE 64
+static struct
+{
+    uint8_t pin;
+    bool level;
+    uint32_t t;
+} writes[WRITE_LOG_SIZE];
+static int writeCount = 0;
+static uint32_t ledNowMs = 0;
+
+static void writePin(uint8_t pin, bool level)
+{
+    if (writeCount < WRITE_LOG_SIZE)
+    {
+        writes[writeCount++] = {pin, level, ledNowMs};
+    }
+}
+
+static const uint8_t pins[3] = {2, 4, 5};
+static const bool idle[3] = {true, false, false};
+
+// Runs the LED timer as the firmware does: sleeps until the returned wait
+static void runLeds(LedPatterns<3> &leds, uint32_t untilMs)
+{
+    uint32_t wait = leds.nextWait(ledNowMs);
+    while (wait != LED_NO_CHANGE && ledNowMs + wait <= untilMs)
+    {
+        ledNowMs += wait;
+        wait = leds.tick(ledNowMs);
+    }
+    ledNowMs = untilMs;
+}
+
+static LedPatterns<3> freshLeds()
+{
+    LedPatterns<3> leds;
+    writeCount = 0;
+    ledNowMs = 5000;
+    leds.begin(writePin, pins, idle);
+    return leds;
+}
+
+static void test_begin_writes_idle_levels(void)
+{
+    LedPatterns<3> leds = freshLeds();
+    TEST_ASSERT_EQUAL_INT(3, writeCount);
+    TEST_ASSERT_TRUE(writes[0].level);
+    TEST_ASSERT_FALSE(writes[1].level);
+    TEST_ASSERT_EQUAL_UINT32(LED_NO_CHANGE, leds.nextWait(ledNowMs));
+}
+
+static void test_blink_count_then_idle(void)
+{
+    LedPatterns<3> leds = freshLeds();
+    writeCount = 0;
+    leds.blink(2, 100, 200, 2, ledNowMs);
+    runLeds(leds, ledNowMs + 2000);
+
+    // on 100, off 200, on 100, then back to idle (off)
+    const bool levels[] = {true, false, true, false};
+    const uint32_t at[] = {5000, 5100, 5300, 5400};
+    TEST_ASSERT_EQUAL_INT(4, writeCount);
+    for (int i = 0; i < 4; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(5, writes[i].pin);
+        TEST_ASSERT_EQUAL_INT(levels[i], writes[i].level);
+        TEST_ASSERT_EQUAL_UINT32(at[i], writes[i].t);
+    }
+    TEST_ASSERT_FALSE(leds.running(2));
+    TEST_ASSERT_EQUAL_UINT32(LED_NO_CHANGE, leds.nextWait(ledNowMs));
+}
+
+// setIdle during a pattern waits for the pattern to end; the end restores the new level
+static void test_idle_change_during_pattern(void)
+{
+    LedPatterns<3> leds = freshLeds();
+    leds.blink(1, 50, 50, 1, ledNowMs);
+    writeCount = 0;
+    leds.setIdle(1, true);
+    TEST_ASSERT_EQUAL_INT(0, writeCount);
+    runLeds(leds, ledNowMs + 500);
+    TEST_ASSERT_EQUAL_INT(1, writeCount);
+    TEST_ASSERT_TRUE(writes[0].level);
+    TEST_ASSERT_TRUE(leds.level(1));
+
+    leds.setIdle(1, false); // No pattern, applies at once
+    TEST_ASSERT_EQUAL_INT(2, writeCount);
+    TEST_ASSERT_FALSE(leds.level(1));
+}
+
+// The WiFi heartbeat runs forever; the timer wakes only at its transitions
+static void test_forever_pattern_and_wakeups(void)
+{
+    LedPatterns<3> leds = freshLeds();
+    leds.setIdle(0, false);
+    leds.blink(0, 10, 4990, -1, ledNowMs);
+    writeCount = 0;
+    int wakeups = 0;
+    uint32_t until = ledNowMs + 20000;
+    uint32_t wait = leds.nextWait(ledNowMs);
+    while (ledNowMs + wait <= until)
+    {
+        ledNowMs += wait;
+        wait = leds.tick(ledNowMs);
+        wakeups++;
+    }
+    TEST_ASSERT_EQUAL_INT(8, wakeups); // Off at +10, on at +5000, ... over 20 s
+    TEST_ASSERT_EQUAL_INT(8, writeCount);
+    TEST_ASSERT_TRUE(leds.running(0));
+}
+
+// Two patterns interleave, the wait is always to the earliest transition
+static void test_two_patterns_interleave(void)
+{
+    LedPatterns<3> leds = freshLeds();
+    leds.blink(1, 30, 30, 1, ledNowMs);
+    leds.blink(2, 100, 100, 1, ledNowMs);
+    TEST_ASSERT_EQUAL_UINT32(30, leds.nextWait(ledNowMs));
+    writeCount = 0;
+    runLeds(leds, ledNowMs + 1000);
+    TEST_ASSERT_EQUAL_INT(2, writeCount);
+    TEST_ASSERT_EQUAL_UINT32(4, writes[0].pin);
+    TEST_ASSERT_EQUAL_UINT32(5030, writes[0].t);
+    TEST_ASSERT_EQUAL_UINT32(5, writes[1].pin);
+    TEST_ASSERT_EQUAL_UINT32(5100, writes[1].t);
+}
+
+// Count 0 turns the LED on and stops, as used for "solid on until reconnected"
+static void test_blink_zero_stays_on(void)
+{
+    LedPatterns<3> leds = freshLeds();
+    leds.blink(0, 0, 0, 0, ledNowMs);
+    TEST_ASSERT_TRUE(leds.level(0));
+    TEST_ASSERT_FALSE(leds.running(0));
+    TEST_ASSERT_EQUAL_UINT32(LED_NO_CHANGE, leds.nextWait(ledNowMs));
+}
+
+// An overdue transition is scheduled right away, a wait of at least 1; across the wrap
+static void test_late_timer(void)
+{
+    LedPatterns<3> leds = freshLeds();
+    leds.blink(2, 100, 100, 3, 0xFFFFFFFFu - 50); // Off due at 49
+    TEST_ASSERT_EQUAL_UINT32(90, leds.nextWait(0xFFFFFFFFu - 40));
+    TEST_ASSERT_EQUAL_UINT32(1, leds.nextWait(59));
+    TEST_ASSERT_EQUAL_UINT32(100, leds.tick(59)); // On again 100 ms after the late wakeup
+    TEST_ASSERT_FALSE(leds.level(2));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_bounce_gives_one_press_and_one_release);
+    RUN_TEST(test_glitch_is_ignored);
+    RUN_TEST(test_settle_before_debounce_time_does_nothing);
+    RUN_TEST(test_short_press);
+    RUN_TEST(test_long_press_fires_once);
+    RUN_TEST(test_slow_release_without_long_press_timer);
+    RUN_TEST(test_long_press_needs_the_button_down);
+    RUN_TEST(test_clock_wrap);
+    RUN_TEST(test_begin_writes_idle_levels);
+    RUN_TEST(test_blink_count_then_idle);
+    RUN_TEST(test_idle_change_during_pattern);
+    RUN_TEST(test_forever_pattern_and_wakeups);
+    RUN_TEST(test_two_patterns_interleave);
+    RUN_TEST(test_blink_zero_stays_on);
+    RUN_TEST(test_late_timer);
+    return UNITY_END();
+}
@@ -0,0 +1,178 @@
+#include <stdint.h>
+#include <math.h>
+#include <unity.h>
+#include <decimator.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// The firmware's burst chain: 500 Hz capture down to the 1 Hz stream (captureDecimation)
+#define CIC_RATE 25
+#define FIR_RATE 20
+#define DECIMATION (CIC_RATE * FIR_RATE)
+
+static const uint16_t rates[][2] = {{CIC_RATE, FIR_RATE}, {8, 4}, {4, 2}, {32, 16}, {1, 1}};
+
+// Input samples fed until the first output, 0 if none within limit
+template <int Channels>
+static uint32_t firstOutput(CicFirDecimator<Channels> &decimator, const int32_t in[Channels], uint32_t limit)
+{
+    float out[Channels];
+    for (uint32_t i = 1; i <= limit; i++)
+    {
+        if (decimator.push(in, out))
+        {
+            return i;
+        }
+    }
+    return 0;
+}
+
+void test_first_output_at_latency(void)
+{
+    for (const uint16_t *r : rates)
+    {
+        static CicFirDecimator<1> decimator;
+        decimator.begin(r[0], r[1]);
+        const int32_t in[1] = {100};
+        TEST_ASSERT_EQUAL_UINT32(decimator.latency(), firstOutput(decimator, in, 100000));
+        decimator.reset();
+        TEST_ASSERT_EQUAL_UINT32(decimator.latency(), firstOutput(decimator, in, 100000));
+    }
+}
+
+// A constant comes out unchanged from the first output on, every channel on its own
+void test_dc_passthrough(void)
+{
+    static CicFirDecimator<3> decimator;
+    const int32_t in[3] = {32767, -5000, 0};
+    for (const uint16_t *r : rates)
+    {
+        decimator.begin(r[0], r[1]);
+        float out[3];
+        int outputs = 0;
+        for (uint32_t i = 0; i < 50 * (uint32_t)r[0] * r[1] + decimator.latency(); i++)
+        {
+            if (decimator.push(in, out))
+            {
+                outputs++;
+                TEST_ASSERT_FLOAT_WITHIN(0.05f, 32767, out[0]);
+                TEST_ASSERT_FLOAT_WITHIN(0.01f, -5000, out[1]);
+                TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0, out[2]);
+            }
+        }
+        TEST_ASSERT_EQUAL_INT(51, outputs);
+    }
+}
+
+// Full-scale inputs wrap the uint64_t integrators within a few thousand samples; the
+// combs still recover the value
+void test_integrator_wrap(void)
+{
+    static CicFirDecimator<1> decimator;
+    decimator.begin(CIC_RATE, FIR_RATE);
+    const int32_t in[1] = {2000000000};
+    float out[1];
+    int outputs = 0;
+    for (uint32_t i = 0; i < 200 * DECIMATION; i++)
+    {
+        if (decimator.push(in, out))
+        {
+            outputs++;
+            TEST_ASSERT_FLOAT_WITHIN(2000, 2e9f, out[0]);
+        }
+    }
+    TEST_ASSERT_TRUE(outputs > 190);
+}
+
+// latency() is when outputs start, not when a change is through: a step takes the span
+// of both stages, CIC_ORDER + taps CIC outputs, to settle to 0.1 %
+void test_step_settling(void)
+{
+    for (const uint16_t *r : rates)
+    {
+        if (r[1] == 1)
+        {
+            continue; // No FIR to speak of
+        }
+        static CicFirDecimator<1> decimator;
+        decimator.begin(r[0], r[1]);
+        const uint32_t decimation = (uint32_t)r[0] * r[1];
+        const uint32_t span = (uint32_t)r[0] * (CIC_ORDER + 4 * r[1] + 1);
+        const uint32_t stepAt = decimator.latency() + 10 * decimation;
+
+        float out[1];
+        uint32_t settledAfter = 0;
+        for (uint32_t i = 1; i < stepAt + 4 * span; i++)
+        {
+            const int32_t in[1] = {i > stepAt ? 1000 : 0};
+            if (!decimator.push(in, out))
+            {
+                continue;
+            }
+            if (i <= stepAt)
+            {
+                TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0, out[0]);
+            }
+            else if (fabsf(out[0] - 1000) > 1)
+            {
+                settledAfter = 0; // Not there yet, or rang out again
+            }
+            else if (settledAfter == 0)
+            {
+                settledAfter = i - stepAt;
+            }
+        }
+        TEST_ASSERT_TRUE(settledAfter > 0);
+        TEST_ASSERT_TRUE(settledAfter <= span);
+        TEST_ASSERT_TRUE(settledAfter > decimator.latency());
+    }
+}
+
+// Peak output over a few hundred output samples for a tone of cycles per output sample
+static float tonePeak(double cyclesPerOutput, float *dc)
+{
+    static CicFirDecimator<2> decimator;
+    decimator.begin(CIC_RATE, FIR_RATE);
+    const double amplitude = 100000;
+    float peak = 0, out[2];
+    int outputs = 0;
+    for (uint32_t i = 0; i < 300 * DECIMATION; i++)
+    {
+        const int32_t in[2] = {(int32_t)lround(amplitude * sin(2 * M_PI * cyclesPerOutput * i / DECIMATION + 0.3)), 5};
+        if (decimator.push(in, out) && ++outputs > 10) // Past the start-up window
+        {
+            peak = fabsf(out[0]) > peak ? fabsf(out[0]) : peak;
+            *dc = out[1];
+        }
+    }
+    return peak / amplitude;
+}
+
+// Tones above the output Nyquist would alias into the 1 Hz stream; they are rejected by
+// the FIR from the output rate up and by the CIC nulls beyond (e.g. mains at 50 Hz)
+void test_stop_band_rejection(void)
+{
+    float dc;
+    TEST_ASSERT_TRUE(tonePeak(0.1, &dc) > 0.9f); // Passband
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 5, dc);      // The other channel is untouched
+
+    TEST_ASSERT_TRUE(tonePeak(1.0, &dc) < 2e-3f); // -54 dB, aliases to DC
+    const double stopBand[] = {1.5, 2.0, 3.7, 50.0, 60.0, 100.0};
+    for (double cycles : stopBand)
+    {
+        TEST_ASSERT_TRUE(tonePeak(cycles, &dc) < 1e-4f); // -80 dB
+        TEST_ASSERT_FLOAT_WITHIN(1e-3f, 5, dc);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_first_output_at_latency);
+    RUN_TEST(test_dc_passthrough);
+    RUN_TEST(test_integrator_wrap);
+    RUN_TEST(test_step_settling);
+    RUN_TEST(test_stop_band_rejection);
+    return UNITY_END();
+}
@@ -0,0 +1,136 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unity.h>
+#include <fixedPoint.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Callendar-Van Dusen as in main.cpp (PT200, 430 Ω reference), the float reference for the table
+static float rtdToKelvin(float code)
+{
+    const float A = 3.9083e-3;
+    const float B = -5.775e-7;
+    float Rt = code / 32768.0f * 430;
+    float temp = (sqrtf(A * A - 4 * B * (1 - Rt / 200.0f)) - A) / (2 * B);
+    if (temp < 0)
+    {
+        Rt = Rt / 200.0f * 100;
+        float rpoly = Rt;
+        temp = -242.02f;
+        temp += 2.2228f * rpoly;
+        rpoly *= Rt;
+        temp += 2.5859e-3f * rpoly;
+        rpoly *= Rt;
+        temp -= 4.8260e-6f * rpoly;
+        rpoly *= Rt;
+        temp -= 2.8183e-8f * rpoly;
+        rpoly *= Rt;
+        temp += 1.5243e-10f * rpoly;
+    }
+    return temp + 273.15f;
+}
+
+void test_conversion_and_arithmetic(void)
+{
+    TEST_ASSERT_EQUAL_INT32(0x18000, Q16::fromFloat(1.5f).raw);
+    TEST_ASSERT_EQUAL_INT32(-0x18000, Q16::fromFloat(-1.5f).raw);
+    Q16 a = Q16::fromFloat(77.25f), b = Q16::fromFloat(-3.5f);
+    TEST_ASSERT_EQUAL_FLOAT(73.75f, (a + b).toFloat());
+    TEST_ASSERT_EQUAL_FLOAT(80.75f, (a - b).toFloat());
+    TEST_ASSERT_EQUAL_FLOAT(-270.375f, (a * b).toFloat());
+    TEST_ASSERT_FLOAT_WITHIN(1.0f / 65536, 77.25f / -3.5f, (a / b).toFloat());
+    TEST_ASSERT_EQUAL_INT32(0, (a / Q16::fromRaw(0)).raw);
+    TEST_ASSERT_EQUAL_FLOAT(3.5f, b.abs().toFloat());
+    TEST_ASSERT_EQUAL_INT32(Q16::fromFloat(1.5f).raw >> 8, Q16::fromFloat(1.5f).rescale<8>().raw);
+}
+
+void test_median(void)
+{
+    Q16 window[5];
+    const float values[5] = {80.1f, 79.9f, 500.0f, 80.0f, -1.0f};
+    for (int i = 0; i < 5; i++)
+    {
+        window[i] = Q16::fromFloat(values[i]);
+    }
+    TEST_ASSERT_EQUAL_INT32(Q16::fromFloat(80.0f).raw, fixedMedian(window, 5).raw);
+}
+
+void test_rtd_table_within_1mK(void)
+{
+    static RtdTable table;
+    table.build(rtdToKelvin);
+    float worst = 0;
+    int checked = 0;
+    for (uint32_t code = 0; code < 32768; code++)
+    {
+        float reference = rtdToKelvin((float)code);
+        if (reference < 73 || reference > 300)
+        {
+            continue;
+        }
+        float error = fabsf(table.kelvin(code).toFloat() - reference);
+        worst = error > worst ? error : worst;
+        checked++;
+    }
+    TEST_ASSERT_GREATER_THAN(1000, checked);
+    TEST_ASSERT_FLOAT_WITHIN(0.0011f, 0, worst);
+}
+
+void test_conductivity_matches_float(void)
+{
+    // k = P·L / (A·ΔT·1000) over the lab's range of powers, ΔT and geometry
+    const float powers[] = {5, 150, 1500, 4000};
+    const float dTs[] = {0.5f, 2, 12, -12, 40};
+    const float thicknesses[] = {1, 5, 20};
+    const float diameters[] = {10, 20, 40};
+    for (float p : powers)
+        for (float dT : dTs)
+            for (float l : thicknesses)
+                for (float d : diameters)
+                {
+                    float area = (float)M_PI * d * d / 4;
+                    float expected = p * l / (area * fabsf(dT) * 1000);
+                    float k = fixedConductivity(Q16::fromFloat(p), Q16::fromFloat(l), Q16::fromFloat(area), Q16::fromFloat(dT)).toFloat();
+                    TEST_ASSERT_FLOAT_WITHIN(0.0015f * expected + 2.0f / 65536, expected, k);
+                }
+    TEST_ASSERT_EQUAL_INT32(0, fixedConductivity(Q16::fromFloat(1500), Q16::fromFloat(5), Q16::fromFloat(314), Q16::fromRaw(0)).raw);
+}
+
+void test_format_matches_printf(void)
+{
+    // Values exactly representable in Q16, so round-half-up agrees with printf on the same number
+    const float values[] = {0, 0.5f, 1.25f, -1.25f, 77.125f, -0.0001220703125f, 12345.6789f, -32767.5f};
+    char fixed[24], reference[24];
+    for (float v : values)
+    {
+        Q16 q = Q16::fromFloat(v);
+        for (int decimals = 0; decimals <= 5; decimals++)
+        {
+            double exact = (double)q.raw / 65536;
+            double scale = pow(10, decimals);
+            double rounded = floor(fabs(exact) * scale + 0.5) / scale;
+            snprintf(reference, sizeof(reference), "%.*f", decimals, exact < 0 && rounded != 0 ? -rounded : rounded);
+            size_t n = formatFixed(fixed, sizeof(fixed), q, decimals);
+            TEST_ASSERT_EQUAL_STRING(reference, fixed);
+            TEST_ASSERT_EQUAL_UINT32(strlen(reference), n);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, formatFixed(fixed, 4, Q16::fromFloat(123.5f), 2)); // Truncated to the buffer
+    fixed[0] = 'x';
+    TEST_ASSERT_EQUAL_UINT32(0, formatFixed(fixed, 0, Q16::fromFloat(123.5f), 2)); // Nothing written
+    TEST_ASSERT_EQUAL_INT('x', fixed[0]);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_conversion_and_arithmetic);
+    RUN_TEST(test_median);
+    RUN_TEST(test_rtd_table_within_1mK);
+    RUN_TEST(test_conductivity_matches_float);
+    RUN_TEST(test_format_matches_printf);
+    return UNITY_END();
+}
@@ -0,0 +1,378 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unity.h>
+#include <mdnsDiscovery.h>
+#include <fleetAggregator.h>
+#include <rigSimulator.h>
+
+static std::string columnarPath;
+
+void setUp(void)
+{
+    columnarPath = "/tmp/cryo_fleet_" + std::to_string(getpid()) + ".cryc";
+}
+
+void tearDown(void)
+{
+    remove(columnarPath.c_str());
+}
+
+static void put16(std::vector<uint8_t> &packet, uint16_t value)
+{
+    packet.push_back(value >> 8);
+    packet.push_back(value & 0xFF);
+}
+
+// One resource record; name is already encoded
+static void putRecord(std::vector<uint8_t> &packet, const std::vector<uint8_t> &name, uint16_t type, uint32_t ttl,
+                      const std::vector<uint8_t> &data)
+{
+    packet.insert(packet.end(), name.begin(), name.end());
+    put16(packet, type);
+    put16(packet, 0x8001); // Cache flush, class IN
+    put16(packet, ttl >> 16);
+    put16(packet, ttl & 0xFFFF);
+    put16(packet, data.size());
+    packet.insert(packet.end(), data.begin(), data.end());
+}
+
+static std::vector<uint8_t> encoded(const char *name)
+{
+    std::vector<uint8_t> bytes;
+    mdnsWriteName(bytes, name);
+    return bytes;
+}
+
+static std::vector<uint8_t> responseHeader(uint16_t answers)
+{
+    std::vector<uint8_t> packet = {0, 0, 0x84, 0, 0, 0};
+    put16(packet, answers);
+    put16(packet, 0);
+    put16(packet, 0);
+    return packet;
+}
+
+// What a rig answers: PTR with the instance compressed against the service name at 12
+static std::vector<uint8_t> rigResponse(uint32_t ttl)
+{
+    std::vector<uint8_t> packet = responseHeader(5);
+    std::vector<uint8_t> instance = {6, 'C', 'r', 'y', 'o', '-', 'A', 0xC0, 12};
+    putRecord(packet, encoded(MDNS_TELEMETRY_SERVICE), MDNS_TYPE_PTR, ttl, instance);
+
+    std::vector<uint8_t> srv = {0, 0, 0, 0};
+    put16(srv, 4210);
+    std::vector<uint8_t> target = encoded("cryo-a1b2c3.local");
+    srv.insert(srv.end(), target.begin(), target.end());
+    putRecord(packet, encoded("cryo-a._cryo._udp.local"), MDNS_TYPE_SRV, ttl, srv); // Case differs from the PTR
+
+    std::vector<uint8_t> txt;
+    for (const char *entry : {"fw=2.3.0", "frame=2", "channels=12", "mac=A4:CF:12:B2:C3:01", "run=", "broken"})
+    {
+        txt.push_back(strlen(entry));
+        txt.insert(txt.end(), entry, entry + strlen(entry));
+    }
+    putRecord(packet, encoded("Cryo-A._cryo._udp.local"), MDNS_TYPE_TXT, ttl, txt);
+
+    std::vector<uint8_t> http = {0, 0, 0, 0};
+    put16(http, 8080);
+    http.insert(http.end(), target.begin(), target.end());
+    putRecord(packet, encoded("Cryo-A._http._tcp.local"), MDNS_TYPE_SRV, ttl, http);
+
+    putRecord(packet, encoded("cryo-a1b2c3.local"), MDNS_TYPE_A, ttl, {192, 168, 1, 20});
+    return packet;
+}
+
+void test_mdns_query(void)
+{
+    std::vector<uint8_t> query = mdnsQuery();
+    static const uint8_t header[12] = {0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0};
+    TEST_ASSERT_EQUAL_MEMORY(header, query.data(), 12);
+    size_t offset = 12;
+    std::string name;
+    TEST_ASSERT_TRUE(mdnsReadName(query.data(), query.size(), offset, name));
+    TEST_ASSERT_EQUAL_STRING(MDNS_TELEMETRY_SERVICE, name.c_str());
+    TEST_ASSERT_EQUAL_INT(MDNS_TYPE_PTR, query[offset + 1]);
+    offset += 4;
+    TEST_ASSERT_TRUE(mdnsReadName(query.data(), query.size(), offset, name));
+    TEST_ASSERT_EQUAL_STRING(MDNS_HTTP_SERVICE, name.c_str());
+    TEST_ASSERT_EQUAL_INT(query.size(), offset + 4);
+
+    // A query is not an answer
+    MdnsBrowser browser;
+    TEST_ASSERT_FALSE(browser.parse(query.data(), query.size()));
+}
+
+void test_mdns_browse(void)
+{
+    MdnsBrowser browser;
+    std::vector<uint8_t> response = rigResponse(120);
+    TEST_ASSERT_TRUE(browser.parse(response.data(), response.size()));
+    std::vector<DiscoveredRig> rigs = browser.rigs();
+    TEST_ASSERT_EQUAL_INT(1, rigs.size());
+    TEST_ASSERT_EQUAL_STRING("Cryo-A", rigs[0].name.c_str());
+    TEST_ASSERT_EQUAL_STRING("cryo-a1b2c3.local", rigs[0].host.c_str());
+    TEST_ASSERT_EQUAL_STRING("192.168.1.20", rigs[0].address.c_str());
+    TEST_ASSERT_EQUAL_UINT32(4210, rigs[0].udpPort);
+    TEST_ASSERT_EQUAL_UINT32(8080, rigs[0].httpPort);
+    TEST_ASSERT_EQUAL_INT(5, rigs[0].txt.size()); // "broken" has no '='
+    TEST_ASSERT_EQUAL_STRING("2.3.0", rigs[0].txt["fw"].c_str());
+    TEST_ASSERT_EQUAL_STRING("A4:CF:12:B2:C3:01", rigs[0].txt["mac"].c_str());
+    TEST_ASSERT_EQUAL_STRING("", rigs[0].txt["run"].c_str());
+
+    // A rig whose address has not been heard yet is left out
+    std::vector<uint8_t> partial = responseHeader(2);
+    putRecord(partial, encoded(MDNS_TELEMETRY_SERVICE), MDNS_TYPE_PTR, 120, encoded("Cryo-B._cryo._udp.local"));
+    std::vector<uint8_t> srv = {0, 0, 0, 0, 0x10, 0x72};
+    std::vector<uint8_t> target = encoded("cryo-b.local");
+    srv.insert(srv.end(), target.begin(), target.end());
+    putRecord(partial, encoded("Cryo-B._cryo._udp.local"), MDNS_TYPE_SRV, 120, srv);
+    TEST_ASSERT_TRUE(browser.parse(partial.data(), partial.size()));
+    TEST_ASSERT_EQUAL_INT(1, browser.rigs().size());
+
+    // Goodbye
+    std::vector<uint8_t> goodbye = rigResponse(0);
+    TEST_ASSERT_TRUE(browser.parse(goodbye.data(), goodbye.size()));
+    TEST_ASSERT_EQUAL_INT(0, browser.rigs().size());
+}
+
+void test_mdns_rejects_bad_names(void)
+{
+    // A pointer to itself
+    std::vector<uint8_t> loop = responseHeader(1);
+    loop.push_back(0xC0);
+    loop.push_back(12);
+    MdnsBrowser browser;
+    TEST_ASSERT_FALSE(browser.parse(loop.data(), loop.size()));
+
+    // Cut short inside the record data
+    std::vector<uint8_t> response = rigResponse(120);
+    response.resize(response.size() - 2);
+    MdnsBrowser cut;
+    TEST_ASSERT_FALSE(cut.parse(response.data(), response.size()));
+
+    // A label running past the end
+    std::vector<uint8_t> label = {0, 0, 0x84, 0, 0, 0, 0, 1, 0, 0, 0, 0, 40, 'a'};
+    size_t offset = 12;
+    std::string name;
+    TEST_ASSERT_FALSE(mdnsReadName(label.data(), label.size(), offset, name));
+}
+
+void test_clock_alignment(void)
+{
+    ClockAlignment clock;
+    const int64_t host = 1700000000000;
+    // Delays of 1-20 ms, the least delayed frame sets the offset
+    static const int delays[] = {12, 5, 20, 1, 9, 3, 17, 1, 6};
+    int64_t aligned = 0;
+    for (int i = 0; i < 9; i++)
+    {
+        aligned = clock.align(1000 + i * 100, host + i * 100 + delays[i]);
+        TEST_ASSERT_LESS_OR_EQUAL(i * 100 + delays[i], (int)(aligned - host)); // Never after arrival
+    }
+    TEST_ASSERT_EQUAL_INT(800 + 1, (int)(aligned - host));
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, 1, (float)(clock.offsetMs() - (host - 1000)));
+
+    // The rig clock wraps past 2^32 ms without a jump
+    ClockAlignment wrapping;
+    TEST_ASSERT_EQUAL_INT(0, (int)(wrapping.align(0xFFFFFF00u, host) - host));
+    TEST_ASSERT_EQUAL_INT(512, (int)(wrapping.align(0x100u, host + 512) - host));
+
+    // A rig clock 100 ppm slow is followed: the offset creeps up with it
+    ClockAlignment slow;
+    for (int64_t t = 0; t <= 600000; t += 1000)
+    {
+        aligned = slow.align((uint32_t)(t - t / 10000), host + t);
+    }
+    TEST_ASSERT_INT_WITHIN(2, 600000, (int)(aligned - host));
+
+    // After a restart the new clock is taken as is
+    clock.reset();
+    TEST_ASSERT_EQUAL_INT(5000, (int)(clock.align(10, host + 5000) - host));
+}
+
+void test_fleet_store(void)
+{
+    FleetStore store;
+    store.begin(2, 1000, 500);
+    float a[FLEET_CHANNELS] = {1, 2, 3, 4, 5, 6, NAN, 8};
+    float b[FLEET_CHANNELS] = {3, 4, 5, 6, 7, 8, 9, 10};
+    TEST_ASSERT_TRUE(store.add(0, 10100, a));
+    TEST_ASSERT_TRUE(store.add(0, 10900, b));
+    TEST_ASSERT_TRUE(store.add(1, 12000, a)); // 11000 has no rig 1, 11000-12000 nobody
+    TEST_ASSERT_EQUAL_UINT32(2, store.openBins());
+
+    std::vector<int64_t> starts;
+    std::vector<std::vector<float>> rows;
+    auto emit = [&](int64_t startMs, const float *means) {
+        starts.push_back(startMs);
+        rows.emplace_back(means, means + 2 * FLEET_CHANNELS);
+    };
+    store.close(11499, emit); // Not final yet
+    TEST_ASSERT_EQUAL_INT(0, starts.size());
+    store.close(11500, emit);
+    TEST_ASSERT_EQUAL_INT(1, starts.size());
+    TEST_ASSERT_EQUAL_INT(10000, starts[0]);
+    TEST_ASSERT_EQUAL_FLOAT(2, rows[0][0]);
+    TEST_ASSERT_EQUAL_FLOAT(9, rows[0][6]); // NaN is left out of the mean
+    TEST_ASSERT_TRUE(isnan(rows[0][FLEET_CHANNELS])); // Rig 1 had nothing
+
+    TEST_ASSERT_FALSE(store.add(1, 10999, b)); // Its bin is final
+    TEST_ASSERT_TRUE(store.add(1, 11000, b));  // Still open
+    store.flush(emit);
+    TEST_ASSERT_EQUAL_INT(3, starts.size());
+    TEST_ASSERT_EQUAL_INT(11000, starts[1]);
+    TEST_ASSERT_EQUAL_FLOAT(7, rows[1][FLEET_CHANNELS + 4]);
+    TEST_ASSERT_TRUE(isnan(rows[1][0]));
+    TEST_ASSERT_EQUAL_INT(12000, starts[2]);
+    TEST_ASSERT_EQUAL_FLOAT(1, rows[2][FLEET_CHANNELS]);
+    TEST_ASSERT_EQUAL_UINT32(0, store.openBins());
+}
+
+// Dozens of simulated rigs on loopback, each with its own clock, one of them wrapping
+// past 2^32 ms during the run, plus a rig that does not answer
+void test_fleet_loopback(void)
+{
+    const int RIGS = 16;
+    const uint32_t BIN_MS = 250;
+    int64_t epoch = hostTimeMs();
+    std::vector<std::unique_ptr<SimulatedRig>> simulated;
+    FleetAggregator fleet;
+    for (int i = 0; i < RIGS; i++)
+    {
+        simulated.emplace_back(new SimulatedRig());
+        uint32_t offset = i == 0 ? 0xFFFFFFFFu - 1000 : (uint32_t)(i * 268000000u + i * 7919);
+        TEST_ASSERT_TRUE(simulated[i]->start(10, offset, epoch));
+        fleet.addRig("rig" + std::to_string(i), "127.0.0.1", simulated[i]->httpPort());
+    }
+    uint16_t closedPort;
+    {
+        SimulatedRig gone; // Its port is free again once it stops
+        TEST_ASSERT_TRUE(gone.start(10, 0, epoch));
+        closedPort = gone.httpPort();
+    }
+    fleet.addRig("offline", "127.0.0.1", closedPort);
+    TEST_ASSERT_TRUE(fleet.start(BIN_MS, 200));
+
+    FleetTable table;
+    table.begin(fleet);
+    TEST_ASSERT_EQUAL_INT(1 + (RIGS + 1) * FLEET_CHANNELS, table.count());
+    TEST_ASSERT_EQUAL_STRING("rig3.temp1", table.columns()[1 + 3 * FLEET_CHANNELS].name);
+    ColumnarWriter writer(4);
+    TEST_ASSERT_TRUE(writer.open(columnarPath.c_str(), table.columns(), table.count()));
+
+    int complete = 0;
+    float worstRamp = 0, worstSpread = 0;
+    bool offlineEmpty = true, stopping = false;
+    auto emit = [&](int64_t startMs, const float *means) {
+        writer.append(table.fill(startMs, means));
+        for (int c = 0; c < FLEET_CHANNELS; c++)
+        {
+            offlineEmpty = offlineEmpty && isnan(means[RIGS * FLEET_CHANNELS + c]);
+        }
+        float low = INFINITY, high = -INFINITY;
+        for (int r = 0; r < RIGS; r++)
+        {
+            low = fminf(low, means[r * FLEET_CHANNELS]);
+            high = fmaxf(high, means[r * FLEET_CHANNELS]);
+        }
+        if (isinf(low) || isnan(low) || isnan(high))
+        {
+            return; // A rig not subscribed yet, or left already
+        }
+        // Bins at the edges of a rig's stream are partly filled
+        bool full = true;
+        for (int r = 0; r < RIGS; r++)
+        {
+            full = full && !isnan(means[r * FLEET_CHANNELS]);
+        }
+        if (!full || startMs < epoch + 500 || stopping)
+        {
+            return; // Only bins filled for their whole span are compared
+        }
+        complete++;
+        float ramp = 80 + (startMs - epoch + BIN_MS / 2.0f) / 1000;
+        worstRamp = fmaxf(worstRamp, fmaxf(fabsf(low - ramp), fabsf(high - ramp)));
+        worstSpread = fmaxf(worstSpread, high - low);
+    };
+
+    int64_t until = hostTimeMs() + 3000;
+    while (hostTimeMs() < until)
+    {
+        fleet.poll(50, emit);
+    }
+    for (int i = 0; i < RIGS; i++)
+    {
+        TEST_ASSERT_EQUAL_INT(1, simulated[i]->subscriberCount());
+    }
+    stopping = true; // The last bins are flushed part filled
+    fleet.stop(emit);
+    writer.close();
+
+    for (int i = 0; i < RIGS; i++)
+    {
+        RigStats_t stats = fleet.stats(i);
+        TEST_ASSERT_EQUAL_INT(200, stats.subscribeStatus);
+        TEST_ASSERT_GREATER_THAN_UINT32(200, stats.receiver.frames);
+        TEST_ASSERT_EQUAL_UINT32(0, stats.receiver.lost);
+        TEST_ASSERT_EQUAL_UINT32(0, stats.receiver.invalid);
+        TEST_ASSERT_EQUAL_UINT32(0, stats.receiver.restarts);
+        TEST_ASSERT_EQUAL_UINT32(0, (uint32_t)stats.tooLate);
+        TEST_ASSERT_EQUAL_INT(0, simulated[i]->subscriberCount()); // Unsubscribed at stop
+    }
+    RigStats_t offline = fleet.stats(RIGS);
+    TEST_ASSERT_EQUAL_INT(-1, offline.subscribeStatus);
+    TEST_ASSERT_EQUAL_UINT32(0, offline.receiver.frames);
+    TEST_ASSERT_TRUE(offlineEmpty);
+
+    // Every rig lands on the same host-time ramp, whatever its own clock reads
+    char message[96];
+    snprintf(message, sizeof(message), "%d full bins, worst %.4f K off the ramp, %.4f K between rigs", complete, worstRamp,
+             worstSpread);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_GREATER_THAN(5, complete);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 0, worstRamp);
+    TEST_ASSERT_FLOAT_WITHIN(0.02f, 0, worstSpread);
+
+    // The merged table reads back with its rig.channel columns
+    ColumnarReader reader;
+    TEST_ASSERT_TRUE(reader.open(columnarPath.c_str()));
+    TEST_ASSERT_EQUAL_INT(table.count(), reader.columns());
+    TEST_ASSERT_EQUAL_INT(COLUMN_U64, reader.type(0));
+    int temp1 = reader.find("rig5.temp1");
+    TEST_ASSERT_EQUAL_INT(1 + 5 * FLEET_CHANNELS, temp1);
+    int64_t previous = 0;
+    bool ordered = true, onRamp = true;
+    while (reader.nextGroup())
+    {
+        for (uint32_t row = 0; row < reader.rows(); row++)
+        {
+            int64_t start = (int64_t)reader.number(0, row);
+            ordered = ordered && start > previous && start % BIN_MS == 0;
+            previous = start;
+            double value = reader.number(temp1, row);
+            onRamp = onRamp && (isnan(value) || fabs(value - (80 + (start + BIN_MS / 2.0 - epoch) / 1000.0)) < 0.2);
+        }
+    }
+    TEST_ASSERT_TRUE(ordered);
+    TEST_ASSERT_TRUE(onRamp);
+    TEST_ASSERT_TRUE(reader.complete());
+    TEST_ASSERT_GREATER_THAN(complete, (int)reader.rowsRead());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_mdns_query);
+    RUN_TEST(test_mdns_browse);
+    RUN_TEST(test_mdns_rejects_bad_names);
+    RUN_TEST(test_clock_alignment);
+    RUN_TEST(test_fleet_store);
+    RUN_TEST(test_fleet_loopback);
+    return UNITY_END();
+}
@@ -0,0 +1,105 @@
+#include <stdint.h>
+#include <math.h>
+#include <unity.h>
+#include <forecast.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static double noise(uint32_t &seed, double amplitude)
+{
+    // Sum of uniforms, close enough to Gaussian for RTD noise
+    double sum = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        sum += (seed >> 8) / 16777216.0 - 0.5;
+    }
+    return sum * amplitude;
+}
+
+void test_exact_first_order_response(void)
+{
+    SteadyStateForecast forecast;
+    forecast.begin(0.995);
+    for (int i = 0; i < 300; i++)
+    {
+        double t = i * 2.0;
+        forecast.update(t, 12.0 - 9.0 * exp(-t / 180.0));
+    }
+    TEST_ASSERT_TRUE(forecast.valid());
+    TEST_ASSERT_DOUBLE_WITHIN(0.01, 12.0, forecast.asymptote());
+    TEST_ASSERT_DOUBLE_WITHIN(2.0, 180.0, forecast.tau());
+    double remaining = 9.0 * exp(-598.0 / 180.0);
+    TEST_ASSERT_DOUBLE_WITHIN(5.0, 180.0 * log(remaining / 0.01), forecast.timeToEquilibrium(0.01));
+}
+
+void test_noisy_uneven_sampling_covers_truth(void)
+{
+    // Adaptive sampling: intervals from 1 to 5 s, 5 mK RTD noise. The 95 % interval must
+    // hold the true asymptote in most runs
+    int covered = 0;
+    const int runs = 40;
+    for (int run = 0; run < runs; run++)
+    {
+        uint32_t seed = 1000 + run;
+        SteadyStateForecast forecast;
+        forecast.begin(0.995);
+        double t = 0;
+        for (int i = 0; i < 250; i++)
+        {
+            forecast.update(t, 8.0 + 4.0 * exp(-t / 240.0) + noise(seed, 0.005));
+            seed = seed * 1664525 + 1013904223;
+            t += 1 + (seed >> 8) % 5;
+        }
+        TEST_ASSERT_TRUE(forecast.valid());
+        TEST_ASSERT_DOUBLE_WITHIN(0.2, 8.0, forecast.asymptote());
+        if (fabs(forecast.asymptote() - 8.0) <= 1.96 * forecast.asymptoteUnc())
+        {
+            covered++;
+        }
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(runs * 8 / 10, covered);
+}
+
+void test_not_valid_before_enough_samples_or_when_diverging(void)
+{
+    SteadyStateForecast forecast;
+    forecast.begin(0.995);
+    for (int i = 0; i < FORECAST_MIN_SAMPLES - 1; i++)
+    {
+        forecast.update(i, 12.0 - 9.0 * exp(-i / 30.0));
+    }
+    TEST_ASSERT_FALSE(forecast.valid());
+    TEST_ASSERT_TRUE(isinf(forecast.timeToEquilibrium(0.01)));
+
+    // Runaway growth has no equilibrium
+    forecast.reset();
+    for (int i = 0; i < 100; i++)
+    {
+        forecast.update(i, exp(i / 50.0));
+    }
+    TEST_ASSERT_FALSE(forecast.valid());
+    TEST_ASSERT_TRUE(isinf(forecast.asymptoteUnc()));
+}
+
+void test_reset_and_repeated_time(void)
+{
+    SteadyStateForecast forecast;
+    forecast.begin(0.995);
+    forecast.update(0, 1);
+    forecast.update(0, 2); // Not after the previous sample, ignored
+    TEST_ASSERT_EQUAL_INT(1, forecast.count());
+    forecast.reset();
+    TEST_ASSERT_EQUAL_INT(0, forecast.count());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_exact_first_order_response);
+    RUN_TEST(test_noisy_uneven_sampling_covers_truth);
+    RUN_TEST(test_not_valid_before_enough_samples_or_when_diverging);
+    RUN_TEST(test_reset_and_repeated_time);
+    return UNITY_END();
+}
@@ -0,0 +1,167 @@
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <unity.h>
+#include <gorilla.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#define CHANNELS 7 // As the archive
+#define BLOCK_BYTES 1000
+
+static uint8_t block[BLOCK_BYTES];
+static uint32_t times[2048];
+static uint32_t words[2048][CHANNELS];
+
+static uint32_t lcg(uint32_t &seed)
+{
+    seed = seed * 1664525 + 1013904223;
+    return seed >> 8;
+}
+
+// Fills the block and returns the number of records; times cover every timestamp width
+static uint16_t encode(uint8_t codec, uint32_t seed)
+{
+    SeriesEncoder<CHANNELS> encoder;
+    encoder.begin(block, sizeof(block), codec);
+    uint32_t t = 4000000000UL; // Wraps inside the block
+    uint16_t n = 0;
+    for (;; n++)
+    {
+        uint32_t r = lcg(seed);
+        const int32_t jitter[] = {0, 0, 0, 3, -40, 200, -1500, 70000};
+        t += 1000 + jitter[r % 8];
+        times[n] = t;
+        for (int c = 0; c < CHANNELS; c++)
+        {
+            if (codec == SERIES_CODEC_XOR)
+            {
+                const float specials[] = {NAN, INFINITY, -0.0f, 1e-38f};
+                float v = (r >> 4) % 50 == 0 ? specials[c % 4] : 77.0f + c + (lcg(seed) % 1000) / 1000.0f;
+                memcpy(&words[n][c], &v, sizeof(v));
+            }
+            else
+            {
+                // Q16 raw values, with the odd full-range jump
+                words[n][c] = (r >> 4) % 40 == 0 ? lcg(seed) * 2654435761UL : (uint32_t)(5046272 + c * 65536 + lcg(seed) % 2000);
+            }
+        }
+        if (!encoder.append(times[n], words[n]))
+        {
+            break;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT16(n, encoder.count());
+    TEST_ASSERT_EQUAL_UINT32(times[0], encoder.firstTime());
+    TEST_ASSERT_EQUAL_UINT32(times[n - 1], encoder.lastTime());
+    TEST_ASSERT_LESS_OR_EQUAL(BLOCK_BYTES, encoder.bytes());
+    return n;
+}
+
+static void roundTrip(uint8_t codec)
+{
+    for (uint32_t seed = 1; seed <= 20; seed++)
+    {
+        uint16_t n = encode(codec, seed);
+        TEST_ASSERT_GREATER_THAN(20, n);
+        SeriesDecoder<CHANNELS> decoder;
+        decoder.begin(block, sizeof(block), codec, n, times[0]);
+        uint32_t t, out[CHANNELS];
+        for (uint16_t i = 0; i < n; i++)
+        {
+            TEST_ASSERT_TRUE(decoder.next(t, out));
+            TEST_ASSERT_EQUAL_UINT32(times[i], t);
+            TEST_ASSERT_EQUAL_MEMORY(words[i], out, sizeof(out)); // Bit-exact, NaN included
+        }
+        TEST_ASSERT_FALSE(decoder.next(t, out));
+    }
+}
+
+void test_xor_round_trip(void)
+{
+    roundTrip(SERIES_CODEC_XOR);
+}
+
+void test_varint_round_trip(void)
+{
+    roundTrip(SERIES_CODEC_VARINT);
+}
+
+void test_truncated_block_stops(void)
+{
+    uint16_t n = encode(SERIES_CODEC_XOR, 3);
+    SeriesDecoder<CHANNELS> decoder;
+    decoder.begin(block, 100, SERIES_CODEC_XOR, n, times[0]);
+    uint32_t t, out[CHANNELS];
+    uint16_t decoded = 0;
+    while (decoder.next(t, out))
+    {
+        TEST_ASSERT_EQUAL_UINT32(times[decoded], t);
+        decoded++;
+    }
+    TEST_ASSERT_LESS_THAN(n, decoded);
+    TEST_ASSERT_FALSE(decoder.next(t, out));
+}
+
+void test_xor_window_past_32_bits_is_rejected(void)
+{
+    // First record verbatim, then timestamp '0' and a control '11' with leading 31, length 32
+    BitWriter writer;
+    uint8_t bad[64];
+    writer.begin(bad, sizeof(bad));
+    for (int c = 0; c < CHANNELS; c++)
+    {
+        writer.write(0x42000000, 32);
+    }
+    writer.write(0, 1);
+    writer.write(0x3, 2);
+    writer.write(31, 5);
+    writer.write(31, 5);
+    writer.write(0xFFFFFFFF, 32);
+
+    SeriesDecoder<CHANNELS> decoder;
+    decoder.begin(bad, sizeof(bad), SERIES_CODEC_XOR, 10, 0);
+    uint32_t t, out[CHANNELS];
+    TEST_ASSERT_TRUE(decoder.next(t, out));
+    TEST_ASSERT_EQUAL_HEX32(0x42000000, out[0]);
+    TEST_ASSERT_FALSE(decoder.next(t, out));
+    TEST_ASSERT_FALSE(decoder.next(t, out)); // Stays stopped, nothing after it is trusted
+}
+
+void test_random_corruption_is_contained(void)
+{
+    // Bit flips must never read outside the block or decode more records than the header says
+    uint32_t seed = 99;
+    for (int trial = 0; trial < 2000; trial++)
+    {
+        uint8_t codec = trial % 2 ? SERIES_CODEC_XOR : SERIES_CODEC_VARINT;
+        uint16_t n = encode(codec, trial + 1);
+        size_t bytes = 1 + lcg(seed) % BLOCK_BYTES;
+        for (int flips = 1 + lcg(seed) % 8; flips > 0; flips--)
+        {
+            block[lcg(seed) % bytes] ^= 1 << (lcg(seed) % 8);
+        }
+        SeriesDecoder<CHANNELS> decoder;
+        decoder.begin(block, bytes, codec, n, times[0]);
+        uint32_t t, out[CHANNELS];
+        uint16_t decoded = 0;
+        while (decoder.next(t, out))
+        {
+            decoded++;
+        }
+        TEST_ASSERT_LESS_OR_EQUAL(n, decoded);
+        TEST_ASSERT_FALSE(decoder.next(t, out));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_xor_round_trip);
+    RUN_TEST(test_varint_round_trip);
+    RUN_TEST(test_truncated_block_stops);
+    RUN_TEST(test_xor_window_past_32_bits_is_rejected);
+    RUN_TEST(test_random_corruption_is_contained);
+    return UNITY_END();
+}
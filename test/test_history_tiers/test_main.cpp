@@ -0,0 +1,200 @@
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <unity.h>
+#include <historyTiers.h>
+
+// The configuration from main.cpp: 1 s, 10 s, 1 min and 10 min, 144 buckets each
+#define CHANNELS 5 // temp1, temp2, power, k, u(k)
+typedef HistoryTiers<CHANNELS, 4, 144> History;
+static const uint32_t RESOLUTION_MS[4] = {1000, 10000, 60000, 600000};
+
+struct Raw
+{
+    uint32_t t;
+    float v[CHANNELS];
+};
+
+static History history;
+static std::vector<Raw> raw;
+
+void setUp(void) { history.begin(RESOLUTION_MS); }
+void tearDown(void) {}
+
+static std::vector<HistoryPoint<CHANNELS>> query(uint32_t from, uint32_t to, uint32_t points, int *tier = nullptr,
+                                                 uint32_t *bin = nullptr)
+{
+    std::vector<HistoryPoint<CHANNELS>> out;
+    int used = history.query(from, to, points, [&](const HistoryPoint<CHANNELS> &p) { out.push_back(p); }, bin);
+    if (tier)
+    {
+        *tier = used;
+    }
+    return out;
+}
+
+void test_empty_and_invalid_queries(void)
+{
+    TEST_ASSERT_EQUAL_INT(-1, history.query(0, 1000, 10, [](const HistoryPoint<CHANNELS> &) {}));
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, history.oldestMs(0));
+    const float v[CHANNELS] = {1, 2, 3, 4, 0.1f};
+    history.add(5000, v);
+    TEST_ASSERT_EQUAL_INT(-1, history.query(2000, 1000, 10, [](const HistoryPoint<CHANNELS> &) {}));
+    TEST_ASSERT_EQUAL_INT(-1, history.query(0, 1000, 0, [](const HistoryPoint<CHANNELS> &) {}));
+}
+
+void test_open_bucket_and_nan(void)
+{
+    // Three samples in one second, the middle one without k: all still in the bucket being filled
+    const float a[CHANNELS] = {10, 20, 30, 1, 0.1f};
+    const float b[CHANNELS] = {12, 18, 30, NAN, NAN};
+    const float c[CHANNELS] = {11, 19, 30, 3, 0.3f};
+    history.add(7100, a);
+    history.add(7400, b);
+    history.add(7900, c);
+    TEST_ASSERT_EQUAL_INT(1, history.size(0));
+    TEST_ASSERT_EQUAL_UINT32(7000, history.oldestMs(0));
+    TEST_ASSERT_EQUAL_UINT32(0, history.oldestMs(3));
+
+    int tier;
+    std::vector<HistoryPoint<CHANNELS>> out = query(7000, 7999, 1, &tier);
+    TEST_ASSERT_EQUAL_INT(0, tier);
+    TEST_ASSERT_EQUAL_UINT32(1, out.size());
+    TEST_ASSERT_EQUAL_UINT32(7000, out[0].tMs);
+    TEST_ASSERT_EQUAL_UINT32(3, out[0].count);
+    TEST_ASSERT_EQUAL_FLOAT(10, out[0].min[0]);
+    TEST_ASSERT_EQUAL_FLOAT(12, out[0].max[0]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 11, out[0].mean[0]);
+    TEST_ASSERT_EQUAL_FLOAT(1, out[0].min[3]);
+    TEST_ASSERT_EQUAL_FLOAT(3, out[0].max[3]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 2, out[0].mean[3]);
+    TEST_ASSERT_EQUAL_FLOAT(0.1f, out[0].min[4]); // u(k) next to k
+    TEST_ASSERT_EQUAL_FLOAT(0.3f, out[0].max[4]);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.2f, out[0].mean[4]);
+
+    // All NaN stays NaN
+    History single;
+    single.begin(RESOLUTION_MS);
+    const float none[CHANNELS] = {NAN, NAN, NAN, NAN, NAN};
+    single.add(0, none);
+    single.add(1500, none);
+    single.query(0, 2000, 2, [](const HistoryPoint<CHANNELS> &p) {
+        TEST_ASSERT_TRUE(isnan(p.min[0]) && isnan(p.max[0]) && isnan(p.mean[0]));
+    });
+}
+
+void test_ring_evicts_oldest_bucket(void)
+{
+    const float v[CHANNELS] = {0, 0, 0, 0, 0};
+    for (uint32_t t = 0; t < 200000; t += 1000)
+    {
+        history.add(t, v);
+    }
+    TEST_ASSERT_EQUAL_INT(145, history.size(0)); // 144 stored plus the open one
+    TEST_ASSERT_EQUAL_UINT32(55000, history.oldestMs(0));
+    TEST_ASSERT_EQUAL_INT(20, history.size(1));
+    TEST_ASSERT_EQUAL_UINT32(200, history.samples());
+
+    // Older than tier 0 reaches: served from tier 1
+    int tier;
+    uint32_t bin;
+    query(10000, 199000, 1000, &tier, &bin);
+    TEST_ASSERT_EQUAL_INT(1, tier);
+    TEST_ASSERT_EQUAL_UINT32(10000, bin);
+    query(60000, 199000, 1000, &tier, &bin);
+    TEST_ASSERT_EQUAL_INT(0, tier);
+    TEST_ASSERT_EQUAL_UINT32(1000, bin);
+}
+
+void test_matches_brute_force(void)
+{
+    // 25 h at irregular 0.5-5 s intervals, a cooling curve with noise and the odd missing k
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> noise(-0.05f, 0.05f);
+    raw.clear();
+    uint32_t t = 12345;
+    while (t < 25u * 3600 * 1000)
+    {
+        Raw r;
+        r.t = t;
+        float x = t / 3.6e6f;
+        r.v[0] = 300 - 200 * (1 - expf(-x)) + noise(rng);
+        r.v[1] = r.v[0] - 1 + noise(rng);
+        r.v[2] = 50 + noise(rng);
+        r.v[3] = rng() % 50 == 0 ? NAN : 0.3f + noise(rng);
+        r.v[4] = isnan(r.v[3]) ? NAN : 0.01f + 0.1f * fabsf(noise(rng)); // u(k) exists with k
+        history.add(r.t, r.v);
+        raw.push_back(r);
+        t += 500 + rng() % 4500;
+    }
+    TEST_ASSERT_EQUAL_UINT32(raw.size(), history.samples());
+    TEST_ASSERT_TRUE(t - history.oldestMs(3) >= 24u * 3600 * 1000); // 24 h at the coarsest tier
+
+    std::uniform_int_distribution<uint32_t> pick(0, 24u * 3600 * 1000);
+    int checked = 0;
+    for (int q = 0; q < 200; q++)
+    {
+        uint32_t to = t - pick(rng) % (4 * 3600 * 1000);
+        uint32_t span = 1000 + pick(rng);
+        uint32_t from = span < to ? to - span : 0;
+        uint32_t points = 10 + rng() % 1000, bin = 0;
+        int tier;
+        std::vector<HistoryPoint<CHANNELS>> out = query(from, to, points, &tier, &bin);
+        TEST_ASSERT_GREATER_OR_EQUAL(0, tier);
+        TEST_ASSERT_LESS_OR_EQUAL_UINT32(points, out.size());
+        TEST_ASSERT_EQUAL_UINT32(0, bin % history.resolutionMs(tier));
+
+        // Interior points only: the first and last bins may be cut by the range
+        for (size_t i = 1; i + 1 < out.size(); i++)
+        {
+            const HistoryPoint<CHANNELS> &p = out[i];
+            TEST_ASSERT_TRUE(p.tMs > out[i - 1].tMs);
+            TEST_ASSERT_EQUAL_UINT32(0, p.tMs % bin);
+
+            uint32_t n = 0;
+            float mn[CHANNELS], mx[CHANNELS];
+            double sum[CHANNELS] = {};
+            int valid[CHANNELS] = {};
+            std::fill(mn, mn + CHANNELS, NAN);
+            std::fill(mx, mx + CHANNELS, NAN);
+            auto first = std::lower_bound(raw.begin(), raw.end(), p.tMs, [](const Raw &r, uint32_t ms) { return r.t < ms; });
+            for (auto r = first; r != raw.end() && r->t < p.tMs + bin; ++r)
+            {
+                n++;
+                for (int c = 0; c < CHANNELS; c++)
+                {
+                    if (!isnan(r->v[c]))
+                    {
+                        mn[c] = fminf(mn[c], r->v[c]);
+                        mx[c] = fmaxf(mx[c], r->v[c]);
+                        sum[c] += r->v[c];
+                        valid[c]++;
+                    }
+                }
+            }
+            TEST_ASSERT_EQUAL_UINT32(n, p.count);
+            for (int c = 0; c < CHANNELS; c++)
+            {
+                TEST_ASSERT_EQUAL_FLOAT(mn[c], p.min[c]);
+                TEST_ASSERT_EQUAL_FLOAT(mx[c], p.max[c]);
+                // Bucket means are weighted by bucket count, missing k readings shift the weights slightly
+                double mean = sum[c] / valid[c];
+                TEST_ASSERT_DOUBLE_WITHIN((c >= 3 ? 2e-3 : 1e-3) * fabs(mean) + 1e-3, mean, p.mean[c]);
+            }
+            checked++;
+        }
+    }
+    TEST_ASSERT_GREATER_THAN(1000, checked);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_and_invalid_queries);
+    RUN_TEST(test_open_bucket_and_nan);
+    RUN_TEST(test_ring_evicts_oldest_bucket);
+    RUN_TEST(test_matches_brute_force);
+    return UNITY_END();
+}
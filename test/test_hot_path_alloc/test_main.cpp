@@ -0,0 +1,331 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <math.h>
+#include <atomic>
+#include <new>
+#include <thread>
+#include <unity.h>
+#include <spscQueue.h>
+#include <samplePool.h>
+#include <sinkDispatcher.h>
+#include <historyTiers.h>
+#include <adaptiveRate.h>
+
+// Every heap allocation of the process is counted: operator new always, malloc and
+// friends too on glibc (forwarded to glibc's own allocator). Sanitizers bring their own
+// malloc, so under them only operator new is counted.
+static std::atomic<uint32_t> heapAllocations{0};
+
+#if defined(__GLIBC__) && !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+#define COUNT_MALLOC 1
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t count, size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+extern "C" void *__libc_memalign(size_t alignment, size_t size);
+extern "C" void __libc_free(void *p);
+
+extern "C" void *malloc(size_t size)
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t count, size_t size)
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+extern "C" void *realloc(void *p, size_t size)
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(p, size);
+}
+
+extern "C" int posix_memalign(void **out, size_t alignment, size_t size)
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    *out = __libc_memalign(alignment, size);
+    return *out ? 0 : ENOMEM;
+}
+
+extern "C" void *aligned_alloc(size_t alignment, size_t size)
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_memalign(alignment, size);
+}
+
+extern "C" void free(void *p) { __libc_free(p); }
+#else
+#define COUNT_MALLOC 0
+#endif
+
+void *operator new(size_t size)
+{
+    heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    void *p = malloc(size ? size : 1);
+    if (!p)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+// The firmware's types and sizes (main.cpp)
+struct Sample
+{
+    uint32_t timestamp_ms;
+    float temp1;
+    float temp2;
+    float dT;
+    float busVoltage;
+    float current_mA;
+    float power_mW;
+    float thermalConductivity;
+    float thermalConductivityUnc;
+};
+
+// Spinlock like the firmware's CriticalSection
+struct SpinLock
+{
+    std::atomic_flag flag = ATOMIC_FLAG_INIT;
+    void lock()
+    {
+        while (flag.test_and_set(std::memory_order_acquire))
+        {
+        }
+    }
+    void unlock() { flag.clear(std::memory_order_release); }
+};
+
+#define RING_SIZE 16
+#define POOL_SIZE 32
+#define SINK_DEPTH 4
+#define ARCHIVE_SPOOL 64
+enum
+{
+    SINK_TELEMETRY,
+    SINK_ARCHIVE,
+    SINK_SHEETS,
+    SINK_COUNT
+};
+#define CHANNELS 5
+
+typedef SinkDispatcher<Sample, POOL_SIZE, SpinLock, SINK_COUNT, SINK_DEPTH> Dispatcher;
+static const uint32_t RESOLUTION_MS[4] = {1000, 10000, 60000, 600000};
+
+// All of it static, as in the firmware
+static BlockPool<Sample, POOL_SIZE> pool;
+static SpscQueue<BlockHandle, RING_SIZE> ring;
+static Dispatcher sinks;
+static Dispatcher::SpoolEntry archiveSpool[ARCHIVE_SPOOL];
+static HistoryTiers<CHANNELS, 4, 144> history;
+static AdaptiveRate rate;
+static DeadbandLogger logger;
+static BlockHandle latest = INVALID_BLOCK;
+
+static void noWait(uint32_t) {}
+
+void setUp(void)
+{
+    sinks.begin(&pool, noWait);
+    sinks.addSink(SINK_TELEMETRY, "telemetry", SINK_DROP_OLDEST, 0);
+    sinks.addSink(SINK_ARCHIVE, "archive", SINK_SPOOL, 0, 0, archiveSpool, ARCHIVE_SPOOL);
+    sinks.addSink(SINK_SHEETS, "sheets", SINK_DROP_OLDEST, 5000);
+    history.begin(RESOLUTION_MS);
+    rate.begin(500, 5000, 0.003f, 2.0f, 1.25f, 10000);
+    logger.begin(0.05f, 1.0f, 0.01f, 5000, 300000);
+}
+
+void tearDown(void)
+{
+    for (int i = 0; i < SINK_COUNT; i++)
+    {
+        sinks.clear(i);
+    }
+    BlockHandle h;
+    while (ring.pop(h))
+    {
+        pool.release(h);
+    }
+    pool.release(latest);
+    latest = INVALID_BLOCK;
+}
+
+// Acquisition side: fill a block once and hand it over, never blocks
+static void acquire(uint32_t t)
+{
+    float dT = 1.0f + 0.1f * sinf(t * 1e-4f);
+    float power = t % 600000 < 300000 ? 50 : 60;
+    rate.update(t, dT, power);
+    BlockHandle h = pool.alloc();
+    if (h == INVALID_BLOCK)
+    {
+        return;
+    }
+    Sample &s = pool[h];
+    s.timestamp_ms = t;
+    s.temp1 = 80 + dT;
+    s.temp2 = 80;
+    s.dT = dT;
+    s.busVoltage = 5;
+    s.current_mA = power / 5;
+    s.power_mW = power;
+    s.thermalConductivity = 0.3f;
+    s.thermalConductivityUnc = 0.01f;
+    if (!ring.push(h))
+    {
+        pool.release(h);
+    }
+}
+
+// NetTask side: publish to the sinks, add to the history, keep the newest
+static int distribute(uint32_t now)
+{
+    int count = 0;
+    BlockHandle h;
+    while (ring.pop(h))
+    {
+        const Sample &s = pool[h];
+        uint32_t mask = SINK_MASK(SINK_TELEMETRY) | SINK_MASK(SINK_ARCHIVE);
+        if (logger.shouldLog(s.timestamp_ms, s.dT, s.power_mW, s.thermalConductivity))
+        {
+            mask |= SINK_MASK(SINK_SHEETS);
+        }
+        sinks.publish(h, now, mask);
+        const float values[CHANNELS] = {s.temp1, s.temp2, s.power_mW, s.thermalConductivity, s.thermalConductivityUnc};
+        history.add(s.timestamp_ms, values);
+        pool.release(latest);
+        latest = h;
+        count++;
+    }
+    return count;
+}
+
+// Sink workers; the archive one can be held back to make its spool fill
+static void drain(uint32_t now, bool archiveStuck)
+{
+    Sample out;
+    for (int i = 0; i < SINK_COUNT; i++)
+    {
+        while ((i != SINK_ARCHIVE || !archiveStuck) && sinks.take(i, out, now))
+        {
+        }
+    }
+}
+
+static void test_steady_samples_do_not_allocate(void)
+{
+    // Warm-up, so one-time initialisation is not counted
+    for (uint32_t t = 0; t < 100000; t += 500)
+    {
+        acquire(t);
+        distribute(t);
+        drain(t, false);
+    }
+
+    uint32_t before = heapAllocations.load();
+    int samples = 0;
+    for (uint32_t t = 100000; t < 100000 + 20000 * 500; t += 500)
+    {
+        acquire(t);
+        samples += distribute(t);
+        drain(t, false);
+    }
+    uint32_t after = heapAllocations.load();
+    TEST_ASSERT_EQUAL_INT(20000, samples);
+    TEST_ASSERT_EQUAL_UINT32(0, after - before);
+    TEST_ASSERT_EQUAL_UINT32(1, pool.inUse()); // Only latest
+}
+
+// Overflow paths: a burst overruns the ring, stuck sinks drop oldest and spool
+static void test_overflow_paths_do_not_allocate(void)
+{
+    uint32_t before = heapAllocations.load();
+    uint32_t t = 0;
+    for (int round = 0; round < 200; round++)
+    {
+        for (int i = 0; i < RING_SIZE + 4; i++, t += 100)
+        {
+            acquire(t); // Ring full: released again
+        }
+        distribute(t);
+        drain(t, round % 4 != 3); // The archive spools for three rounds, then drains
+    }
+    uint32_t after = heapAllocations.load();
+    TEST_ASSERT_EQUAL_UINT32(0, after - before);
+    TEST_ASSERT_TRUE(ring.drops() > 0);
+    TEST_ASSERT_TRUE(sinks.stats(SINK_ARCHIVE).spooled > 0);
+    TEST_ASSERT_TRUE(sinks.stats(SINK_TELEMETRY).delivered > 0);
+}
+
+// The same across cores: acquisition on its own thread, started before counting
+#define THREADED_SAMPLES 50000
+static void test_two_threads_do_not_allocate(void)
+{
+    std::atomic<bool> go{false}, done{false};
+    std::atomic<uint32_t> produced{0};
+    std::thread producer([&] {
+        while (!go.load())
+        {
+        }
+        for (uint32_t t = 0; t < THREADED_SAMPLES; t++)
+        {
+            while (ring.size() >= RING_SIZE - 1)
+            {
+                std::this_thread::yield();
+            }
+            acquire(t * 10);
+            produced.fetch_add(1);
+        }
+        done.store(true);
+    });
+
+    uint32_t dropsBefore = ring.drops();
+    uint32_t before = heapAllocations.load();
+    go.store(true);
+    uint32_t consumed = 0, t = 0;
+    while (!done.load() || ring.size() > 0)
+    {
+        consumed += distribute(t);
+        drain(t, false);
+        t += 10;
+    }
+    uint32_t after = heapAllocations.load();
+    producer.join();
+    TEST_ASSERT_EQUAL_UINT32(0, after - before);
+    TEST_ASSERT_EQUAL_UINT32(THREADED_SAMPLES, produced.load());
+    TEST_ASSERT_EQUAL_UINT32(THREADED_SAMPLES - (ring.drops() - dropsBefore), consumed);
+}
+
+// The counter itself works, or a zero above would prove nothing
+static void test_counter_sees_allocations(void)
+{
+    uint32_t before = heapAllocations.load();
+    int *volatile p = new int(1); // volatile: a new/delete pair may be elided
+    delete p;
+#if COUNT_MALLOC
+    void *volatile m = malloc(16);
+    free(m);
+    TEST_ASSERT_EQUAL_UINT32(3, heapAllocations.load() - before); // new counts its malloc too
+#else
+    TEST_ASSERT_EQUAL_UINT32(1, heapAllocations.load() - before);
+#endif
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_counter_sees_allocations);
+    RUN_TEST(test_steady_samples_do_not_allocate);
+    RUN_TEST(test_overflow_paths_do_not_allocate);
+    RUN_TEST(test_two_threads_do_not_allocate);
+    return UNITY_END();
+}
@@ -0,0 +1,255 @@
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <unity.h>
+#include <httpFlow.h>
+
+// In-memory socket: connects after openPolls calls, accepts sendChunk bytes per call and
+// serves the scripted response recvChunk bytes at a time, then closes (or stalls)
+struct FakeTransport
+{
+    static int openPolls;
+    static int openResult;
+    static size_t sendChunk;
+    static size_t recvChunk;
+    static const char *response;
+    static bool closeAtEnd;
+    static int closes;
+
+    int open(const char *host, uint16_t port, bool tls)
+    {
+        lastHost = host;
+        lastPort = port;
+        lastTls = tls;
+        return ++opens < openPolls ? 0 : openResult;
+    }
+
+    int send(const uint8_t *data, size_t length)
+    {
+        size_t n = length < sendChunk ? length : sendChunk;
+        sent.append((const char *)data, n);
+        return (int)n;
+    }
+
+    int recv(uint8_t *data, size_t length)
+    {
+        size_t left = strlen(response) - position;
+        if (left == 0)
+        {
+            return closeAtEnd ? -2 : 0;
+        }
+        size_t n = left < recvChunk ? left : recvChunk;
+        n = n < length ? n : length;
+        memcpy(data, response + position, n);
+        position += n;
+        return (int)n;
+    }
+
+    void close() { closes++; }
+
+    int opens = 0;
+    size_t position = 0;
+    std::string sent;
+    std::string lastHost;
+    uint16_t lastPort = 0;
+    bool lastTls = false;
+};
+
+int FakeTransport::openPolls;
+int FakeTransport::openResult;
+size_t FakeTransport::sendChunk;
+size_t FakeTransport::recvChunk;
+const char *FakeTransport::response;
+bool FakeTransport::closeAtEnd;
+int FakeTransport::closes;
+
+void setUp(void)
+{
+    FakeTransport::openPolls = 1;
+    FakeTransport::openResult = 1;
+    FakeTransport::sendChunk = 1000;
+    FakeTransport::recvChunk = 1000;
+    FakeTransport::response = "";
+    FakeTransport::closeAtEnd = true;
+    FakeTransport::closes = 0;
+}
+
+void tearDown(void) {}
+
+static HttpFlowState run(HttpFlow<FakeTransport> &flow, uint32_t &now, int maxSteps = 10000)
+{
+    while (flow.step(now) && maxSteps-- > 0)
+    {
+        now += 10;
+    }
+    return flow.state();
+}
+
+void test_parse_url(void)
+{
+    char host[HTTP_HOST_MAX];
+    uint16_t port;
+    bool tls;
+    const char *path;
+    TEST_ASSERT_TRUE(httpParseUrl("https://script.google.com/macros/s/x/exec", host, sizeof(host), port, tls, path));
+    TEST_ASSERT_EQUAL_STRING("script.google.com", host);
+    TEST_ASSERT_EQUAL_UINT16(443, port);
+    TEST_ASSERT_TRUE(tls);
+    TEST_ASSERT_EQUAL_STRING("/macros/s/x/exec", path);
+    TEST_ASSERT_TRUE(httpParseUrl("http://10.10.11.1:8090", host, sizeof(host), port, tls, path));
+    TEST_ASSERT_EQUAL_STRING("10.10.11.1", host);
+    TEST_ASSERT_EQUAL_UINT16(8090, port);
+    TEST_ASSERT_FALSE(tls);
+    TEST_ASSERT_EQUAL_STRING("/", path);
+    TEST_ASSERT_FALSE(httpParseUrl("ftp://host/", host, sizeof(host), port, tls, path));
+    TEST_ASSERT_FALSE(httpParseUrl("http:///path", host, sizeof(host), port, tls, path));
+    TEST_ASSERT_FALSE(httpParseUrl("http://host:0/", host, sizeof(host), port, tls, path));
+}
+
+void test_post_with_content_length_in_small_chunks(void)
+{
+    FakeTransport::openPolls = 3;
+    FakeTransport::sendChunk = 7;
+    FakeTransport::recvChunk = 5;
+    FakeTransport::response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\ncontent-length: 11\r\n\r\nhello world";
+    FakeTransport::closeAtEnd = false; // Done on the length, not on the close
+    static HttpFlow<FakeTransport> flow;
+    uint32_t now = 1000;
+    TEST_ASSERT_TRUE(flow.begin("http://10.0.0.2:8090/log", "POST", "application/json", "{\"k\":1}", now, 5000));
+    TEST_ASSERT_EQUAL(HTTP_DONE, run(flow, now));
+    TEST_ASSERT_EQUAL_INT(200, flow.status());
+    TEST_ASSERT_EQUAL_UINT32(11, flow.bodyBytes());
+    TEST_ASSERT_EQUAL_STRING("POST /log HTTP/1.1\r\nHost: 10.0.0.2\r\nUser-Agent: cryo-esp32\r\nConnection: close\r\n"
+                             "Content-Type: application/json\r\nContent-Length: 7\r\n\r\n{\"k\":1}",
+                             flow.transport().sent.c_str());
+    TEST_ASSERT_EQUAL_UINT16(8090, flow.transport().lastPort);
+    TEST_ASSERT_GREATER_THAN(0, flow.elapsedMs());
+}
+
+void test_redirect_completes_without_body(void)
+{
+    FakeTransport::response = "HTTP/1.1 302 Moved Temporarily\r\nLocation: https://x/\r\n\r\n<html>";
+    FakeTransport::closeAtEnd = false;
+    static HttpFlow<FakeTransport> flow;
+    uint32_t now = 0;
+    flow.begin("https://script.google.com/exec", "POST", "application/json", "{}", now, 5000);
+    TEST_ASSERT_EQUAL(HTTP_DONE, run(flow, now));
+    TEST_ASSERT_EQUAL_INT(302, flow.status());
+    TEST_ASSERT_TRUE(flow.transport().lastTls);
+}
+
+void test_marker_found_across_chunks(void)
+{
+    FakeTransport::recvChunk = 3;
+    FakeTransport::response = "HTTP/1.1 200 OK\r\n\r\n<html>...login success...</html>";
+    FakeTransport::closeAtEnd = false;
+    static HttpFlow<FakeTransport> flow;
+    uint32_t now = 0;
+    flow.begin("http://10.10.11.1:8090/httpclient.html", "POST", "application/x-www-form-urlencoded", "a=b", now, 5000, "success");
+    TEST_ASSERT_EQUAL(HTTP_DONE, run(flow, now));
+    TEST_ASSERT_TRUE(flow.found());
+    TEST_ASSERT_LESS_THAN(strlen("<html>...login success...</html>"), flow.bodyBytes()); // Stopped early
+}
+
+void test_marker_missing_until_close(void)
+{
+    FakeTransport::response = "HTTP/1.1 200 OK\r\n\r\nlogin failed";
+    static HttpFlow<FakeTransport> flow;
+    uint32_t now = 0;
+    flow.begin("http://10.10.11.1:8090/", "POST", "text/plain", "a", now, 5000, "success");
+    TEST_ASSERT_EQUAL(HTTP_DONE, run(flow, now)); // Body ends with the connection
+    TEST_ASSERT_FALSE(flow.found());
+}
+
+void test_close_before_headers_fails(void)
+{
+    FakeTransport::response = "HTTP/1.1 200 OK\r\nContent-Le";
+    static HttpFlow<FakeTransport> flow;
+    uint32_t now = 0;
+    flow.begin("http://h/", "GET", nullptr, nullptr, now, 5000);
+    TEST_ASSERT_EQUAL(HTTP_FAILED, run(flow, now));
+}
+
+void test_malformed_status_fails(void)
+{
+    FakeTransport::response = "garbage\r\n\r\n";
+    static HttpFlow<FakeTransport> flow;
+    uint32_t now = 0;
+    flow.begin("http://h/", "GET", nullptr, nullptr, now, 5000);
+    TEST_ASSERT_EQUAL(HTTP_FAILED, run(flow, now));
+}
+
+void test_stalled_connect_times_out_and_closes(void)
+{
+    FakeTransport::openPolls = 1000000;
+    static HttpFlow<FakeTransport> flow;
+    uint32_t now = 0xFFFFFF00UL; // Deadline across the millis() wrap
+    flow.begin("http://10.10.11.1:8090/", "GET", nullptr, nullptr, now, 300);
+    TEST_ASSERT_EQUAL(HTTP_TIMEOUT, run(flow, now));
+    TEST_ASSERT_EQUAL_UINT32(300, flow.elapsedMs());
+    TEST_ASSERT_GREATER_THAN(0, FakeTransport::closes);
+}
+
+void test_request_too_large_is_rejected(void)
+{
+    static char body[HTTP_REQUEST_MAX];
+    memset(body, 'x', sizeof(body) - 1);
+    body[sizeof(body) - 1] = '\0';
+    static HttpFlow<FakeTransport> flow;
+    TEST_ASSERT_FALSE(flow.begin("http://h/", "POST", "text/plain", body, 0, 1000));
+    TEST_ASSERT_EQUAL(HTTP_FAILED, flow.state());
+    TEST_ASSERT_FALSE(flow.step(0));
+}
+
+static int completions;
+static uint32_t completedTags;
+static HttpFlowState completedStates[8];
+
+static void done(int slot, const HttpFlow<FakeTransport> &flow, uint32_t tag)
+{
+    completions++;
+    completedTags |= 1UL << tag;
+    completedStates[tag] = flow.state();
+}
+
+void test_executor_slots_and_cancel(void)
+{
+    FakeTransport::openPolls = 1000000; // Nothing connects
+    static HttpExecutor<FakeTransport, 3> executor;
+    completions = 0;
+    completedTags = 0;
+    TEST_ASSERT_EQUAL_INT(0, executor.start("http://a/", "GET", nullptr, nullptr, 0, 10000, 1));
+    TEST_ASSERT_EQUAL_INT(1, executor.start("ftp://bad/", "GET", nullptr, nullptr, 0, 10000, 2));
+    TEST_ASSERT_EQUAL_INT(2, executor.start("http://c/", "GET", nullptr, nullptr, 0, 10000, 3));
+    TEST_ASSERT_TRUE(executor.full());
+    TEST_ASSERT_EQUAL_INT(-1, executor.start("http://d/", "GET", nullptr, nullptr, 0, 10000, 4));
+    TEST_ASSERT_EQUAL_UINT32(2, executor.started());
+
+    executor.poll(10, done); // The invalid request is reported as failed
+    TEST_ASSERT_EQUAL_INT(1, completions);
+    TEST_ASSERT_EQUAL(HTTP_FAILED, completedStates[2]);
+    TEST_ASSERT_EQUAL_INT(2, executor.active());
+
+    executor.cancelAll(20, done);
+    TEST_ASSERT_EQUAL_INT(3, completions);
+    TEST_ASSERT_EQUAL_UINT32((1UL << 1) | (1UL << 2) | (1UL << 3), completedTags);
+    TEST_ASSERT_EQUAL(HTTP_CANCELLED, completedStates[1]);
+    TEST_ASSERT_EQUAL(HTTP_CANCELLED, completedStates[3]);
+    TEST_ASSERT_EQUAL_INT(0, executor.active());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_parse_url);
+    RUN_TEST(test_post_with_content_length_in_small_chunks);
+    RUN_TEST(test_redirect_completes_without_body);
+    RUN_TEST(test_marker_found_across_chunks);
+    RUN_TEST(test_marker_missing_until_close);
+    RUN_TEST(test_close_before_headers_fails);
+    RUN_TEST(test_malformed_status_fails);
+    RUN_TEST(test_stalled_connect_times_out_and_closes);
+    RUN_TEST(test_request_too_large_is_rejected);
+    RUN_TEST(test_executor_slots_and_cancel);
+    return UNITY_END();
+}
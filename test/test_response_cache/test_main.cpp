@@ -0,0 +1,190 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unity.h>
+#include <responseCache.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#define CLIENTS 8
+#define VERSIONS 25
+#define POLLS_PER_VERSION 4
+
+// handleGetData() without the web server: rebuild when the data moved on, then a 304
+// when the client's tag matches, else the body. Returns true for a full response.
+static bool serve(ResponseCache<256> &cache, uint32_t &builtFor, uint32_t dataVersion, char *clientTag, size_t tagSize)
+{
+    if (!cache.valid() || builtFor != dataVersion)
+    {
+        int length = snprintf(cache.buffer(), cache.capacity(), "{\"v\":%u}", (unsigned)dataVersion);
+        cache.commit(length > 0 ? (size_t)length : 0);
+        builtFor = dataVersion;
+    }
+    bool notModified = cache.notModified(clientTag);
+    cache.served(notModified);
+    if (!notModified)
+    {
+        snprintf(clientTag, tagSize, "%s", cache.etag());
+    }
+    return !notModified;
+}
+
+// One build per version however many clients poll; each client gets every version once
+static void test_polling_clients_across_versions(void)
+{
+    ResponseCache<256> cache;
+    cache.begin(0xC0FFEE);
+    uint32_t builtFor = 0;
+    char tags[CLIENTS][24] = {};
+    uint32_t fullPerClient[CLIENTS] = {};
+
+    for (uint32_t v = 1; v <= VERSIONS; v++)
+    {
+        for (int poll = 0; poll < POLLS_PER_VERSION; poll++)
+        {
+            for (int c = 0; c < CLIENTS; c++)
+            {
+                if (serve(cache, builtFor, v, tags[c], sizeof(tags[c])))
+                {
+                    fullPerClient[c]++;
+                    char expected[16];
+                    snprintf(expected, sizeof(expected), "{\"v\":%u}", (unsigned)v);
+                    TEST_ASSERT_EQUAL_STRING(expected, cache.data());
+                }
+            }
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(VERSIONS, cache.builds());
+    TEST_ASSERT_EQUAL_UINT32(VERSIONS, cache.version());
+    TEST_ASSERT_EQUAL_UINT32(CLIENTS * VERSIONS, cache.fullResponses());
+    TEST_ASSERT_EQUAL_UINT32(CLIENTS * VERSIONS * (POLLS_PER_VERSION - 1), cache.notModifiedResponses());
+    for (int c = 0; c < CLIENTS; c++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(VERSIONS, fullPerClient[c]);
+        TEST_ASSERT_EQUAL_STRING(cache.etag(), tags[c]);
+    }
+}
+
+// A client that skips versions gets the newest body once, then 304s
+static void test_slow_client_skips_versions(void)
+{
+    ResponseCache<256> cache;
+    cache.begin(1);
+    uint32_t builtFor = 0;
+    char fast[24] = "", slow[24] = "";
+    for (uint32_t v = 1; v <= 10; v++)
+    {
+        serve(cache, builtFor, v, fast, sizeof(fast));
+    }
+    TEST_ASSERT_TRUE(serve(cache, builtFor, 10, slow, sizeof(slow)));
+    TEST_ASSERT_FALSE(serve(cache, builtFor, 10, slow, sizeof(slow)));
+    TEST_ASSERT_EQUAL_UINT32(10, cache.builds());
+}
+
+static void test_etag_format(void)
+{
+    ResponseCache<64> cache;
+    cache.begin(0xABCDEF12);
+    TEST_ASSERT_FALSE(cache.valid());
+    TEST_ASSERT_EQUAL_STRING("", cache.etag());
+    cache.commit(snprintf(cache.buffer(), cache.capacity(), "x"));
+    TEST_ASSERT_EQUAL_STRING("\"abcdef12-1\"", cache.etag());
+    for (int i = 0; i < 15; i++)
+    {
+        cache.commit(1);
+    }
+    TEST_ASSERT_EQUAL_STRING("\"abcdef12-10\"", cache.etag());
+}
+
+static void test_not_modified_parsing(void)
+{
+    ResponseCache<64> cache;
+    cache.begin(0x1234);
+    TEST_ASSERT_FALSE(cache.notModified("*")); // Nothing built yet
+    cache.commit(snprintf(cache.buffer(), cache.capacity(), "{}"));
+    const char *tag = cache.etag(); // "00001234-1"
+
+    TEST_ASSERT_TRUE(cache.notModified(tag));
+    TEST_ASSERT_TRUE(cache.notModified("*"));
+    TEST_ASSERT_TRUE(cache.notModified("W/\"00001234-1\""));
+    TEST_ASSERT_TRUE(cache.notModified("\"old\", \"00001234-1\""));
+    TEST_ASSERT_TRUE(cache.notModified("\"a\",W/\"b\",W/\"00001234-1\""));
+    TEST_ASSERT_TRUE(cache.notModified("  \"00001234-1\"  "));
+
+    TEST_ASSERT_FALSE(cache.notModified(nullptr));
+    TEST_ASSERT_FALSE(cache.notModified(""));
+    TEST_ASSERT_FALSE(cache.notModified(" , ,"));
+    TEST_ASSERT_FALSE(cache.notModified("00001234-1"));      // Unquoted
+    TEST_ASSERT_FALSE(cache.notModified("\"00001234-1"));    // Unterminated
+    TEST_ASSERT_FALSE(cache.notModified("\"00001234-10\"")); // Longer, shares the prefix
+    TEST_ASSERT_FALSE(cache.notModified("\"00001234-\""));
+    TEST_ASSERT_FALSE(cache.notModified("w/\"00001234-1\"")); // Weak prefix is case sensitive
+    TEST_ASSERT_FALSE(cache.notModified("\"a\", \"b\""));
+}
+
+// Same version after a reboot, but a tag from the previous boot must not match
+static void test_stale_boot_id(void)
+{
+    ResponseCache<64> before, after;
+    before.begin(0x11111111);
+    after.begin(0x22222222);
+    before.commit(snprintf(before.buffer(), before.capacity(), "{\"v\":1}"));
+    after.commit(snprintf(after.buffer(), after.capacity(), "{\"v\":1}"));
+    TEST_ASSERT_EQUAL_UINT32(before.version(), after.version());
+    TEST_ASSERT_FALSE(after.notModified(before.etag()));
+    TEST_ASSERT_TRUE(after.notModified(after.etag()));
+
+    // begin() again forgets the built version
+    after.begin(0x33333333);
+    TEST_ASSERT_FALSE(after.valid());
+    TEST_ASSERT_FALSE(after.notModified("*"));
+}
+
+// Writes like snprintf into the cache: at most Capacity − 1 chars, returns the full length
+template <size_t Capacity>
+static size_t fill(ResponseCache<Capacity> &cache, const char *text)
+{
+    size_t length = strlen(text);
+    size_t copied = length < Capacity ? length : Capacity - 1;
+    memcpy(cache.buffer(), text, copied);
+    cache.buffer()[copied] = '\0';
+    return length;
+}
+
+// A body that did not fit is cut to Capacity − 1 and stays terminated
+static void test_commit_truncation(void)
+{
+    ResponseCache<16> cache;
+    cache.begin(7);
+
+    cache.commit(fill(cache, "0123456789abcde")); // 15, fits
+    TEST_ASSERT_EQUAL_UINT32(15, cache.length());
+    TEST_ASSERT_EQUAL_STRING("0123456789abcde", cache.data());
+
+    cache.commit(fill(cache, "0123456789abcdef")); // 16, == Capacity
+    TEST_ASSERT_EQUAL_UINT32(15, cache.length());
+    TEST_ASSERT_EQUAL_STRING("0123456789abcde", cache.data());
+
+    cache.commit(fill(cache, "0123456789abcdefghijklmnop"));
+    TEST_ASSERT_EQUAL_UINT32(15, cache.length());
+    TEST_ASSERT_EQUAL_UINT32(15, strlen(cache.data()));
+
+    cache.commit(0); // A failed snprintf commits an empty body
+    TEST_ASSERT_EQUAL_UINT32(0, cache.length());
+    TEST_ASSERT_EQUAL_STRING("", cache.data());
+    TEST_ASSERT_EQUAL_UINT32(4, cache.builds());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_polling_clients_across_versions);
+    RUN_TEST(test_slow_client_skips_versions);
+    RUN_TEST(test_etag_format);
+    RUN_TEST(test_not_modified_parsing);
+    RUN_TEST(test_stale_boot_id);
+    RUN_TEST(test_commit_truncation);
+    return UNITY_END();
+}
@@ -0,0 +1,164 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <type_traits>
+#include <unity.h>
+#include <runCheckpoint.h>
+#include <forecast.h>
+#include <uncertainty.h>
+
+// A cut-down RunState_t: plain values plus the filter objects that are checkpointed whole
+struct State
+{
+    uint32_t runClockMs;
+    float window[5];
+    int index;
+    uint16_t heaterLevel;
+    bool mosfetOn;
+    bool interlockTripped;
+    char archiveRun[25];
+    RollingCovariance stats;
+    SteadyStateForecast forecast;
+};
+
+static_assert(std::is_trivially_default_constructible<RunCheckpoint<State>>::value, "Must not wipe RTC memory at boot");
+
+#define LAYOUT 1
+
+alignas(8) static unsigned char rtc[sizeof(RunCheckpoint<State>)]; // RTC_NOINIT stand-in
+static RunCheckpoint<State> *checkpoint = reinterpret_cast<RunCheckpoint<State> *>(rtc);
+static State live;
+
+void setUp(void)
+{
+    live = State();
+    live.stats.reset();
+    live.forecast.begin(0.995);
+    strcpy(live.archiveRun, "sampleA");
+    live.heaterLevel = 40000;
+    live.mosfetOn = true;
+}
+
+void tearDown(void) {}
+
+static void advance(int step)
+{
+    live.runClockMs = step * 1000;
+    live.window[step % 5] = 80 + step * 1e-3f;
+    live.index = step % 5;
+    live.stats.push(1500 + step % 7, 1.0f + step * 1e-4f);
+    live.forecast.update(step, 1.0 - exp(-step / 300.0));
+}
+
+void test_power_on_garbage_is_not_restored(void)
+{
+    State state;
+    memset(rtc, 0xA5, sizeof(rtc));
+    TEST_ASSERT_FALSE(checkpoint->restore(state, LAYOUT));
+    srand(3);
+    for (int trial = 0; trial < 100; trial++)
+    {
+        for (size_t i = 0; i < sizeof(rtc); i++)
+        {
+            rtc[i] = rand();
+        }
+        TEST_ASSERT_FALSE(checkpoint->restore(state, LAYOUT));
+        TEST_ASSERT_EQUAL_UINT32(0, checkpoint->sequence(LAYOUT));
+    }
+}
+
+void test_reset_during_save_restores_new_or_previous(void)
+{
+    // A reset at a random byte of every 97th save: the other slot is always intact
+    static unsigned char before[sizeof(rtc)], after[sizeof(rtc)];
+    checkpoint->invalidate();
+    srand(5);
+    int fresh = 0;
+    for (int step = 1; step <= 2000; step++)
+    {
+        advance(step);
+        if (step % 97 != 0)
+        {
+            checkpoint->save(live, LAYOUT);
+            continue;
+        }
+        memcpy(before, rtc, sizeof(rtc));
+        checkpoint->save(live, LAYOUT);
+        memcpy(after, rtc, sizeof(rtc));
+        size_t cut = rand() % sizeof(rtc);
+        memcpy(rtc + cut, before + cut, sizeof(rtc) - cut); // Torn: only a prefix made it
+
+        State restored;
+        TEST_ASSERT_TRUE(checkpoint->restore(restored, LAYOUT));
+        TEST_ASSERT_TRUE(restored.runClockMs == live.runClockMs || restored.runClockMs == live.runClockMs - 1000);
+        fresh += restored.runClockMs == live.runClockMs;
+        TEST_ASSERT_EQUAL_STRING("sampleA", restored.archiveRun);
+        TEST_ASSERT_EQUAL_UINT16(40000, restored.heaterLevel);
+        memcpy(rtc, after, sizeof(rtc)); // Carry on as if there was no reset
+    }
+    TEST_ASSERT_GREATER_THAN(0, fresh); // Both outcomes occur
+    TEST_ASSERT_LESS_THAN(2000 / 97, fresh);
+    TEST_ASSERT_EQUAL_UINT32(2000, checkpoint->sequence(LAYOUT));
+}
+
+void test_restored_filters_continue_identically(void)
+{
+    checkpoint->invalidate();
+    for (int step = 1; step <= 500; step++)
+    {
+        advance(step);
+        checkpoint->save(live, LAYOUT);
+    }
+    State restored;
+    TEST_ASSERT_TRUE(checkpoint->restore(restored, LAYOUT));
+    TEST_ASSERT_EQUAL_MEMORY(&live, &restored, sizeof(State));
+
+    // Both carry on from the same point with the same inputs
+    advance(501);
+    restored.stats.push(1500 + 501 % 7, 1.0f + 501 * 1e-4f);
+    restored.forecast.update(501, 1.0 - exp(-501 / 300.0));
+    TEST_ASSERT_TRUE(restored.forecast.asymptote() == live.forecast.asymptote());
+    TEST_ASSERT_TRUE(restored.stats.covXY() == live.stats.covXY());
+}
+
+void test_other_layout_and_invalidate(void)
+{
+    checkpoint->invalidate();
+    advance(1);
+    checkpoint->save(live, LAYOUT);
+    State restored;
+    TEST_ASSERT_FALSE(checkpoint->restore(restored, LAYOUT + 1)); // Firmware with another RunState_t
+    TEST_ASSERT_TRUE(checkpoint->restore(restored, LAYOUT));
+    checkpoint->invalidate();
+    TEST_ASSERT_FALSE(checkpoint->restore(restored, LAYOUT));
+}
+
+void test_bit_flip_falls_back_to_older_slot(void)
+{
+    checkpoint->invalidate();
+    for (int step = 1; step <= 10; step++)
+    {
+        advance(step);
+        live.interlockTripped = step == 9; // Only the older slot has the trip
+        checkpoint->save(live, LAYOUT);
+    }
+    TEST_ASSERT_EQUAL_UINT32(10, checkpoint->sequence(LAYOUT));
+    rtc[sizeof(rtc) - 3] ^= 0x10; // In the state of the second slot, the newest
+    State restored;
+    TEST_ASSERT_TRUE(checkpoint->restore(restored, LAYOUT));
+    TEST_ASSERT_EQUAL_UINT32(9, checkpoint->sequence(LAYOUT));
+    TEST_ASSERT_EQUAL_UINT32(9000, restored.runClockMs);
+    TEST_ASSERT_TRUE(restored.interlockTripped);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_power_on_garbage_is_not_restored);
+    RUN_TEST(test_reset_during_save_restores_new_or_previous);
+    RUN_TEST(test_restored_filters_continue_identically);
+    RUN_TEST(test_other_layout_and_invalidate);
+    RUN_TEST(test_bit_flip_falls_back_to_older_slot);
+    return UNITY_END();
+}
@@ -0,0 +1,197 @@
+#include <stdint.h>
+#include <math.h>
+#include <unity.h>
+#include <safetyInterlock.h>
+
+#define STALE_US 15000000UL
+#define PERIOD_US 1000
+
+static SafetyInterlock interlock;
+
+void setUp(void)
+{
+    interlock = SafetyInterlock();
+    interlock.setLimit(INTERLOCK_TEMP1, 330);
+    interlock.setLimit(INTERLOCK_TEMP2, 330);
+    interlock.setLimit(INTERLOCK_POWER, 2000);
+    interlock.setLimit(INTERLOCK_CURRENT, 1000);
+    interlock.begin(0, STALE_US);
+}
+
+void tearDown(void) {}
+
+static void reportNormal(uint32_t nowUs)
+{
+    interlock.report(INTERLOCK_TEMP1, 80, nowUs);
+    interlock.report(INTERLOCK_TEMP2, 79, nowUs);
+    interlock.report(INTERLOCK_POWER, 1500, nowUs);
+    interlock.report(INTERLOCK_CURRENT, 300, nowUs);
+}
+
+// Timer ticks every PERIOD_US from fromUs until a check trips, returns the trip time
+static uint32_t tickUntilTrip(uint32_t fromUs, uint32_t limitUs)
+{
+    for (uint32_t t = fromUs; t < fromUs + limitUs; t += PERIOD_US)
+    {
+        if (interlock.check(t))
+        {
+            return t;
+        }
+    }
+    return 0;
+}
+
+void test_not_armed_never_trips(void)
+{
+    SafetyInterlock idle;
+    idle.setLimit(INTERLOCK_TEMP1, 1);
+    idle.report(INTERLOCK_TEMP1, 500, 0);
+    TEST_ASSERT_FALSE(idle.check(100000000));
+}
+
+void test_normal_readings_do_not_trip(void)
+{
+    for (uint32_t t = 0; t < 10000000; t += PERIOD_US)
+    {
+        if (t % 250000 == 0)
+        {
+            reportNormal(t);
+        }
+        TEST_ASSERT_FALSE(interlock.check(t));
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, interlock.trips());
+    TEST_ASSERT_EQUAL_UINT32(10000, interlock.checks());
+}
+
+void test_over_limit_trips_within_one_period(void)
+{
+    reportNormal(0);
+    interlock.check(0);
+    interlock.report(INTERLOCK_POWER, 2000.5f, 500);
+    uint32_t trip = tickUntilTrip(1000, 10 * PERIOD_US);
+    TEST_ASSERT_EQUAL_UINT32(1000, trip);
+    TEST_ASSERT_TRUE(interlock.tripped());
+    TEST_ASSERT_EQUAL(INTERLOCK_OVER_LIMIT, interlock.fault());
+    TEST_ASSERT_EQUAL_INT(INTERLOCK_POWER, interlock.faultChannel());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 2000.5f, interlock.faultValue());
+    TEST_ASSERT_EQUAL_UINT32(500, interlock.tripLatencyUs());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(interlock.maxCheckGapUs(), interlock.tripLatencyUs());
+}
+
+void test_cut_time_counts_in_the_latency(void)
+{
+    reportNormal(0);
+    interlock.report(INTERLOCK_TEMP1, 400, 500);
+    TEST_ASSERT_TRUE(interlock.check(1000));
+    interlock.cutDone(1012); // MOSFET and DAC written 12 µs after the check
+    TEST_ASSERT_EQUAL_UINT32(512, interlock.tripLatencyUs());
+    TEST_ASSERT_EQUAL_UINT32(512, interlock.maxTripLatencyUs());
+
+    // Ticks while latched cut again but are not new trips
+    TEST_ASSERT_TRUE(interlock.check(2000));
+    interlock.cutDone(2100);
+    TEST_ASSERT_EQUAL_UINT32(512, interlock.tripLatencyUs());
+
+    // A fault restored at boot has no reading to measure from
+    SafetyInterlock restored;
+    restored.latch(INTERLOCK_RESTORED);
+    restored.cutDone(5000);
+    TEST_ASSERT_EQUAL_UINT32(0, restored.maxTripLatencyUs());
+}
+
+void test_non_finite_reading_is_a_sensor_fault(void)
+{
+    reportNormal(0);
+    interlock.report(INTERLOCK_CURRENT, NAN, 10);
+    TEST_ASSERT_TRUE(interlock.check(20));
+    TEST_ASSERT_EQUAL(INTERLOCK_SENSOR, interlock.fault());
+    TEST_ASSERT_TRUE(isnan(interlock.faultValue()));
+
+    TEST_ASSERT_FALSE(interlock.clear(30));
+    reportNormal(40);
+    TEST_ASSERT_TRUE(interlock.clear(50));
+    interlock.report(INTERLOCK_TEMP1, INFINITY, 60);
+    TEST_ASSERT_TRUE(interlock.check(70));
+    TEST_ASSERT_EQUAL(INTERLOCK_SENSOR, interlock.fault());
+    TEST_ASSERT_EQUAL_INT(INTERLOCK_TEMP1, interlock.faultChannel());
+}
+
+void test_silent_channel_trips_as_stale(void)
+{
+    // Acquisition hangs after the last report at 1 s
+    reportNormal(1000000);
+    uint32_t trip = tickUntilTrip(1000000, 2 * STALE_US);
+    TEST_ASSERT_EQUAL_UINT32(1000000 + STALE_US + PERIOD_US, trip);
+    TEST_ASSERT_EQUAL(INTERLOCK_STALE, interlock.fault());
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(PERIOD_US, interlock.tripLatencyUs());
+}
+
+void test_fault_stays_latched_until_cleared(void)
+{
+    reportNormal(0);
+    interlock.report(INTERLOCK_TEMP2, 400, 0);
+    TEST_ASSERT_TRUE(interlock.check(1000));
+
+    // Back to normal: still latched, and clear() is refused while a reading violates
+    reportNormal(2000);
+    TEST_ASSERT_TRUE(interlock.check(3000));
+    interlock.report(INTERLOCK_TEMP2, 400, 3500);
+    TEST_ASSERT_FALSE(interlock.clear(4000));
+    TEST_ASSERT_TRUE(interlock.tripped());
+
+    reportNormal(5000);
+    TEST_ASSERT_TRUE(interlock.clear(6000));
+    TEST_ASSERT_FALSE(interlock.check(7000));
+    TEST_ASSERT_EQUAL_UINT32(1, interlock.trips());
+
+    // A stale channel also blocks clearing
+    interlock.report(INTERLOCK_TEMP2, 400, 8000);
+    TEST_ASSERT_TRUE(interlock.check(9000));
+    interlock.report(INTERLOCK_TEMP1, 80, 9000 + STALE_US);
+    interlock.report(INTERLOCK_TEMP2, 79, 9000 + STALE_US);
+    interlock.report(INTERLOCK_POWER, 1500, 9000 + STALE_US);
+    TEST_ASSERT_FALSE(interlock.clear(9000 + STALE_US + 1)); // Current last reported at 5000
+}
+
+void test_report_from_other_core_just_after_check_time(void)
+{
+    // A reading stamped after the ISR's micros() must not look 4295 s old
+    reportNormal(0);
+    interlock.report(INTERLOCK_TEMP1, 80, 2000);
+    TEST_ASSERT_FALSE(interlock.check(1999));
+}
+
+void test_restored_latch(void)
+{
+    interlock.latch(INTERLOCK_RESTORED);
+    TEST_ASSERT_TRUE(interlock.tripped());
+    TEST_ASSERT_EQUAL_STRING("restored", interlockFaultName(interlock.fault()));
+    TEST_ASSERT_TRUE(isnan(interlock.faultValue()));
+    reportNormal(0);
+    TEST_ASSERT_TRUE(interlock.check(1000)); // Latched until cleared like any trip
+    TEST_ASSERT_TRUE(interlock.clear(2000));
+    TEST_ASSERT_FALSE(interlock.check(3000));
+}
+
+void test_names(void)
+{
+    TEST_ASSERT_EQUAL_STRING("overLimit", interlockFaultName(INTERLOCK_OVER_LIMIT));
+    TEST_ASSERT_EQUAL_STRING("current", interlockChannelName(INTERLOCK_CURRENT));
+    TEST_ASSERT_EQUAL_STRING("?", interlockChannelName(-1));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_not_armed_never_trips);
+    RUN_TEST(test_normal_readings_do_not_trip);
+    RUN_TEST(test_over_limit_trips_within_one_period);
+    RUN_TEST(test_cut_time_counts_in_the_latency);
+    RUN_TEST(test_non_finite_reading_is_a_sensor_fault);
+    RUN_TEST(test_silent_channel_trips_as_stale);
+    RUN_TEST(test_fault_stays_latched_until_cleared);
+    RUN_TEST(test_report_from_other_core_just_after_check_time);
+    RUN_TEST(test_restored_latch);
+    RUN_TEST(test_names);
+    return UNITY_END();
+}
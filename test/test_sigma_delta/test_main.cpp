@@ -0,0 +1,91 @@
+#include <stdint.h>
+#include <math.h>
+#include <unity.h>
+#include <sigmaDelta.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#define TICKS 65536
+
+void test_mean_power_tracks_level(void)
+{
+    // Mean of code² over the period lands on (level / 256)², to well under one LSB² step
+    for (uint32_t level = 0; level < 0xFF00; level += 37)
+    {
+        SigmaDelta modulator;
+        modulator.set(level);
+        double power = 0;
+        for (int i = 0; i < TICKS; i++)
+        {
+            double code = modulator.next();
+            power += code * code;
+        }
+        double target = (level / 256.0) * (level / 256.0);
+        double step = 2 * (level >> 8) + 1; // Between two adjacent codes
+        TEST_ASSERT_DOUBLE_WITHIN(step / 256, target, power / TICKS);
+    }
+}
+
+void test_voltage_mode_mean_code(void)
+{
+    for (uint32_t level = 0; level < 0xFF00; level += 53)
+    {
+        SigmaDelta modulator;
+        modulator.set(level, false);
+        uint64_t sum = 0;
+        for (int i = 0; i < TICKS; i++)
+        {
+            sum += modulator.next();
+        }
+        TEST_ASSERT_DOUBLE_WITHIN(1.0 / 256, level / 256.0, (double)sum / TICKS);
+    }
+}
+
+void test_only_adjacent_codes_and_short_term_duty(void)
+{
+    // First order: over any 256 ticks the upper code count is within one of the duty
+    SigmaDelta modulator;
+    modulator.set(0x80C3);
+    uint8_t low = modulator.code();
+    double expected = modulator.duty() / 65536.0 * 256;
+    int window[256] = {};
+    int high = 0;
+    for (int i = 0; i < 4096; i++)
+    {
+        uint8_t code = modulator.next();
+        TEST_ASSERT_TRUE(code == low || code == low + 1);
+        high += (code == low + 1) - window[i % 256];
+        window[i % 256] = code == low + 1;
+        if (i >= 255)
+        {
+            TEST_ASSERT_DOUBLE_WITHIN(1.0, expected, high);
+        }
+    }
+}
+
+void test_whole_codes_and_full_scale_do_not_dither(void)
+{
+    SigmaDelta modulator;
+    modulator.set(0x4000);
+    TEST_ASSERT_EQUAL_UINT16(0, modulator.duty());
+    modulator.set(HEATER_LEVEL_MAX);
+    TEST_ASSERT_EQUAL_UINT8(255, modulator.code());
+    TEST_ASSERT_EQUAL_UINT16(0, modulator.duty());
+    for (int i = 0; i < 1000; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(255, modulator.next()); // Never wraps to 0
+    }
+    modulator.set(0);
+    TEST_ASSERT_EQUAL_UINT8(0, modulator.next());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_mean_power_tracks_level);
+    RUN_TEST(test_voltage_mode_mean_code);
+    RUN_TEST(test_only_adjacent_codes_and_short_term_duty);
+    RUN_TEST(test_whole_codes_and_full_scale_do_not_dither);
+    return UNITY_END();
+}
@@ -0,0 +1,281 @@
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <unity.h>
+#include <sinkDispatcher.h>
+
+// Host stand-ins for the sample and for CriticalSection
+struct Sample
+{
+    uint32_t t;
+    float v[8];
+};
+
+struct MutexLock
+{
+    std::mutex m;
+    void lock() { m.lock(); }
+    void unlock() { m.unlock(); }
+};
+
+using namespace std::chrono;
+static steady_clock::time_point start = steady_clock::now();
+static uint32_t nowMs() { return duration_cast<milliseconds>(steady_clock::now() - start).count(); }
+static void sleepMs(uint32_t ms) { std::this_thread::sleep_for(milliseconds(ms)); }
+
+typedef SinkDispatcher<Sample, 32, MutexLock, 3, 4> Dispatcher;
+
+static BlockPool<Sample, 32> *pool;
+
+void setUp(void) { pool = new BlockPool<Sample, 32>(); }
+void tearDown(void) { delete pool; }
+
+// Publishes t = from..to-1 at nowMs = t, dropping the publisher's own reference
+template <typename D>
+static void publishRange(D &dispatcher, uint32_t from, uint32_t to, uint32_t mask = 0xFFFFFFFFUL)
+{
+    for (uint32_t i = from; i < to; i++)
+    {
+        BlockHandle h = pool->alloc();
+        TEST_ASSERT_TRUE(h != INVALID_BLOCK);
+        (*pool)[h].t = i;
+        dispatcher.publish(h, i, mask);
+        pool->release(h);
+    }
+}
+
+void test_drop_oldest_keeps_newest(void)
+{
+    Dispatcher d;
+    d.begin(pool, sleepMs);
+    d.addSink(0, "drop", SINK_DROP_OLDEST, 0);
+    publishRange(d, 0, 10);
+
+    Sample s;
+    for (uint32_t expected = 6; expected < 10; expected++)
+    {
+        TEST_ASSERT_TRUE(d.take(0, s, 10));
+        TEST_ASSERT_EQUAL_UINT32(expected, s.t);
+    }
+    TEST_ASSERT_FALSE(d.take(0, s, 10));
+    SinkStats_t stats = d.stats(0);
+    TEST_ASSERT_EQUAL_UINT32(10, stats.published);
+    TEST_ASSERT_EQUAL_UINT32(4, stats.delivered);
+    TEST_ASSERT_EQUAL_UINT32(6, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, pool->inUse());
+}
+
+void test_spool_keeps_order_and_loses_nothing(void)
+{
+    Dispatcher d;
+    Dispatcher::SpoolEntry spool[8];
+    d.begin(pool, sleepMs);
+    d.addSink(1, "spool", SINK_SPOOL, 0, 0, spool, 8);
+    publishRange(d, 0, 10);
+    TEST_ASSERT_EQUAL_UINT32(4, pool->inUse()); // Only the queue holds blocks
+
+    Sample s;
+    for (uint32_t expected = 0; expected < 10; expected++)
+    {
+        TEST_ASSERT_TRUE(d.take(1, s, 10));
+        TEST_ASSERT_EQUAL_UINT32(expected, s.t);
+        if (expected == 5)
+        {
+            publishRange(d, 10, 12); // Still spooling until it drains
+        }
+    }
+    for (uint32_t expected = 10; expected < 12; expected++)
+    {
+        TEST_ASSERT_TRUE(d.take(1, s, 20));
+        TEST_ASSERT_EQUAL_UINT32(expected, s.t);
+    }
+    SinkStats_t stats = d.stats(1);
+    TEST_ASSERT_EQUAL_UINT32(12, stats.delivered);
+    TEST_ASSERT_EQUAL_UINT32(8, stats.spooled);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.dropped);
+    TEST_ASSERT_EQUAL_UINT32(10, stats.peakBacklog);
+    TEST_ASSERT_EQUAL_UINT32(0, pool->inUse());
+
+    // A full spool drops its oldest copy
+    publishRange(d, 0, 14);
+    TEST_ASSERT_EQUAL_UINT32(2, d.stats(1).dropped);
+    TEST_ASSERT_TRUE(d.take(1, s, 30));
+    TEST_ASSERT_EQUAL_UINT32(0, s.t);
+    for (int i = 0; i < 3; i++)
+    {
+        d.take(1, s, 30);
+    }
+    TEST_ASSERT_TRUE(d.take(1, s, 30));
+    TEST_ASSERT_EQUAL_UINT32(6, s.t); // 4 and 5 were dropped
+}
+
+void test_rate_limit_and_clear(void)
+{
+    Dispatcher d;
+    d.begin(pool, sleepMs);
+    d.addSink(2, "rate", SINK_DROP_OLDEST, 100);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, d.waitMs(2, 0));
+    publishRange(d, 0, 3);
+
+    Sample s;
+    TEST_ASSERT_EQUAL_UINT32(0, d.waitMs(2, 10));
+    TEST_ASSERT_TRUE(d.take(2, s, 10));
+    TEST_ASSERT_EQUAL_UINT32(0, s.t);
+    TEST_ASSERT_FALSE(d.take(2, s, 50));
+    TEST_ASSERT_EQUAL_UINT32(60, d.waitMs(2, 50));
+    TEST_ASSERT_TRUE(d.take(2, s, 110));
+    TEST_ASSERT_EQUAL_UINT32(1, s.t);
+    TEST_ASSERT_EQUAL_UINT32(109, d.stats(2).lagMs);
+
+    d.clear(2);
+    TEST_ASSERT_EQUAL_UINT32(0, d.stats(2).backlog);
+    TEST_ASSERT_EQUAL_UINT32(1, d.stats(2).dropped);
+    TEST_ASSERT_EQUAL_UINT32(0, pool->inUse());
+}
+
+void test_mask_and_unset_sinks(void)
+{
+    Dispatcher d;
+    d.begin(pool, sleepMs);
+    d.addSink(0, "a", SINK_DROP_OLDEST, 0);
+    d.addSink(2, "c", SINK_DROP_OLDEST, 0);
+    BlockHandle h = pool->alloc();
+    TEST_ASSERT_EQUAL_UINT32(SINK_MASK(0) | SINK_MASK(2), d.publish(h, 0));
+    TEST_ASSERT_EQUAL_UINT32(SINK_MASK(2), d.publish(h, 0, SINK_MASK(1) | SINK_MASK(2)));
+    TEST_ASSERT_EQUAL_UINT32(0, d.publish(INVALID_BLOCK, 0));
+    pool->release(h);
+    TEST_ASSERT_EQUAL_UINT32(1, d.stats(0).backlog);
+    TEST_ASSERT_EQUAL_UINT32(2, d.stats(2).backlog);
+    TEST_ASSERT_EQUAL_UINT32(0, d.stats(1).published);
+    d.clear(0);
+    d.clear(2);
+    TEST_ASSERT_EQUAL_UINT32(0, pool->inUse());
+}
+
+void test_block_waits_for_the_worker(void)
+{
+    SinkDispatcher<Sample, 32, MutexLock, 1, 2> d;
+    d.begin(pool, sleepMs);
+    d.addSink(0, "block", SINK_BLOCK, 0, 20);
+
+    // No worker: the third publish waits blockMs, then drops the new sample
+    publishRange(d, 0, 3);
+    TEST_ASSERT_EQUAL_UINT32(1, d.stats(0).blocked);
+    TEST_ASSERT_EQUAL_UINT32(1, d.stats(0).dropped);
+
+    // A worker that takes within blockMs lets the publish through
+    std::thread worker([&] {
+        sleepMs(5);
+        Sample s;
+        d.take(0, s, 0);
+    });
+    publishRange(d, 3, 4);
+    worker.join();
+    TEST_ASSERT_EQUAL_UINT32(2, d.stats(0).blocked);
+    TEST_ASSERT_EQUAL_UINT32(1, d.stats(0).dropped);
+
+    Sample s;
+    TEST_ASSERT_TRUE(d.take(0, s, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, s.t);
+    TEST_ASSERT_TRUE(d.take(0, s, 0));
+    TEST_ASSERT_EQUAL_UINT32(3, s.t);
+    TEST_ASSERT_EQUAL_UINT32(0, pool->inUse());
+}
+
+void test_slow_sink_does_not_hold_back_the_others(void)
+{
+    // 200 Hz publisher; a fast sink, a spooled sink with periodic 100 ms stalls (flash
+    // writes) and a sink that needs 50 ms per sample
+    enum
+    {
+        FAST,
+        SPOOLED,
+        SLOW,
+        SINKS
+    };
+    SinkDispatcher<Sample, 32, MutexLock, SINKS, 8> d;
+    SinkDispatcher<Sample, 32, MutexLock, SINKS, 8>::SpoolEntry spool[64];
+    d.begin(pool, sleepMs);
+    d.addSink(FAST, "fast", SINK_DROP_OLDEST, 0);
+    d.addSink(SPOOLED, "spooled", SINK_SPOOL, 0, 0, spool, 64);
+    d.addSink(SLOW, "slow", SINK_DROP_OLDEST, 0);
+
+    std::atomic<bool> done(false);
+    std::atomic<uint32_t> gaps(0);
+    std::vector<std::thread> workers;
+    for (int k = 0; k < SINKS; k++)
+    {
+        workers.emplace_back([&, k] {
+            Sample s;
+            bool first = true;
+            uint32_t last = 0;
+            while (!done || d.stats(k).backlog)
+            {
+                if (!d.take(k, s, nowMs()))
+                {
+                    sleepMs(1);
+                    continue;
+                }
+                if (k != SLOW && !first && s.t != last + 1)
+                {
+                    gaps++;
+                }
+                first = false;
+                last = s.t;
+                if (k == SLOW)
+                {
+                    sleepMs(50);
+                }
+                if (k == SPOOLED && s.t % 200 == 199)
+                {
+                    sleepMs(100);
+                }
+            }
+        });
+    }
+
+    uint32_t exhausted = 0;
+    for (uint32_t i = 0; i < 400; i++)
+    {
+        BlockHandle h = pool->alloc();
+        if (h == INVALID_BLOCK)
+        {
+            exhausted++;
+            continue;
+        }
+        (*pool)[h].t = i;
+        d.publish(h, nowMs());
+        pool->release(h);
+        sleepMs(5);
+    }
+    done = true;
+    for (std::thread &w : workers)
+    {
+        w.join();
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, exhausted);
+    TEST_ASSERT_EQUAL_UINT32(0, gaps.load());
+    TEST_ASSERT_EQUAL_UINT32(400, d.stats(FAST).delivered);
+    TEST_ASSERT_EQUAL_UINT32(400, d.stats(SPOOLED).delivered);
+    TEST_ASSERT_EQUAL_UINT32(0, d.stats(SPOOLED).dropped);
+    TEST_ASSERT_GREATER_THAN(0, d.stats(SPOOLED).spooled);
+    TEST_ASSERT_GREATER_THAN(300, d.stats(SLOW).dropped);
+    TEST_ASSERT_LESS_OR_EQUAL_UINT32(8, d.stats(SLOW).peakBacklog);
+    TEST_ASSERT_EQUAL_UINT32(0, pool->inUse());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_drop_oldest_keeps_newest);
+    RUN_TEST(test_spool_keeps_order_and_loses_nothing);
+    RUN_TEST(test_rate_limit_and_clear);
+    RUN_TEST(test_mask_and_unset_sinks);
+    RUN_TEST(test_block_waits_for_the_worker);
+    RUN_TEST(test_slow_sink_does_not_hold_back_the_others);
+    return UNITY_END();
+}
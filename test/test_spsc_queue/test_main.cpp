@@ -0,0 +1,94 @@
+#include <stdint.h>
+#include <thread>
+#include <unity.h>
+#include <spscQueue.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_fifo_order_and_capacity(void)
+{
+    SpscQueue<uint32_t, 8> queue = {};
+    uint32_t value;
+    TEST_ASSERT_FALSE(queue.pop(value));
+    for (uint32_t i = 0; i < 7; i++)
+    {
+        TEST_ASSERT_TRUE(queue.push(i));
+    }
+    TEST_ASSERT_EQUAL_UINT32(7, queue.size());
+    TEST_ASSERT_FALSE(queue.push(99)); // One slot stays empty
+    TEST_ASSERT_EQUAL_UINT32(1, queue.drops());
+    for (uint32_t i = 0; i < 7; i++)
+    {
+        TEST_ASSERT_TRUE(queue.pop(value));
+        TEST_ASSERT_EQUAL_UINT32(i, value);
+    }
+    TEST_ASSERT_FALSE(queue.pop(value));
+    TEST_ASSERT_EQUAL_UINT32(0, queue.size());
+}
+
+void test_wraps_around(void)
+{
+    SpscQueue<uint32_t, 4> queue = {};
+    uint32_t value;
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        TEST_ASSERT_TRUE(queue.push(i));
+        TEST_ASSERT_TRUE(queue.push(i + 1000000));
+        TEST_ASSERT_TRUE(queue.pop(value));
+        TEST_ASSERT_EQUAL_UINT32(i, value);
+        TEST_ASSERT_TRUE(queue.pop(value));
+        TEST_ASSERT_EQUAL_UINT32(i + 1000000, value);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, queue.drops());
+}
+
+// Producer and consumer on two threads, as between the two cores: every item that was
+// accepted arrives once and in order, every rejected one is counted as a drop
+void test_two_threads_lose_nothing_silently(void)
+{
+    static SpscQueue<uint32_t, 64> queue;
+    const uint32_t items = 200000;
+    uint32_t accepted = 0;
+    std::thread producer([&]
+                         {
+        for (uint32_t i = 0; i < items; i++)
+        {
+            if (queue.push(i))
+            {
+                accepted++;
+            }
+        } });
+
+    uint32_t received = 0, last = 0;
+    bool ordered = true;
+    uint32_t value;
+    for (;;)
+    {
+        if (queue.pop(value))
+        {
+            ordered = ordered && (received == 0 || value > last);
+            last = value;
+            received++;
+            continue;
+        }
+        if (received + queue.drops() == items)
+        {
+            break;
+        }
+        std::this_thread::yield();
+    }
+    producer.join();
+    TEST_ASSERT_TRUE(ordered);
+    TEST_ASSERT_EQUAL_UINT32(accepted, received);
+    TEST_ASSERT_EQUAL_UINT32(items, received + queue.drops());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fifo_order_and_capacity);
+    RUN_TEST(test_wraps_around);
+    RUN_TEST(test_two_threads_lose_nothing_silently);
+    return UNITY_END();
+}
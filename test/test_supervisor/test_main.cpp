@@ -0,0 +1,322 @@
+#include <stdint.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <unity.h>
+#include <supervisor.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+enum
+{
+    ACQ,
+    NET,
+    TASKS
+};
+
+void test_miss_reported_once_per_stall(void)
+{
+    Supervisor<TASKS> supervisor;
+    supervisor.watch(ACQ, "AcqTask", 1000, 0);
+    TEST_ASSERT_EQUAL_UINT32(0, supervisor.check(1000));
+    TEST_ASSERT_EQUAL_UINT32(1UL << ACQ, supervisor.check(1001));
+    TEST_ASSERT_TRUE(supervisor.isOverdue(ACQ));
+    TEST_ASSERT_EQUAL_UINT32(0, supervisor.check(5000)); // Same stall
+    TEST_ASSERT_EQUAL_UINT32(1, supervisor.misses(ACQ));
+    TEST_ASSERT_EQUAL_UINT32(4000, supervisor.worstLateMs(ACQ));
+
+    supervisor.beat(ACQ, 5100);
+    TEST_ASSERT_EQUAL_UINT32(0, supervisor.check(5200));
+    TEST_ASSERT_FALSE(supervisor.isOverdue(ACQ));
+    TEST_ASSERT_EQUAL_UINT32(1UL << ACQ, supervisor.check(6101)); // A new stall
+    TEST_ASSERT_EQUAL_UINT32(2, supervisor.misses(ACQ));
+}
+
+void test_idle_task_is_not_late(void)
+{
+    Supervisor<TASKS> supervisor;
+    supervisor.watch(NET, "NetTask", 1000, 0);
+    supervisor.idle(NET, 10);
+    TEST_ASSERT_EQUAL_UINT32(0, supervisor.check(60000));
+    TEST_ASSERT_FALSE(supervisor.isActive(NET));
+    supervisor.beat(NET, 60000);
+    TEST_ASSERT_EQUAL_UINT32(1UL << NET, supervisor.check(61001));
+}
+
+void test_unwatched_ids_are_ignored(void)
+{
+    Supervisor<TASKS> supervisor;
+    supervisor.watch(NET, "NetTask", 1000, 0);
+    TEST_ASSERT_EQUAL_UINT32(1UL << NET, supervisor.check(100000));
+}
+
+void test_restart_event_completes_on_next_beat(void)
+{
+    Supervisor<TASKS> supervisor;
+    supervisor.watch(NET, "NetTask", 1000, 0);
+    supervisor.check(2000);
+    TEST_ASSERT_TRUE(supervisor.isOverdue(NET));
+
+    int slot = supervisor.logEvent("web", "restart task", 2000, supervisor.ageMs(NET, 2000), NET);
+    TEST_ASSERT_FALSE(supervisor.isOverdue(NET));
+    TEST_ASSERT_EQUAL_UINT32(1, supervisor.restarts(NET));
+    TEST_ASSERT_EQUAL_UINT32(0, supervisor.check(2500)); // A full deadline after the restart
+    TEST_ASSERT_EQUAL_UINT32(0, supervisor.event(slot).recovery_ms);
+
+    supervisor.beat(NET, 2300);
+    supervisor.check(2500);
+    TEST_ASSERT_EQUAL_UINT32(300, supervisor.event(slot).recovery_ms);
+    TEST_ASSERT_EQUAL_UINT32(2000, supervisor.event(slot).stalled_ms);
+    TEST_ASSERT_EQUAL_STRING("restart task", supervisor.event(slot).action);
+}
+
+void test_restarted_task_that_stays_stuck_is_reported_again(void)
+{
+    Supervisor<TASKS> supervisor;
+    supervisor.watch(NET, "NetTask", 1000, 0);
+    supervisor.check(1500);
+    supervisor.logEvent("web", "restart task", 1500, 1500, NET);
+    TEST_ASSERT_EQUAL_UINT32(0, supervisor.check(2500));
+    TEST_ASSERT_EQUAL_UINT32(1UL << NET, supervisor.check(2501));
+    TEST_ASSERT_TRUE(supervisor.isOverdue(NET));
+}
+
+void test_event_log_keeps_newest(void)
+{
+    Supervisor<TASKS> supervisor;
+    int wifi = supervisor.logEvent("wifi", "reconnect", 100, 20000);
+    supervisor.complete(wifi, 100); // Recovered at once still reads as complete
+    TEST_ASSERT_TRUE(supervisor.event(0).recovery_ms != 0);
+
+    for (uint32_t i = 1; i < SUPERVISOR_LOG_SIZE + 5; i++)
+    {
+        supervisor.logEvent("wifi", "reconnect", 100 + i, 0);
+    }
+    TEST_ASSERT_EQUAL_UINT32(SUPERVISOR_LOG_SIZE + 5, supervisor.totalEvents());
+    TEST_ASSERT_EQUAL_UINT32(SUPERVISOR_LOG_SIZE, supervisor.eventsLogged());
+    for (uint32_t i = 0; i < supervisor.eventsLogged(); i++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(100 + 5 + i, supervisor.event(i).t_ms); // Oldest first
+    }
+}
+
+void test_millis_wrap(void)
+{
+    Supervisor<TASKS> supervisor;
+    supervisor.watch(ACQ, "AcqTask", 1000, 0xFFFFFF00UL);
+    TEST_ASSERT_EQUAL_UINT32(0, supervisor.check(0x00000100UL));
+    TEST_ASSERT_EQUAL_UINT32(1UL << ACQ, supervisor.check(0x00000400UL));
+}
+
+#define ASK_GRACE_MS 5000
+#define SOCKET_GRACE_MS 5000
+
+void test_recovery_ladder(void)
+{
+    TaskRecovery recovery;
+    recovery.begin(ASK_GRACE_MS, SOCKET_GRACE_MS);
+    TEST_ASSERT_EQUAL_INT(RECOVERY_NONE, recovery.step(false, 1000));
+    TEST_ASSERT_EQUAL_INT(RECOVERY_ASK, recovery.step(true, 2000));
+    TEST_ASSERT_TRUE(recovery.requested());
+    TEST_ASSERT_EQUAL_INT(RECOVERY_NONE, recovery.step(true, 7000));
+    TEST_ASSERT_EQUAL_INT(RECOVERY_SHUTDOWN_SOCKETS, recovery.step(true, 7001));
+    TEST_ASSERT_EQUAL_INT(RECOVERY_NONE, recovery.step(false, 12001)); // Not overdue: logEvent reset the beat
+    TEST_ASSERT_EQUAL_INT(RECOVERY_RECREATE, recovery.step(false, 12002));
+    TEST_ASSERT_FALSE(recovery.requested()); // The new task starts clean
+    TEST_ASSERT_EQUAL_INT(RECOVERY_NONE, recovery.step(false, 13000));
+}
+
+void test_acknowledged_request_ends_recovery(void)
+{
+    TaskRecovery recovery;
+    recovery.begin(ASK_GRACE_MS, SOCKET_GRACE_MS);
+    TEST_ASSERT_EQUAL_INT(RECOVERY_ASK, recovery.step(true, 0));
+    recovery.acknowledge();
+    TEST_ASSERT_EQUAL_INT(RECOVERY_NONE, recovery.step(false, 100));
+    for (uint32_t t = 1000; t < 30000; t += 1000)
+    {
+        TEST_ASSERT_EQUAL_INT(RECOVERY_NONE, recovery.step(false, t));
+    }
+    TEST_ASSERT_EQUAL_INT(RECOVERY_ASK, recovery.step(true, 30000)); // A new stall starts over
+}
+
+void test_postponed_recreate(void)
+{
+    TaskRecovery recovery;
+    recovery.begin(ASK_GRACE_MS, SOCKET_GRACE_MS);
+    recovery.step(true, 0);
+    TEST_ASSERT_EQUAL_INT(RECOVERY_SHUTDOWN_SOCKETS, recovery.step(true, 6000));
+    TEST_ASSERT_EQUAL_INT(RECOVERY_RECREATE, recovery.step(true, 12000));
+    recovery.postpone(12000); // E.g. it holds a mutex
+    TEST_ASSERT_TRUE(recovery.requested());
+    TEST_ASSERT_EQUAL_INT(RECOVERY_NONE, recovery.step(true, 17000));
+    TEST_ASSERT_EQUAL_INT(RECOVERY_RECREATE, recovery.step(true, 17001));
+}
+
+void test_task_sockets(void)
+{
+    TaskSockets sockets;
+    static std::vector<int> seen;
+    seen.clear();
+    auto collect = [](int fd) { seen.push_back(fd); };
+    TEST_ASSERT_EQUAL_INT(0, sockets.forEach(collect));
+    for (int fd = 10; fd < 10 + TASK_SOCKETS_MAX; fd++)
+    {
+        TEST_ASSERT_TRUE(sockets.add(fd));
+    }
+    TEST_ASSERT_FALSE(sockets.add(99)); // Full
+    sockets.remove(11);
+    TEST_ASSERT_TRUE(sockets.add(20)); // Takes the freed slot
+    TEST_ASSERT_EQUAL_INT(TASK_SOCKETS_MAX, sockets.forEach(collect));
+    TEST_ASSERT_EQUAL_INT(10, seen[0]);
+    TEST_ASSERT_EQUAL_INT(20, seen[1]);
+    sockets.clear();
+    TEST_ASSERT_EQUAL_INT(0, sockets.forEach(collect));
+}
+
+static void shutdownSocket(int fd) { shutdown(fd, SHUT_RDWR); }
+
+// Fault injection: a task blocks in recv() on a socket whose peer never answers, as
+// NetTask in a handler whose client went silent. Asking does not reach it; shutting
+// its socket down does, and it recovers without being recreated (or a reboot).
+void test_hung_socket_recovered_by_shutdown(void)
+{
+    Supervisor<TASKS> supervisor;
+    TaskRecovery recovery;
+    TaskSockets sockets;
+    recovery.begin(ASK_GRACE_MS, SOCKET_GRACE_MS);
+    supervisor.watch(NET, "NetTask", 1000, 0);
+
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    std::atomic<uint32_t> clock{0};
+    std::atomic<bool> blocked{false}, returned{false};
+    std::thread task([&] {
+        supervisor.beat(NET, clock.load());
+        sockets.add(fds[0]);
+        blocked.store(true);
+        char byte;
+        ssize_t n = recv(fds[0], &byte, 1, 0); // Hangs until the socket is shut down
+        sockets.remove(fds[0]);
+        returned.store(n <= 0);
+        while (!recovery.requested())
+        {
+            std::this_thread::yield();
+        }
+        recovery.acknowledge(); // Resets itself, as NetTask on the request
+        supervisor.beat(NET, clock.load());
+    });
+    while (!blocked.load())
+    {
+        std::this_thread::yield();
+    }
+
+    std::vector<int> actions;
+    bool recovered = false;
+    for (uint32_t t = 1000; t <= 30000 && !recovered; t += 1000)
+    {
+        clock.store(t);
+        supervisor.check(t);
+        RecoveryAction action = recovery.step(supervisor.isOverdue(NET), t);
+        recovered = !task.joinable(); // Joined: this was the first check after it recovered
+        if (action == RECOVERY_NONE)
+        {
+            continue;
+        }
+        actions.push_back(action);
+        if (action == RECOVERY_ASK)
+        {
+            supervisor.logEvent("web", "restart task", t, supervisor.ageMs(NET, t), NET);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            TEST_ASSERT_FALSE(returned.load()); // Still in recv(), the request does not reach it
+        }
+        else if (action == RECOVERY_SHUTDOWN_SOCKETS)
+        {
+            supervisor.logEvent("web", "close sockets", t, supervisor.ageMs(NET, t), NET);
+            clock.store(t + 10); // Its next beat comes after the event
+            TEST_ASSERT_EQUAL_INT(1, sockets.forEach(shutdownSocket));
+            for (int i = 0; i < 5000 && recovery.requested(); i++)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            TEST_ASSERT_FALSE(recovery.requested());
+            task.join();
+        }
+    }
+    if (task.joinable())
+    {
+        task.join();
+    }
+    close(fds[0]);
+    close(fds[1]);
+
+    TEST_ASSERT_TRUE(returned.load());
+    TEST_ASSERT_EQUAL_INT(2, (int)actions.size()); // No RECREATE
+    TEST_ASSERT_EQUAL_INT(RECOVERY_ASK, actions[0]);
+    TEST_ASSERT_EQUAL_INT(RECOVERY_SHUTDOWN_SOCKETS, actions[1]);
+    TEST_ASSERT_EQUAL_INT(2, supervisor.restarts(NET));
+    const RecoveryEvent_t &last = supervisor.event(supervisor.eventsLogged() - 1);
+    TEST_ASSERT_EQUAL_STRING("close sockets", last.action);
+    TEST_ASSERT_EQUAL_UINT32(10, last.recovery_ms);
+}
+
+// Stuck somewhere without a socket (e.g. DNS): the last step recreates it
+void test_task_stuck_off_socket_is_recreated(void)
+{
+    Supervisor<TASKS> supervisor;
+    TaskRecovery recovery;
+    TaskSockets sockets;
+    recovery.begin(ASK_GRACE_MS, SOCKET_GRACE_MS);
+    supervisor.watch(NET, "NetTask", 1000, 0);
+
+    std::vector<int> actions;
+    bool recreated = false;
+    for (uint32_t t = 1000; t <= 30000; t += 1000)
+    {
+        if (recreated)
+        {
+            supervisor.beat(NET, t); // The new task runs
+        }
+        supervisor.check(t);
+        RecoveryAction action = recovery.step(supervisor.isOverdue(NET), t);
+        if (action != RECOVERY_NONE)
+        {
+            actions.push_back(action);
+            supervisor.logEvent("web", action == RECOVERY_RECREATE ? "recreate task" : "restart task", t,
+                                supervisor.ageMs(NET, t), NET);
+        }
+        if (action == RECOVERY_SHUTDOWN_SOCKETS)
+        {
+            TEST_ASSERT_EQUAL_INT(0, sockets.forEach(shutdownSocket));
+        }
+        recreated |= action == RECOVERY_RECREATE;
+    }
+    TEST_ASSERT_EQUAL_INT(3, (int)actions.size());
+    TEST_ASSERT_EQUAL_INT(RECOVERY_RECREATE, actions[2]);
+    TEST_ASSERT_FALSE(recovery.requested());
+    TEST_ASSERT_FALSE(supervisor.isOverdue(NET));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_miss_reported_once_per_stall);
+    RUN_TEST(test_idle_task_is_not_late);
+    RUN_TEST(test_unwatched_ids_are_ignored);
+    RUN_TEST(test_restart_event_completes_on_next_beat);
+    RUN_TEST(test_restarted_task_that_stays_stuck_is_reported_again);
+    RUN_TEST(test_event_log_keeps_newest);
+    RUN_TEST(test_millis_wrap);
+    RUN_TEST(test_recovery_ladder);
+    RUN_TEST(test_acknowledged_request_ends_recovery);
+    RUN_TEST(test_postponed_recreate);
+    RUN_TEST(test_task_sockets);
+    RUN_TEST(test_hung_socket_recovered_by_shutdown);
+    RUN_TEST(test_task_stuck_off_socket_is_recreated);
+    return UNITY_END();
+}
@@ -0,0 +1,319 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <unity.h>
+#include <telemetryReceiver.h>
+#include <tableWriter.h>
+
+static std::string csvPath, columnarPath;
+
+void setUp(void)
+{
+    csvPath = "/tmp/cryo_receiver_" + std::to_string(getpid()) + ".csv";
+    columnarPath = "/tmp/cryo_receiver_" + std::to_string(getpid()) + ".cryc";
+}
+
+void tearDown(void)
+{
+    remove(csvPath.c_str());
+    remove(columnarPath.c_str());
+}
+
+// A frame as the rig would send it
+static TelemetryFrame_t makeFrame(uint32_t sequence)
+{
+    TelemetryFrame_t frame = {};
+    frame.magic = TELEMETRY_MAGIC;
+    frame.version = TELEMETRY_VERSION;
+    frame.flags = sequence % 3 == 0 ? TELEMETRY_FLAG_MOSFET : 0;
+    frame.sequence = sequence;
+    frame.timestamp_ms = sequence * 500;
+    frame.temp1 = 80 + sequence * 1e-4f;
+    frame.temp2 = 79 + sequence * 1e-4f;
+    frame.dT = 1;
+    frame.busVoltage = 5;
+    frame.current_mA = 100;
+    frame.power_mW = 500;
+    frame.thermalConductivity = sequence % 7 == 0 ? NAN : 0.3f;
+    frame.thermalConductivityUnc = 0.01f;
+    frame.dacValue = sequence & 0xFFFF;
+    telemetrySeal(frame);
+    return frame;
+}
+
+void test_sequence_tracker(void)
+{
+    SequenceTracker tracker;
+    ReceiverStats_t stats = {};
+    TEST_ASSERT_TRUE(tracker.accept(100, stats)); // Joining mid-run is no loss
+    TEST_ASSERT_TRUE(tracker.accept(101, stats));
+    TEST_ASSERT_TRUE(tracker.accept(105, stats));
+    TEST_ASSERT_EQUAL_UINT32(3, stats.lost);
+    TEST_ASSERT_FALSE(tracker.accept(105, stats)); // Duplicate
+    TEST_ASSERT_FALSE(tracker.accept(103, stats)); // Late, stays counted as lost
+    TEST_ASSERT_EQUAL_UINT32(2, stats.late);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.lost);
+
+    TEST_ASSERT_TRUE(tracker.accept(0, stats)); // Rebooted shortly after the last boot
+    TEST_ASSERT_EQUAL_UINT32(1, stats.restarts);
+    TEST_ASSERT_TRUE(tracker.accept(1, stats));
+    TEST_ASSERT_TRUE(tracker.accept(50000, stats));
+    TEST_ASSERT_TRUE(tracker.accept(7, stats)); // Rebooted, its frame 0 lost
+    TEST_ASSERT_EQUAL_UINT32(2, stats.restarts);
+    TEST_ASSERT_EQUAL_UINT32(3 + 49998, stats.lost);
+
+    tracker.reset();
+    TEST_ASSERT_TRUE(tracker.accept(0xFFFFFFFEUL, stats));
+    TEST_ASSERT_TRUE(tracker.accept(1, stats)); // Wraps, 0xFFFFFFFF and 0 lost
+    TEST_ASSERT_EQUAL_UINT32(3 + 49998 + 2, stats.lost);
+    TEST_ASSERT_EQUAL_UINT32(2, stats.restarts);
+    TEST_ASSERT_EQUAL_UINT32(9, stats.frames);
+}
+
+void test_parse_rejects_bad_datagrams(void)
+{
+    TelemetryFrame_t frame = makeFrame(9), parsed;
+    uint8_t buffer[sizeof(frame) + 1];
+    memcpy(buffer, &frame, sizeof(frame));
+    TEST_ASSERT_TRUE(telemetryParse(buffer, sizeof(frame), parsed));
+    TEST_ASSERT_EQUAL_MEMORY(&frame, &parsed, sizeof(frame));
+    TEST_ASSERT_FALSE(telemetryParse(buffer, sizeof(frame) - 1, parsed));
+    TEST_ASSERT_FALSE(telemetryParse(buffer, sizeof(frame) + 1, parsed));
+    buffer[20] ^= 0x01;
+    TEST_ASSERT_FALSE(telemetryParse(buffer, sizeof(frame), parsed));
+
+    frame.version = TELEMETRY_VERSION + 1;
+    telemetrySeal(frame);
+    TEST_ASSERT_FALSE(telemetryParse(&frame, sizeof(frame), parsed));
+}
+
+// Answers one HTTP request like the rig's /subscribe handler, returns the request line
+static std::string serveOnce(int listener)
+{
+    int client = accept(listener, nullptr, nullptr);
+    char request[512] = {};
+    recv(client, request, sizeof(request) - 1, 0);
+    const char *response = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nConnection: close\r\n\r\nSubscribed 127.0.0.1";
+    send(client, response, strlen(response), MSG_NOSIGNAL);
+    close(client);
+    return std::string(request, strcspn(request, "\r"));
+}
+
+static int listenLoopback(uint16_t &port)
+{
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listener, (const sockaddr *)&address, sizeof(address));
+    listen(listener, 4);
+    socklen_t length = sizeof(address);
+    getsockname(listener, (sockaddr *)&address, &length);
+    port = ntohs(address.sin_port);
+    return listener;
+}
+
+void test_subscribe_over_http(void)
+{
+    uint16_t httpPort;
+    int listener = listenLoopback(httpPort);
+    std::string requestLine;
+    std::thread rig([&] { requestLine = serveOnce(listener); });
+    std::string body;
+    TEST_ASSERT_EQUAL_INT(200, telemetrySubscribe("127.0.0.1", httpPort, 6001, true, &body));
+    rig.join();
+    TEST_ASSERT_EQUAL_STRING("GET /subscribe?port=6001 HTTP/1.0", requestLine.c_str());
+    TEST_ASSERT_EQUAL_STRING("Subscribed 127.0.0.1", body.c_str());
+    close(listener);
+
+    TEST_ASSERT_EQUAL_INT(-1, telemetrySubscribe("127.0.0.1", httpPort, 6001)); // Nobody listening
+
+    std::string host;
+    uint16_t port;
+    TEST_ASSERT_TRUE(parseHostPort("cryo.local", host, port));
+    TEST_ASSERT_EQUAL_STRING("cryo.local", host.c_str());
+    TEST_ASSERT_EQUAL_UINT32(80, port);
+    TEST_ASSERT_TRUE(parseHostPort("10.0.0.7:8080", host, port));
+    TEST_ASSERT_EQUAL_STRING("10.0.0.7", host.c_str());
+    TEST_ASSERT_EQUAL_UINT32(8080, port);
+    TEST_ASSERT_FALSE(parseHostPort("cryo.local:http", host, port));
+    TEST_ASSERT_FALSE(parseHostPort(":80", host, port));
+}
+
+// Loopback run: every 1000th frame never sent, every 2000th sent twice, a corrupted
+// datagram every 5000. The sender keeps at most WINDOW frames ahead of the receiver so
+// the kernel never drops one and the counts are exact.
+#define FRAMES 50000
+#define WINDOW 128
+
+void test_loopback_loss_and_throughput(void)
+{
+    TelemetryReceiver receiver;
+    TEST_ASSERT_TRUE(receiver.open(0));
+    uint16_t port = receiver.port();
+    TEST_ASSERT_TRUE(port != 0);
+
+    CsvWriter csv;
+    ColumnarWriter columnar(1000);
+    TEST_ASSERT_TRUE(csv.open(csvPath.c_str(), telemetryColumns, TELEMETRY_COLUMNS));
+    TEST_ASSERT_TRUE(columnar.open(columnarPath.c_str(), telemetryColumns, TELEMETRY_COLUMNS));
+
+    std::atomic<uint32_t> received(0);
+    std::atomic<bool> sent(false), receiving(true);
+    std::thread rig([&] {
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in to = {};
+        to.sin_family = AF_INET;
+        to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        to.sin_port = htons(port);
+        for (uint32_t sequence = 0; sequence < FRAMES; sequence++)
+        {
+            while (receiving && sequence - received.load() > WINDOW)
+            {
+                std::this_thread::yield();
+            }
+            TelemetryFrame_t frame = makeFrame(sequence);
+            if (sequence % 1000 != 500)
+            {
+                sendto(fd, &frame, sizeof(frame), 0, (const sockaddr *)&to, sizeof(to));
+            }
+            if (sequence % 2000 == 1)
+            {
+                sendto(fd, &frame, sizeof(frame), 0, (const sockaddr *)&to, sizeof(to));
+            }
+            if (sequence % 5000 == 0)
+            {
+                frame.crc ^= 1;
+                sendto(fd, &frame, sizeof(frame), 0, (const sockaddr *)&to, sizeof(to));
+                sendto(fd, &frame, 20, 0, (const sockaddr *)&to, sizeof(to));
+            }
+        }
+        close(fd);
+        sent = true;
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    TelemetryFrame_t frame;
+    uint32_t expected = 0;
+    bool inOrder = true;
+    while (receiver.next(frame, sent ? 100 : 2000))
+    {
+        if (expected % 1000 == 500)
+        {
+            expected++;
+        }
+        inOrder = inOrder && frame.sequence == expected;
+        expected = frame.sequence + 1;
+        received = frame.sequence;
+        csv.append(&frame);
+        columnar.append(&frame);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    receiving = false; // Releases the rig if a frame went missing after all
+    rig.join();
+    TEST_ASSERT_TRUE(csv.close());
+    TEST_ASSERT_TRUE(columnar.close());
+
+    const ReceiverStats_t &stats = receiver.stats;
+    TEST_ASSERT_TRUE(inOrder);
+    TEST_ASSERT_EQUAL_UINT32(FRAMES - FRAMES / 1000, stats.frames);
+    TEST_ASSERT_EQUAL_UINT32(FRAMES / 1000, stats.lost);
+    TEST_ASSERT_EQUAL_UINT32(FRAMES / 2000, stats.late);
+    TEST_ASSERT_EQUAL_UINT32(2 * FRAMES / 5000, stats.invalid);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.restarts);
+
+    // Far above any rig's sample rate, even under sanitizers
+    char message[64];
+    snprintf(message, sizeof(message), "%.0f frames/s on loopback", stats.frames / seconds);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_GREATER_THAN(5000, (uint32_t)(stats.frames / seconds));
+
+    // CSV: a header and one line per frame, NaN left empty
+    FILE *file = fopen(csvPath.c_str(), "r");
+    TEST_ASSERT_NOT_NULL(file);
+    char line[256];
+    TEST_ASSERT_NOT_NULL(fgets(line, sizeof(line), file));
+    TEST_ASSERT_EQUAL_STRING("sequence,timestamp_ms,temp1,temp2,dT,busVoltage,current_mA,power_mW,k,u_k,dacValue,flags\n", line);
+    TEST_ASSERT_NOT_NULL(fgets(line, sizeof(line), file));
+    TEST_ASSERT_EQUAL_STRING("0,0,80,79,1,5,100,500,,0.01,0,1\n", line);
+    TEST_ASSERT_NOT_NULL(fgets(line, sizeof(line), file));
+    TEST_ASSERT_EQUAL_STRING("1,500,80.0001,79.0001,1,5,100,500,0.3,0.01,1,0\n", line);
+    uint32_t lines = 3;
+    while (fgets(line, sizeof(line), file))
+    {
+        lines++;
+    }
+    fclose(file);
+    TEST_ASSERT_EQUAL_UINT32(stats.frames + 1, lines);
+
+    // Columnar: the same values back, bit for bit
+    ColumnarReader reader;
+    TEST_ASSERT_TRUE(reader.open(columnarPath.c_str()));
+    TEST_ASSERT_EQUAL_INT(TELEMETRY_COLUMNS, reader.columns());
+    int sequenceColumn = reader.find("sequence"), temp1Column = reader.find("temp1"), kColumn = reader.find("k");
+    TEST_ASSERT_EQUAL_INT(COLUMN_F32, reader.type(temp1Column));
+    uint32_t groups = 0;
+    bool same = true;
+    while (reader.nextGroup())
+    {
+        groups++;
+        for (uint32_t row = 0; row < reader.rows(); row++)
+        {
+            uint32_t sequence = (uint32_t)reader.number(sequenceColumn, row);
+            TelemetryFrame_t original = makeFrame(sequence);
+            same = same && sequence % 1000 != 500 && (float)reader.number(temp1Column, row) == original.temp1 &&
+                   (isnan(reader.number(kColumn, row)) == isnan(original.thermalConductivity));
+        }
+    }
+    TEST_ASSERT_TRUE(same);
+    TEST_ASSERT_TRUE(reader.complete());
+    TEST_ASSERT_EQUAL_UINT32(stats.frames, reader.rowsRead());
+    TEST_ASSERT_EQUAL_UINT32((stats.frames + 999) / 1000, groups);
+}
+
+void test_columnar_file_cut_short(void)
+{
+    ColumnarWriter writer(100);
+    TEST_ASSERT_TRUE(writer.open(columnarPath.c_str(), telemetryColumns, TELEMETRY_COLUMNS));
+    for (uint32_t i = 0; i < 250; i++)
+    {
+        TelemetryFrame_t frame = makeFrame(i);
+        writer.append(&frame);
+    }
+    TEST_ASSERT_TRUE(writer.flush()); // 3 groups on disk, as after a crash
+    FILE *file = fopen(columnarPath.c_str(), "rb");
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    TEST_ASSERT_EQUAL_INT(0, truncate(columnarPath.c_str(), size - 10)); // Last group torn
+
+    ColumnarReader reader;
+    TEST_ASSERT_TRUE(reader.open(columnarPath.c_str()));
+    int groups = 0;
+    while (reader.nextGroup())
+    {
+        TEST_ASSERT_EQUAL_UINT32(100, reader.rows());
+        TEST_ASSERT_EQUAL_UINT32(groups * 100 + 99, (uint32_t)reader.number(reader.find("sequence"), 99));
+        groups++;
+    }
+    TEST_ASSERT_EQUAL_INT(2, groups);
+    TEST_ASSERT_EQUAL_UINT32(200, reader.rowsRead());
+    TEST_ASSERT_FALSE(reader.complete());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_sequence_tracker);
+    RUN_TEST(test_parse_rejects_bad_datagrams);
+    RUN_TEST(test_subscribe_over_http);
+    RUN_TEST(test_loopback_loss_and_throughput);
+    RUN_TEST(test_columnar_file_cut_short);
+    return UNITY_END();
+}
@@ -0,0 +1,164 @@
+#include <stdint.h>
+#include <math.h>
+#include <unity.h>
+#include <timeAlign.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#define RAMP_KS 0.5f
+#define PERIOD_US 200000
+#define SKEW_US 50000 // temp2 converts this long after temp1
+
+// Both RTDs sit at the same temperature, a ramp in true time; the skew alone makes a
+// fake ΔT of RAMP_KS·SKEW_US
+static float rampAt(uint32_t t0, uint32_t tUs) { return 80 + RAMP_KS * (int32_t)(tUs - t0) * 1e-6f; }
+
+static void test_float_ramp_residual(void)
+{
+    TimeAligner<2, 5> aligner;
+    aligner.reset();
+    uint32_t t0 = 0xFFFFFFFFu - 300000; // Wraps after the second pair
+    float residual = 0;
+    for (int i = 0; i < 12; i++)
+    {
+        uint32_t t1 = t0 + i * PERIOD_US, t2 = t1 + SKEW_US;
+        aligner.push(0, t1, rampAt(t0, t1));
+        aligner.push(1, t2, rampAt(t0, t2));
+        uint32_t grid = t1 + (t2 - t1) / 2;
+        float aligned1 = rampAt(t0, t1) + aligner.shift(0, grid);
+        float aligned2 = rampAt(t0, t2) + aligner.shift(1, grid);
+        residual = aligned1 - aligned2;
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, RAMP_KS, aligner.slope(0));
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, RAMP_KS, aligner.slope(1));
+    TEST_ASSERT_FLOAT_WITHIN(0.0005f, 0, residual); // vs 25 mK unaligned
+}
+
+static void test_fixed_ramp_residual(void)
+{
+    TimeAlignerQ<2, 5> aligner;
+    aligner.reset();
+    uint32_t t0 = 0xFFFFFFFFu - 300000;
+    Q16 residual = Q16::fromRaw(0);
+    for (int i = 0; i < 12; i++)
+    {
+        uint32_t t1 = t0 + i * PERIOD_US, t2 = t1 + SKEW_US;
+        Q16 reading1 = Q16::fromFloat(rampAt(t0, t1));
+        Q16 reading2 = Q16::fromFloat(rampAt(t0, t2));
+        aligner.push(0, t1, reading1);
+        aligner.push(1, t2, reading2);
+        uint32_t grid = t1 + (t2 - t1) / 2;
+        residual = (reading1 + aligner.shift(0, grid)) - (reading2 + aligner.shift(1, grid));
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, RAMP_KS, aligner.slope(0).toFloat());
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, RAMP_KS, aligner.slope(1).toFloat());
+    TEST_ASSERT_FLOAT_WITHIN(0.0005f, 0, residual.toFloat());
+}
+
+// Readings hours apart: the time scaling still fits, the sums do not overflow
+static void test_fixed_slow_and_long(void)
+{
+    TimeAlignerQ<1, 8> aligner;
+    aligner.reset();
+    for (int i = 0; i < 8; i++)
+    {
+        aligner.push(0, (uint32_t)i * 500000000u, Q16::fromFloat(4 - 0.001f * i * 500)); // −1 mK/s over 58 min
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.00002f, -0.001f, aligner.slope(0).toFloat());
+}
+
+static void test_steady_and_short_history(void)
+{
+    TimeAligner<1, 4> aligner;
+    TimeAlignerQ<1, 4> alignerQ;
+    aligner.reset();
+    alignerQ.reset();
+    aligner.push(0, 1000, 77);
+    alignerQ.push(0, 1000, Q16::fromFloat(77));
+    TEST_ASSERT_EQUAL_INT(1, aligner.count(0));
+    TEST_ASSERT_EQUAL_FLOAT(0, aligner.shift(0, 100000)); // One reading has no slope
+    TEST_ASSERT_EQUAL_INT32(0, alignerQ.shift(0, 100000).raw);
+
+    for (int i = 1; i < 6; i++)
+    {
+        aligner.push(0, 1000 + i * PERIOD_US, 77);
+        alignerQ.push(0, 1000 + i * PERIOD_US, Q16::fromFloat(77));
+    }
+    TEST_ASSERT_EQUAL_INT(4, aligner.count(0));
+    TEST_ASSERT_EQUAL_INT(4, alignerQ.count(0));
+    TEST_ASSERT_EQUAL_FLOAT(0, aligner.shift(0, 1000 + 5 * PERIOD_US + 100000));
+    TEST_ASSERT_EQUAL_INT32(0, alignerQ.shift(0, 1000 + 5 * PERIOD_US + 100000).raw);
+}
+
+// Past TIME_ALIGN_MAX_SHIFT_US either way the reading is not moved at all
+static void test_max_shift_clamp(void)
+{
+    TimeAligner<1, 4> aligner;
+    TimeAlignerQ<1, 4> alignerQ;
+    aligner.reset();
+    alignerQ.reset();
+    for (int i = 0; i < 3; i++)
+    {
+        aligner.push(0, i * 100000, 10 + 2.0f * i * 0.1f); // 2 K/s
+        alignerQ.push(0, i * 100000, Q16::fromFloat(10 + 2.0f * i * 0.1f));
+    }
+    uint32_t newest = 200000;
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, aligner.shift(0, newest + TIME_ALIGN_MAX_SHIFT_US));
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, -1.0f, aligner.shift(0, newest - TIME_ALIGN_MAX_SHIFT_US));
+    TEST_ASSERT_EQUAL_FLOAT(0, aligner.shift(0, newest + TIME_ALIGN_MAX_SHIFT_US + 1));
+    TEST_ASSERT_EQUAL_FLOAT(0, aligner.shift(0, newest - TIME_ALIGN_MAX_SHIFT_US - 1));
+
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 1.0f, alignerQ.shift(0, newest + TIME_ALIGN_MAX_SHIFT_US).toFloat());
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, -1.0f, alignerQ.shift(0, newest - TIME_ALIGN_MAX_SHIFT_US).toFloat());
+    TEST_ASSERT_EQUAL_INT32(0, alignerQ.shift(0, newest + TIME_ALIGN_MAX_SHIFT_US + 1).raw);
+    TEST_ASSERT_EQUAL_INT32(0, alignerQ.shift(0, newest - TIME_ALIGN_MAX_SHIFT_US - 1).raw);
+}
+
+static void test_reset_forgets_history(void)
+{
+    TimeAlignerQ<2, 4> aligner;
+    aligner.reset();
+    aligner.push(1, 0, Q16::fromFloat(10));
+    aligner.push(1, 100000, Q16::fromFloat(11));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 10, aligner.slope(1).toFloat());
+    TEST_ASSERT_EQUAL_INT(0, aligner.count(0));
+    aligner.reset();
+    TEST_ASSERT_EQUAL_INT(0, aligner.count(1));
+    TEST_ASSERT_EQUAL_INT32(0, aligner.slope(1).raw);
+}
+
+// Ties go to the lowest index, so both medians of a steady pair pick the same entry
+static void test_median_index_ties(void)
+{
+    const float allEqual[5] = {2, 2, 2, 2, 2};
+    TEST_ASSERT_EQUAL_INT(0, medianIndex(allEqual, 5));
+    const float tiedMedian[5] = {3, 1, 3, 2, 3};
+    TEST_ASSERT_EQUAL_INT(0, medianIndex(tiedMedian, 5));
+    const float tiedBelow[5] = {5, 4, 4, 1, 9};
+    TEST_ASSERT_EQUAL_INT(1, medianIndex(tiedBelow, 5));
+    const float even[4] = {3, 2, 2, 1}; // Upper median, rank size / 2
+    TEST_ASSERT_EQUAL_INT(1, medianIndex(even, 4));
+    const float plain[5] = {9, 7, 8, 1, 2};
+    TEST_ASSERT_EQUAL_INT(1, medianIndex(plain, 5));
+
+    Q16 fixed[5];
+    for (int i = 0; i < 5; i++)
+    {
+        fixed[i] = Q16::fromFloat(tiedMedian[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(0, medianIndex(fixed, 5));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_float_ramp_residual);
+    RUN_TEST(test_fixed_ramp_residual);
+    RUN_TEST(test_fixed_slow_and_long);
+    RUN_TEST(test_steady_and_short_history);
+    RUN_TEST(test_max_shift_clamp);
+    RUN_TEST(test_reset_forgets_history);
+    RUN_TEST(test_median_index_ties);
+    return UNITY_END();
+}
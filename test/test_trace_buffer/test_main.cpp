@@ -0,0 +1,324 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include <unity.h>
+#include <traceBuffer.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+#define CPU_MHZ 240
+#define US_PER_TICK 1000
+
+// Minimal JSON checker: true when text is exactly one well-formed value
+static bool jsonValue(const char *&p);
+
+static void jsonSpace(const char *&p)
+{
+    while (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')
+    {
+        p++;
+    }
+}
+
+static bool jsonString(const char *&p)
+{
+    if (*p != '"')
+    {
+        return false;
+    }
+    for (p++; *p && *p != '"'; p++)
+    {
+        if ((unsigned char)*p < 0x20)
+        {
+            return false;
+        }
+        if (*p == '\\' && !*++p)
+        {
+            return false;
+        }
+    }
+    return *p++ == '"';
+}
+
+static bool jsonNumber(const char *&p)
+{
+    char *end;
+    strtod(p, &end);
+    if (end == p || !(*p == '-' || (*p >= '0' && *p <= '9')))
+    {
+        return false;
+    }
+    p = end;
+    return true;
+}
+
+template <typename Item>
+static bool jsonList(const char *&p, char close, Item item)
+{
+    p++;
+    jsonSpace(p);
+    if (*p == close)
+    {
+        p++;
+        return true;
+    }
+    for (;;)
+    {
+        jsonSpace(p);
+        if (!item(p))
+        {
+            return false;
+        }
+        jsonSpace(p);
+        if (*p == close)
+        {
+            p++;
+            return true;
+        }
+        if (*p++ != ',')
+        {
+            return false;
+        }
+    }
+}
+
+static bool jsonValue(const char *&p)
+{
+    jsonSpace(p);
+    if (*p == '{')
+    {
+        return jsonList(p, '}', [](const char *&q) {
+            if (!jsonString(q))
+            {
+                return false;
+            }
+            jsonSpace(q);
+            if (*q++ != ':')
+            {
+                return false;
+            }
+            return jsonValue(q);
+        });
+    }
+    if (*p == '[')
+    {
+        return jsonList(p, ']', [](const char *&q) { return jsonValue(q); });
+    }
+    if (*p == '"')
+    {
+        return jsonString(p);
+    }
+    for (const char *word : {"true", "false", "null"})
+    {
+        if (strncmp(p, word, strlen(word)) == 0)
+        {
+            p += strlen(word);
+            return true;
+        }
+    }
+    return jsonNumber(p);
+}
+
+static bool jsonValid(const std::string &text)
+{
+    const char *p = text.c_str();
+    if (!jsonValue(p))
+    {
+        return false;
+    }
+    jsonSpace(p);
+    return *p == '\0';
+}
+
+struct Exported
+{
+    std::string json;
+    uint32_t count;
+    std::vector<std::string> events;
+};
+
+// Frames the events as /trace does: an array, a comma before all but the first
+template <uint16_t N, int Cores>
+static Exported exportTrace(const TraceBuffer<N, Cores> &trace)
+{
+    Exported out;
+    out.json = "[";
+    int firsts = 0;
+    out.count = trace.exportJson(CPU_MHZ, US_PER_TICK, [&](const char *text, size_t length, bool first) {
+        firsts += first;
+        if (!first)
+        {
+            out.json += ',';
+        }
+        out.json.append(text, length);
+        out.events.push_back(std::string(text, length));
+    });
+    out.json += "]";
+    TEST_ASSERT_EQUAL_INT(out.count ? 1 : 0, firsts);
+    return out;
+}
+
+static double field(const std::string &event, const char *key)
+{
+    const char *p = strstr(event.c_str(), key);
+    TEST_ASSERT_NOT_NULL(p);
+    return strtod(p + strlen(key), nullptr);
+}
+
+static void test_format_event(void)
+{
+    TraceEvent_t event = {0, 0, "acq", 0x3FFB1234, TRACE_PHASE_BEGIN, 1};
+    char line[160];
+    int n = traceFormatEvent(line, sizeof(line), event, 1234.5678);
+    TEST_ASSERT_EQUAL_INT((int)strlen(line), n);
+    TEST_ASSERT_EQUAL_STRING("{\"name\":\"acq\",\"ph\":\"B\",\"ts\":1234.568,\"pid\":1,\"tid\":1073418804}", line);
+    TEST_ASSERT_TRUE(jsonValid(line));
+
+    event.phase = TRACE_PHASE_INSTANT;
+    traceFormatEvent(line, sizeof(line), event, 0);
+    TEST_ASSERT_TRUE(strstr(line, ",\"s\":\"t\"}") != nullptr);
+    TEST_ASSERT_TRUE(jsonValid(line));
+}
+
+// Two cores with unrelated cycle counters that wrap every ~17.9 s at 240 MHz, and a
+// shared tick that wraps too. Exported times are monotonic per core and agree with
+// the true time across cores to well within a tick.
+static void test_wrapped_cycles_two_cores(void)
+{
+    static TraceBuffer<4096, 2> trace;
+    const uint32_t cycleOffset[2] = {0xFFF00000u, 0x12345678u};
+    const uint32_t tickStart = 0xFFFFFFFFu - 30000; // The tick wraps 30 s in
+    const double originUs = (double)tickStart * US_PER_TICK;
+    std::vector<double> trueUs[2];
+
+    // 60 s of events, 29989 µs apart on core 0 and 19997 µs on core 1
+    for (int c = 0; c < 2; c++)
+    {
+        const uint64_t step = c == 0 ? 29989 : 19997;
+        for (uint64_t t = 250 + c * 111; t < 60000000; t += step)
+        {
+            uint32_t cycles = (uint32_t)(t * CPU_MHZ) + cycleOffset[c];
+            uint32_t tick = tickStart + (uint32_t)(t / US_PER_TICK);
+            trace.write(c, 0x1000 + c, cycles, tick, trueUs[c].size() % 2 ? "end" : "begin",
+                        trueUs[c].size() % 2 ? TRACE_PHASE_END : TRACE_PHASE_BEGIN);
+            trueUs[c].push_back(originUs + t);
+        }
+        TEST_ASSERT_TRUE(trueUs[c].size() < 4096); // Nothing overwritten in this test
+    }
+
+    Exported out = exportTrace(trace);
+    TEST_ASSERT_TRUE(jsonValid(out.json));
+    TEST_ASSERT_EQUAL_UINT32(trueUs[0].size() + trueUs[1].size(), out.count);
+
+    size_t next[2] = {0, 0};
+    double lastTs[2] = {-1, -1};
+    double worstUs = 0;
+    for (const std::string &event : out.events)
+    {
+        int core = (int)field(event, "\"pid\":");
+        double ts = field(event, "\"ts\":");
+        TEST_ASSERT_TRUE(ts > lastTs[core]);
+        double error = ts - trueUs[core][next[core]++];
+        worstUs = fabs(error) > worstUs ? fabs(error) : worstUs;
+        // Within a core the cycle counter gives the spacing exactly
+        if (next[core] > 1)
+        {
+            double spacing = trueUs[core][next[core] - 1] - trueUs[core][next[core] - 2];
+            TEST_ASSERT_DOUBLE_WITHIN(0.01, spacing, ts - lastTs[core]);
+        }
+        lastTs[core] = ts;
+    }
+    TEST_ASSERT_TRUE(next[0] == trueUs[0].size() && next[1] == trueUs[1].size());
+    TEST_ASSERT_DOUBLE_WITHIN(US_PER_TICK / 10.0, 0, worstUs);
+}
+
+// The ring keeps the newest N events; older indices no longer read
+static void test_overwritten_slots_are_skipped(void)
+{
+    TraceRing<8> ring;
+    TraceEvent_t event = {0, 0, "x", 1, TRACE_PHASE_INSTANT, 0};
+    for (uint32_t i = 0; i < 20; i++)
+    {
+        event.cycles = i * CPU_MHZ;
+        ring.write(event);
+    }
+    TEST_ASSERT_EQUAL_UINT32(20, ring.written());
+    TEST_ASSERT_EQUAL_UINT32(12, ring.oldest());
+
+    TraceEvent_t out;
+    for (uint32_t i = 0; i < 12; i++)
+    {
+        TEST_ASSERT_FALSE(ring.read(i, out)); // Same slot now holds event i + 8k
+    }
+    for (uint32_t i = 12; i < 20; i++)
+    {
+        TEST_ASSERT_TRUE(ring.read(i, out));
+        TEST_ASSERT_EQUAL_UINT32(i * CPU_MHZ, out.cycles);
+    }
+    TEST_ASSERT_FALSE(ring.read(20, out)); // Not written yet
+}
+
+// Export after wrapping the ring: only the surviving events, still monotonic and valid
+static void test_export_after_overwrite(void)
+{
+    static TraceBuffer<64, 2> trace;
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        trace.write(0, 7, i * 1000 * CPU_MHZ, i, "a", i % 2 ? TRACE_PHASE_END : TRACE_PHASE_BEGIN);
+    }
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        trace.write(1, 9, 0x80000000u + i * 500 * CPU_MHZ, i / 2, "b", TRACE_PHASE_INSTANT);
+    }
+
+    Exported out = exportTrace(trace);
+    TEST_ASSERT_TRUE(jsonValid(out.json));
+    TEST_ASSERT_EQUAL_UINT32(64 + 10, out.count);
+
+    double last = -1;
+    for (int i = 0; i < 64; i++)
+    {
+        double ts = field(out.events[i], "\"ts\":");
+        TEST_ASSERT_TRUE(ts > last);
+        last = ts;
+    }
+    // The oldest surviving event on core 0 is event 936, 936 ms on the tick clock
+    TEST_ASSERT_DOUBLE_WITHIN(1, 936000, field(out.events[0], "\"ts\":"));
+}
+
+static void test_empty_export(void)
+{
+    static TraceBuffer<16, 2> trace;
+    Exported out = exportTrace(trace);
+    TEST_ASSERT_EQUAL_UINT32(0, out.count);
+    TEST_ASSERT_EQUAL_STRING("[]", out.json.c_str());
+    TEST_ASSERT_TRUE(jsonValid(out.json));
+}
+
+// The checker itself rejects what a broken framing would produce
+static void test_json_checker(void)
+{
+    TEST_ASSERT_TRUE(jsonValid("[{\"a\":1.5,\"b\":\"x\"},{\"c\":[true,null]}]"));
+    TEST_ASSERT_FALSE(jsonValid("[{\"a\":1},]"));
+    TEST_ASSERT_FALSE(jsonValid("[,{\"a\":1}]"));
+    TEST_ASSERT_FALSE(jsonValid("[{\"a\":1}{\"b\":2}]"));
+    TEST_ASSERT_FALSE(jsonValid("[{\"a\":1}"));
+    TEST_ASSERT_FALSE(jsonValid("{\"a\":}"));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_json_checker);
+    RUN_TEST(test_format_event);
+    RUN_TEST(test_wrapped_cycles_two_cores);
+    RUN_TEST(test_overwritten_slots_are_skipped);
+    RUN_TEST(test_export_after_overwrite);
+    RUN_TEST(test_empty_export);
+    return UNITY_END();
+}
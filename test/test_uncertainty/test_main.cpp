@@ -0,0 +1,121 @@
+#include <stdint.h>
+#include <unity.h>
+#include <uncertainty.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Two-pass statistics over the last UNCERTAINTY_WINDOW samples, the reference for the rolling ones
+static void bruteForce(const float *x, const float *y, int end, double &vx, double &vy, double &cxy)
+{
+    int start = end > UNCERTAINTY_WINDOW ? end - UNCERTAINTY_WINDOW : 0;
+    int n = end - start;
+    double mx = 0, my = 0;
+    for (int i = start; i < end; i++)
+    {
+        mx += x[i];
+        my += y[i];
+    }
+    mx /= n;
+    my /= n;
+    vx = vy = cxy = 0;
+    for (int i = start; i < end; i++)
+    {
+        vx += (x[i] - mx) * (x[i] - mx);
+        vy += (y[i] - my) * (y[i] - my);
+        cxy += (x[i] - mx) * (y[i] - my);
+    }
+    vx /= n - 1;
+    vy /= n - 1;
+    cxy /= n - 1;
+}
+
+void test_rolling_matches_two_pass_over_window(void)
+{
+    static float x[500], y[500];
+    uint32_t seed = 12345;
+    RollingCovariance stats;
+    stats.reset();
+    for (int i = 0; i < 500; i++)
+    {
+        seed = seed * 1664525 + 1013904223;
+        float noise = (int)(seed >> 16 & 0xFFFF) / 65536.0f - 0.5f;
+        // Slow drift plus correlated noise, like P and ΔT during a heater step
+        x[i] = 1500.0f + i * 0.8f + 20 * noise;
+        y[i] = 12.0f + i * 0.01f + 0.3f * noise;
+        stats.push(x[i], y[i]);
+        if (i < 2)
+        {
+            continue;
+        }
+        double vx, vy, cxy;
+        bruteForce(x, y, i + 1, vx, vy, cxy);
+        TEST_ASSERT_EQUAL_INT(i + 1 < UNCERTAINTY_WINDOW ? i + 1 : UNCERTAINTY_WINDOW, stats.count());
+        TEST_ASSERT_DOUBLE_WITHIN(1e-6 * vx + 1e-9, vx, stats.varX());
+        TEST_ASSERT_DOUBLE_WITHIN(1e-6 * vy + 1e-9, vy, stats.varY());
+        TEST_ASSERT_DOUBLE_WITHIN(1e-6 * fabs(cxy) + 1e-9, cxy, stats.covXY());
+    }
+}
+
+void test_constant_input_has_no_dispersion(void)
+{
+    RollingCovariance stats;
+    stats.reset();
+    for (int i = 0; i < 3 * UNCERTAINTY_WINDOW; i++)
+    {
+        stats.push(1000.0f, 10.0f);
+    }
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 0, stats.varX());
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 0, stats.varY());
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 0, stats.covXY());
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 1000, stats.meanOfX());
+}
+
+void test_gum_geometry_only(void)
+{
+    // No scatter: (u_k/k)² = (u_L/L)² + (2·u_d/d)²
+    RollingCovariance stats;
+    stats.reset();
+    float u = conductivityUncertainty(0.2f, 1500, 12, 5.0f, 20.0f, stats, 0.01f, 0.01f);
+    double rel = sqrt(pow(0.01 / 5.0, 2) + pow(2 * 0.01 / 20.0, 2));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.2 * rel, u);
+}
+
+void test_gum_correlation_reduces_uncertainty(void)
+{
+    // P and ΔT moving together cancel in k = P/ΔT, moving apart add up
+    RollingCovariance together, apart;
+    together.reset();
+    apart.reset();
+    for (int i = 0; i < UNCERTAINTY_WINDOW; i++)
+    {
+        float s = (i % 2) ? 1.0f : -1.0f;
+        together.push(1500 + 15 * s, 12 + 0.12f * s);
+        apart.push(1500 + 15 * s, 12 - 0.12f * s);
+    }
+    float uTogether = conductivityUncertainty(0.2f, 1500, 12, 5.0f, 20.0f, together, 0, 0);
+    float uApart = conductivityUncertainty(0.2f, 1500, 12, 5.0f, 20.0f, apart, 0, 0);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0, uTogether); // Same relative scatter, fully correlated
+    double rel = sqrt(apart.varX() / (1500.0 * 1500) + apart.varY() / (12.0 * 12) - 2 * apart.covXY() / (1500.0 * 12));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6, 0.2 * rel, uApart);
+}
+
+void test_gum_degenerate_inputs(void)
+{
+    RollingCovariance stats;
+    stats.reset();
+    TEST_ASSERT_EQUAL_FLOAT(0, conductivityUncertainty(0, 1500, 12, 5, 20, stats, 0.01f, 0.01f));
+    TEST_ASSERT_EQUAL_FLOAT(0, conductivityUncertainty(0.2f, 1500, 0, 5, 20, stats, 0.01f, 0.01f));
+    TEST_ASSERT_EQUAL_FLOAT(0, conductivityUncertainty(0.2f, 1500, 12, 0, 20, stats, 0.01f, 0.01f));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_rolling_matches_two_pass_over_window);
+    RUN_TEST(test_constant_input_has_no_dispersion);
+    RUN_TEST(test_gum_geometry_only);
+    RUN_TEST(test_gum_correlation_reduces_uncertainty);
+    RUN_TEST(test_gum_degenerate_inputs);
+    return UNITY_END();
+}
@@ -0,0 +1,202 @@
+// cryo-aggregate: records the telemetry of many rigs into one time-aligned table, a row
+// per time bin with a column per rig and channel.
+//   g++ -std=gnu++17 -O2 -pthread -Isrc -Itools tools/cryoAggregate.cpp -o cryo-aggregate
+//   ./cryo-aggregate --columnar lab.cryc                    (rigs found by mDNS)
+//   ./cryo-aggregate --rig left=10.0.0.21 --rig 10.0.0.22 --csv lab.csv
+#include <signal.h>
+#include <time.h>
+#include <memory>
+#include <mdnsDiscovery.h>
+#include <fleetAggregator.h>
+
+#define STATUS_INTERVAL_S 10
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int) { stopRequested = 1; }
+
+static double monotonicSeconds()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static void usage()
+{
+    fprintf(stderr, "Usage: cryo-aggregate [options]\n"
+                    "  --rig [NAME=]HOST[:httpPort]  a rig to record, repeatable (default: discover them)\n"
+                    "  --discover S        browse mDNS for S s for _cryo._udp rigs (default 3)\n"
+                    "  --bin-ms N          row interval in ms (default 1000)\n"
+                    "  --late-ms N         wait for late frames before a row is written (default 2000)\n"
+                    "  --base-port N       UDP ports N, N+1, ... one per rig (default: any free)\n"
+                    "  --csv FILE          write rows as CSV (default: CSV on stdout)\n"
+                    "  --columnar FILE     write rows to a columnar file (tools/tableWriter.h)\n"
+                    "  --seconds N         stop after N s (default: Ctrl-C)\n");
+}
+
+static void printStats(const FleetAggregator &fleet, double seconds)
+{
+    fprintf(stderr, "%.1f s:\n", seconds);
+    for (int r = 0; r < fleet.rigCount(); r++)
+    {
+        RigStats_t stats = fleet.stats(r);
+        fprintf(stderr,
+                "  %-20s port %u, subscribe %d, %llu frames, %llu lost, %llu late, %llu too late, %u restarts, "
+                "clock %+.0f ms\n",
+                fleet.rigName(r).c_str(), stats.udpPort, stats.subscribeStatus, (unsigned long long)stats.receiver.frames,
+                (unsigned long long)stats.receiver.lost, (unsigned long long)stats.receiver.late,
+                (unsigned long long)stats.tooLate, stats.receiver.restarts, stats.clockOffsetMs);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<const char *> rigTargets;
+    double discoverSeconds = 3;
+    long binMs = 1000, lateMs = 2000, basePort = 0;
+    const char *csvPath = nullptr;
+    const char *columnarPath = nullptr;
+    double duration = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value)
+        {
+            usage();
+            return 2;
+        }
+        if (strcmp(arg, "--rig") == 0)
+        {
+            rigTargets.push_back(value);
+        }
+        else if (strcmp(arg, "--discover") == 0)
+        {
+            discoverSeconds = strtod(value, nullptr);
+        }
+        else if (strcmp(arg, "--bin-ms") == 0)
+        {
+            binMs = strtol(value, nullptr, 10);
+        }
+        else if (strcmp(arg, "--late-ms") == 0)
+        {
+            lateMs = strtol(value, nullptr, 10);
+        }
+        else if (strcmp(arg, "--base-port") == 0)
+        {
+            basePort = strtol(value, nullptr, 10);
+        }
+        else if (strcmp(arg, "--csv") == 0)
+        {
+            csvPath = value;
+        }
+        else if (strcmp(arg, "--columnar") == 0)
+        {
+            columnarPath = value;
+        }
+        else if (strcmp(arg, "--seconds") == 0)
+        {
+            duration = strtod(value, nullptr);
+        }
+        else
+        {
+            usage();
+            return 2;
+        }
+        i++;
+    }
+    if (binMs < 1 || lateMs < 0 || basePort < 0 || basePort > 65535 || (csvPath && columnarPath))
+    {
+        usage();
+        return 2;
+    }
+
+    signal(SIGINT, requestStop);
+    signal(SIGTERM, requestStop);
+    signal(SIGPIPE, SIG_IGN);
+
+    FleetAggregator fleet;
+    for (const char *target : rigTargets)
+    {
+        const char *equals = strchr(target, '=');
+        std::string host;
+        uint16_t httpPort = 80;
+        if (!parseHostPort(equals ? equals + 1 : target, host, httpPort))
+        {
+            fprintf(stderr, "Bad host: %s\n", target);
+            return 2;
+        }
+        fleet.addRig(equals ? std::string(target, equals - target) : std::string(target), host, httpPort);
+    }
+    if (rigTargets.empty())
+    {
+        std::vector<DiscoveredRig> found = mdnsDiscover((int)(discoverSeconds * 1000));
+        for (const DiscoveredRig &rig : found)
+        {
+            fprintf(stderr, "Found %s at %s (%s) http %u, udp %u", rig.name.c_str(), rig.host.c_str(), rig.address.c_str(),
+                    rig.httpPort, rig.udpPort);
+            for (const auto &entry : rig.txt)
+            {
+                fprintf(stderr, " %s=%s", entry.first.c_str(), entry.second.c_str());
+            }
+            fprintf(stderr, "\n");
+            fleet.addRig(rig.name, rig.address, rig.httpPort);
+        }
+    }
+    if (fleet.rigCount() == 0)
+    {
+        fprintf(stderr, "No rigs: none answered on mDNS, name them with --rig\n");
+        return 1;
+    }
+    if (!fleet.start(binMs, lateMs, basePort))
+    {
+        fprintf(stderr, "Cannot bind UDP ports: %s\n", strerror(errno));
+        return 1;
+    }
+
+    FleetTable table;
+    table.begin(fleet);
+    std::unique_ptr<TableWriter> writer;
+    if (columnarPath)
+    {
+        writer.reset(new ColumnarWriter());
+    }
+    else
+    {
+        writer.reset(new CsvWriter());
+    }
+    const char *path = columnarPath ? columnarPath : csvPath ? csvPath : "-";
+    if (!writer->open(path, table.columns(), table.count()))
+    {
+        fprintf(stderr, "Cannot write %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    bool ok = true;
+    auto emit = [&](int64_t startMs, const float *means) {
+        if (ok && !writer->append(table.fill(startMs, means)))
+        {
+            fprintf(stderr, "Write to %s failed: %s\n", path, strerror(errno));
+            ok = false;
+        }
+    };
+
+    double start = monotonicSeconds();
+    double lastStatus = start;
+    while (ok && !stopRequested && (duration <= 0 || monotonicSeconds() - start < duration))
+    {
+        fleet.poll(200, emit);
+        double now = monotonicSeconds();
+        if (now - lastStatus >= STATUS_INTERVAL_S)
+        {
+            printStats(fleet, now - start);
+            lastStatus = now;
+        }
+    }
+
+    fleet.stop(emit);
+    ok = writer->close() && ok;
+    printStats(fleet, monotonicSeconds() - start);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,184 @@
+// cryo-receive: records the UDP telemetry of one rig to CSV or a columnar file.
+//   g++ -std=gnu++17 -O2 -Isrc -Itools tools/cryoReceive.cpp -o cryo-receive
+//   ./cryo-receive --subscribe cryo.local --columnar run1.cryc
+#include <signal.h>
+#include <time.h>
+#include <memory>
+#include <telemetryReceiver.h>
+#include <tableWriter.h>
+
+#define STATUS_INTERVAL_S 10
+#define RESUBSCRIBE_SILENCE_S 10 // A rebooted rig has forgotten its subscribers
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int) { stopRequested = 1; }
+
+static double monotonicSeconds()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static void usage()
+{
+    fprintf(stderr,
+            "Usage: cryo-receive [options]\n"
+            "  --port N            UDP port to listen on (default %d)\n"
+            "  --subscribe HOST    subscribe at HOST[:httpPort] now, unsubscribe at exit\n"
+            "  --csv FILE          write frames as CSV (default: CSV on stdout)\n"
+            "  --columnar FILE     write frames to a columnar file (tools/tableWriter.h)\n"
+            "  --seconds N         stop after N s (default: Ctrl-C)\n",
+            TELEMETRY_PORT);
+}
+
+static void printStats(const ReceiverStats_t &stats, double seconds)
+{
+    uint64_t expected = stats.frames + stats.lost;
+    fprintf(stderr, "%.1f s: %llu frames (%.1f/s), %llu lost (%.3f %%), %llu late, %llu invalid, %u restarts\n", seconds,
+            (unsigned long long)stats.frames, seconds > 0 ? stats.frames / seconds : 0.0, (unsigned long long)stats.lost,
+            expected ? 100.0 * stats.lost / expected : 0.0, (unsigned long long)stats.late,
+            (unsigned long long)stats.invalid, stats.restarts);
+}
+
+static bool subscribe(const std::string &host, uint16_t httpPort, uint16_t udpPort)
+{
+    std::string body;
+    int status = telemetrySubscribe(host.c_str(), httpPort, udpPort, true, &body);
+    if (status != 200)
+    {
+        fprintf(stderr, "Subscribe at %s:%u failed (%d) %s\n", host.c_str(), httpPort, status, body.c_str());
+        return false;
+    }
+    fprintf(stderr, "%s\n", body.c_str());
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    long port = TELEMETRY_PORT;
+    const char *subscribeTarget = nullptr;
+    const char *csvPath = nullptr;
+    const char *columnarPath = nullptr;
+    double duration = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value)
+        {
+            usage();
+            return 2;
+        }
+        if (strcmp(arg, "--port") == 0)
+        {
+            port = strtol(value, nullptr, 10);
+        }
+        else if (strcmp(arg, "--subscribe") == 0)
+        {
+            subscribeTarget = value;
+        }
+        else if (strcmp(arg, "--csv") == 0)
+        {
+            csvPath = value;
+        }
+        else if (strcmp(arg, "--columnar") == 0)
+        {
+            columnarPath = value;
+        }
+        else if (strcmp(arg, "--seconds") == 0)
+        {
+            duration = strtod(value, nullptr);
+        }
+        else
+        {
+            usage();
+            return 2;
+        }
+        i++;
+    }
+    if (port < 1 || port > 65535 || (csvPath && columnarPath))
+    {
+        usage();
+        return 2;
+    }
+
+    std::string host;
+    uint16_t httpPort = 80;
+    if (subscribeTarget && !parseHostPort(subscribeTarget, host, httpPort))
+    {
+        fprintf(stderr, "Bad host: %s\n", subscribeTarget);
+        return 2;
+    }
+
+    signal(SIGINT, requestStop);
+    signal(SIGTERM, requestStop);
+    signal(SIGPIPE, SIG_IGN);
+
+    TelemetryReceiver receiver;
+    if (!receiver.open(port))
+    {
+        fprintf(stderr, "Cannot bind UDP port %ld: %s\n", port, strerror(errno));
+        return 1;
+    }
+
+    std::unique_ptr<TableWriter> writer;
+    if (columnarPath)
+    {
+        writer.reset(new ColumnarWriter());
+    }
+    else
+    {
+        writer.reset(new CsvWriter());
+    }
+    const char *path = columnarPath ? columnarPath : csvPath ? csvPath : "-";
+    if (!writer->open(path, telemetryColumns, TELEMETRY_COLUMNS))
+    {
+        fprintf(stderr, "Cannot write %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    if (!host.empty())
+    {
+        subscribe(host, httpPort, port);
+    }
+
+    double start = monotonicSeconds();
+    double lastStatus = start, lastFrame = start;
+    bool ok = true;
+    while (!stopRequested && (duration <= 0 || monotonicSeconds() - start < duration))
+    {
+        TelemetryFrame_t frame;
+        if (receiver.next(frame, 200))
+        {
+            ok = writer->append(&frame);
+            if (!ok)
+            {
+                fprintf(stderr, "Write to %s failed: %s\n", path, strerror(errno));
+                break;
+            }
+            lastFrame = monotonicSeconds();
+        }
+
+        double now = monotonicSeconds();
+        if (!host.empty() && now - lastFrame > RESUBSCRIBE_SILENCE_S)
+        {
+            subscribe(host, httpPort, port);
+            lastFrame = now;
+        }
+        if (now - lastStatus >= STATUS_INTERVAL_S)
+        {
+            printStats(receiver.stats, now - start);
+            lastStatus = now;
+        }
+    }
+
+    if (!host.empty())
+    {
+        telemetrySubscribe(host.c_str(), httpPort, port, false);
+    }
+    ok = writer->close() && ok;
+    printStats(receiver.stats, monotonicSeconds() - start);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+// cryo-simulate: stand-in rigs on loopback, to try cryo-receive and cryo-aggregate
+// without hardware. Rig i answers HTTP on 127.0.0.1:<http-port + i> with its own clock.
+//   g++ -std=gnu++17 -O2 -pthread -Isrc -Itools tools/cryoSimulate.cpp -o cryo-simulate
+//   ./cryo-simulate --rigs 24 --http-port 8100
+//   ./cryo-aggregate --rig 127.0.0.1:8100 --rig 127.0.0.1:8101 ...
+#include <signal.h>
+#include <memory>
+#include <rigSimulator.h>
+
+static volatile sig_atomic_t stopRequested = 0;
+
+static void requestStop(int) { stopRequested = 1; }
+
+static void usage()
+{
+    fprintf(stderr, "Usage: cryo-simulate [options]\n"
+                    "  --rigs N            rigs to run (default 4)\n"
+                    "  --http-port N       HTTP port of the first rig, the others follow (default 8100)\n"
+                    "  --period-ms N       frame interval (default 500, as the firmware)\n"
+                    "  --loss N            drop every Nth frame (default 0, none)\n");
+}
+
+int main(int argc, char **argv)
+{
+    long rigs = 4, httpPort = 8100, periodMs = 500, loss = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value)
+        {
+            usage();
+            return 2;
+        }
+        long number = strtol(value, nullptr, 10);
+        if (strcmp(arg, "--rigs") == 0)
+        {
+            rigs = number;
+        }
+        else if (strcmp(arg, "--http-port") == 0)
+        {
+            httpPort = number;
+        }
+        else if (strcmp(arg, "--period-ms") == 0)
+        {
+            periodMs = number;
+        }
+        else if (strcmp(arg, "--loss") == 0)
+        {
+            loss = number;
+        }
+        else
+        {
+            usage();
+            return 2;
+        }
+        i++;
+    }
+    if (rigs < 1 || periodMs < 1 || loss < 0 || httpPort < 1 || httpPort + rigs - 1 > 65535)
+    {
+        usage();
+        return 2;
+    }
+
+    signal(SIGINT, requestStop);
+    signal(SIGTERM, requestStop);
+    signal(SIGPIPE, SIG_IGN);
+
+    int64_t epoch = hostTimeMs();
+    std::vector<std::unique_ptr<SimulatedRig>> simulated;
+    for (long i = 0; i < rigs; i++)
+    {
+        simulated.emplace_back(new SimulatedRig());
+        simulated[i]->setLoss(loss);
+        // Clocks far apart, as rigs booted at different times
+        if (!simulated[i]->start(periodMs, (uint32_t)(i * 3600000 + i * 7919), epoch, httpPort + i))
+        {
+            fprintf(stderr, "Cannot listen on 127.0.0.1:%ld: %s\n", httpPort + i, strerror(errno));
+            return 1;
+        }
+    }
+    fprintf(stderr, "%ld rigs on 127.0.0.1:%ld-%ld, Ctrl-C to stop\n", rigs, httpPort, httpPort + rigs - 1);
+    while (!stopRequested)
+    {
+        usleep(200000);
+    }
+    for (std::unique_ptr<SimulatedRig> &rig : simulated)
+    {
+        rig->stop();
+    }
+    return 0;
+}
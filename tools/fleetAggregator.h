@@ -0,0 +1,449 @@
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include <telemetryReceiver.h>
+#include <tableWriter.h>
+
+// Telemetry of many rigs at once, merged into one time-aligned table. Every rig streams
+// to its own UDP port: frames are told apart by port, since a rig's source port changes
+// per frame and simulated rigs all share 127.0.0.1. One poll() loop serves dozens of
+// rigs; the blocking HTTP subscribe calls run on a small thread pool, so an unreachable
+// rig (3 s timeout) holds up neither the others nor the receive loop.
+#define FLEET_CHANNELS 8
+#define FLEET_RESUBSCRIBE_MS 10000 // Silence after which a rig is subscribed again, it may have rebooted
+#define FLEET_CLOCK_CREEP 1e-4     // Offset creep per ms, follows a rig clock up to 100 ppm slow
+
+static const char *const fleetChannelNames[FLEET_CHANNELS] = {"temp1", "temp2", "dT", "busVoltage",
+                                                              "current_mA", "power_mW", "k", "u_k"};
+
+inline void fleetValues(const TelemetryFrame_t &frame, float values[FLEET_CHANNELS])
+{
+    values[0] = frame.temp1;
+    values[1] = frame.temp2;
+    values[2] = frame.dT;
+    values[3] = frame.busVoltage;
+    values[4] = frame.current_mA;
+    values[5] = frame.power_mW;
+    values[6] = frame.thermalConductivity;
+    values[7] = frame.thermalConductivityUnc;
+}
+
+// Maps a rig's timestamp_ms onto the host clock. The offset is the smallest arrival time
+// minus rig time seen (the least delayed frame), so network and scheduling delays do not
+// move samples, and an aligned time is never later than the arrival. It may creep up by
+// FLEET_CLOCK_CREEP to follow a rig clock that runs slow.
+class ClockAlignment
+{
+public:
+    int64_t align(uint32_t rigMs, int64_t hostMs)
+    {
+        if (valid)
+        {
+            rigTime += (int32_t)(rigMs - lastRigMs); // Unwrapped past 49 days
+            offset = fmin(offset + (hostMs - lastHostMs) * FLEET_CLOCK_CREEP, (double)(hostMs - rigTime));
+        }
+        else
+        {
+            rigTime = rigMs;
+            offset = (double)(hostMs - rigTime);
+            valid = true;
+        }
+        lastRigMs = rigMs;
+        lastHostMs = hostMs;
+        return rigTime + (int64_t)floor(offset);
+    }
+
+    // After a rig restart its clock starts over
+    void reset() { valid = false; }
+
+    double offsetMs() const { return offset; }
+
+private:
+    bool valid = false;
+    int64_t rigTime = 0;
+    uint32_t lastRigMs = 0;
+    int64_t lastHostMs = 0;
+    double offset = 0;
+};
+
+// The merged store: host time in bins of binMs, the mean per rig and channel in each. A
+// bin is final once the host clock is lateMs past its end; a sample for a final bin is
+// refused (counted late by the caller).
+class FleetStore
+{
+public:
+    void begin(int rigCount, uint32_t binMilliseconds, uint32_t lateMilliseconds)
+    {
+        rigs = rigCount;
+        binMs = binMilliseconds;
+        lateMs = lateMilliseconds;
+        bins.clear();
+        closedUntil = INT64_MIN;
+        means.assign(rigs * FLEET_CHANNELS, NAN);
+    }
+
+    bool add(int rig, int64_t alignedMs, const float values[FLEET_CHANNELS])
+    {
+        int64_t start = alignedMs - alignedMs % binMs;
+        if (start < closedUntil)
+        {
+            return false;
+        }
+        Bin &bin = bins[start];
+        if (bin.sum.empty())
+        {
+            bin.sum.assign(rigs * FLEET_CHANNELS, 0);
+            bin.count.assign(rigs * FLEET_CHANNELS, 0);
+        }
+        for (int c = 0; c < FLEET_CHANNELS; c++)
+        {
+            if (!isnan(values[c]))
+            {
+                bin.sum[rig * FLEET_CHANNELS + c] += values[c];
+                bin.count[rig * FLEET_CHANNELS + c]++;
+            }
+        }
+        return true;
+    }
+
+    // Calls emit(int64_t startMs, const float *means) for every bin final at nowMs, oldest
+    // first. means holds rigs × FLEET_CHANNELS values, rig by rig, NaN where a rig had
+    // no reading in the bin. Bins nobody had a sample in are skipped.
+    template <typename Emit>
+    void close(int64_t nowMs, Emit emit)
+    {
+        int64_t until = nowMs - lateMs;
+        until -= until % binMs;
+        if (until > closedUntil)
+        {
+            closedUntil = until;
+        }
+        while (!bins.empty() && bins.begin()->first < closedUntil)
+        {
+            emitFirst(emit);
+        }
+    }
+
+    // Emits everything, at the end of a run
+    template <typename Emit>
+    void flush(Emit emit)
+    {
+        while (!bins.empty())
+        {
+            closedUntil = bins.begin()->first + binMs;
+            emitFirst(emit);
+        }
+    }
+
+    size_t openBins() const { return bins.size(); }
+
+private:
+    struct Bin
+    {
+        std::vector<double> sum;
+        std::vector<uint32_t> count;
+    };
+
+    template <typename Emit>
+    void emitFirst(Emit &emit)
+    {
+        const Bin &bin = bins.begin()->second;
+        for (int i = 0; i < rigs * FLEET_CHANNELS; i++)
+        {
+            means[i] = bin.count[i] ? (float)(bin.sum[i] / bin.count[i]) : NAN;
+        }
+        emit(bins.begin()->first, static_cast<const float *>(means.data()));
+        bins.erase(bins.begin());
+    }
+
+    int rigs = 0;
+    uint32_t binMs = 1000;
+    uint32_t lateMs = 0;
+    std::map<int64_t, Bin> bins; // Open, by start
+    int64_t closedUntil = INT64_MIN;
+    std::vector<float> means;
+};
+
+// A few threads for blocking jobs, run in submission order
+class WorkerPool
+{
+public:
+    ~WorkerPool() { stop(); }
+
+    void start(int threads)
+    {
+        stopping = false;
+        for (int i = 0; i < threads; i++)
+        {
+            workers.emplace_back([this] { run(); });
+        }
+    }
+
+    void submit(std::function<void()> job)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(std::move(job));
+        wake.notify_one();
+    }
+
+    // Finishes the queued jobs, then joins
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            wake.notify_all();
+        }
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+        workers.clear();
+    }
+
+private:
+    void run()
+    {
+        for (;;)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (jobs.empty())
+            {
+                return;
+            }
+            std::function<void()> job = std::move(jobs.front());
+            jobs.pop_front();
+            lock.unlock();
+            job();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
+
+typedef struct
+{
+    ReceiverStats_t receiver;
+    uint64_t tooLate;    // Arrived after its bin was final
+    int subscribeStatus; // HTTP status of the last attempt, 0 before one, -1 unreachable
+    uint16_t udpPort;
+    double clockOffsetMs; // Host minus rig clock
+} RigStats_t;
+
+class FleetAggregator
+{
+public:
+    ~FleetAggregator() { pool.stop(); }
+
+    // Before start(), returns the rig's index in the merged rows
+    int addRig(const std::string &name, const std::string &host, uint16_t httpPort)
+    {
+        rigs.emplace_back(new Rig());
+        Rig &rig = *rigs.back();
+        rig.name = name;
+        rig.host = host;
+        rig.httpPort = httpPort;
+        return (int)rigs.size() - 1;
+    }
+
+    // Opens a UDP port per rig (basePort + index, or free ones when 0) and subscribes them
+    bool start(uint32_t binMs, uint32_t lateMs, uint16_t basePort = 0, int threads = 8)
+    {
+        store.begin((int)rigs.size(), binMs, lateMs);
+        for (size_t i = 0; i < rigs.size(); i++)
+        {
+            if (!rigs[i]->receiver.open(basePort ? basePort + i : 0))
+            {
+                return false;
+            }
+            rigs[i]->udpPort = rigs[i]->receiver.port();
+        }
+        poolThreads = threads < (int)rigs.size() ? threads : (int)rigs.size();
+        pool.start(poolThreads);
+        int64_t now = hostTimeMs();
+        for (std::unique_ptr<Rig> &rig : rigs)
+        {
+            rig->lastHeardMs = now;
+            subscribe(*rig, true);
+        }
+        return true;
+    }
+
+    // Receives for up to timeoutMs, then emits the bins that became final (see FleetStore)
+    template <typename Emit>
+    void poll(int timeoutMs, Emit emit)
+    {
+        fds.resize(rigs.size());
+        for (size_t i = 0; i < rigs.size(); i++)
+        {
+            fds[i] = {rigs[i]->receiver.handle(), POLLIN, 0};
+        }
+        ::poll(fds.data(), fds.size(), timeoutMs);
+
+        int64_t now = hostTimeMs();
+        for (size_t i = 0; i < rigs.size(); i++)
+        {
+            Rig &rig = *rigs[i];
+            if (fds[i].revents & POLLIN)
+            {
+                receive(rig, (int)i, now);
+            }
+            if (now - rig.lastHeardMs > FLEET_RESUBSCRIBE_MS)
+            {
+                rig.lastHeardMs = now;
+                subscribe(rig, true);
+            }
+        }
+        store.close(now, emit);
+    }
+
+    // Unsubscribes every rig and emits what is left
+    template <typename Emit>
+    void stop(Emit emit)
+    {
+        pool.stop();
+        pool.start(poolThreads);
+        for (std::unique_ptr<Rig> &rig : rigs)
+        {
+            subscribe(*rig, false);
+        }
+        pool.stop();
+        store.flush(emit);
+        for (std::unique_ptr<Rig> &rig : rigs)
+        {
+            rig->receiver.close();
+        }
+    }
+
+    int rigCount() const { return (int)rigs.size(); }
+    const std::string &rigName(int rig) const { return rigs[rig]->name; }
+
+    RigStats_t stats(int index) const
+    {
+        const Rig &rig = *rigs[index];
+        RigStats_t stats;
+        stats.receiver = rig.receiver.stats;
+        stats.tooLate = rig.tooLate;
+        stats.subscribeStatus = rig.status;
+        stats.udpPort = rig.udpPort;
+        stats.clockOffsetMs = rig.clock.offsetMs();
+        return stats;
+    }
+
+private:
+    struct Rig
+    {
+        std::string name;
+        std::string host;
+        uint16_t httpPort = 80;
+        uint16_t udpPort = 0; // Kept for stats() after stop()
+        TelemetryReceiver receiver;
+        ClockAlignment clock;
+        uint32_t restarts = 0;
+        uint64_t tooLate = 0;
+        int64_t lastHeardMs = 0;          // Last frame or subscribe attempt
+        std::atomic<int> status{0};       // Written by the pool
+        std::atomic<bool> pending{false}; // A subscribe job is queued or running
+    };
+
+    void subscribe(Rig &rig, bool on)
+    {
+        if (on && rig.pending.exchange(true))
+        {
+            return;
+        }
+        uint16_t port = rig.udpPort;
+        pool.submit([&rig, port, on] {
+            int status = telemetrySubscribe(rig.host.c_str(), rig.httpPort, port, on);
+            if (on)
+            {
+                rig.status = status;
+                rig.pending = false;
+            }
+        });
+    }
+
+    void receive(Rig &rig, int index, int64_t now)
+    {
+        TelemetryFrame_t frame;
+        float values[FLEET_CHANNELS];
+        while (rig.receiver.next(frame, 0))
+        {
+            if (rig.receiver.stats.restarts != rig.restarts)
+            {
+                rig.restarts = rig.receiver.stats.restarts;
+                rig.clock.reset();
+            }
+            fleetValues(frame, values);
+            if (!store.add(index, rig.clock.align(frame.timestamp_ms, now), values))
+            {
+                rig.tooLate++;
+            }
+        }
+        rig.lastHeardMs = now;
+    }
+
+    std::vector<std::unique_ptr<Rig>> rigs;
+    std::vector<pollfd> fds;
+    FleetStore store;
+    WorkerPool pool;
+    int poolThreads = 1;
+};
+
+// The merged rows for a TableWriter: time_ms (bin start, Unix ms), then <rig>.<channel>
+class FleetTable
+{
+public:
+    void begin(const FleetAggregator &fleet)
+    {
+        names.clear();
+        names.push_back("time_ms");
+        for (int r = 0; r < fleet.rigCount(); r++)
+        {
+            for (int c = 0; c < FLEET_CHANNELS; c++)
+            {
+                names.push_back(fleet.rigName(r) + "." + fleetChannelNames[c]);
+            }
+        }
+        spec.clear();
+        spec.push_back({names[0].c_str(), COLUMN_U64, 0});
+        for (size_t i = 1; i < names.size(); i++)
+        {
+            spec.push_back({names[i].c_str(), COLUMN_F32, sizeof(uint64_t) + (i - 1) * sizeof(float)});
+        }
+        row.assign(sizeof(uint64_t) + (names.size() - 1) * sizeof(float), 0);
+    }
+
+    const ColumnSpec_t *columns() const { return spec.data(); }
+    int count() const { return (int)spec.size(); }
+
+    const void *fill(int64_t startMs, const float *means)
+    {
+        uint64_t time = startMs;
+        memcpy(row.data(), &time, sizeof(time));
+        memcpy(row.data() + sizeof(time), means, row.size() - sizeof(time));
+        return row.data();
+    }
+
+private:
+    std::vector<std::string> names;
+    std::vector<ColumnSpec_t> spec;
+    std::vector<uint8_t> row;
+};
@@ -0,0 +1,340 @@
+#pragma once
+
+#include <stdint.h>
+#include <ctype.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+// Finds rigs on the LAN by the _cryo._udp service each one advertises, with the TXT
+// records (fw, frame, channels, mac, run) and the port of its _http._tcp dashboard.
+// A one-shot query from an ephemeral port (RFC 6762 legacy unicast) is answered straight
+// to that port, so no mDNS daemon is needed and port 5353 stays free.
+#define MDNS_GROUP "224.0.0.251"
+#define MDNS_PORT 5353
+#define MDNS_TELEMETRY_SERVICE "_cryo._udp.local"
+#define MDNS_HTTP_SERVICE "_http._tcp.local"
+#define MDNS_TYPE_A 1
+#define MDNS_TYPE_PTR 12
+#define MDNS_TYPE_TXT 16
+#define MDNS_TYPE_SRV 33
+#define MDNS_MAX_JUMPS 32 // Compression pointers followed per name, stops loops
+
+struct DiscoveredRig
+{
+    std::string name;    // Instance name, the rig's device name
+    std::string host;    // e.g. cryo-a1b2c3.local
+    std::string address; // IPv4, dotted
+    uint16_t udpPort = 0;
+    uint16_t httpPort = 80;
+    std::map<std::string, std::string> txt;
+};
+
+// Name at offset, following compression pointers. offset moves past the name as stored.
+inline bool mdnsReadName(const uint8_t *packet, size_t length, size_t &offset, std::string &name)
+{
+    size_t pos = offset;
+    bool jumped = false;
+    int jumps = 0;
+    name.clear();
+    for (;;)
+    {
+        if (pos >= length)
+        {
+            return false;
+        }
+        uint8_t label = packet[pos];
+        if ((label & 0xC0) == 0xC0)
+        {
+            if (pos + 1 >= length || ++jumps > MDNS_MAX_JUMPS)
+            {
+                return false;
+            }
+            if (!jumped)
+            {
+                offset = pos + 2;
+            }
+            jumped = true;
+            pos = ((label & 0x3F) << 8) | packet[pos + 1];
+            continue;
+        }
+        if (label & 0xC0)
+        {
+            return false;
+        }
+        pos++;
+        if (label == 0)
+        {
+            break;
+        }
+        if (pos + label > length)
+        {
+            return false;
+        }
+        if (!name.empty())
+        {
+            name += '.';
+        }
+        name.append((const char *)packet + pos, label);
+        pos += label;
+    }
+    if (!jumped)
+    {
+        offset = pos;
+    }
+    return true;
+}
+
+inline void mdnsWriteName(std::vector<uint8_t> &packet, const char *name)
+{
+    while (*name)
+    {
+        size_t label = strcspn(name, ".");
+        packet.push_back((uint8_t)label);
+        packet.insert(packet.end(), name, name + label);
+        name += label;
+        if (*name == '.')
+        {
+            name++;
+        }
+    }
+    packet.push_back(0);
+}
+
+// A query for the PTR records of the telemetry and the dashboard services
+inline std::vector<uint8_t> mdnsQuery()
+{
+    std::vector<uint8_t> packet = {0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0}; // Two questions
+    for (const char *service : {MDNS_TELEMETRY_SERVICE, MDNS_HTTP_SERVICE})
+    {
+        mdnsWriteName(packet, service);
+        packet.insert(packet.end(), {0, MDNS_TYPE_PTR, 0, 1}); // PTR, class IN
+    }
+    return packet;
+}
+
+// Collects the answers of any number of responses and joins them into rigs
+class MdnsBrowser
+{
+public:
+    // False for a malformed packet, whose records up to the fault are still kept
+    bool parse(const uint8_t *packet, size_t length)
+    {
+        if (length < 12 || !(packet[2] & 0x80)) // Responses only
+        {
+            return false;
+        }
+        int questions = packet[4] << 8 | packet[5];
+        int records = (packet[6] << 8 | packet[7]) + (packet[8] << 8 | packet[9]) + (packet[10] << 8 | packet[11]);
+        size_t offset = 12;
+        std::string name;
+        for (int i = 0; i < questions; i++)
+        {
+            if (!mdnsReadName(packet, length, offset, name) || (offset += 4) > length)
+            {
+                return false;
+            }
+        }
+        for (int i = 0; i < records; i++)
+        {
+            if (!mdnsReadName(packet, length, offset, name) || offset + 10 > length)
+            {
+                return false;
+            }
+            const uint8_t *p = packet + offset;
+            uint16_t type = p[0] << 8 | p[1];
+            uint32_t ttl = (uint32_t)p[4] << 24 | p[5] << 16 | p[6] << 8 | p[7];
+            uint16_t dataLength = p[8] << 8 | p[9];
+            offset += 10;
+            if (offset + dataLength > length)
+            {
+                return false;
+            }
+            if (!record(packet, length, offset, dataLength, name, type, ttl))
+            {
+                return false;
+            }
+            offset += dataLength;
+        }
+        return true;
+    }
+
+    // Rigs with a complete telemetry service and an address, by name
+    std::vector<DiscoveredRig> rigs() const
+    {
+        std::vector<DiscoveredRig> found;
+        for (const std::string &instance : telemetryInstances)
+        {
+            auto service = services.find(lower(instance));
+            if (service == services.end())
+            {
+                continue;
+            }
+            auto address = addresses.find(lower(service->second.target));
+            if (address == addresses.end())
+            {
+                continue;
+            }
+            DiscoveredRig rig;
+            rig.name = instance.substr(0, instance.size() - strlen(MDNS_TELEMETRY_SERVICE) - 1);
+            rig.host = service->second.target;
+            rig.address = address->second;
+            rig.udpPort = service->second.port;
+            auto http = services.find(lower(rig.name + "." MDNS_HTTP_SERVICE));
+            if (http != services.end())
+            {
+                rig.httpPort = http->second.port;
+            }
+            auto txt = texts.find(lower(instance));
+            if (txt != texts.end())
+            {
+                rig.txt = txt->second;
+            }
+            found.push_back(rig);
+        }
+        return found;
+    }
+
+private:
+    struct Service
+    {
+        std::string target;
+        uint16_t port;
+    };
+
+    static std::string lower(std::string text)
+    {
+        for (char &c : text)
+        {
+            c = tolower((unsigned char)c);
+        }
+        return text;
+    }
+
+    static bool endsWith(const std::string &name, const char *suffix)
+    {
+        size_t n = strlen(suffix);
+        return name.size() > n + 1 && name[name.size() - n - 1] == '.' && strcasecmp(name.c_str() + name.size() - n, suffix) == 0;
+    }
+
+    bool record(const uint8_t *packet, size_t length, size_t offset, uint16_t dataLength, const std::string &name,
+                uint16_t type, uint32_t ttl)
+    {
+        const uint8_t *data = packet + offset;
+        std::string target;
+        if (type == MDNS_TYPE_PTR && strcasecmp(name.c_str(), MDNS_TELEMETRY_SERVICE) == 0)
+        {
+            size_t at = offset;
+            if (!mdnsReadName(packet, length, at, target) || !endsWith(target, MDNS_TELEMETRY_SERVICE))
+            {
+                return false;
+            }
+            if (ttl == 0)
+            {
+                telemetryInstances.erase(target); // Goodbye: the rig is leaving
+            }
+            else
+            {
+                telemetryInstances.insert(target);
+            }
+        }
+        else if (type == MDNS_TYPE_SRV && dataLength >= 7)
+        {
+            size_t at = offset + 6;
+            if (!mdnsReadName(packet, length, at, target))
+            {
+                return false;
+            }
+            services[lower(name)] = {target, (uint16_t)(data[4] << 8 | data[5])};
+        }
+        else if (type == MDNS_TYPE_TXT)
+        {
+            std::map<std::string, std::string> &entries = texts[lower(name)];
+            for (size_t i = 0; i < dataLength;)
+            {
+                size_t n = data[i++];
+                if (i + n > dataLength)
+                {
+                    return false;
+                }
+                std::string entry((const char *)data + i, n);
+                size_t equals = entry.find('=');
+                if (equals != std::string::npos && equals > 0)
+                {
+                    entries[entry.substr(0, equals)] = entry.substr(equals + 1);
+                }
+                i += n;
+            }
+        }
+        else if (type == MDNS_TYPE_A && dataLength == 4)
+        {
+            char dotted[INET_ADDRSTRLEN];
+            inet_ntop(AF_INET, data, dotted, sizeof(dotted));
+            addresses[lower(name)] = dotted;
+        }
+        return true;
+    }
+
+    std::set<std::string> telemetryInstances;
+    std::map<std::string, Service> services; // By instance name, lower case
+    std::map<std::string, std::map<std::string, std::string>> texts;
+    std::map<std::string, std::string> addresses; // By host name
+};
+
+// Asks the LAN for rigs for timeoutMs, repeating the query twice in case one is lost
+inline std::vector<DiscoveredRig> mdnsDiscover(int timeoutMs)
+{
+    MdnsBrowser browser;
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0)
+    {
+        return browser.rigs();
+    }
+    unsigned char ttl = 255;
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+    sockaddr_in group = {};
+    group.sin_family = AF_INET;
+    group.sin_port = htons(MDNS_PORT);
+    inet_pton(AF_INET, MDNS_GROUP, &group.sin_addr);
+    std::vector<uint8_t> query = mdnsQuery();
+
+    timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int queries = 0;
+    for (;;)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int elapsed = (now.tv_sec - start.tv_sec) * 1000 + (now.tv_nsec - start.tv_nsec) / 1000000;
+        if (elapsed >= timeoutMs)
+        {
+            break;
+        }
+        if (queries < 3 && elapsed >= queries * timeoutMs / 3)
+        {
+            sendto(fd, query.data(), query.size(), 0, (const sockaddr *)&group, sizeof(group));
+            queries++;
+        }
+        pollfd p = {fd, POLLIN, 0};
+        int wait = queries < 3 ? queries * timeoutMs / 3 - elapsed : timeoutMs - elapsed;
+        if (poll(&p, 1, wait > 0 ? wait : 0) > 0)
+        {
+            uint8_t packet[1500];
+            ssize_t n = recv(fd, packet, sizeof(packet), 0);
+            if (n > 0)
+            {
+                browser.parse(packet, n);
+            }
+        }
+    }
+    close(fd);
+    return browser.rigs();
+}
@@ -0,0 +1,233 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <poll.h>
+#include <telemetryReceiver.h>
+
+// A stand-in rig on loopback for the host tools' tests and demos. It answers /subscribe
+// and /unsubscribe like the firmware (up to SIMULATOR_MAX_SUBSCRIBERS, one port per
+// subscriber address) and streams a frame every periodMs to its subscribers, stamped with
+// its own clock. The signal is a ramp of 1 K/s in host time from epochMs, so rigs that
+// are aligned correctly agree on temp1. One thread per rig.
+#define SIMULATOR_MAX_SUBSCRIBERS 4
+
+class SimulatedRig
+{
+public:
+    ~SimulatedRig() { stop(); }
+
+    // Every lossEvery-th frame is skipped (a sequence gap), 0 sends all. Before start().
+    void setLoss(uint32_t every) { lossEvery = every; }
+
+    // httpPort 0 picks a free one; the rig clock reads clockOffsetMs at start
+    bool start(uint32_t periodMs, uint32_t clockOffsetMs, int64_t epochMs, uint16_t httpPort = 0)
+    {
+        period = periodMs;
+        rigClockStart = clockOffsetMs;
+        epoch = epochMs;
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        udp = socket(AF_INET, SOCK_DGRAM, 0);
+        int one = 1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = htons(httpPort);
+        if (listener < 0 || udp < 0 || bind(listener, (const sockaddr *)&address, sizeof(address)) < 0 ||
+            listen(listener, 8) < 0)
+        {
+            stop();
+            return false;
+        }
+        fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+        socklen_t length = sizeof(address);
+        getsockname(listener, (sockaddr *)&address, &length);
+        port = ntohs(address.sin_port);
+        running = true;
+        worker = std::thread([this] { run(); });
+        return true;
+    }
+
+    void stop()
+    {
+        running = false;
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+        for (int *fd : {&listener, &udp})
+        {
+            if (*fd >= 0)
+            {
+                close(*fd);
+                *fd = -1;
+            }
+        }
+    }
+
+    uint16_t httpPort() const { return port; }
+    uint32_t framesSent() const { return sent; } // Frames that reached at least one subscriber
+
+    int subscriberCount()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return (int)subscribers.size();
+    }
+
+private:
+    void run()
+    {
+        int64_t start = hostTimeMs();
+        int64_t next = start;
+        while (running)
+        {
+            int64_t now = hostTimeMs();
+            if (now >= next)
+            {
+                sendFrame(now, (uint32_t)(rigClockStart + (now - start)));
+                next += period;
+                if (next < now)
+                {
+                    next = now + period; // Fell behind, skip instead of bursting
+                }
+            }
+            int64_t wait = next - hostTimeMs();
+            pollfd p = {listener, POLLIN, 0};
+            if (poll(&p, 1, wait > 50 ? 50 : wait > 0 ? (int)wait : 0) > 0)
+            {
+                serve();
+            }
+        }
+    }
+
+    void sendFrame(int64_t now, uint32_t rigMs)
+    {
+        TelemetryFrame_t frame = {};
+        frame.magic = TELEMETRY_MAGIC;
+        frame.version = TELEMETRY_VERSION;
+        frame.sequence = sequence++;
+        frame.timestamp_ms = rigMs;
+        frame.temp1 = 80 + (now - epoch) / 1000.0f;
+        frame.temp2 = frame.temp1 - 1;
+        frame.dT = 1;
+        frame.busVoltage = 5;
+        frame.current_mA = 100;
+        frame.power_mW = 500;
+        frame.thermalConductivity = 0.3f;
+        frame.thermalConductivityUnc = 0.01f;
+        telemetrySeal(frame);
+        if (lossEvery && frame.sequence % lossEvery == lossEvery - 1)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (const sockaddr_in &to : subscribers)
+        {
+            sendto(udp, &frame, sizeof(frame), 0, (const sockaddr *)&to, sizeof(to));
+        }
+        if (!subscribers.empty())
+        {
+            sent++;
+        }
+    }
+
+    // One HTTP request per connection, like the firmware's web server
+    void serve()
+    {
+        sockaddr_in peer = {};
+        socklen_t length = sizeof(peer);
+        int client = accept(listener, (sockaddr *)&peer, &length);
+        if (client < 0)
+        {
+            return;
+        }
+        fcntl(client, F_SETFL, fcntl(client, F_GETFL) & ~O_NONBLOCK);
+        timeval timeout = {1, 0};
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        char request[512] = {};
+        recv(client, request, sizeof(request) - 1, 0);
+
+        char body[96];
+        int status = 200;
+        long udpPort = 0;
+        if (sscanf(request, "GET /subscribe?port=%ld", &udpPort) == 1)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            sockaddr_in *slot = nullptr;
+            for (sockaddr_in &existing : subscribers)
+            {
+                if (existing.sin_addr.s_addr == peer.sin_addr.s_addr)
+                {
+                    slot = &existing; // Re-subscribe just updates the port
+                }
+            }
+            if (udpPort < 1 || udpPort > 65535)
+            {
+                status = 400;
+                snprintf(body, sizeof(body), "port must be 1-65535");
+            }
+            else if (!slot && subscribers.size() == SIMULATOR_MAX_SUBSCRIBERS)
+            {
+                status = 503;
+                snprintf(body, sizeof(body), "Subscriber list full");
+            }
+            else
+            {
+                if (!slot)
+                {
+                    subscribers.push_back(peer);
+                    slot = &subscribers.back();
+                }
+                slot->sin_port = htons((uint16_t)udpPort);
+                snprintf(body, sizeof(body), "Subscribed 127.0.0.1:%ld (frame v%d, %u bytes)", udpPort, TELEMETRY_VERSION,
+                         (unsigned)sizeof(TelemetryFrame_t));
+            }
+        }
+        else if (strncmp(request, "GET /unsubscribe", 16) == 0)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = subscribers.size(); i-- > 0;)
+            {
+                if (subscribers[i].sin_addr.s_addr == peer.sin_addr.s_addr)
+                {
+                    subscribers.erase(subscribers.begin() + i);
+                }
+            }
+            snprintf(body, sizeof(body), "Unsubscribed 127.0.0.1");
+        }
+        else
+        {
+            status = 404;
+            snprintf(body, sizeof(body), "Not found");
+        }
+
+        char response[256];
+        int n = snprintf(response, sizeof(response), "HTTP/1.1 %d %s\r\nContent-Type: text/plain\r\nConnection: close\r\n\r\n%s",
+                         status, status == 200 ? "OK" : "Error", body);
+        send(client, response, n, MSG_NOSIGNAL);
+        close(client);
+    }
+
+    uint32_t period = 1000;
+    uint32_t rigClockStart = 0;
+    int64_t epoch = 0;
+    uint32_t lossEvery = 0;
+    uint32_t sequence = 0;
+    int listener = -1;
+    int udp = -1;
+    uint16_t port = 0;
+    std::atomic<bool> running{false};
+    std::atomic<uint32_t> sent{0};
+    std::thread worker;
+    std::mutex mutex; // subscribers, between serve() and a caller's subscriberCount()
+    std::vector<sockaddr_in> subscribers;
+};
@@ -0,0 +1,428 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stddef.h>
+#include <string>
+#include <vector>
+#include <telemetryFrame.h>
+
+// Table output of the host tools: CSV for a quick look and a columnar binary file for long
+// high-rate runs. Rows are structs described by a column table (name, type, offset), so
+// the same writers serve single-rig frames and merged fleet rows.
+//
+// Columnar layout, little-endian and Parquet-like: row groups stored column by column, so
+// a reader pulls one channel without touching the others, and a footer indexing the groups.
+//   header  "CRYOCOL1", uint16 columns, per column: uint8 type, uint8 name length, name
+//   group   uint32 COLUMNAR_GROUP_MAGIC, uint32 rows, uint32 CRC-32 of the values,
+//           then the values of each column back to back
+//   footer  uint32 COLUMNAR_FOOTER_MAGIC, uint32 groups, uint64 offset of each group, uint64 rows
+// Every group is flushed as it is written: a file cut short by a crash reads up to its
+// last complete group.
+#define COLUMNAR_MAGIC "CRYOCOL1"
+#define COLUMNAR_GROUP_MAGIC 0x50524752  // "RGRP"
+#define COLUMNAR_FOOTER_MAGIC 0x544F4F46 // "FOOT"
+#define COLUMNAR_GROUP_ROWS 4096
+
+enum ColumnType : uint8_t
+{
+    COLUMN_U8,
+    COLUMN_U16,
+    COLUMN_U32,
+    COLUMN_F32,
+    COLUMN_U64,
+};
+
+inline size_t columnWidth(ColumnType type)
+{
+    static const uint8_t widths[] = {1, 2, 4, 4, 8};
+    return type <= COLUMN_U64 ? widths[type] : 0;
+}
+
+typedef struct
+{
+    const char *name;
+    ColumnType type;
+    size_t offset; // In the row struct
+} ColumnSpec_t;
+
+// Any column value as a double, from unaligned (packed) storage
+inline double columnNumber(const uint8_t *value, ColumnType type)
+{
+    switch (type)
+    {
+    case COLUMN_U8:
+        return *value;
+    case COLUMN_U16:
+    {
+        uint16_t v;
+        memcpy(&v, value, sizeof(v));
+        return v;
+    }
+    case COLUMN_U32:
+    {
+        uint32_t v;
+        memcpy(&v, value, sizeof(v));
+        return v;
+    }
+    case COLUMN_U64:
+    {
+        uint64_t v;
+        memcpy(&v, value, sizeof(v));
+        return v; // Exact up to 2^53, Unix milliseconds for the next 285000 years
+    }
+    default:
+    {
+        float v;
+        memcpy(&v, value, sizeof(v));
+        return v;
+    }
+    }
+}
+
+// The telemetry frame as a row, channel names as in the rig's "channels" TXT record
+static const ColumnSpec_t telemetryColumns[] = {
+    {"sequence", COLUMN_U32, offsetof(TelemetryFrame_t, sequence)},
+    {"timestamp_ms", COLUMN_U32, offsetof(TelemetryFrame_t, timestamp_ms)},
+    {"temp1", COLUMN_F32, offsetof(TelemetryFrame_t, temp1)},
+    {"temp2", COLUMN_F32, offsetof(TelemetryFrame_t, temp2)},
+    {"dT", COLUMN_F32, offsetof(TelemetryFrame_t, dT)},
+    {"busVoltage", COLUMN_F32, offsetof(TelemetryFrame_t, busVoltage)},
+    {"current_mA", COLUMN_F32, offsetof(TelemetryFrame_t, current_mA)},
+    {"power_mW", COLUMN_F32, offsetof(TelemetryFrame_t, power_mW)},
+    {"k", COLUMN_F32, offsetof(TelemetryFrame_t, thermalConductivity)},
+    {"u_k", COLUMN_F32, offsetof(TelemetryFrame_t, thermalConductivityUnc)},
+    {"dacValue", COLUMN_U16, offsetof(TelemetryFrame_t, dacValue)},
+    {"flags", COLUMN_U8, offsetof(TelemetryFrame_t, flags)},
+};
+#define TELEMETRY_COLUMNS ((int)(sizeof(telemetryColumns) / sizeof(telemetryColumns[0])))
+
+// Common interface, so a tool picks the format once
+class TableWriter
+{
+public:
+    virtual ~TableWriter() {}
+    virtual bool open(const char *path, const ColumnSpec_t *columns, int count) = 0;
+    virtual bool append(const void *row) = 0;
+    virtual bool close() = 0;
+    uint64_t rows() const { return rowCount; }
+
+protected:
+    std::vector<ColumnSpec_t> spec;
+    uint64_t rowCount = 0;
+};
+
+// Header line with the column names, floats to 7 significant digits, NaN as an empty field
+class CsvWriter : public TableWriter
+{
+public:
+    ~CsvWriter() { close(); }
+
+    // "-" writes to stdout
+    bool open(const char *path, const ColumnSpec_t *columns, int count) override
+    {
+        close();
+        file = strcmp(path, "-") == 0 ? stdout : fopen(path, "w");
+        if (!file)
+        {
+            return false;
+        }
+        spec.assign(columns, columns + count);
+        rowCount = 0;
+        for (int c = 0; c < count; c++)
+        {
+            fprintf(file, "%s%s", c ? "," : "", columns[c].name);
+        }
+        fputc('\n', file);
+        return !ferror(file);
+    }
+
+    bool append(const void *row) override
+    {
+        const uint8_t *base = (const uint8_t *)row;
+        for (size_t c = 0; c < spec.size(); c++)
+        {
+            if (c)
+            {
+                fputc(',', file);
+            }
+            double value = columnNumber(base + spec[c].offset, spec[c].type);
+            if (spec[c].type != COLUMN_F32)
+            {
+                fprintf(file, "%.0f", value);
+            }
+            else if (!isnan(value))
+            {
+                fprintf(file, "%.7g", value);
+            }
+        }
+        fputc('\n', file);
+        rowCount++;
+        return !ferror(file);
+    }
+
+    bool close() override
+    {
+        if (!file)
+        {
+            return true;
+        }
+        bool ok = !ferror(file) && fflush(file) == 0;
+        if (file != stdout)
+        {
+            ok = fclose(file) == 0 && ok;
+        }
+        file = nullptr;
+        return ok;
+    }
+
+private:
+    FILE *file = nullptr;
+};
+
+class ColumnarWriter : public TableWriter
+{
+public:
+    explicit ColumnarWriter(uint32_t rowsPerGroup = COLUMNAR_GROUP_ROWS) : groupRows(rowsPerGroup) {}
+    ~ColumnarWriter() { close(); }
+
+    bool open(const char *path, const ColumnSpec_t *columns, int count) override
+    {
+        close();
+        file = fopen(path, "wb");
+        if (!file)
+        {
+            return false;
+        }
+        spec.assign(columns, columns + count);
+        values.assign(count, std::vector<uint8_t>());
+        offsets.clear();
+        rowCount = 0;
+        pending = 0;
+
+        uint16_t columnCount = count;
+        fwrite(COLUMNAR_MAGIC, 1, 8, file);
+        fwrite(&columnCount, sizeof(columnCount), 1, file);
+        for (int c = 0; c < count; c++)
+        {
+            uint8_t type = columns[c].type;
+            uint8_t length = strlen(columns[c].name);
+            fwrite(&type, 1, 1, file);
+            fwrite(&length, 1, 1, file);
+            fwrite(columns[c].name, 1, length, file);
+            values[c].reserve(groupRows * columnWidth(columns[c].type));
+        }
+        return !ferror(file);
+    }
+
+    bool append(const void *row) override
+    {
+        const uint8_t *base = (const uint8_t *)row;
+        for (size_t c = 0; c < spec.size(); c++)
+        {
+            const uint8_t *value = base + spec[c].offset;
+            values[c].insert(values[c].end(), value, value + columnWidth(spec[c].type));
+        }
+        rowCount++;
+        return ++pending < groupRows || flush();
+    }
+
+    // Writes the rows so far as a group, a crash then loses only what comes after
+    bool flush()
+    {
+        if (!file || pending == 0)
+        {
+            return file && !ferror(file);
+        }
+        group.clear();
+        for (const std::vector<uint8_t> &column : values)
+        {
+            group.insert(group.end(), column.begin(), column.end());
+        }
+        uint32_t header[3] = {COLUMNAR_GROUP_MAGIC, pending, telemetryCrc32(group.data(), group.size())};
+        offsets.push_back(ftello(file));
+        fwrite(header, sizeof(header), 1, file);
+        fwrite(group.data(), 1, group.size(), file);
+        for (std::vector<uint8_t> &column : values)
+        {
+            column.clear();
+        }
+        pending = 0;
+        return fflush(file) == 0 && !ferror(file);
+    }
+
+    bool close() override
+    {
+        if (!file)
+        {
+            return true;
+        }
+        bool ok = flush();
+        uint32_t footer[2] = {COLUMNAR_FOOTER_MAGIC, (uint32_t)offsets.size()};
+        fwrite(footer, sizeof(footer), 1, file);
+        fwrite(offsets.data(), sizeof(uint64_t), offsets.size(), file);
+        fwrite(&rowCount, sizeof(rowCount), 1, file);
+        ok = !ferror(file) && ok;
+        ok = fclose(file) == 0 && ok;
+        file = nullptr;
+        return ok;
+    }
+
+private:
+    FILE *file = nullptr;
+    uint32_t groupRows;
+    uint32_t pending = 0;
+    std::vector<std::vector<uint8_t>> values; // Per column, the group being filled
+    std::vector<uint8_t> group;
+    std::vector<uint64_t> offsets;
+};
+
+// Reads a columnar file group by group
+class ColumnarReader
+{
+public:
+    ~ColumnarReader() { close(); }
+
+    bool open(const char *path)
+    {
+        close();
+        file = fopen(path, "rb");
+        char magic[8];
+        uint16_t count;
+        if (!file || fread(magic, 1, 8, file) != 8 || memcmp(magic, COLUMNAR_MAGIC, 8) != 0 ||
+            fread(&count, sizeof(count), 1, file) != 1)
+        {
+            close();
+            return false;
+        }
+        names.clear();
+        types.clear();
+        for (int c = 0; c < count; c++)
+        {
+            uint8_t type, length;
+            char name[256];
+            if (fread(&type, 1, 1, file) != 1 || fread(&length, 1, 1, file) != 1 || fread(name, 1, length, file) != length ||
+                type > COLUMN_U64)
+            {
+                close();
+                return false;
+            }
+            names.push_back(std::string(name, length));
+            types.push_back((ColumnType)type);
+        }
+        groupCount = 0;
+        totalRows = 0;
+        groupRows = 0;
+        footerValid = false;
+        return true;
+    }
+
+    void close()
+    {
+        if (file)
+        {
+            fclose(file);
+            file = nullptr;
+        }
+    }
+
+    int columns() const { return (int)names.size(); }
+    const std::string &name(int column) const { return names[column]; }
+    ColumnType type(int column) const { return types[column]; }
+
+    // Column index by name, -1 when absent
+    int find(const char *columnName) const
+    {
+        for (size_t c = 0; c < names.size(); c++)
+        {
+            if (names[c] == columnName)
+            {
+                return (int)c;
+            }
+        }
+        return -1;
+    }
+
+    // Loads the next group. False at the footer, or where a cut-short file ends or a
+    // group fails its CRC.
+    bool nextGroup()
+    {
+        groupRows = 0;
+        uint32_t header[3];
+        if (!file || fread(header, sizeof(uint32_t), 1, file) != 1)
+        {
+            return false;
+        }
+        if (header[0] == COLUMNAR_FOOTER_MAGIC)
+        {
+            readFooter();
+            return false;
+        }
+        if (header[0] != COLUMNAR_GROUP_MAGIC || fread(header + 1, sizeof(uint32_t), 2, file) != 2)
+        {
+            return false;
+        }
+
+        size_t rowBytes = 0;
+        for (ColumnType t : types)
+        {
+            rowBytes += columnWidth(t);
+        }
+        buffer.resize((size_t)header[1] * rowBytes);
+        if (fread(buffer.data(), 1, buffer.size(), file) != buffer.size() ||
+            telemetryCrc32(buffer.data(), buffer.size()) != header[2])
+        {
+            return false;
+        }
+        starts.clear();
+        size_t start = 0;
+        for (ColumnType t : types)
+        {
+            starts.push_back(start);
+            start += header[1] * columnWidth(t);
+        }
+        groupRows = header[1];
+        groupCount++;
+        totalRows += groupRows;
+        return true;
+    }
+
+    // Rows in the current group
+    uint32_t rows() const { return groupRows; }
+
+    // Values of one column of the current group, contiguous
+    const uint8_t *column(int c) const { return buffer.data() + starts[c]; }
+
+    double number(int c, uint32_t row) const { return columnNumber(column(c) + row * columnWidth(types[c]), types[c]); }
+
+    // Every group read and the footer agrees with them: the file was closed properly
+    bool complete() const { return footerValid; }
+    uint64_t rowsRead() const { return totalRows; }
+
+private:
+    void readFooter()
+    {
+        uint32_t groups;
+        uint64_t rows;
+        std::vector<uint64_t> offsets;
+        if (fread(&groups, sizeof(groups), 1, file) != 1)
+        {
+            return;
+        }
+        offsets.resize(groups);
+        footerValid = fread(offsets.data(), sizeof(uint64_t), groups, file) == groups &&
+                      fread(&rows, sizeof(rows), 1, file) == 1 && groups == groupCount && rows == totalRows;
+    }
+
+    FILE *file = nullptr;
+    std::vector<std::string> names;
+    std::vector<ColumnType> types;
+    std::vector<uint8_t> buffer;
+    std::vector<size_t> starts;
+    uint32_t groupRows = 0;
+    uint32_t groupCount = 0;
+    uint64_t totalRows = 0;
+    bool footerValid = false;
+};
@@ -0,0 +1,314 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <string>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <time.h>
+#include <telemetryFrame.h>
+
+// Host side of the UDP telemetry (POSIX sockets, Linux and macOS): subscribes a port on
+// a rig over HTTP, receives and checks the binary frames, and counts lost frames from
+// the sequence numbers. Header-only, like the modules in src/ it shares the frame with.
+#define RECEIVER_REORDER_WINDOW 64   // Frames up to this far behind are late, further back the rig restarted
+#define RECEIVER_MAX_GAP 0x100000UL  // A forward jump beyond this is a restart too
+#define RECEIVER_SOCKET_BUFFER (4 << 20) // Rides out a stalled writer at full rate
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // macOS: the tools ignore SIGPIPE instead
+#endif
+
+typedef struct
+{
+    uint64_t frames;   // Valid and in order
+    uint64_t lost;     // Sequence numbers never received (late frames stay counted)
+    uint64_t late;     // Arrived after a newer frame, dropped
+    uint64_t invalid;  // Wrong size, magic, version or CRC
+    uint32_t restarts; // Sequence started over: the rig rebooted
+} ReceiverStats_t;
+
+// Host wall clock, Unix milliseconds
+inline int64_t hostTimeMs()
+{
+    timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// Loss detection on the sequence numbers of one rig. They count from 0 at boot, so a
+// frame 0 or a jump out of the window starts over instead of counting as loss.
+class SequenceTracker
+{
+public:
+    // False for a late or duplicate frame, which should be dropped
+    bool accept(uint32_t sequence, ReceiverStats_t &stats)
+    {
+        if (started)
+        {
+            int32_t delta = (int32_t)(sequence - expected);
+            if (delta < 0 && delta >= -RECEIVER_REORDER_WINDOW && sequence != 0)
+            {
+                stats.late++;
+                return false;
+            }
+            if (delta >= 0 && (uint32_t)delta <= RECEIVER_MAX_GAP)
+            {
+                stats.lost += delta;
+            }
+            else
+            {
+                stats.restarts++;
+            }
+        }
+        started = true;
+        expected = sequence + 1;
+        stats.frames++;
+        return true;
+    }
+
+    void reset() { started = false; }
+
+private:
+    bool started = false;
+    uint32_t expected = 0;
+};
+
+// A datagram is a frame when it has exactly the frame's size and passes telemetryValid()
+inline bool telemetryParse(const void *data, size_t length, TelemetryFrame_t &frame)
+{
+    if (length != sizeof(TelemetryFrame_t))
+    {
+        return false;
+    }
+    memcpy(&frame, data, sizeof(frame));
+    return telemetryValid(frame);
+}
+
+class TelemetrySocket
+{
+public:
+    ~TelemetrySocket() { close(); }
+
+    // Binds the UDP port on all interfaces, 0 picks a free one (see port())
+    bool open(uint16_t port)
+    {
+        close();
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0)
+        {
+            return false;
+        }
+        int one = 1;
+        int buffer = RECEIVER_SOCKET_BUFFER;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer)); // Capped by net.core.rmem_max
+
+        sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_ANY);
+        address.sin_port = htons(port);
+        if (bind(fd, (const sockaddr *)&address, sizeof(address)) < 0)
+        {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close()
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    uint16_t port() const
+    {
+        sockaddr_in address = {};
+        socklen_t length = sizeof(address);
+        if (fd < 0 || getsockname(fd, (sockaddr *)&address, &length) < 0)
+        {
+            return 0;
+        }
+        return ntohs(address.sin_port);
+    }
+
+    int handle() const { return fd; }
+
+    // One datagram: its length, 0 when none arrived within timeoutMs, -1 on error.
+    // Polls only when the queue is empty, a backlog drains at one syscall per frame.
+    int receive(void *buffer, size_t size, sockaddr_in &from, int timeoutMs)
+    {
+        for (int attempt = 0; attempt < 2; attempt++)
+        {
+            socklen_t length = sizeof(from);
+            ssize_t n = recvfrom(fd, buffer, size, MSG_DONTWAIT, (sockaddr *)&from, &length);
+            if (n >= 0)
+            {
+                return (int)n;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                return -1;
+            }
+            if (attempt == 0)
+            {
+                pollfd p = {fd, POLLIN, 0};
+                int ready = poll(&p, 1, timeoutMs);
+                if (ready <= 0)
+                {
+                    return ready == 0 || errno == EINTR ? 0 : -1;
+                }
+            }
+        }
+        return 0;
+    }
+
+private:
+    int fd = -1;
+};
+
+// Frames from one rig: valid, in order, with loss statistics
+class TelemetryReceiver
+{
+public:
+    bool open(uint16_t port) { return socket.open(port); }
+    void close() { socket.close(); }
+    uint16_t port() const { return socket.port(); }
+    int handle() const { return socket.handle(); } // For poll() over several receivers
+
+    // Next frame to keep, false when none arrived within timeoutMs
+    bool next(TelemetryFrame_t &frame, int timeoutMs, sockaddr_in *from = nullptr)
+    {
+        uint8_t buffer[sizeof(TelemetryFrame_t) + 1]; // The spare byte shows oversized datagrams
+        sockaddr_in source;
+        for (;;)
+        {
+            int n = socket.receive(buffer, sizeof(buffer), source, timeoutMs);
+            if (n <= 0)
+            {
+                return false;
+            }
+            if (!telemetryParse(buffer, n, frame))
+            {
+                stats.invalid++;
+                continue;
+            }
+            if (tracker.accept(frame.sequence, stats))
+            {
+                if (from)
+                {
+                    *from = source;
+                }
+                return true;
+            }
+        }
+    }
+
+    ReceiverStats_t stats = {};
+
+private:
+    TelemetrySocket socket;
+    SequenceTracker tracker;
+};
+
+// Splits "host[:port]", the port defaults to 80
+inline bool parseHostPort(const char *text, std::string &host, uint16_t &port)
+{
+    const char *colon = strrchr(text, ':');
+    port = 80;
+    if (colon)
+    {
+        char *end;
+        long value = strtol(colon + 1, &end, 10);
+        if (end == colon + 1 || *end != '\0' || value < 1 || value > 65535)
+        {
+            return false;
+        }
+        port = (uint16_t)value;
+    }
+    host.assign(text, colon ? colon - text : strlen(text));
+    return !host.empty();
+}
+
+// Blocking HTTP/1.0 GET. Returns the status code (body in *body), -1 when the host is
+// unreachable or does not answer within timeoutMs.
+inline int httpGet(const char *host, uint16_t port, const char *path, std::string *body = nullptr, int timeoutMs = 3000)
+{
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *found = nullptr;
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+    if (getaddrinfo(host, service, &hints, &found) != 0 || !found)
+    {
+        return -1;
+    }
+    int fd = socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+    if (fd < 0)
+    {
+        freeaddrinfo(found);
+        return -1;
+    }
+    timeval timeout = {timeoutMs / 1000, (timeoutMs % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout)); // Bounds connect() too
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    bool connected = connect(fd, found->ai_addr, found->ai_addrlen) == 0;
+    freeaddrinfo(found);
+
+    std::string response;
+    if (connected)
+    {
+        std::string request = std::string("GET ") + path + " HTTP/1.0\r\nHost: " + host + "\r\nConnection: close\r\n\r\n";
+        if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) == (ssize_t)request.size())
+        {
+            char chunk[512];
+            ssize_t n;
+            while ((n = recv(fd, chunk, sizeof(chunk), 0)) > 0)
+            {
+                response.append(chunk, n);
+            }
+        }
+    }
+    ::close(fd);
+
+    int status;
+    if (sscanf(response.c_str(), "HTTP/%*d.%*d %d", &status) != 1)
+    {
+        return -1;
+    }
+    if (body)
+    {
+        size_t start = response.find("\r\n\r\n");
+        *body = start == std::string::npos ? "" : response.substr(start + 4);
+    }
+    return status;
+}
+
+// /subscribe?port= (or /unsubscribe) on a rig, returns the HTTP status like httpGet()
+inline int telemetrySubscribe(const char *host, uint16_t httpPort, uint16_t udpPort, bool subscribe = true,
+                              std::string *body = nullptr)
+{
+    char path[48];
+    if (subscribe)
+    {
+        snprintf(path, sizeof(path), "/subscribe?port=%u", udpPort);
+    }
+    else
+    {
+        snprintf(path, sizeof(path), "/unsubscribe");
+    }
+    return httpGet(host, httpPort, path, body);
+}